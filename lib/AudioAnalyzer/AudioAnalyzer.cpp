@@ -0,0 +1,225 @@
+#include "AudioAnalyzer.h"
+#include <esp_timer.h>
+#include <math.h>
+
+AudioAnalyzer& AudioAnalyzer::getInstance()
+{
+    static AudioAnalyzer instance;
+    return instance;
+}
+
+AudioAnalyzer::AudioAnalyzer()
+    : source(nullptr),
+      fft(512),
+      sampleRate(22050),
+      taskHandle(nullptr),
+      running(false),
+      agcPeak(-100.0f),
+      agcFloor(100.0f),
+      fluxAverage(0.0f),
+      lastBeatMs(0),
+      beatCount(0),
+      hops(0),
+      seqlock(0),
+      lastFftUs(0),
+      maxFftUs(0),
+      totalFftUs(0),
+      shortReads(0)
+{
+    memset(history, 0, sizeof(history));
+    memset(bandDb, 0, sizeof(bandDb));
+    memset(bandLevel, 0, sizeof(bandLevel));
+    memset(smoothed, 0, sizeof(smoothed));
+    memset(&published, 0, sizeof(published));
+}
+
+bool AudioAnalyzer::begin(AudioSource* audioSource, uint32_t rate, size_t fftSize)
+{
+    if (running || audioSource == nullptr) return false;
+    if (!fft.setSize(fftSize)) {
+        Serial.printf("ERROR: Invalid FFT size %u\n", static_cast<unsigned>(fftSize));
+        delete audioSource;
+        return false;
+    }
+    if (!audioSource->begin(rate)) {
+        Serial.printf("ERROR: Audio source %s failed to start\n", audioSource->name());
+        delete audioSource;
+        return false;
+    }
+
+    source = audioSource;
+    sampleRate = rate;
+    computeBands();
+
+    running = true;
+    xTaskCreatePinnedToCore(
+        audioTask,
+        "Audio",
+        4096,
+        this,
+        2,
+        &taskHandle,
+        0);
+
+    Serial.printf("Audio: %s, %u Hz, FFT %u\n", source->name(),
+                  static_cast<unsigned>(sampleRate), static_cast<unsigned>(fftSize));
+    return true;
+}
+
+// Log spaced band edges in bins, at least one bin per band
+void AudioAnalyzer::computeBands()
+{
+    size_t n = fft.size();
+    float binHz = static_cast<float>(sampleRate) / n;
+    float maxFreq = std::min(AUDIO_MAX_FREQ, sampleRate / 2.0f);
+    float ratio = powf(maxFreq / AUDIO_MIN_FREQ, 1.0f / AUDIO_BAND_COUNT);
+
+    float freq = AUDIO_MIN_FREQ;
+    uint16_t bin = std::max<uint16_t>(1, static_cast<uint16_t>(freq / binHz));
+    for (int b = 0; b <= AUDIO_BAND_COUNT; b++) {
+        uint16_t edge = static_cast<uint16_t>(freq / binHz + 0.5f);
+        if (b > 0) edge = std::max<uint16_t>(edge, bin + 1);
+        edge = std::min<uint16_t>(edge, n / 2);
+        bandEdges[b] = b == 0 ? bin : edge;
+        bin = bandEdges[b];
+        freq *= ratio;
+    }
+}
+
+void AudioAnalyzer::analyze(const int16_t* window, uint32_t now)
+{
+    int64_t start = esp_timer_get_time();
+    fft.window(window, re, im);
+    fft.transform(re, im);
+    fft.power(re, im, power);
+    lastFftUs = static_cast<uint32_t>(esp_timer_get_time() - start);
+    maxFftUs = std::max(maxFftUs, lastFftUs);
+    totalFftUs += lastFftUs;
+
+    AudioSnapshot snapshot;
+    float loudest = -100.0f;
+    float quietest = 100.0f;
+    float flux = 0.0f;
+
+    for (int b = 0; b < AUDIO_BAND_COUNT; b++) {
+        uint64_t energy = 0;
+        for (uint16_t k = bandEdges[b]; k < bandEdges[b + 1]; k++) {
+            energy += power[k];
+        }
+        uint16_t width = std::max<uint16_t>(1, bandEdges[b + 1] - bandEdges[b]);
+        float db = 10.0f * log10f(static_cast<float>(energy) / width + 1.0f);
+        bandDb[b] = db;
+        loudest = std::max(loudest, db);
+        quietest = std::min(quietest, db);
+    }
+
+    // AGC: the peak falls slowly and jumps up, the floor rises slowly and jumps down
+    agcPeak = std::max(loudest, agcPeak - AGC_PEAK_DECAY_DB);
+    agcFloor = std::min(quietest, agcFloor + AGC_FLOOR_RISE_DB);
+    float range = std::max(AGC_MIN_RANGE_DB, agcPeak - agcFloor);
+    float top = agcFloor + range;
+
+    for (int b = 0; b < AUDIO_BAND_COUNT; b++) {
+        float level = std::max(0.0f, std::min(1.0f, (bandDb[b] - (top - range)) / range));
+        // Flux after the AGC, so flicker near the noise floor does not count
+        if (b < AUDIO_BEAT_BANDS) {
+            flux += std::max(0.0f, level - bandLevel[b]);
+        }
+        bandLevel[b] = level;
+        // Instant attack, exponential release
+        smoothed[b] = std::max(level, smoothed[b] * BAND_RELEASE);
+        snapshot.bands[b] = static_cast<uint8_t>(smoothed[b] * 255.0f);
+    }
+
+    // Onsets: low band flux well above its own average, at most one per refractory period
+    bool beat = flux > fluxAverage * BEAT_THRESHOLD && flux > BEAT_MIN_FLUX &&
+                now - lastBeatMs >= AUDIO_BEAT_REFRACTORY_MS;
+    fluxAverage += FLUX_AVERAGE_ALPHA * (flux - fluxAverage);
+    if (beat) {
+        lastBeatMs = now;
+        beatCount++;
+    }
+
+    // VU level over the newest half window, -60 to 0 dBFS
+    size_t n = fft.size();
+    uint64_t squares = 0;
+    for (size_t i = n / 2; i < n; i++) {
+        squares += static_cast<int32_t>(window[i]) * window[i];
+    }
+    float rms = sqrtf(static_cast<float>(squares) / (n / 2));
+    float dbfs = 20.0f * log10f(rms / 32768.0f + 1e-6f);
+    snapshot.level = static_cast<uint8_t>(std::max(0.0f, std::min(1.0f, (dbfs + 60.0f) / 60.0f)) * 255.0f);
+
+    snapshot.beat = beat;
+    snapshot.beatCount = beatCount;
+    snapshot.sequence = ++hops;
+    snapshot.timestamp = now;
+    publish(snapshot);
+}
+
+void AudioAnalyzer::publish(const AudioSnapshot& snapshot)
+{
+    uint32_t seq = seqlock.load(std::memory_order_relaxed);
+    seqlock.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    published = snapshot;
+    std::atomic_thread_fence(std::memory_order_release);
+    seqlock.store(seq + 2, std::memory_order_relaxed);
+}
+
+bool AudioAnalyzer::read(AudioSnapshot& out) const
+{
+    if (!running) return false;
+    for (int attempt = 0; attempt < 4; attempt++) {
+        uint32_t before = seqlock.load(std::memory_order_acquire);
+        if (before & 1) continue;
+        out = published;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seqlock.load(std::memory_order_relaxed) == before) {
+            return out.sequence != 0;
+        }
+    }
+    // The writer kept the lock for four tries, the caller keeps its previous frame
+    return false;
+}
+
+void AudioAnalyzer::getStats(JsonObject& out)
+{
+    out["running"] = running;
+    if (!running) return;
+    out["source"] = source->name();
+    out["sampleRate"] = sampleRate;
+    out["fftSize"] = fft.size();
+    out["hops"] = hops;
+    out["beats"] = beatCount;
+    out["lastFftUs"] = lastFftUs;
+    out["maxFftUs"] = maxFftUs;
+    out["avgFftUs"] = hops ? static_cast<uint32_t>(totalFftUs / hops) : 0;
+    out["shortReads"] = shortReads;
+    out["agcPeakDb"] = agcPeak;
+    out["agcFloorDb"] = agcFloor;
+}
+
+void AudioAnalyzer::audioTask(void* parameter)
+{
+    static_cast<AudioAnalyzer*>(parameter)->taskLoop();
+}
+
+// Slides the window by half its length per hop
+void AudioAnalyzer::taskLoop()
+{
+    while (true) {
+        size_t n = fft.size();
+        size_t hop = n / 2;
+        memmove(history, history + hop, hop * sizeof(int16_t));
+
+        size_t got = source->read(history + hop, hop);
+        if (got < hop) {
+            shortReads++;
+            memset(history + hop + got, 0, (hop - got) * sizeof(int16_t));
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+
+        analyze(history, millis());
+    }
+}
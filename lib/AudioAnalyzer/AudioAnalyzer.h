@@ -0,0 +1,114 @@
+#ifndef AUDIOANALYZER_H
+#define AUDIOANALYZER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "FixedFFT.h"
+#include "AudioSource.h"
+
+#define AUDIO_BAND_COUNT 16
+#define AUDIO_BEAT_BANDS 4          // Lowest bands feeding the beat detector
+#define AUDIO_BEAT_REFRACTORY_MS 250
+#define AUDIO_MIN_FREQ 60.0f
+#define AUDIO_MAX_FREQ 8000.0f
+
+/**
+ * @brief What the effects see of the audio, published once per hop
+ */
+struct AudioSnapshot {
+    uint8_t bands[AUDIO_BAND_COUNT];  ///< Log spaced, after AGC, 0-255
+    uint8_t level;                    ///< VU level from the block RMS, 0-255
+    bool beat;                        ///< Onset in this hop
+    uint32_t beatCount;               ///< Total onsets, effects compare it with the last one they saw
+    uint32_t sequence;                ///< Hops analyzed, 0 before the first one
+    uint32_t timestamp;               ///< millis() of the hop
+};
+
+/**
+ * @brief Audio analysis task feeding the audio reactive effects
+ *
+ * The task reads half an FFT window at a time from the source, so windows
+ * overlap by 50%, then runs the Hann window and the Q15 FFT. Bin powers are
+ * summed into log spaced bands and converted to dB; an AGC tracking a
+ * decaying peak above a rising noise floor maps them to 0-255. Beats are
+ * spectral flux peaks on the low bands above 1.5x their running average.
+ *
+ * Results go through a sequence lock: the single writer bumps the sequence
+ * to odd, copies, bumps it back to even, and readers retry on a torn copy,
+ * so the render task never waits on the analyzer.
+ */
+class AudioAnalyzer {
+public:
+    static AudioAnalyzer& getInstance();
+
+    // Takes ownership of the source
+    bool begin(AudioSource* source, uint32_t sampleRate, size_t fftSize = 512);
+    bool isRunning() const { return running; }
+
+    // Lock free, safe from any task. False until the first hop is published.
+    bool read(AudioSnapshot& out) const;
+
+    // One hop of analysis on a full window, exposed for offline use
+    void analyze(const int16_t* window, uint32_t now);
+
+    void getStats(JsonObject& out);
+
+private:
+    AudioAnalyzer();
+    AudioAnalyzer(const AudioAnalyzer&) = delete;
+    AudioAnalyzer& operator=(const AudioAnalyzer&) = delete;
+
+    AudioSource* source;
+    FixedFFT fft;
+    uint32_t sampleRate;
+    TaskHandle_t taskHandle;
+    bool running;
+
+    // Analysis buffers, only touched by the audio task
+    int16_t history[FFT_MAX_SIZE];
+    int16_t re[FFT_MAX_SIZE];
+    int16_t im[FFT_MAX_SIZE];
+    uint32_t power[FFT_MAX_SIZE / 2];
+    uint16_t bandEdges[AUDIO_BAND_COUNT + 1];   ///< First bin of each band, last entry is the end
+    float bandDb[AUDIO_BAND_COUNT];
+    float bandLevel[AUDIO_BAND_COUNT];    ///< After AGC, 0-1
+    float smoothed[AUDIO_BAND_COUNT];
+
+    // AGC, in dB
+    float agcPeak;
+    float agcFloor;
+
+    // Beat detection
+    float fluxAverage;
+    uint32_t lastBeatMs;
+    uint32_t beatCount;
+    uint32_t hops;
+
+    // Published state
+    AudioSnapshot published;
+    std::atomic<uint32_t> seqlock;
+
+    // Stats
+    uint32_t lastFftUs;
+    uint32_t maxFftUs;
+    uint64_t totalFftUs;
+    uint32_t shortReads;
+
+    void computeBands();
+    void publish(const AudioSnapshot& snapshot);
+    static void audioTask(void* parameter);
+    void taskLoop();
+
+    static constexpr float AGC_PEAK_DECAY_DB = 0.05f;   ///< Per hop
+    static constexpr float AGC_FLOOR_RISE_DB = 0.02f;   ///< Per hop
+    static constexpr float AGC_MIN_RANGE_DB = 24.0f;    ///< Keeps silence from being stretched to full scale
+    static constexpr float BAND_RELEASE = 0.85f;
+    static constexpr float BEAT_THRESHOLD = 1.5f;
+    static constexpr float BEAT_MIN_FLUX = 0.6f;        ///< Summed level rise over the beat bands
+    static constexpr float FLUX_AVERAGE_ALPHA = 0.1f;
+};
+
+#endif // AUDIOANALYZER_H
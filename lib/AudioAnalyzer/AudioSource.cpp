@@ -0,0 +1,183 @@
+#include "AudioSource.h"
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <thread>
+#include <chrono>
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <freertos/FreeRTOS.h>
+#include <driver/i2s.h>
+
+I2SMicSource::I2SMicSource(uint8_t bckPin, uint8_t wsPin, uint8_t dataPin, uint8_t port)
+    : bckPin(bckPin), wsPin(wsPin), dataPin(dataPin), port(port), installed(false)
+{
+}
+
+I2SMicSource::~I2SMicSource()
+{
+    if (installed) {
+        i2s_driver_uninstall(static_cast<i2s_port_t>(port));
+    }
+}
+
+bool I2SMicSource::begin(uint32_t sampleRate)
+{
+    i2s_config_t config = {};
+    config.mode = static_cast<i2s_mode_t>(I2S_MODE_MASTER | I2S_MODE_RX);
+    config.sample_rate = sampleRate;
+    config.bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT;
+    config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+    config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+    config.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
+    config.dma_buf_count = 4;
+    config.dma_buf_len = 256;
+
+    i2s_pin_config_t pins = {};
+    pins.bck_io_num = bckPin;
+    pins.ws_io_num = wsPin;
+    pins.data_out_num = I2S_PIN_NO_CHANGE;
+    pins.data_in_num = dataPin;
+
+    i2s_port_t i2sPort = static_cast<i2s_port_t>(port);
+    if (i2s_driver_install(i2sPort, &config, 0, nullptr) != ESP_OK) {
+        Serial.println("ERROR: I2S driver install failed");
+        return false;
+    }
+    installed = true;
+    if (i2s_set_pin(i2sPort, &pins) != ESP_OK) {
+        Serial.println("ERROR: I2S pin setup failed");
+        return false;
+    }
+    return true;
+}
+
+size_t I2SMicSource::read(int16_t* samples, size_t count)
+{
+    size_t done = 0;
+    while (done < count) {
+        size_t chunk = std::min(count - done, sizeof(raw) / sizeof(raw[0]));
+        size_t bytes = 0;
+        if (i2s_read(static_cast<i2s_port_t>(port), raw, chunk * sizeof(int32_t), &bytes, portMAX_DELAY) != ESP_OK) {
+            break;
+        }
+        size_t got = bytes / sizeof(int32_t);
+        // 24-bit samples left aligned in 32-bit slots
+        for (size_t i = 0; i < got; i++) {
+            samples[done + i] = static_cast<int16_t>(raw[i] >> 16);
+        }
+        done += got;
+    }
+    return done;
+}
+#endif
+
+SyntheticSource::SyntheticSource(float bpm, bool realTime)
+    : bpm(bpm), realTime(realTime), sampleRate(22050), position(0), noise(0x12345678)
+{
+}
+
+bool SyntheticSource::begin(uint32_t rate)
+{
+    sampleRate = rate;
+    position = 0;
+    return true;
+}
+
+size_t SyntheticSource::read(int16_t* samples, size_t count)
+{
+    uint32_t beatSamples = static_cast<uint32_t>(sampleRate * 60.0f / bpm);
+    for (size_t i = 0; i < count; i++, position++) {
+        float t = static_cast<float>(position) / sampleRate;
+        // Tone sweeping 200 Hz - 3.2 kHz every 8 s
+        float sweep = 200.0f * powf(16.0f, fmodf(t, 8.0f) / 8.0f);
+        float value = 0.25f * sinf(2.0f * static_cast<float>(M_PI) * sweep * t);
+
+        // Decaying 55 Hz kick on every beat
+        uint32_t sinceBeat = position % beatSamples;
+        float kickT = static_cast<float>(sinceBeat) / sampleRate;
+        value += 0.6f * expf(-kickT * 18.0f) * sinf(2.0f * static_cast<float>(M_PI) * 55.0f * kickT);
+
+        noise = noise * 1664525u + 1013904223u;
+        value += 0.02f * (static_cast<int32_t>(noise >> 16) - 32768) / 32768.0f;
+
+        samples[i] = static_cast<int16_t>(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f);
+    }
+
+    if (realTime) {
+        uint32_t us = static_cast<uint32_t>(1000000ull * count / sampleRate);
+#if defined(ARDUINO)
+        delay(us / 1000);
+#else
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+#endif
+    }
+    return count;
+}
+
+WavFileSource::WavFileSource(const char* path, bool loop)
+    : loop(loop), file(nullptr), dataStart(0), channels(1), fileRate(0)
+{
+    strncpy(this->path, path, sizeof(this->path) - 1);
+    this->path[sizeof(this->path) - 1] = '\0';
+}
+
+WavFileSource::~WavFileSource()
+{
+    if (file) fclose(file);
+}
+
+bool WavFileSource::begin(uint32_t /*sampleRate*/)
+{
+    file = fopen(path, "rb");
+    if (!file) return false;
+
+    uint8_t header[12];
+    if (fread(header, 1, 12, file) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    // Walk chunks up to "data", reading the format on the way
+    uint8_t chunk[8];
+    uint16_t bits = 0;
+    while (fread(chunk, 1, 8, file) == 8) {
+        uint32_t length = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | (static_cast<uint32_t>(chunk[7]) << 24);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            if (length < 16 || fread(fmt, 1, 16, file) != 16) return false;
+            channels = fmt[2] | (fmt[3] << 8);
+            fileRate = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | (static_cast<uint32_t>(fmt[7]) << 24);
+            bits = fmt[14] | (fmt[15] << 8);
+            fseek(file, length - 16, SEEK_CUR);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            dataStart = ftell(file);
+            return bits == 16 && channels >= 1;
+        } else {
+            fseek(file, length, SEEK_CUR);
+        }
+    }
+    return false;
+}
+
+size_t WavFileSource::read(int16_t* samples, size_t count)
+{
+    if (!file) return 0;
+    size_t done = 0;
+    int16_t frame[8];
+    while (done < count) {
+        if (fread(frame, sizeof(int16_t), channels, file) != channels) {
+            if (!loop) break;
+            fseek(file, dataStart, SEEK_SET);
+            continue;
+        }
+        int32_t mix = 0;
+        for (uint16_t c = 0; c < channels && c < 8; c++) mix += frame[c];
+        samples[done++] = static_cast<int16_t>(mix / channels);
+    }
+    return done;
+}
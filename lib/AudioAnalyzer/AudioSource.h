@@ -0,0 +1,83 @@
+#ifndef AUDIOSOURCE_H
+#define AUDIOSOURCE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @brief Mono 16-bit sample provider feeding the AudioAnalyzer
+ */
+class AudioSource {
+public:
+    virtual ~AudioSource() = default;
+    virtual bool begin(uint32_t sampleRate) = 0;
+    // Blocks until count samples are read, returns the number actually read
+    virtual size_t read(int16_t* samples, size_t count) = 0;
+    virtual const char* name() const = 0;
+};
+
+#if defined(ARDUINO_ARCH_ESP32)
+/**
+ * @brief I2S MEMS microphone (INMP441, SPH0645...) on the legacy I2S driver
+ */
+class I2SMicSource : public AudioSource {
+public:
+    I2SMicSource(uint8_t bckPin, uint8_t wsPin, uint8_t dataPin, uint8_t port = 0);
+    ~I2SMicSource() override;
+    bool begin(uint32_t sampleRate) override;
+    size_t read(int16_t* samples, size_t count) override;
+    const char* name() const override { return "i2s"; }
+
+private:
+    uint8_t bckPin, wsPin, dataPin, port;
+    bool installed;
+    int32_t raw[64];
+};
+#endif
+
+/**
+ * @brief Test signal: a swept tone plus a kick drum pulse at a fixed tempo
+ *
+ * Paced in real time, so effects can be tuned without a microphone.
+ */
+class SyntheticSource : public AudioSource {
+public:
+    explicit SyntheticSource(float bpm = 120.0f, bool realTime = true);
+    bool begin(uint32_t sampleRate) override;
+    size_t read(int16_t* samples, size_t count) override;
+    const char* name() const override { return "synthetic"; }
+
+private:
+    float bpm;
+    bool realTime;
+    uint32_t sampleRate;
+    uint32_t position;
+    uint32_t noise;
+};
+
+/**
+ * @brief 16-bit PCM WAV file read through stdio, looped at the end
+ *
+ * stdio works on the host and, through the VFS, on "/spiffs/..." paths.
+ * Stereo files are mixed down; the sample rate of the file wins.
+ */
+class WavFileSource : public AudioSource {
+public:
+    explicit WavFileSource(const char* path, bool loop = true);
+    ~WavFileSource() override;
+    bool begin(uint32_t sampleRate) override;
+    size_t read(int16_t* samples, size_t count) override;
+    const char* name() const override { return "wav"; }
+    uint32_t getSampleRate() const { return fileRate; }
+
+private:
+    char path[64];
+    bool loop;
+    FILE* file;
+    long dataStart;
+    uint16_t channels;
+    uint32_t fileRate;
+};
+
+#endif // AUDIOSOURCE_H
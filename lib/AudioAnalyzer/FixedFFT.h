@@ -0,0 +1,42 @@
+#ifndef FIXEDFFT_H
+#define FIXEDFFT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FFT_MAX_SIZE 1024
+#define FFT_MAX_LOG2 10
+
+/**
+ * @brief Q15 radix-2 FFT with a Hann window
+ *
+ * In place, decimation in time. Every stage halves its outputs, so the
+ * result is the DFT divided by n and can never overflow int16. Twiddles
+ * come from one quarter-wave sine table sized for FFT_MAX_SIZE, shared by
+ * every size. No Arduino dependency, so it runs unchanged on the host.
+ */
+class FixedFFT {
+public:
+    explicit FixedFFT(size_t n = 512);
+
+    bool setSize(size_t n);
+    size_t size() const { return n; }
+
+    // re = window(samples), im = 0
+    void window(const int16_t* samples, int16_t* re, int16_t* im) const;
+    void transform(int16_t* re, int16_t* im) const;
+    // |X[k]|^2 for k in [0, n/2)
+    void power(const int16_t* re, const int16_t* im, uint32_t* out) const;
+
+    static int16_t sinQ15(uint32_t phase);   ///< phase in 1/FFT_MAX_SIZE turns
+    static int16_t cosQ15(uint32_t phase) { return sinQ15(phase + FFT_MAX_SIZE / 4); }
+
+private:
+    size_t n;
+    uint8_t log2n;
+    int16_t hann[FFT_MAX_SIZE / 2 + 1];   ///< Symmetric, first half only
+
+    static const int16_t SINE_TABLE[FFT_MAX_SIZE / 4 + 1];
+};
+
+#endif // FIXEDFFT_H
@@ -0,0 +1,188 @@
+#include "BootConfig.h"
+#include <SPIFFS.h>
+#include <Adafruit_NeoPixel.h>
+#include <ConfigStore.h>
+#include <GestureDetector.h>
+#include <InputRules.h>
+
+namespace {
+    const char* const BLOB_PATH = "/io.bin";
+    const char* const BLOB_TMP_PATH = "/io.bin.tmp";
+    const uint32_t BLOB_MAGIC = 0x424F4957; // "WIOB"
+    const size_t MAX_BOOT_IOS = 32;
+}
+
+BootConfig& BootConfig::getInstance()
+{
+    static BootConfig instance;
+    return instance;
+}
+
+BootConfig::BootConfig()
+    : listening(false),
+      fromBlob(false),
+      loadUs(0),
+      rebuilds(0)
+{
+}
+
+bool BootConfig::load()
+{
+    uint32_t start = micros();
+
+    if (!listening) {
+        listening = true;
+        ConfigStore::getInstance().onWrite([this](const char* name) {
+            if (strstr(name, ".json")) invalidate();
+        });
+    }
+
+    fromBlob = readBlob();
+    bool ok = fromBlob || rebuild();
+
+    loadUs = micros() - start;
+    Serial.printf("BootConfig: %u IO from %s in %lu us\n",
+                  static_cast<unsigned>(entries.size()), fromBlob ? "blob" : "json",
+                  static_cast<unsigned long>(loadUs));
+    return ok;
+}
+
+bool BootConfig::readBlob()
+{
+    if (!ConfigStore::getInstance().mount()) return false;
+
+    File file = SPIFFS.open(BLOB_PATH, FILE_READ);
+    if (!file) return false;
+
+    Header header;
+    bool valid = file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+                 header.magic == BLOB_MAGIC &&
+                 header.version == BOOT_CONFIG_VERSION &&
+                 header.recordSize == sizeof(PackedIO) &&
+                 header.count <= MAX_BOOT_IOS;
+    if (valid) {
+        entries.resize(header.count);
+        size_t bytes = header.count * sizeof(PackedIO);
+        valid = file.read(reinterpret_cast<uint8_t*>(entries.data()), bytes) == bytes;
+    }
+    file.close();
+
+    if (!valid) {
+        Serial.println("BootConfig: stale or corrupt blob, rebuilding");
+        entries.clear();
+    }
+    return valid;
+}
+
+bool BootConfig::writeBlob()
+{
+    File file = SPIFFS.open(BLOB_TMP_PATH, FILE_WRITE);
+    if (!file) {
+        Serial.println("BootConfig: cannot write blob");
+        return false;
+    }
+
+    Header header = { BLOB_MAGIC, BOOT_CONFIG_VERSION, sizeof(PackedIO),
+                      static_cast<uint16_t>(entries.size()) };
+    size_t bytes = entries.size() * sizeof(PackedIO);
+    bool ok = file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+              file.write(reinterpret_cast<const uint8_t*>(entries.data()), bytes) == bytes;
+    file.close();
+
+    if (!ok) {
+        SPIFFS.remove(BLOB_TMP_PATH);
+        return false;
+    }
+    SPIFFS.remove(BLOB_PATH);
+    return SPIFFS.rename(BLOB_TMP_PATH, BLOB_PATH);
+}
+
+// Parses config.json and every <UID>.json it lists, then packs the result
+bool BootConfig::rebuild()
+{
+    ConfigStore& store = ConfigStore::getInstance();
+    entries.clear();
+
+    std::vector<String> uids;
+    store.view("config.json", [&uids](JsonVariantConst config) {
+        JsonArrayConst ioIndex = config["ioIndex"];
+        if (ioIndex.isNull()) {
+            Serial.println("🛑 ioIndex n'est pas un tableau !");
+            return;
+        }
+        for (JsonObjectConst io : ioIndex) {
+            const char* uid = io["UID"];
+            if (uid) uids.push_back(uid);
+        }
+    });
+
+    for (const String& uid : uids) {
+        if (entries.size() >= MAX_BOOT_IOS) break;
+        PackedIO packed;
+        bool found = store.view((uid + ".json").c_str(), [&](JsonVariantConst io) {
+            if (packIO(io, packed)) entries.push_back(packed);
+        });
+        if (!found) {
+            Serial.println("🛑 Pas de config pour " + uid);
+        }
+    }
+
+    rebuilds++;
+    return writeBlob();
+}
+
+bool BootConfig::packIO(JsonVariantConst io, PackedIO& out)
+{
+    memset(&out, 0, sizeof(out));
+    const char* uid = io["UID"];
+    const char* type = io["type"];
+    if (!uid || !type) return false;
+    strlcpy(out.uid, uid, sizeof(out.uid));
+
+    if (strcmp(type, "ledstrip") == 0) {
+        if (!io["ledCount"].is<uint16_t>() || !io["pin"].is<uint8_t>()) return false;
+        out.kind = PACKED_IO_LEDSTRIP;
+        out.ledCount = io["ledCount"];
+        out.pin = io["pin"];
+        out.ledType = ledTypeFromString(io["ledType"] | "");
+        if (!io["matrix"].isNull()) out.flags |= PACKED_IO_HAS_LAYOUT;
+        if (!io["map"].isNull()) out.flags |= PACKED_IO_HAS_MAP;
+        return out.ledType > 0 && out.ledCount > 0;
+    }
+    if (strcmp(type, "btn") == 0) {
+        GestureTiming defaults;
+        out.kind = PACKED_IO_BUTTON;
+        out.pin = io["pin"] | 0;
+        out.flags = (io["activeLow"] | false) ? PACKED_IO_ACTIVE_LOW : 0;
+        if (InputRules::hasRules(io)) out.flags |= PACKED_IO_HAS_RULES;
+        out.debounceMs = io["debounce"] | defaults.debounceMs;
+        out.doubleClickMs = io["doubleClick"] | defaults.doubleClickMs;
+        out.longPressMs = io["longPress"] | defaults.longPressMs;
+        return true;
+    }
+    return false;
+}
+
+uint16_t BootConfig::ledTypeFromString(const char* typeStr)
+{
+    if (strcmp(typeStr, "NEO_GRB + NEO_KHZ800") == 0) return NEO_GRB | NEO_KHZ800;
+    if (strcmp(typeStr, "NEO_GRB") == 0) return NEO_GRB;
+    if (strcmp(typeStr, "NEO_KHZ800") == 0) return NEO_KHZ800;
+    return 0; // inconnu
+}
+
+void BootConfig::invalidate()
+{
+    if (SPIFFS.exists(BLOB_PATH)) {
+        SPIFFS.remove(BLOB_PATH);
+        Serial.println("BootConfig: blob invalidated");
+    }
+}
+
+void BootConfig::getStats(JsonObject& out)
+{
+    out["source"] = fromBlob ? "blob" : "json";
+    out["ios"] = entries.size();
+    out["loadUs"] = loadUs;
+    out["rebuilds"] = rebuilds;
+}
@@ -0,0 +1,90 @@
+#ifndef BOOTCONFIG_H
+#define BOOTCONFIG_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+
+#define BOOT_CONFIG_VERSION 5
+#define MAX_IO_UID_LEN 24
+
+enum PackedIOKind : uint8_t {
+    PACKED_IO_LEDSTRIP = 1,
+    PACKED_IO_BUTTON = 2
+};
+
+enum PackedIOFlags : uint8_t {
+    PACKED_IO_ACTIVE_LOW = 1 << 0,
+    PACKED_IO_HAS_RULES = 1 << 1,   ///< <UID>.json holds onPress/onClick/... rules
+    PACKED_IO_HAS_LAYOUT = 1 << 2,  ///< <UID>.json holds a "matrix" layout
+    PACKED_IO_HAS_MAP = 1 << 3      ///< <UID>.json holds a "map" of the LED order
+};
+
+/**
+ * @brief One IO of the boot configuration, already resolved
+ */
+struct PackedIO {
+    uint8_t kind;              ///< PackedIOKind
+    uint8_t pin;
+    uint8_t flags;             ///< PackedIOFlags
+    uint8_t reserved;
+    uint16_t ledCount;
+    uint16_t ledType;          ///< neoPixelType
+    uint16_t debounceMs;       ///< Buttons only
+    uint16_t doubleClickMs;
+    uint16_t longPressMs;
+    char uid[MAX_IO_UID_LEN];
+};
+
+/**
+ * @brief Packed IO table read at boot in a single file read
+ *
+ * config.json and the <UID>.json files it indexes are compiled once into
+ * "/io.bin", a header followed by fixed size PackedIO records. Boot reads
+ * that blob for the IO table; config.json and the <UID>.json files are
+ * parsed again when the blob is missing or stale. Any write to a .json file
+ * through ConfigStore deletes the blob, and a filesystem upload replaces it,
+ * so the next boot regenerates it.
+ *
+ * Button rules, pixel maps and matrix layouts are variable sized and stay in
+ * <UID>.json. The blob only flags the IOs that have them, so boot parses
+ * <UID>.json for those IOs alone. BootProfile counts these reads and their
+ * time under "boot" in /stats.
+ */
+class BootConfig {
+public:
+    static BootConfig& getInstance();
+
+    bool load();
+    bool rebuild();
+    void invalidate();
+
+    const std::vector<PackedIO>& getEntries() const { return entries; }
+    void getStats(JsonObject& out);
+
+    static uint16_t ledTypeFromString(const char* typeStr);
+
+private:
+    BootConfig();
+    BootConfig(const BootConfig&) = delete;
+    BootConfig& operator=(const BootConfig&) = delete;
+
+    struct Header {
+        uint32_t magic;
+        uint8_t version;
+        uint8_t recordSize;
+        uint16_t count;
+    };
+
+    std::vector<PackedIO> entries;
+    bool listening;
+    bool fromBlob;
+    uint32_t loadUs;
+    uint32_t rebuilds;
+
+    bool readBlob();
+    bool writeBlob();
+    static bool packIO(JsonVariantConst io, PackedIO& out);
+};
+
+#endif // BOOTCONFIG_H
@@ -0,0 +1,90 @@
+#include "BootProfile.h"
+#include <esp_timer.h>
+#include <algorithm>
+
+namespace {
+    int64_t phaseTimes[BOOT_PHASE_COUNT] = {0};
+    uint32_t jsonReads = 0;
+    uint32_t jsonReadUs = 0;
+
+    const char* const PHASE_NAMES[BOOT_PHASE_COUNT] = {
+        "fsMount",
+        "configParse",
+        "outputInit",
+        "firstFrame",
+        "wifiConnect"
+    };
+}
+
+void BootProfile::mark(BootPhase phase)
+{
+    if (phase >= BOOT_PHASE_COUNT || phaseTimes[phase] != 0) return;
+    phaseTimes[phase] = esp_timer_get_time();
+    Serial.printf("[BOOT] %-12s %6lu ms\n", PHASE_NAMES[phase],
+                  static_cast<unsigned long>(phaseTimes[phase] / 1000));
+}
+
+bool BootProfile::reached(BootPhase phase)
+{
+    return phase < BOOT_PHASE_COUNT && phaseTimes[phase] != 0;
+}
+
+uint32_t BootProfile::elapsedMs(BootPhase phase)
+{
+    return reached(phase) ? static_cast<uint32_t>(phaseTimes[phase] / 1000) : 0;
+}
+
+const char* BootProfile::phaseName(BootPhase phase)
+{
+    return phase < BOOT_PHASE_COUNT ? PHASE_NAMES[phase] : "unknown";
+}
+
+void BootProfile::countJsonRead(uint32_t us)
+{
+    jsonReads++;
+    jsonReadUs += us;
+}
+
+// In the order the phases were reached, so every delta is from the phase
+// just before it; phases not reached yet come last
+void BootProfile::report()
+{
+    Serial.println("[BOOT] Phase timings:");
+    int order[BOOT_PHASE_COUNT];
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order, order + BOOT_PHASE_COUNT, [](int a, int b) {
+        if (!phaseTimes[a] || !phaseTimes[b]) return phaseTimes[a] && !phaseTimes[b];
+        return phaseTimes[a] < phaseTimes[b];
+    });
+
+    int64_t previous = 0;
+    for (int i : order) {
+        if (!phaseTimes[i]) {
+            Serial.printf("[BOOT]   %-12s pending\n", PHASE_NAMES[i]);
+            continue;
+        }
+        Serial.printf("[BOOT]   %-12s %6lu ms (+%lu)\n", PHASE_NAMES[i],
+                      static_cast<unsigned long>(phaseTimes[i] / 1000),
+                      static_cast<unsigned long>((phaseTimes[i] - previous) / 1000));
+        previous = phaseTimes[i];
+    }
+    if (jsonReads) {
+        Serial.printf("[BOOT]   %u JSON reads outside the IO blob, %lu us\n",
+                      static_cast<unsigned>(jsonReads), static_cast<unsigned long>(jsonReadUs));
+    }
+}
+
+void BootProfile::getStats(JsonObject& out)
+{
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if (phaseTimes[i]) {
+            out[PHASE_NAMES[i]] = static_cast<uint32_t>(phaseTimes[i] / 1000);
+        } else {
+            out[PHASE_NAMES[i]] = nullptr;
+        }
+    }
+    out["jsonReads"] = jsonReads;
+    out["jsonReadUs"] = jsonReadUs;
+}
@@ -0,0 +1,34 @@
+#ifndef BOOTPROFILE_H
+#define BOOTPROFILE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+enum BootPhase {
+    BOOT_FS_MOUNT,
+    BOOT_CONFIG_PARSE,
+    BOOT_OUTPUT_INIT,
+    BOOT_FIRST_FRAME,      ///< First frame rendered after the boot scene was restored
+    BOOT_WIFI_CONNECT,
+    BOOT_PHASE_COUNT
+};
+
+/**
+ * @brief Boot phase timestamps, in microseconds since the esp_timer started
+ *
+ * The timer starts right after the second stage bootloader, so ROM and
+ * bootloader time (~30-60 ms) is not included. Each phase is recorded the
+ * first time it is marked; later marks are ignored. JSON files still parsed
+ * at boot, outside the IO blob, are counted with the time they took.
+ */
+namespace BootProfile {
+    void mark(BootPhase phase);
+    bool reached(BootPhase phase);
+    uint32_t elapsedMs(BootPhase phase);
+    const char* phaseName(BootPhase phase);
+    void countJsonRead(uint32_t us);
+    void report();
+    void getStats(JsonObject& out);
+}
+
+#endif // BOOTPROFILE_H
@@ -0,0 +1,411 @@
+#include "CommandScheduler.h"
+#include <Telemetry.h>
+#include <HeapStats.h>
+
+CommandScheduler::CommandScheduler(Output* output, const String& name)
+    : output(output),
+      name(name),
+      count(0),
+      textUsed(0),
+      nextSequence(0),
+      queueMutex(nullptr),
+      workerHandle(nullptr),
+      running(false),
+      executing(false),
+      frameBudgetUs(DEFAULT_FRAME_BUDGET_US),
+      frameIntervalMs(DEFAULT_FRAME_INTERVAL_MS)
+{
+    queueMutex = xSemaphoreCreateMutex();
+
+    maxAgeMs[PRIORITY_LOW] = DEFAULT_LOW_MAX_AGE_MS;
+    maxAgeMs[PRIORITY_NORMAL] = DEFAULT_COMMAND_TIMEOUT;
+    maxAgeMs[PRIORITY_HIGH] = 0;
+    maxAgeMs[PRIORITY_SAFETY] = 0;
+
+    resetStats();
+}
+
+CommandScheduler::~CommandScheduler()
+{
+    end();
+    if (queueMutex) {
+        vSemaphoreDelete(queueMutex);
+        queueMutex = nullptr;
+    }
+}
+
+bool CommandScheduler::begin()
+{
+    if (running) return true;
+    if (!queueMutex || !output) {
+        Serial.println("ERROR: CommandScheduler cannot start without output or mutex");
+        return false;
+    }
+
+    running = true;
+    BaseType_t result = xTaskCreatePinnedToCore(
+        workerTask,
+        "CmdSched",
+        6144,
+        this,
+        1,
+        &workerHandle,
+        1);
+
+    if (result != pdPASS) {
+        Serial.println("ERROR: Failed to create CommandScheduler task");
+        running = false;
+        workerHandle = nullptr;
+        return false;
+    }
+    Serial.printf("CommandScheduler started for %s\n", name.c_str());
+    return true;
+}
+
+void CommandScheduler::end()
+{
+    if (running) {
+        running = false;
+        if (workerHandle) {
+            xTaskNotifyGive(workerHandle);
+            // Wait for the worker to self-terminate
+            while (workerHandle != nullptr) vTaskDelay(1);
+        }
+    }
+
+    if (queueMutex && xSemaphoreTake(queueMutex, portMAX_DELAY)) {
+        while (count > 0) {
+            removeAt(count - 1);
+        }
+        xSemaphoreGive(queueMutex);
+    }
+}
+
+CommandPriority CommandScheduler::classify(JsonObject& command)
+{
+    if (command.containsKey("priority")) {
+        JsonVariant p = command["priority"];
+        if (p.is<int>()) {
+            int value = p.as<int>();
+            return static_cast<CommandPriority>(std::max(0, std::min(value, PRIORITY_CLASS_COUNT - 1)));
+        }
+        String level = p.as<String>();
+        level.toLowerCase();
+        if (level == "safety") return PRIORITY_SAFETY;
+        if (level == "high") return PRIORITY_HIGH;
+        if (level == "low") return PRIORITY_LOW;
+        return PRIORITY_NORMAL;
+    }
+
+    // Same test as the parser: {"blackout": false} is not a blackout
+    if (command["blackout"].as<bool>()) {
+        return PRIORITY_SAFETY;
+    }
+    if (command.containsKey("animation")) {
+        return PRIORITY_HIGH;
+    }
+
+    // A lone effect block without a type only tweaks parameters of the running effect
+    if (command.containsKey("effect") && !command["effect"].containsKey("type")) {
+        for (JsonPair kv : command) {
+            const char* key = kv.key().c_str();
+            if (strcmp(key, "effect") != 0 && strcmp(key, "target") != 0) {
+                return PRIORITY_NORMAL;
+            }
+        }
+        return PRIORITY_LOW;
+    }
+    return PRIORITY_NORMAL;
+}
+
+const char* CommandScheduler::priorityName(uint32_t priority)
+{
+    switch (priority) {
+        case PRIORITY_LOW: return "low";
+        case PRIORITY_NORMAL: return "normal";
+        case PRIORITY_HIGH: return "high";
+        case PRIORITY_SAFETY: return "safety";
+        default: return "unknown";
+    }
+}
+
+bool CommandScheduler::enqueue(JsonObject& command)
+{
+    return enqueue(command, classify(command));
+}
+
+bool CommandScheduler::enqueue(JsonObject& command, CommandPriority priority, bool armProbe)
+{
+    if (!queueMutex) return false;
+
+    // Measured before the lock, a command that cannot fit must not evict anything
+    size_t length = measureJson(command);
+    if (length >= MAX_JSON_SIZE) {
+        Serial.printf("WARNING: CommandScheduler command of %u bytes exceeds the %u byte limit, rejected\n",
+                      static_cast<unsigned>(length), static_cast<unsigned>(MAX_JSON_SIZE));
+        busyRejected[priority].fetch_add(1, std::memory_order_relaxed);
+        Telemetry::getInstance().record(TELEMETRY_ERROR, output->telemetrySource, TELEMETRY_ERR_QUEUE_REJECTED, priority);
+        return false;
+    }
+
+    if (!xSemaphoreTake(queueMutex, pdMS_TO_TICKS(50))) {
+        Serial.println("WARNING: CommandScheduler queue busy, command rejected");
+        busyRejected[priority].fetch_add(1, std::memory_order_relaxed);
+        Telemetry::getInstance().record(TELEMETRY_ERROR, output->telemetrySource, TELEMETRY_ERR_QUEUE_REJECTED, priority);
+        return false;
+    }
+
+    // Safety commands pre-empt everything queued below them
+    if (priority == PRIORITY_SAFETY) {
+        flushBelow(PRIORITY_SAFETY);
+    }
+
+    // Out of entries or text space: lower priority commands make room, or
+    // nothing is evicted and this one is refused
+    size_t lower = bytesBelow(priority);
+    bool noEntry = count >= MAX_QUEUE_SIZE && lower == 0;
+    if (noEntry || textUsed - lower + length > MAX_QUEUED_JSON_BYTES) {
+        stats[priority].rejected++;
+        xSemaphoreGive(queueMutex);
+        Telemetry::getInstance().record(TELEMETRY_ERROR, output->telemetrySource, TELEMETRY_ERR_QUEUE_REJECTED, priority);
+        return false;
+    }
+    while (count >= MAX_QUEUE_SIZE || textUsed + length > MAX_QUEUED_JSON_BYTES) {
+        int victim = findLowestPriority();
+        stats[queue[victim].priority].preempted++;
+        removeAt(victim);
+    }
+
+    // The router buffer does not outlive this call, the text is copied in
+    QueuedCommand& entry = queue[count++];
+    entry.offset = static_cast<uint16_t>(textUsed);
+    entry.length = static_cast<uint16_t>(serializeJson(command, text + textUsed, MAX_QUEUED_JSON_BYTES - textUsed));
+    textUsed += entry.length;
+    entry.priority = priority;
+    entry.queueTime = millis();
+    entry.sequence = nextSequence++;
+    stats[priority].enqueued++;
+    // Under the lock, so the worker cannot run the command before it is tagged
+    if (armProbe) {
+        output->probeSequence = entry.sequence;
+    }
+
+    xSemaphoreGive(queueMutex);
+
+    if (workerHandle) {
+        xTaskNotifyGive(workerHandle);
+    }
+    return true;
+}
+
+void CommandScheduler::setFrameBudget(uint32_t budgetUs, uint32_t frameIntervalMs)
+{
+    this->frameBudgetUs = std::max(500U, budgetUs);
+    this->frameIntervalMs = std::max(1U, frameIntervalMs);
+}
+
+void CommandScheduler::setMaxAge(CommandPriority priority, uint32_t maxAgeMs)
+{
+    if (priority < PRIORITY_CLASS_COUNT) {
+        this->maxAgeMs[priority] = maxAgeMs;
+    }
+}
+
+size_t CommandScheduler::pendingCount()
+{
+    size_t pending = 0;
+    if (xSemaphoreTake(queueMutex, pdMS_TO_TICKS(10))) {
+        pending = count;
+        xSemaphoreGive(queueMutex);
+    }
+    return pending;
+}
+
+// Nothing queued and the worker between commands
+bool CommandScheduler::isIdle()
+{
+    bool idle = false;
+    if (xSemaphoreTake(queueMutex, pdMS_TO_TICKS(10))) {
+        idle = count == 0 && !executing;
+        xSemaphoreGive(queueMutex);
+    }
+    return idle;
+}
+
+void CommandScheduler::getStats(JsonObject& out)
+{
+    if (!xSemaphoreTake(queueMutex, pdMS_TO_TICKS(50))) return;
+
+    out["pending"] = count;
+    out["capacity"] = MAX_QUEUE_SIZE;
+    for (uint32_t p = 0; p < PRIORITY_CLASS_COUNT; p++) {
+        const PriorityClassStats& s = stats[p];
+        JsonObject cls = out.createNestedObject(priorityName(p));
+        cls["enqueued"] = s.enqueued;
+        cls["executed"] = s.executed;
+        cls["droppedStale"] = s.droppedStale;
+        cls["preempted"] = s.preempted;
+        cls["rejected"] = s.rejected + busyRejected[p].load(std::memory_order_relaxed);
+        cls["avgWaitMs"] = s.executed ? static_cast<float>(s.totalWaitMs) / s.executed : 0.0f;
+        cls["maxWaitMs"] = s.maxWaitMs;
+    }
+
+    xSemaphoreGive(queueMutex);
+}
+
+void CommandScheduler::resetStats()
+{
+    if (queueMutex && xSemaphoreTake(queueMutex, portMAX_DELAY)) {
+        memset(stats, 0, sizeof(stats));
+        xSemaphoreGive(queueMutex);
+    }
+    for (std::atomic<uint32_t>& rejected : busyRejected) {
+        rejected.store(0, std::memory_order_relaxed);
+    }
+}
+
+void CommandScheduler::workerTask(void* parameter)
+{
+    CommandScheduler* scheduler = static_cast<CommandScheduler*>(parameter);
+    HeapStats::tagTask(ALLOC_COMMAND);
+    scheduler->workerLoop();
+    HeapStats::untagTask();
+    scheduler->workerHandle = nullptr;
+    vTaskDelete(NULL);
+}
+
+void CommandScheduler::workerLoop()
+{
+    while (running) {
+        // Sleep until a command is queued
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+
+        uint32_t budgetStart = micros();
+        QueuedCommand command;
+        while (running && popNext(command)) {
+            execute(command);
+            executing = false;
+
+            // Budget spent: give the render task a frame before draining more
+            if (micros() - budgetStart >= frameBudgetUs) {
+                vTaskDelay(pdMS_TO_TICKS(frameIntervalMs));
+                budgetStart = micros();
+            }
+        }
+    }
+}
+
+bool CommandScheduler::popNext(QueuedCommand& out)
+{
+    if (!xSemaphoreTake(queueMutex, portMAX_DELAY)) return false;
+
+    uint32_t now = millis();
+    int best = -1;
+    size_t i = 0;
+    while (i < count) {
+        QueuedCommand& cmd = queue[i];
+        uint32_t maxAge = maxAgeMs[cmd.priority];
+        if (maxAge > 0 && now - cmd.queueTime > maxAge) {
+            stats[cmd.priority].droppedStale++;
+            Telemetry::getInstance().record(TELEMETRY_ERROR, output->telemetrySource, TELEMETRY_ERR_COMMAND_STALE, cmd.priority);
+            removeAt(i);
+            continue;
+        }
+        if (best < 0 ||
+            cmd.priority > queue[best].priority ||
+            (cmd.priority == queue[best].priority && cmd.sequence < queue[best].sequence)) {
+            best = static_cast<int>(i);
+        }
+        i++;
+    }
+
+    bool found = best >= 0;
+    if (found) {
+        out = queue[best];
+        executing = true;
+        // Parsed before its text is reclaimed, the document keeps its own copy
+        if (deserializeJson(commandDoc, text + out.offset, out.length)) {
+            commandDoc.clear();
+        }
+        removeAt(static_cast<size_t>(best));
+    }
+
+    xSemaphoreGive(queueMutex);
+    return found;
+}
+
+int CommandScheduler::findLowestPriority()
+{
+    int lowest = -1;
+    for (size_t i = 0; i < count; i++) {
+        if (lowest < 0 ||
+            queue[i].priority < queue[lowest].priority ||
+            (queue[i].priority == queue[lowest].priority && queue[i].sequence < queue[lowest].sequence)) {
+            lowest = static_cast<int>(i);
+        }
+    }
+    return lowest;
+}
+
+// Text bytes the commands below priority hold, what evicting them would free
+size_t CommandScheduler::bytesBelow(uint32_t priority)
+{
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (queue[i].priority < priority) bytes += queue[i].length;
+    }
+    return bytes;
+}
+
+// Moves the text queued after the command down over it, at most a few
+// kilobytes, so free text space is always in one piece
+void CommandScheduler::removeAt(size_t index)
+{
+    if (index >= count) return;
+    uint16_t offset = queue[index].offset;
+    uint16_t length = queue[index].length;
+    memmove(text + offset, text + offset + length, textUsed - offset - length);
+    textUsed -= length;
+    for (size_t i = 0; i < count; i++) {
+        if (queue[i].offset > offset) queue[i].offset -= length;
+    }
+    queue[index] = queue[count - 1];
+    count--;
+}
+
+void CommandScheduler::flushBelow(uint32_t priority)
+{
+    size_t i = 0;
+    while (i < count) {
+        if (queue[i].priority < priority) {
+            stats[queue[i].priority].preempted++;
+            removeAt(i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void CommandScheduler::execute(QueuedCommand& command)
+{
+    uint32_t waited = millis() - command.queueTime;
+
+    // Parsed by popNext, left empty if the text was not valid
+    if (commandDoc.is<JsonObject>()) {
+        JsonObject json = commandDoc.as<JsonObject>();
+        output->jsonInterpreter(json);
+    }
+
+    // Other commands may run while the probe waits, only its own completes it
+    if (output->probeStartUs && command.sequence == output->probeSequence) {
+        output->probeApplied = true;
+    }
+
+    if (xSemaphoreTake(queueMutex, portMAX_DELAY)) {
+        PriorityClassStats& s = stats[command.priority];
+        s.executed++;
+        s.totalWaitMs += waited;
+        s.maxWaitMs = std::max(s.maxWaitMs, waited);
+        xSemaphoreGive(queueMutex);
+    }
+}
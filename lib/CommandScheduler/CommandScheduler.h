@@ -0,0 +1,103 @@
+#ifndef COMMAND_SCHEDULER_H
+#define COMMAND_SCHEDULER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <utils.h>
+#include <output.h>
+#include <atomic>
+
+/**
+ * @brief Per priority class queue metrics
+ */
+struct PriorityClassStats {
+    uint32_t enqueued;      ///< Commands accepted into the queue
+    uint32_t executed;      ///< Commands handed to the output
+    uint32_t droppedStale;  ///< Commands dropped because they exceeded their max age
+    uint32_t preempted;     ///< Commands flushed by a higher priority command
+    uint32_t rejected;      ///< Commands refused because the queue was full
+    uint64_t totalWaitMs;   ///< Sum of queue wait time of executed commands
+    uint32_t maxWaitMs;     ///< Worst queue wait time of executed commands
+};
+
+/**
+ * @brief Bounded priority queue and worker task in front of an Output
+ *
+ * Commands coming from the router are serialized back to back into a text
+ * buffer of MAX_QUEUED_JSON_BYTES, allocated with the scheduler, and parsed
+ * back by a dedicated task that executes them highest priority first. A
+ * removed command's bytes are reclaimed at once by moving the text queued
+ * after it down, so the buffer holds many small commands or a few large
+ * ones. Queueing never touches the heap; commands over MAX_JSON_SIZE are
+ * rejected, and when the buffer is full lower priority commands are evicted
+ * as when the queue is. Safety commands flush pending lower priority commands, stale low
+ * priority commands are dropped, and the worker never spends more than the
+ * frame budget before yielding a frame to the render task.
+ */
+class CommandScheduler {
+public:
+    CommandScheduler(Output* output, const String& name);
+    ~CommandScheduler();
+
+    bool begin();
+    void end();
+
+    bool enqueue(JsonObject& command);
+    // armProbe tags the output's latency probe with this command
+    bool enqueue(JsonObject& command, CommandPriority priority, bool armProbe = false);
+    static CommandPriority classify(JsonObject& command);
+    static const char* priorityName(uint32_t priority);
+
+    void setFrameBudget(uint32_t budgetUs, uint32_t frameIntervalMs);
+    void setMaxAge(CommandPriority priority, uint32_t maxAgeMs);
+    size_t pendingCount();
+    bool isIdle();
+    void getStats(JsonObject& out);
+    void resetStats();
+    const String& getName() const { return name; }
+    Output* getOutput() const { return output; }
+
+    // Defaults
+    static constexpr uint32_t DEFAULT_FRAME_BUDGET_US = 4000;
+    static constexpr uint32_t DEFAULT_FRAME_INTERVAL_MS = 16;
+    static constexpr uint32_t DEFAULT_LOW_MAX_AGE_MS = 250;
+    // Router callback cooldown: the router parks calls made inside it and
+    // keeps only the latest, which could drop a blackout followed by a tweak.
+    // The queue does the rate limiting instead, by priority.
+    static constexpr unsigned long ROUTER_COOLDOWN_MS = 0;
+
+private:
+    Output* output;
+    String name;
+
+    QueuedCommand queue[MAX_QUEUE_SIZE];
+    size_t count;
+    char text[MAX_QUEUED_JSON_BYTES]; ///< Queued command text, in queue order of arrival
+    size_t textUsed;                  ///< Guarded by queueMutex
+    JsonDocument commandDoc;          ///< Worker only, the command being executed
+    uint32_t nextSequence;
+    SemaphoreHandle_t queueMutex;
+
+    TaskHandle_t workerHandle;
+    volatile bool running;
+    volatile bool executing;          ///< Set with the pop, under queueMutex, cleared once executed
+    uint32_t frameBudgetUs;
+    uint32_t frameIntervalMs;
+    uint32_t maxAgeMs[PRIORITY_CLASS_COUNT];   ///< 0 = never stale
+    PriorityClassStats stats[PRIORITY_CLASS_COUNT];             ///< Guarded by queueMutex
+    std::atomic<uint32_t> busyRejected[PRIORITY_CLASS_COUNT];   ///< Rejected without the lock, added to rejected
+
+    static void workerTask(void* parameter);
+    void workerLoop();
+    bool popNext(QueuedCommand& out);
+    int findLowestPriority();
+    size_t bytesBelow(uint32_t priority);
+    void removeAt(size_t index);
+    void flushBelow(uint32_t priority);
+    void execute(QueuedCommand& command);
+};
+
+#endif // COMMAND_SCHEDULER_H
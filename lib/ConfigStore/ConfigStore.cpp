@@ -0,0 +1,311 @@
+#include "ConfigStore.h"
+#include <FS.h>
+#include <SPIFFS.h>
+
+ConfigStore& ConfigStore::getInstance()
+{
+    static ConfigStore instance;
+    return instance;
+}
+
+ConfigStore::ConfigStore()
+    : storeMutex(nullptr),
+      flushTaskHandle(nullptr),
+      mounted(false),
+      writeDelayMs(DEFAULT_WRITE_DELAY_MS)
+{
+    memset(&stats, 0, sizeof(stats));
+    storeMutex = xSemaphoreCreateMutex();
+}
+
+bool ConfigStore::mount()
+{
+    if (mounted) return true;
+    if (!SPIFFS.begin(true)) {
+        Serial.println("SPIFFS Mount Failed");
+        return false;
+    }
+    stats.mounts++;
+    mounted = true;
+    Serial.println("SPIFFS Ready !");
+    return true;
+}
+
+String ConfigStore::pathFor(const char* name)
+{
+    // SPIFFS wants absolute paths
+    return name[0] == '/' ? String(name) : String("/") + name;
+}
+
+// Finish or roll back a commit interrupted between remove and rename
+void ConfigStore::recover(const String& path)
+{
+    String tmpPath = path + ".tmp";
+    if (!SPIFFS.exists(tmpPath)) return;
+
+    if (SPIFFS.exists(path)) {
+        // Crashed while writing the temp file: the original is intact
+        SPIFFS.remove(tmpPath);
+    } else {
+        // Crashed after removing the original: the temp file is complete
+        SPIFFS.rename(tmpPath, path);
+        Serial.printf("ConfigStore recovered %s\n", path.c_str());
+    }
+}
+
+// Caller holds the store mutex
+ConfigStore::Entry& ConfigStore::load(const char* name)
+{
+    String key(name);
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        stats.cacheHits++;
+        return it->second;
+    }
+
+    stats.cacheMisses++;
+    Entry& entry = cache[key];
+    entry.doc = nullptr;
+    entry.dirty = false;
+    entry.lastWrite = 0;
+    entry.failures = 0;
+
+    if (!mount()) return entry;
+
+    String path = pathFor(name);
+    recover(path);
+
+    File file = SPIFFS.open(path, FILE_READ);
+    if (!file) {
+        // Remember the miss as well, so absent files are not probed again
+        Serial.printf("ConfigStore: %s not found\n", path.c_str());
+        return entry;
+    }
+
+    stats.flashReads++;
+    entry.doc = new DynamicJsonDocument(std::max<size_t>(1024, file.size() * 2));
+    DeserializationError error = deserializeJson(*entry.doc, file);
+    file.close();
+    if (error) {
+        Serial.print("Erreur de désérialisation : ");
+        Serial.println(error.f_str());
+        entry.doc->clear();
+    }
+    return entry;
+}
+
+bool ConfigStore::read(const char* name, JsonDocument& out)
+{
+    if (!xSemaphoreTake(storeMutex, portMAX_DELAY)) return false;
+    Entry& entry = load(name);
+    bool found = entry.doc != nullptr;
+    if (found) {
+        out.set(*entry.doc);
+    }
+    xSemaphoreGive(storeMutex);
+    return found;
+}
+
+String ConfigStore::readString(const char* name, const char* key, const char* fallback)
+{
+    String value(fallback);
+    if (!xSemaphoreTake(storeMutex, portMAX_DELAY)) return value;
+    Entry& entry = load(name);
+    if (entry.doc && entry.doc->containsKey(key)) {
+        value = (*entry.doc)[key].as<String>();
+    }
+    xSemaphoreGive(storeMutex);
+    return value;
+}
+
+bool ConfigStore::exists(const char* name)
+{
+    if (!xSemaphoreTake(storeMutex, portMAX_DELAY)) return false;
+    bool found = load(name).doc != nullptr;
+    xSemaphoreGive(storeMutex);
+    return found;
+}
+
+bool ConfigStore::view(const char* name, std::function<void(JsonVariantConst)> fn)
+{
+    if (!xSemaphoreTake(storeMutex, portMAX_DELAY)) return false;
+    Entry& entry = load(name);
+    bool found = entry.doc != nullptr;
+    if (found) {
+        fn(entry.doc->as<JsonVariantConst>());
+    }
+    xSemaphoreGive(storeMutex);
+    return found;
+}
+
+void ConfigStore::onWrite(std::function<void(const char* name)> listener)
+{
+    writeListeners.push_back(listener);
+}
+
+void ConfigStore::write(const char* name, const JsonDocument& body)
+{
+    if (!xSemaphoreTake(storeMutex, portMAX_DELAY)) return;
+
+    String key(name);
+    Entry& entry = cache[key];
+    if (!entry.doc) {
+        entry.doc = new DynamicJsonDocument(std::max<size_t>(1024, measureJson(body) * 2));
+    }
+    entry.doc->set(body);
+    if (entry.dirty) {
+        stats.coalescedWrites++;
+    }
+    entry.dirty = true;
+    entry.lastWrite = millis();
+
+    xSemaphoreGive(storeMutex);
+
+    for (auto& listener : writeListeners) {
+        listener(name);
+    }
+
+    startFlushTask();
+    xTaskNotifyGive(flushTaskHandle);
+}
+
+// Caller holds the store mutex
+bool ConfigStore::commit(const String& name, Entry& entry)
+{
+    if (!entry.doc) return false;
+    if (!mount()) {
+        stats.failedWrites++;
+        return false;
+    }
+
+    String path = pathFor(name.c_str());
+    String tmpPath = path + ".tmp";
+
+    File file = SPIFFS.open(tmpPath, FILE_WRITE);
+    if (!file) {
+        stats.failedWrites++;
+        Serial.println("Erreur d'ouverture de fichier !");
+        return false;
+    }
+    // Serialized straight into the file, no intermediate String
+    size_t written = serializeJson(*entry.doc, file);
+    file.close();
+
+    if (written == 0) {
+        SPIFFS.remove(tmpPath);
+        stats.failedWrites++;
+        return false;
+    }
+
+    // SPIFFS cannot rename over an existing file; recover() covers a crash in between
+    SPIFFS.remove(path);
+    if (!SPIFFS.rename(tmpPath, path)) {
+        stats.failedWrites++;
+        Serial.printf("ConfigStore: rename to %s failed\n", path.c_str());
+        return false;
+    }
+
+    entry.dirty = false;
+    if (entry.failures) {
+        stats.retriedWrites++;
+        entry.failures = 0;
+    }
+    stats.flashWrites++;
+    stats.bytesWritten += written;
+    Serial.printf("ConfigStore: %s written (%u bytes)\n", path.c_str(), static_cast<unsigned>(written));
+    return true;
+}
+
+bool ConfigStore::flush()
+{
+    if (!xSemaphoreTake(storeMutex, portMAX_DELAY)) return false;
+    bool ok = true;
+    for (auto& kv : cache) {
+        if (kv.second.dirty) {
+            ok = commit(kv.first, kv.second) && ok;
+        }
+    }
+    xSemaphoreGive(storeMutex);
+    return ok;
+}
+
+void ConfigStore::getStats(JsonObject& out)
+{
+    if (!xSemaphoreTake(storeMutex, pdMS_TO_TICKS(50))) return;
+    out["mounts"] = stats.mounts;
+    out["flashReads"] = stats.flashReads;
+    out["flashWrites"] = stats.flashWrites;
+    out["bytesWritten"] = stats.bytesWritten;
+    out["cacheHits"] = stats.cacheHits;
+    out["cacheMisses"] = stats.cacheMisses;
+    out["coalescedWrites"] = stats.coalescedWrites;
+    out["failedWrites"] = stats.failedWrites;
+    out["retriedWrites"] = stats.retriedWrites;
+    uint32_t pending = 0;
+    for (auto& kv : cache) {
+        if (kv.second.dirty) pending++;
+    }
+    out["pendingWrites"] = pending;
+    out["cachedFiles"] = cache.size();
+    xSemaphoreGive(storeMutex);
+}
+
+void ConfigStore::startFlushTask()
+{
+    if (flushTaskHandle) return;
+    xTaskCreatePinnedToCore(
+        flushTask,
+        "CfgFlush",
+        4096,
+        this,
+        1,
+        &flushTaskHandle,
+        0);
+}
+
+void ConfigStore::flushTask(void* parameter)
+{
+    static_cast<ConfigStore*>(parameter)->flushLoop();
+}
+
+// Quiet time before the next commit: the write delay, doubled per failed commit
+uint32_t ConfigStore::delayFor(const Entry& entry) const
+{
+    if (entry.failures == 0) return writeDelayMs;
+    uint32_t backoff = std::max<uint32_t>(writeDelayMs, 100);
+    for (uint8_t i = 0; i < entry.failures && backoff < RETRY_MAX_MS; i++) {
+        backoff *= 2;
+    }
+    return std::min(backoff, RETRY_MAX_MS);
+}
+
+// Sleeps until a write arrives, then commits each file once it has been quiet
+// for the write delay, so bursts of writes cost a single flash write. A file
+// that fails to commit stays dirty and is rescheduled with a back-off
+void ConfigStore::flushLoop()
+{
+    TickType_t wait = portMAX_DELAY;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        uint32_t nextDue = UINT32_MAX;
+        if (xSemaphoreTake(storeMutex, portMAX_DELAY)) {
+            uint32_t now = millis();
+            for (auto& kv : cache) {
+                Entry& entry = kv.second;
+                if (!entry.dirty) continue;
+                uint32_t quiet = now - entry.lastWrite;
+                uint32_t delay = delayFor(entry);
+                if (quiet < delay) {
+                    nextDue = std::min(nextDue, delay - quiet);
+                } else if (!commit(kv.first, entry)) {
+                    if (entry.failures < UINT8_MAX) entry.failures++;
+                    entry.lastWrite = now;
+                    nextDue = std::min(nextDue, delayFor(entry));
+                }
+            }
+            xSemaphoreGive(storeMutex);
+        }
+        wait = (nextDue == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(nextDue + 1);
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef CONFIGSTORE_H
+#define CONFIGSTORE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <map>
+#include <vector>
+#include <functional>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+/**
+ * @brief Flash access counters, to check that hot paths stay in RAM
+ */
+struct ConfigStoreStats {
+    uint32_t mounts;          ///< SPIFFS.begin calls that actually ran
+    uint32_t flashReads;      ///< Files opened and parsed
+    uint32_t flashWrites;     ///< Files committed
+    uint32_t bytesWritten;
+    uint32_t cacheHits;
+    uint32_t cacheMisses;
+    uint32_t coalescedWrites; ///< Writes merged into an already pending flush
+    uint32_t failedWrites;    ///< Commits that failed, each one retried later
+    uint32_t retriedWrites;   ///< Commits that were a retry of a failed one
+};
+
+/**
+ * @brief Single owner of the SPIFFS configuration files
+ *
+ * The filesystem is mounted once. Each file is parsed on first use and kept
+ * in RAM, indexed by name, so later reads never touch flash. Writes update
+ * the cached document and are flushed by a background task once the file
+ * has been quiet for the debounce delay: the document is serialized straight
+ * into "<name>.tmp", which is then renamed over the original. A commit that
+ * fails is retried by the same task, after a delay that doubles with each
+ * failure of that file up to RETRY_MAX_MS.
+ */
+class ConfigStore {
+public:
+    static ConfigStore& getInstance();
+
+    bool mount();
+
+    bool read(const char* name, JsonDocument& out);
+    String readString(const char* name, const char* key, const char* fallback);
+    bool exists(const char* name);
+    // Runs fn on the cached document with the store locked, without copying it
+    bool view(const char* name, std::function<void(JsonVariantConst)> fn);
+
+    void write(const char* name, const JsonDocument& body);
+    bool flush();
+    // Called after a cached document changes, before it reaches flash
+    void onWrite(std::function<void(const char* name)> listener);
+
+    void setWriteDelay(uint32_t ms) { writeDelayMs = ms; }
+    void getStats(JsonObject& out);
+
+    static constexpr uint32_t DEFAULT_WRITE_DELAY_MS = 1500;
+    static constexpr uint32_t RETRY_MAX_MS = 60000;
+
+private:
+    ConfigStore();
+    ConfigStore(const ConfigStore&) = delete;
+    ConfigStore& operator=(const ConfigStore&) = delete;
+
+    struct Entry {
+        DynamicJsonDocument* doc;   ///< nullptr when the file does not exist
+        bool dirty;
+        uint32_t lastWrite;         ///< Of the document, or of the last failed commit
+        uint8_t failures;           ///< Failed commits in a row
+    };
+
+    std::map<String, Entry> cache;
+    SemaphoreHandle_t storeMutex;
+    TaskHandle_t flushTaskHandle;
+    bool mounted;
+    uint32_t writeDelayMs;
+    ConfigStoreStats stats;
+    std::vector<std::function<void(const char*)>> writeListeners;
+
+    static String pathFor(const char* name);
+    Entry& load(const char* name);
+    bool commit(const String& name, Entry& entry);
+    void recover(const String& path);
+    uint32_t delayFor(const Entry& entry) const;
+    void startFlushTask();
+    static void flushTask(void* parameter);
+    void flushLoop();
+};
+
+#endif // CONFIGSTORE_H
@@ -0,0 +1,143 @@
+#include "EasingCurve.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+namespace EasingCurve {
+
+namespace {
+
+inline float bezierAxis(float s, float p1, float p2)
+{
+    // B(s) with endpoints 0 and 1: 3(1-s)^2 s p1 + 3(1-s) s^2 p2 + s^3
+    float inv = 1.0f - s;
+    return 3.0f * inv * inv * s * p1 + 3.0f * inv * s * s * p2 + s * s * s;
+}
+
+inline float bezierAxisSlope(float s, float p1, float p2)
+{
+    float inv = 1.0f - s;
+    return 3.0f * inv * inv * p1 + 6.0f * inv * s * (p2 - p1) + 3.0f * s * s * (1.0f - p2);
+}
+
+// Parameter s where the bezier x equals x: Newton first, bisection fallback
+float solveBezierX(float x, float x1, float x2, float guess)
+{
+    float s = guess;
+    for (int i = 0; i < 6; i++) {
+        float err = bezierAxis(s, x1, x2) - x;
+        if (fabsf(err) < 1e-6f) return s;
+        float slope = bezierAxisSlope(s, x1, x2);
+        if (fabsf(slope) < 1e-6f) break;
+        s -= err / slope;
+    }
+
+    float lo = 0.0f;
+    float hi = 1.0f;
+    s = x;
+    for (int i = 0; i < 24; i++) {
+        float value = bezierAxis(s, x1, x2);
+        if (fabsf(value - x) < 1e-6f) break;
+        if (value < x) lo = s; else hi = s;
+        s = 0.5f * (lo + hi);
+    }
+    return s;
+}
+
+inline int16_t toFixed(float value)
+{
+    float scaled = value * EASING_ONE;
+    scaled = std::max(-32768.0f, std::min(32767.0f, scaled));
+    return static_cast<int16_t>(lroundf(scaled));
+}
+
+} // namespace
+
+void bakeBezier(float x1, float y1, float x2, float y2, EasingTable& out)
+{
+    // x control points outside [0,1] would make the curve non monotonic in x
+    x1 = std::max(0.0f, std::min(1.0f, x1));
+    x2 = std::max(0.0f, std::min(1.0f, x2));
+
+    float s = 0.0f;
+    for (uint16_t i = 0; i <= EASING_TABLE_SIZE; i++) {
+        float x = static_cast<float>(i) / EASING_TABLE_SIZE;
+        // The previous solution is a good starting point for the next sample
+        s = solveBezierX(x, x1, x2, i == 0 ? x : s);
+        out.v[i] = toFixed(bezierAxis(s, y1, y2));
+    }
+}
+
+void bakeSteps(uint16_t steps, EasingTable& out)
+{
+    steps = std::max<uint16_t>(1, steps);
+    for (uint16_t i = 0; i <= EASING_TABLE_SIZE; i++) {
+        // CSS steps(n, end): output jumps at the end of each interval
+        uint32_t step = (static_cast<uint32_t>(i) * steps) / EASING_TABLE_SIZE;
+        step = std::min<uint32_t>(step, steps);
+        out.v[i] = static_cast<int16_t>((step * EASING_ONE) / steps);
+    }
+}
+
+void bakeSampled(const float* samples, uint8_t count, EasingTable& out)
+{
+    if (!samples || count == 0) {
+        out = EasingTables::LINEAR;
+        return;
+    }
+    if (count == 1) {
+        for (uint16_t i = 0; i <= EASING_TABLE_SIZE; i++) out.v[i] = toFixed(samples[0]);
+        return;
+    }
+
+    const float span = static_cast<float>(count - 1);
+    for (uint16_t i = 0; i <= EASING_TABLE_SIZE; i++) {
+        float pos = span * i / EASING_TABLE_SIZE;
+        uint8_t k = std::min<uint8_t>(static_cast<uint8_t>(pos), count - 2);
+        float frac = pos - k;
+        out.v[i] = toFixed(samples[k] + (samples[k + 1] - samples[k]) * frac);
+    }
+}
+
+void bake(const EasingSpec& spec, EasingTable& out)
+{
+    switch (spec.kind) {
+    case EasingSpec::BEZIER:
+        bakeBezier(spec.x1, spec.y1, spec.x2, spec.y2, out);
+        break;
+    case EasingSpec::STEPS:
+        bakeSteps(spec.steps, out);
+        break;
+    case EasingSpec::SAMPLED:
+        bakeSampled(spec.samples, spec.sampleCount, out);
+        break;
+    }
+}
+
+bool parseBezier(const char* text, EasingSpec& out)
+{
+    float x1, y1, x2, y2;
+    if (!text || sscanf(text, "cubic-bezier(%f ,%f ,%f ,%f )", &x1, &y1, &x2, &y2) != 4) {
+        return false;
+    }
+    out.kind = EasingSpec::BEZIER;
+    out.x1 = x1;
+    out.y1 = y1;
+    out.x2 = x2;
+    out.y2 = y2;
+    return true;
+}
+
+bool parseSteps(const char* text, EasingSpec& out)
+{
+    unsigned int steps;
+    if (!text || sscanf(text, "steps(%u", &steps) != 1 || steps == 0) {
+        return false;
+    }
+    out.kind = EasingSpec::STEPS;
+    out.steps = static_cast<uint16_t>(std::min(steps, 1024u));
+    return true;
+}
+
+} // namespace EasingCurve
@@ -0,0 +1,160 @@
+#ifndef EASING_CURVE_H
+#define EASING_CURVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Easing curves resolved into lookup tables
+ *
+ * Every curve is stored as EASING_TABLE_SIZE + 1 samples of the output value
+ * in Q14 fixed point (16384 == 1.0, so overshooting curves down to -2.0 and
+ * up to 2.0 fit). Built-in curves are generated at compile time and live in
+ * flash; cubic-bezier, steps and sampled curves are baked into a RAM table
+ * once per transition. Per frame evaluation is one linear interpolation.
+ */
+
+static constexpr uint16_t EASING_TABLE_SIZE = 256;
+static constexpr int32_t EASING_ONE = 16384;
+static constexpr uint8_t MAX_EASING_SAMPLES = 32;
+
+struct EasingTable {
+    int16_t v[EASING_TABLE_SIZE + 1];
+};
+
+/**
+ * @brief Parameters of a curve that has to be baked at transition start
+ */
+struct EasingSpec {
+    enum Kind : uint8_t { BEZIER, STEPS, SAMPLED };
+
+    Kind kind = BEZIER;
+    float x1 = 0.25f, y1 = 0.1f, x2 = 0.25f, y2 = 1.0f;  ///< cubic-bezier control points
+    uint16_t steps = 1;                                  ///< steps(n), jump at the end of each step
+    uint8_t sampleCount = 0;                             ///< sampled curve, evenly spaced over [0,1]
+    float samples[MAX_EASING_SAMPLES] = {};
+};
+
+namespace easing_detail {
+
+constexpr double kPi = 3.14159265358979323846;
+
+constexpr double cexp(double x)
+{
+    // exp(x) = exp(x / 64)^64, Taylor series on the reduced argument
+    double y = x / 64.0;
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 16; n++) {
+        term *= y / n;
+        sum += term;
+    }
+    for (int i = 0; i < 6; i++) {
+        sum *= sum;
+    }
+    return sum;
+}
+
+constexpr double csin(double x)
+{
+    // Reduce to [-pi, pi] then Taylor series
+    long long turns = static_cast<long long>((x + kPi) / (2.0 * kPi));
+    if (x + kPi < 0.0) turns -= 1;
+    x -= static_cast<double>(turns) * 2.0 * kPi;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 12; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr int16_t toFixed(double value)
+{
+    double scaled = value * EASING_ONE;
+    if (scaled > 32767.0) scaled = 32767.0;
+    if (scaled < -32768.0) scaled = -32768.0;
+    return static_cast<int16_t>(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+template <typename F>
+inline constexpr EasingTable bake(F curve)
+{
+    EasingTable table{};
+    for (uint16_t i = 0; i <= EASING_TABLE_SIZE; i++) {
+        table.v[i] = toFixed(curve(static_cast<double>(i) / EASING_TABLE_SIZE));
+    }
+    return table;
+}
+
+constexpr double bounceOut(double t)
+{
+    if (t < 1.0 / 2.75) {
+        return 7.5625 * t * t;
+    } else if (t < 2.0 / 2.75) {
+        t -= 1.5 / 2.75;
+        return 7.5625 * t * t + 0.75;
+    } else if (t < 2.5 / 2.75) {
+        t -= 2.25 / 2.75;
+        return 7.5625 * t * t + 0.9375;
+    }
+    t -= 2.625 / 2.75;
+    return 7.5625 * t * t + 0.984375;
+}
+
+constexpr double elasticOut(double t)
+{
+    if (t <= 0.0 || t >= 1.0) return t;
+    // 2^(-10t) * sin((t - 0.075) * 2pi / 0.3) + 1
+    return cexp(-10.0 * t * 0.69314718055994530942) * csin((t - 0.075) * (2.0 * kPi) / 0.3) + 1.0;
+}
+
+} // namespace easing_detail
+
+namespace EasingTables {
+using namespace easing_detail;
+
+inline constexpr EasingTable LINEAR = bake([](double t) { return t; });
+inline constexpr EasingTable IN_QUAD = bake([](double t) { return t * t; });
+inline constexpr EasingTable OUT_QUAD = bake([](double t) { return 1.0 - (1.0 - t) * (1.0 - t); });
+inline constexpr EasingTable IN_OUT_QUAD = bake([](double t) {
+    return t < 0.5 ? 2.0 * t * t : 1.0 - 2.0 * (1.0 - t) * (1.0 - t);
+});
+inline constexpr EasingTable IN_CUBIC = bake([](double t) { return t * t * t; });
+inline constexpr EasingTable OUT_CUBIC = bake([](double t) { return 1.0 - (1.0 - t) * (1.0 - t) * (1.0 - t); });
+inline constexpr EasingTable IN_OUT_CUBIC = bake([](double t) {
+    return t < 0.5 ? 4.0 * t * t * t : 1.0 - 4.0 * (1.0 - t) * (1.0 - t) * (1.0 - t);
+});
+inline constexpr EasingTable BOUNCE_OUT = bake([](double t) { return bounceOut(t); });
+inline constexpr EasingTable ELASTIC_OUT = bake([](double t) { return elasticOut(t); });
+
+} // namespace EasingTables
+
+namespace EasingCurve {
+
+/// Sample a table at t in [0,1] with linear interpolation between entries
+inline float sample(const EasingTable& table, float t)
+{
+    if (t <= 0.0f) return table.v[0] / static_cast<float>(EASING_ONE);
+    if (t >= 1.0f) return table.v[EASING_TABLE_SIZE] / static_cast<float>(EASING_ONE);
+
+    float pos = t * EASING_TABLE_SIZE;
+    uint16_t i = static_cast<uint16_t>(pos);
+    float frac = pos - i;
+    float a = table.v[i];
+    float b = table.v[i + 1];
+    return (a + (b - a) * frac) / static_cast<float>(EASING_ONE);
+}
+
+void bakeBezier(float x1, float y1, float x2, float y2, EasingTable& out);
+void bakeSteps(uint16_t steps, EasingTable& out);
+void bakeSampled(const float* samples, uint8_t count, EasingTable& out);
+void bake(const EasingSpec& spec, EasingTable& out);
+
+bool parseBezier(const char* text, EasingSpec& out);
+bool parseSteps(const char* text, EasingSpec& out);
+
+} // namespace EasingCurve
+
+#endif // EASING_CURVE_H
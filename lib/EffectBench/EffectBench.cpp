@@ -0,0 +1,433 @@
+#include "EffectBench.h"
+#include <LEDStrip.h>
+#include <EffectsManager.h>
+#include <TranstionsManager.h>
+#include <GradientManager.h>
+#include <ParticlePool.h>
+#include <esp_timer.h>
+#include <algorithm>
+
+// Never driven, the strip is not started
+static const uint8_t BENCH_PIN = 2;
+
+// TransitionType order, as reported in the case names
+static const char* const EASING_NAMES[] = {
+    "linear", "ease_in", "ease_out", "ease_in_out",
+    "ease_in_quad", "ease_out_quad", "ease_in_out_quad",
+    "ease_in_cubic", "ease_out_cubic", "ease_in_out_cubic",
+    "bounce_out", "elastic_out", "cubic_bezier", "steps", "custom"};
+static_assert(sizeof(EASING_NAMES) / sizeof(EASING_NAMES[0]) == TRANSITION_CUSTOM + 1,
+              "one name per TransitionType");
+
+static const uint8_t GRADIENT_STOPS[] = {2, 8, 32};
+
+// Targets of the rainbow crossfades timed against a plain frame of themselves
+static const char* const CROSSFADE_TARGETS[] = {"fire", "sparkle", "plasma"};
+
+// Live particles of the pool case, in a pool sized like a dense emitter's
+static const uint16_t BENCH_PARTICLES = 1000;
+typedef ParticlePool<1024> BenchParticlePool;
+
+EffectBench::EffectBench(const BenchOptions& options)
+    : options(options), first(true)
+{
+    trialUs.reserve(options.trials);
+}
+
+void EffectBench::run(Print& out)
+{
+    results.clear();
+    first = true;
+
+#ifdef ARDUINO_ARCH_ESP32
+    const char* platform = "esp32";
+#else
+    const char* platform = "host";
+#endif
+    out.printf("{\"bench\": %d, \"platform\": \"%s\", \"cpu_mhz\": %u, "
+               "\"warmup\": %u, \"trials\": %u, \"trim\": %u, \"results\": [",
+               EFFECT_BENCH_VERSION, platform, static_cast<unsigned>(ESP.getCpuFreqMHz()),
+               options.warmupFrames, options.trials, options.trim);
+
+    for (uint8_t i = 0; i < options.sizeCount; i++) {
+        LEDStrip* strip = new LEDStrip(options.sizes[i], BENCH_PIN, NEO_GRB + NEO_KHZ800);
+        strip->setClock(&clock);
+        runEffects(out, *strip);
+        runTransitions(out, *strip);
+        runCrossfades(out, *strip);
+        runGradients(out, *strip);
+        runParticles(out, *strip);
+        runRandom(out, *strip);
+        delete strip;
+    }
+
+    out.print("\n]}\n");
+}
+
+bool EffectBench::selected(const char* name) const
+{
+    return options.filter == nullptr || strstr(name, options.filter) != nullptr;
+}
+
+// Warm up, size the trials so the microsecond timer resolves them, then keep
+// the trimmed mean of the per-frame times
+template <typename Fn>
+void EffectBench::measure(Print& out, const char* name, uint16_t pixels, Fn frame, float baselineNsPerPixel)
+{
+    for (uint8_t i = 0; i < options.warmupFrames; i++) {
+        frame();
+    }
+
+    uint32_t frames = 0;
+    int64_t start = esp_timer_get_time();
+    do {
+        frame();
+        frames++;
+    } while (esp_timer_get_time() - start < options.minTrialUs);
+
+    trialUs.clear();
+    for (uint8_t t = 0; t < options.trials; t++) {
+        int64_t trialStart = esp_timer_get_time();
+        for (uint32_t f = 0; f < frames; f++) {
+            frame();
+        }
+        trialUs.push_back(static_cast<uint32_t>(esp_timer_get_time() - trialStart));
+        yield();
+    }
+    std::sort(trialUs.begin(), trialUs.end());
+
+    size_t trim = std::min<size_t>(options.trim, (trialUs.size() - 1) / 2);
+    size_t kept = trialUs.size() - 2 * trim;
+    uint64_t sum = 0;
+    for (size_t i = trim; i < trim + kept; i++) {
+        sum += trialUs[i];
+    }
+    float meanUs = static_cast<float>(sum) / kept;
+    float frameUs = meanUs / frames;
+
+    BenchResult result;
+    result.name = name;
+    result.pixels = pixels;
+    result.nsPerPixel = frameUs * 1000.0f / pixels;
+    result.fps = frameUs > 0.0f ? 1e6f / frameUs : 0.0f;
+    result.spread = meanUs > 0.0f ? (trialUs[trim + kept - 1] - trialUs[trim]) / meanUs : 0.0f;
+    result.frames = frames;
+    result.ratio = baselineNsPerPixel > 0.0f ? result.nsPerPixel / baselineNsPerPixel : 0.0f;
+    results.push_back(result);
+    emit(out, result);
+}
+
+// One result per line, so runs diff line by line
+void EffectBench::emit(Print& out, const BenchResult& result)
+{
+    out.printf("%s\n  {\"name\": \"%s\", \"pixels\": %u, \"ns_per_pixel\": %.2f, "
+               "\"fps\": %.1f, \"spread\": %.3f, \"frames\": %u",
+               first ? "" : ",", result.name.c_str(), result.pixels, result.nsPerPixel,
+               result.fps, result.spread, static_cast<unsigned>(result.frames));
+    if (result.ratio > 0.0f) {
+        out.printf(", \"ratio\": %.2f", result.ratio);
+    }
+    out.print("}");
+    first = false;
+}
+
+// Every registered effect, advanced and committed as by the render task
+void EffectBench::runEffects(Print& out, LEDStrip& strip)
+{
+    EffectsManager* effects = strip.effectsManager;
+    char name[48];
+
+    for (size_t id = 1; id < EffectRegistry::count(); id++) {
+        const EffectDescriptor& effect = EffectRegistry::get(static_cast<EffectType>(id));
+        snprintf(name, sizeof(name), "effect/%s", effect.name);
+        if (!selected(name)) {
+            continue;
+        }
+
+        effects->state.type = static_cast<EffectType>(id);
+        effects->initializeEffectData();
+        // Far enough apart that no frame is throttled
+        uint32_t now = 0;
+        measure(out, name, strip.numPixels(), [&]() {
+            now += 1000;
+            effects->advanceState(effects->state, now);
+            effects->commitState(effects->state);
+        });
+    }
+    effects->state.type = EFFECT_NONE;
+}
+
+// Rainbow into fire under every easing, both effects rendering each frame
+void EffectBench::runTransitions(Print& out, LEDStrip& strip)
+{
+    EffectsManager* effects = strip.effectsManager;
+    TranstionsManager* transitions = strip.transitionsManager;
+    const uint16_t pixels = strip.numPixels();
+    char name[48];
+
+    int source = EffectRegistry::find("rainbow");
+    int target = EffectRegistry::find("fire");
+    if (source < 0 || target < 0) {
+        return;
+    }
+
+    for (int type = TRANSITION_LINEAR; type <= TRANSITION_CUSTOM; type++) {
+        snprintf(name, sizeof(name), "transition/%s", EASING_NAMES[type]);
+        if (!selected(name)) {
+            continue;
+        }
+
+        EasingSpec& spec = transitions->customEasing;
+        spec = EasingSpec();
+        if (type == TRANSITION_STEPS) {
+            spec.kind = EasingSpec::STEPS;
+            spec.steps = 4;
+        } else if (type == TRANSITION_CUSTOM) {
+            spec.kind = EasingSpec::SAMPLED;
+            spec.sampleCount = 5;
+            const float samples[] = {0.0f, 0.6f, 0.3f, 0.9f, 1.0f};
+            std::copy(samples, samples + 5, spec.samples);
+        }
+
+        effects->state.type = static_cast<EffectType>(source);
+        effects->initializeEffectData();
+        clock.advance(1000);
+        effects->advanceState(effects->state, strip.now());
+        transitions->beginTransition(0, UINT32_MAX / 2, static_cast<TransitionType>(type));
+        EffectState targetState;
+        targetState.copyParams(effects->state);
+        targetState.type = static_cast<EffectType>(target);
+        transitions->setTargetEffect(targetState);
+
+        uint32_t frame = 0;
+        measure(out, name, pixels, [&]() {
+            // Far enough apart that neither effect is throttled
+            clock.advance(1000);
+            float progress = (frame++ & 255) / 255.0f;
+            transitions->renderTransitionFrame(transitions->easeProgress(progress), pixels);
+        });
+        transitions->transition.active = false;
+    }
+    effects->state.type = EFFECT_NONE;
+}
+
+// Rainbow crossfading into each target, both instances rendering and blended,
+// after a plain frame of the target alone: the ratio is the crossfade's cost
+void EffectBench::runCrossfades(Print& out, LEDStrip& strip)
+{
+    EffectsManager* effects = strip.effectsManager;
+    TranstionsManager* transitions = strip.transitionsManager;
+    const uint16_t pixels = strip.numPixels();
+    char name[48];
+
+    int source = EffectRegistry::find("rainbow");
+    for (const char* targetName : CROSSFADE_TARGETS) {
+        int target = EffectRegistry::find(targetName);
+        snprintf(name, sizeof(name), "crossfade/%s", targetName);
+        if (source < 0 || target < 0 || !selected(name)) {
+            continue;
+        }
+
+        snprintf(name, sizeof(name), "crossfade/%s/single", targetName);
+        effects->state.type = static_cast<EffectType>(target);
+        effects->initializeEffectData();
+        measure(out, name, pixels, [&]() {
+            clock.advance(1000);
+            effects->advanceState(effects->state, strip.now());
+            effects->commitState(effects->state);
+        });
+        float singleNsPerPixel = results.back().nsPerPixel;
+
+        effects->state.type = static_cast<EffectType>(source);
+        effects->initializeEffectData();
+        clock.advance(1000);
+        effects->advanceState(effects->state, strip.now());
+        transitions->customEasing = EasingSpec();
+        transitions->beginTransition(0, UINT32_MAX / 2, TRANSITION_LINEAR);
+        EffectState targetState;
+        targetState.copyParams(effects->state);
+        targetState.type = static_cast<EffectType>(target);
+        transitions->setTargetEffect(targetState);
+
+        snprintf(name, sizeof(name), "crossfade/%s", targetName);
+        uint32_t frame = 0;
+        measure(out, name, pixels, [&]() {
+            clock.advance(1000);
+            float progress = (frame++ & 255) / 255.0f;
+            transitions->renderTransitionFrame(transitions->easeProgress(progress), pixels);
+        }, singleNsPerPixel);
+        transitions->transition.active = false;
+    }
+    effects->state.type = EFFECT_NONE;
+}
+
+// Static and scrolling gradients from the cached table, and the rasterization
+// paid when stops change or a gradient transition starts
+void EffectBench::runGradients(Print& out, LEDStrip& strip)
+{
+    GradientManager* gradient = strip.gradientManager;
+    std::vector<GradientStop> stops;
+    std::vector<WColor> raster;
+    raster.reserve(strip.numPixels());
+    char name[48];
+
+    for (uint8_t count : GRADIENT_STOPS) {
+        stops.clear();
+        for (uint8_t i = 0; i < count; i++) {
+            float position = static_cast<float>(i) / (count - 1);
+            stops.push_back(GradientStop(position, WColor::fromHSV(position * 360.0f, 1.0f, 1.0f)));
+        }
+        gradient->setGradient(stops);
+
+        snprintf(name, sizeof(name), "gradient/static/%u", count);
+        if (selected(name)) {
+            gradient->setAnimation(GRADIENT_STATIC, 0.0f);
+            measure(out, name, strip.numPixels(), [&]() { gradient->renderGradient(); });
+        }
+
+        snprintf(name, sizeof(name), "gradient/scroll/%u", count);
+        if (selected(name)) {
+            gradient->setAnimation(GRADIENT_SCROLL, 30.0f);
+            measure(out, name, strip.numPixels(), [&]() {
+                clock.advance(strip.getFrameDelay());
+                gradient->renderGradient();
+            });
+        }
+
+        snprintf(name, sizeof(name), "gradient/rasterize/%u", count);
+        if (selected(name)) {
+            measure(out, name, strip.numPixels(), [&]() {
+                gradient->rasterizeGradient(stops, false, raster);
+            });
+        }
+    }
+    gradient->setAnimation(GRADIENT_STATIC, 0.0f);
+    gradient->clearGradient();
+}
+
+// A pool kept at BENCH_PARTICLES: every frame moves, ages and splats them
+// all onto a cleared canvas, and respawns the ones that died or left the strip
+void EffectBench::runParticles(Print& out, LEDStrip& strip)
+{
+    char name[48];
+    snprintf(name, sizeof(name), "particles/%u", BENCH_PARTICLES);
+    if (!selected(name)) {
+        return;
+    }
+
+    const uint16_t pixels = strip.numPixels();
+    std::vector<WColor> canvas(pixels);
+    BenchParticlePool* pool = new BenchParticlePool();
+    pool->clear();
+    EffectRandom random;
+    random.seed(1);
+    auto refill = [&]() {
+        while (pool->count < BENCH_PARTICLES) {
+            float speed = (random.unit() - 0.5f) * 0.2f * pixels;
+            WColor color(random.below(256), random.below(256), random.below(256));
+            pool->spawn(random.unit() * pixels, speed, color, 0.5f + random.unit() * 2.0f);
+        }
+    };
+    refill();
+
+    measure(out, name, pixels, [&]() {
+        std::fill(canvas.begin(), canvas.end(), WColor(0, 0, 0));
+        pool->update(1.0f / 60.0f, 0.05f * pixels, -1.0f, pixels + 1.0f);
+        refill();
+        pool->splat(canvas.data(), pixels, 1.5f, 2.0f, 1.0f);
+    });
+    delete pool;
+}
+
+// One draw per pixel, as the noise effects take them: Arduino random(), then
+// the effects' own generator with its ratio to random()
+void EffectBench::runRandom(Print& out, LEDStrip& strip)
+{
+    if (!selected("random/")) {
+        return;
+    }
+
+    const uint16_t pixels = strip.numPixels();
+    std::vector<uint8_t> noise(pixels);
+    measure(out, "random/arduino", pixels, [&]() {
+        for (uint16_t i = 0; i < pixels; i++) {
+            noise[i] = random(0, 256);
+        }
+    });
+    float arduinoNsPerPixel = results.back().nsPerPixel;
+
+    EffectRandom generator;
+    generator.seed(1);
+    measure(out, "random/effect", pixels, [&]() {
+        for (uint16_t i = 0; i < pixels; i++) {
+            noise[i] = generator.between(0, 256);
+        }
+    }, arduinoNsPerPixel);
+}
+
+bool EffectBench::load(JsonVariantConst doc, std::vector<BenchResult>& out)
+{
+    JsonArrayConst list = doc["results"].as<JsonArrayConst>();
+    if (list.isNull()) {
+        return false;
+    }
+    out.clear();
+    for (JsonObjectConst entry : list) {
+        BenchResult result;
+        result.name = entry["name"].as<const char*>();
+        result.pixels = entry["pixels"].as<uint16_t>();
+        result.nsPerPixel = entry["ns_per_pixel"].as<float>();
+        result.fps = entry["fps"].as<float>();
+        result.spread = entry["spread"].as<float>();
+        result.frames = entry["frames"].as<uint32_t>();
+        result.ratio = entry["ratio"] | 0.0f;
+        out.push_back(result);
+    }
+    return true;
+}
+
+static const BenchResult* findResult(const std::vector<BenchResult>& list, const BenchResult& like)
+{
+    for (const BenchResult& result : list) {
+        if (result.pixels == like.pixels && result.name == like.name) {
+            return &result;
+        }
+    }
+    return nullptr;
+}
+
+int EffectBench::compare(const std::vector<BenchResult>& baseline,
+                         const std::vector<BenchResult>& current,
+                         float thresholdPct, Print& report)
+{
+    int slower = 0;
+    for (const BenchResult& now : current) {
+        const BenchResult* before = findResult(baseline, now);
+        if (!before) {
+            report.printf("new      %s @%u: %.2f ns/px\n", now.name.c_str(), now.pixels, now.nsPerPixel);
+            continue;
+        }
+        if (before->nsPerPixel <= 0.0f) {
+            continue;
+        }
+        float change = (now.nsPerPixel / before->nsPerPixel - 1.0f) * 100.0f;
+        if (change > thresholdPct) {
+            report.printf("SLOWER   %s @%u: %.2f -> %.2f ns/px (%+.1f%%)\n", now.name.c_str(),
+                          now.pixels, before->nsPerPixel, now.nsPerPixel, change);
+            slower++;
+        }
+    }
+    // A filtered run leaves most of a full baseline out, so only count them
+    unsigned missing = 0;
+    for (const BenchResult& before : baseline) {
+        if (!findResult(current, before)) {
+            missing++;
+        }
+    }
+    if (missing) {
+        report.printf("%u baseline cases not run\n", missing);
+    }
+    report.printf("%d of %u cases slower by more than %.1f%%\n", slower,
+                  static_cast<unsigned>(current.size()), thresholdPct);
+    return slower;
+}
@@ -0,0 +1,93 @@
+#ifndef EFFECT_BENCH_H
+#define EFFECT_BENCH_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+#include <Clock.h>
+
+#define EFFECT_BENCH_VERSION 1
+#define EFFECT_BENCH_MAX_SIZES 4
+
+class LEDStrip;
+
+/**
+ * @brief Timing of one case on one strip length
+ */
+struct BenchResult {
+    String name;          ///< "effect/<name>", "transition/<easing>", "crossfade/<target>",
+                          ///< "gradient/<path>/<stops>", "particles/<count>" or "random/<source>"
+    uint16_t pixels;
+    float nsPerPixel;     ///< Trimmed mean over the trials
+    float fps;            ///< Frames per second the render alone would reach
+    float spread;         ///< (slowest - fastest) / mean of the kept trials
+    uint32_t frames;      ///< Frames per trial
+    float ratio = 0.0f;   ///< Time over the case it pairs with, 0 when unpaired
+};
+
+struct BenchOptions {
+    uint16_t sizes[EFFECT_BENCH_MAX_SIZES] = {15, 150, 600, 2400};
+    uint8_t sizeCount = EFFECT_BENCH_MAX_SIZES;
+    uint8_t warmupFrames = 16;
+    uint8_t trials = 21;
+    uint8_t trim = 5;            ///< Fastest and slowest trials dropped at each end
+    uint32_t minTrialUs = 2000;  ///< Frames per trial are calibrated to last this long
+    const char* filter = nullptr; ///< Only cases whose name contains this
+};
+
+/**
+ * @brief Render microbenchmarks for every effect, easing and gradient path
+ *
+ * Each case renders into the frame buffer of a strip on a stepped clock, so
+ * the render task and show() stay out of the numbers: on the device the
+ * wire time of show() depends on the LED count only. Effects are advanced
+ * frame after frame as the render task would, transitions crossfade rainbow
+ * into fire under each easing, and gradients are timed static, scrolling
+ * and rasterized with 2, 8 and 32 stops. Crossfades are paired with a plain
+ * frame of their target effect, and report the ratio between the two. A
+ * particle pool holding 1000 particles is timed apart from any effect, and
+ * the effects' random generator against Arduino random().
+ *
+ * Results stream as one JSON document with a line per result, so two runs
+ * diff cleanly and compare() can flag slowdowns between them.
+ */
+class EffectBench {
+public:
+    explicit EffectBench(const BenchOptions& options = BenchOptions());
+
+    // Runs every case, printing the JSON document as results come in
+    void run(Print& out);
+    const std::vector<BenchResult>& getResults() const { return results; }
+
+    // Reads the "results" of a document run() printed
+    static bool load(JsonVariantConst doc, std::vector<BenchResult>& out);
+
+    // Prints one line per case slower than baseline by more than thresholdPct
+    // and returns how many there were. Cases on one side only are reported
+    // but never count as slower.
+    static int compare(const std::vector<BenchResult>& baseline,
+                       const std::vector<BenchResult>& current,
+                       float thresholdPct, Print& report);
+
+private:
+    BenchOptions options;
+    std::vector<BenchResult> results;
+    std::vector<uint32_t> trialUs;
+    VirtualClock clock;   ///< Strip time, stepped per frame so no render is throttled
+    bool first;
+
+    // baselineNsPerPixel is that of the paired case, 0 for none
+    template <typename Fn>
+    void measure(Print& out, const char* name, uint16_t pixels, Fn frame, float baselineNsPerPixel = 0.0f);
+    bool selected(const char* name) const;
+    void emit(Print& out, const BenchResult& result);
+
+    void runEffects(Print& out, LEDStrip& strip);
+    void runTransitions(Print& out, LEDStrip& strip);
+    void runCrossfades(Print& out, LEDStrip& strip);
+    void runGradients(Print& out, LEDStrip& strip);
+    void runParticles(Print& out, LEDStrip& strip);
+    void runRandom(Print& out, LEDStrip& strip);
+};
+
+#endif // EFFECT_BENCH_H
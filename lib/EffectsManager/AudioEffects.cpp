@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <Arduino.h>
+#include <AudioAnalyzer.h>
+#include "Effects.h"
+
+// Audio effects read the analyzer snapshot without locking. Without audio
+// they fade out instead of freezing on the last frame.
+static_assert(sizeof(SpectrumEffect::State::peaks) == AUDIO_BAND_COUNT, "one peak per audio band");
+
+// One bar per band, each band owning an equal slice of the strip
+void SpectrumEffect::render(EffectContext& ctx)
+{
+    AudioSnapshot audio;
+    if (!AudioAnalyzer::getInstance().read(audio)) {
+        effectFade(ctx, 0.1f);
+        return;
+    }
+
+    State& s = ctx.stateAs<State>();
+    uint16_t numPixels = ctx.count;
+    WColor peakColor = ctx.color3 != WColor::BLACK ? ctx.color3 : ctx.color1;
+    uint8_t peakFall = static_cast<uint8_t>(std::max(1.0f, 4.0f * ctx.speed));
+
+    for (int b = 0; b < AUDIO_BAND_COUNT; b++) {
+        uint8_t level = audio.bands[b];
+        s.peaks[b] = std::max<int>(level, s.peaks[b] - peakFall);
+
+        uint16_t first = b * numPixels / AUDIO_BAND_COUNT;
+        uint16_t last = (b + 1) * numPixels / AUDIO_BAND_COUNT;
+        WColor bandColor = ctx.color2 != WColor::BLACK
+            ? ctx.color1.lerp(ctx.color2, static_cast<float>(b) / (AUDIO_BAND_COUNT - 1))
+            : ctx.color1;
+
+        if (last <= first) {
+            // Fewer pixels than bands: the pixel shows its band as brightness
+            if (first < numPixels) {
+                ctx.pixels[first] = bandColor.scale(std::min(1.0f, level / 255.0f * ctx.intensity));
+            }
+            continue;
+        }
+
+        uint16_t length = last - first;
+        uint16_t lit = level * length / 255;
+        uint16_t peak = s.peaks[b] * (length - 1) / 255;
+        float brightness = std::min(1.0f, ctx.intensity);
+        for (uint16_t i = 0; i < length; i++) {
+            ctx.pixels[first + i] = i < lit ? bandColor.scale(brightness) : WColor::BLACK;
+        }
+        if (length > 2 && s.peaks[b] > 0) {
+            ctx.pixels[first + peak] = peakColor.scale(brightness);
+        }
+    }
+}
+
+// Beats heard before the effect started do not flash
+void BeatPulseEffect::init(EffectContext& ctx)
+{
+    AudioSnapshot audio;
+    if (AudioAnalyzer::getInstance().read(audio)) {
+        ctx.stateAs<State>().lastBeatCount = audio.beatCount;
+    }
+}
+
+// Whole strip flashes on every beat, alternating color1 and color2
+void BeatPulseEffect::render(EffectContext& ctx)
+{
+    AudioSnapshot audio;
+    if (!AudioAnalyzer::getInstance().read(audio)) {
+        effectFade(ctx, 0.1f);
+        return;
+    }
+
+    State& s = ctx.stateAs<State>();
+    if (audio.beatCount != s.lastBeatCount) {
+        s.lastBeatCount = audio.beatCount;
+        s.pulse = 1.0f;
+    } else {
+        s.pulse *= std::max(0.5f, 1.0f - 0.08f * ctx.speed);
+    }
+
+    const WColor& color = (audio.beatCount & 1) && ctx.color2 != WColor::BLACK ? ctx.color2 : ctx.color1;
+    // Bass keeps a dim glow between beats
+    float bass = audio.bands[0] / 255.0f * 0.25f;
+    float level = std::min(1.0f, std::max(s.pulse, bass) * ctx.intensity);
+    effectFill(ctx, color.scale(level));
+}
+
+// Bar from the start of the strip, color1 to color2 along its length, peak dot in color3
+void VuMeterEffect::render(EffectContext& ctx)
+{
+    AudioSnapshot audio;
+    if (!AudioAnalyzer::getInstance().read(audio)) {
+        effectFade(ctx, 0.1f);
+        return;
+    }
+
+    State& s = ctx.stateAs<State>();
+    uint16_t numPixels = ctx.count;
+    float level = std::min(1.0f, audio.level / 255.0f * ctx.intensity);
+    float release = std::max(0.5f, 1.0f - 0.03f * ctx.speed);
+    s.level = std::max(level, s.level * release);
+
+    uint16_t lit = static_cast<uint16_t>(s.level * numPixels);
+    WColor endColor = ctx.color2 != WColor::BLACK ? ctx.color2 : ctx.color1;
+    for (uint16_t i = 0; i < numPixels; i++) {
+        ctx.pixels[i] = i < lit ? ctx.color1.lerp(endColor, static_cast<float>(i) / numPixels) : WColor::BLACK;
+    }
+
+    uint8_t peakFall = static_cast<uint8_t>(std::max(1.0f, 2.0f * ctx.speed));
+    s.peak = std::max<int>(static_cast<int>(s.level * 255), s.peak - peakFall);
+    uint16_t peak = s.peak * (numPixels - 1) / 255;
+    if (s.peak > 0) {
+        ctx.pixels[peak] = ctx.color3 != WColor::BLACK ? ctx.color3 : endColor;
+    }
+}
@@ -0,0 +1,189 @@
+#include <string.h>
+#include <algorithm>
+#include <Arduino.h>
+#include "EffectRegistry.h"
+#include "Effects.h"
+
+// Index = EffectType id, stored in presets and journals: append only.
+// Schema: colors, speed range, intensity range. The effects of the original
+// API keep its 0.1 - 10 speed and 0 - 2 intensity, which stored commands and
+// presets were written against. Later ranges end where the effect stops
+// responding: intensities the render caps at 1 stop there, speeds stop where
+// a rate or a decay saturates.
+static constexpr EffectDescriptor EFFECTS[] = {
+    EffectDescriptor::of<NoneEffect>("none", nullptr, EffectSchema{0}),
+    EffectDescriptor::of<RainbowEffect>("rainbow", nullptr, EffectSchema{0}),
+    EffectDescriptor::of<BreathingEffect>("breathing", "breathe", EffectSchema{1}),
+    EffectDescriptor::of<WaveEffect>("wave", nullptr, EffectSchema{2}),
+    EffectDescriptor::of<SparkleEffect>("sparkle", nullptr, EffectSchema{1}),
+    EffectDescriptor::of<ChaseEffect>("chase", nullptr, EffectSchema{1}),
+    EffectDescriptor::of<FireEffect>("fire", nullptr, EffectSchema{0}),
+    EffectDescriptor::of<TwinkleEffect>("twinkle", nullptr, EffectSchema{3}),
+    EffectDescriptor::of<MeteorEffect>("meteor", nullptr, EffectSchema{1}),
+    // Audio effects: intensity is the input gain, speed the peak fall and release
+    EffectDescriptor::of<SpectrumEffect>("spectrum", nullptr, EffectSchema{3, 0.25f, 10.0f, 0.0f, 4.0f}),
+    EffectDescriptor::of<BeatPulseEffect>("beat", "beatpulse", EffectSchema{2, 0.1f, 6.0f, 0.0f, 4.0f}),
+    EffectDescriptor::of<VuMeterEffect>("vu", "vumeter", EffectSchema{3, 0.5f, 10.0f, 0.0f, 4.0f}),
+    EffectDescriptor::of<CometsEffect>("comets", "comet", EffectSchema{3, 0.1f, 5.0f, 0.0f, 1.5f}),
+    EffectDescriptor::of<FireworksEffect>("fireworks", nullptr, EffectSchema{3, 0.1f, 3.0f, 0.0f, 2.0f}),
+    EffectDescriptor::of<RainEffect>("rain", nullptr, EffectSchema{1, 0.1f, 5.0f, 0.0f, 1.0f}),
+    EffectDescriptor::of<BallsEffect>("balls", "bouncingballs", EffectSchema{3, 0.1f, 3.0f, 0.0f, 1.0f}),
+    EffectDescriptor::of<PlasmaEffect>("plasma", nullptr, EffectSchema{0, 0.1f, 10.0f, 0.0f, 1.0f}),
+    // Ignition chance saturates at speed 200 / 60
+    EffectDescriptor::of<Fire2DEffect>("fire2d", nullptr, EffectSchema{0, 0.1f, 3.4f, 0.0f, 2.0f}),
+    EffectDescriptor::of<ScrollEffect>("scroll", "scrollgradient", EffectSchema{3, 0.1f, 10.0f, 0.0f, 1.0f}),
+    EffectDescriptor::of<NoiseFieldEffect>("noise", "noisefield", EffectSchema{2, 0.1f, 10.0f, 0.0f, 1.0f}),
+    EffectDescriptor::of<SweepEffect>("sweep", "planesweep", EffectSchema{2, 0.1f, 10.0f, 0.0f, 1.0f}),
+    EffectDescriptor::of<PulseEffect>("pulse", "radialpulse", EffectSchema{2, 0.1f, 10.0f, 0.0f, 1.0f}),
+    EffectDescriptor::of<Noise3DEffect>("noise3d", nullptr, EffectSchema{2, 0.1f, 10.0f, 0.0f, 1.0f}),
+};
+
+static constexpr size_t EFFECT_COUNT = sizeof(EFFECTS) / sizeof(EFFECTS[0]);
+
+// Named ids must match their rows
+static_assert(EFFECTS[EFFECT_FIRE].render == FireEffect::render, "EffectType out of sync with the registry");
+static_assert(EFFECTS[EFFECT_METEOR].render == MeteorEffect::render, "EffectType out of sync with the registry");
+static_assert(EFFECTS[EFFECT_VU_METER].render == VuMeterEffect::render, "EffectType out of sync with the registry");
+
+static constexpr size_t align4(size_t n) { return (n + 3) & ~static_cast<size_t>(3); }
+
+static constexpr size_t maxStateSize()
+{
+    size_t size = 0;
+    for (const EffectDescriptor& effect : EFFECTS) size = std::max<size_t>(size, align4(effect.stateSize));
+    return size;
+}
+
+static constexpr size_t maxPixelStateSize()
+{
+    size_t size = 0;
+    for (const EffectDescriptor& effect : EFFECTS) size = std::max<size_t>(size, effect.pixelStateSize);
+    return size;
+}
+
+namespace EffectRegistry {
+
+size_t count()
+{
+    return EFFECT_COUNT;
+}
+
+const EffectDescriptor& get(EffectType type)
+{
+    size_t index = static_cast<size_t>(type);
+    return index < EFFECT_COUNT ? EFFECTS[index] : EFFECTS[EFFECT_NONE];
+}
+
+int find(const char* name)
+{
+    if (name == nullptr) return -1;
+    for (size_t i = 0; i < EFFECT_COUNT; i++) {
+        if (strcmp(EFFECTS[i].name, name) == 0 ||
+            (EFFECTS[i].alias && strcmp(EFFECTS[i].alias, name) == 0)) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+size_t arenaWords(uint16_t numPixels)
+{
+    return (maxStateSize() + align4(maxPixelStateSize() * numPixels)) / 4;
+}
+
+static EffectContext bind(EffectState& s, const EffectDescriptor& effect)
+{
+    EffectContext ctx;
+    ctx.pixels = s.pixels.data();
+    ctx.count = s.pixels.size();
+    ctx.frame = s.counter;
+    ctx.now = s.lastUpdate;
+    ctx.speed = s.speed;
+    ctx.intensity = s.intensity;
+    ctx.color1 = s.color1;
+    ctx.color2 = s.color2;
+    ctx.color3 = s.color3;
+    ctx.emitter = s.emitter;
+    ctx.spatial = s.spatial;
+    ctx.rng = &s.rng;
+    ctx.matrix = s.matrix;
+    ctx.coords = s.coords;
+    uint8_t* arena = reinterpret_cast<uint8_t*>(s.arena.data());
+    ctx.state = arena;
+    ctx.pixelState = arena + align4(effect.stateSize);
+    return ctx;
+}
+
+void clampParams(EffectState& s)
+{
+    const EffectSchema& schema = get(s.type).schema;
+    s.speed = schema.clampSpeed(s.speed);
+    s.intensity = schema.clampIntensity(s.intensity);
+}
+
+void seed(EffectState& s)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    s.rng.seed(s.seed != 0 ? s.seed : esp_random());
+#else
+    s.rng.seed(s.seed != 0 ? s.seed : static_cast<uint32_t>(random(0x7FFFFFFF)));
+#endif
+}
+
+void start(EffectState& s)
+{
+    // Same size for every effect: after the first call this never reallocates
+    s.arena.assign(arenaWords(s.pixels.size()), 0);
+    seed(s);
+
+    const EffectDescriptor& effect = get(s.type);
+    if (effect.init) {
+        EffectContext ctx = bind(s, effect);
+        effect.init(ctx);
+    }
+}
+
+void render(EffectState& s)
+{
+    const EffectDescriptor& effect = get(s.type);
+    EffectContext ctx = bind(s, effect);
+    effect.render(ctx);
+}
+
+void describe(JsonArray& out)
+{
+    for (size_t i = 0; i < EFFECT_COUNT; i++) {
+        const EffectDescriptor& effect = EFFECTS[i];
+        JsonObject entry = out.createNestedObject();
+        entry["id"] = i;
+        entry["name"] = effect.name;
+        if (effect.alias) entry["alias"] = effect.alias;
+        entry["colors"] = effect.schema.colors;
+        JsonArray speed = entry.createNestedArray("speed");
+        speed.add(effect.schema.minSpeed);
+        speed.add(effect.schema.maxSpeed);
+        JsonArray intensity = entry.createNestedArray("intensity");
+        intensity.add(effect.schema.minIntensity);
+        intensity.add(effect.schema.maxIntensity);
+        entry["stateBytes"] = effect.stateSize;
+        entry["pixelStateBytes"] = effect.pixelStateSize;
+    }
+}
+
+} // namespace EffectRegistry
+
+void effectFade(EffectContext& ctx, float fadeAmount)
+{
+    float keep = 1.0f - fadeAmount;
+    for (uint16_t i = 0; i < ctx.count; i++) {
+        WColor& pixel = ctx.pixels[i];
+        pixel.r = static_cast<uint8_t>(pixel.r * keep);
+        pixel.g = static_cast<uint8_t>(pixel.g * keep);
+        pixel.b = static_cast<uint8_t>(pixel.b * keep);
+    }
+}
+
+void effectFill(EffectContext& ctx, const WColor& color)
+{
+    std::fill(ctx.pixels, ctx.pixels + ctx.count, color);
+}
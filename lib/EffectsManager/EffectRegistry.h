@@ -0,0 +1,119 @@
+#ifndef EFFECT_REGISTRY_H
+#define EFFECT_REGISTRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ArduinoJson.h>
+#include <wcolor.h>
+#include <PixelLayout.h>
+#include "utils.h"
+
+/**
+ * @brief What a render function sees of one effect instance for one frame
+ */
+struct EffectContext {
+    WColor* pixels;          ///< Canvas span, kept between frames so trails can fade
+    uint16_t count;
+    uint32_t frame;          ///< Frames rendered since the instance started
+    uint32_t now;            ///< Strip clock time of this frame, LEDStrip::now()
+    float speed;
+    float intensity;
+    WColor color1, color2, color3;
+    EmitterConfig emitter;   ///< Overrides only, see EmitterConfig::resolve
+    SpatialConfig spatial;
+    EffectRandom* rng;       ///< Generator of the instance, use it instead of random()
+    const MatrixLayout* matrix;  ///< 2D view, pixels[matrix->row(y)[x]]; one row when not a matrix
+    const PixelCoords* coords;   ///< Position of pixel i at x()[i], y()[i], z()[i]
+    void* state;             ///< The effect State struct, zeroed before init
+    uint8_t* pixelState;     ///< PIXEL_STATE bytes per pixel, zeroed before init
+
+    template<typename T>
+    T& stateAs() const { return *static_cast<T*>(state); }
+};
+
+typedef void (*EffectFn)(EffectContext& ctx);
+
+/**
+ * @brief Parameters an effect accepts, used to clamp commands and listed on GET /effects
+ */
+struct EffectSchema {
+    uint8_t colors;          ///< Colors the effect reads, 0 when it makes its own
+    float minSpeed = 0.1f;
+    float maxSpeed = 10.0f;
+    float minIntensity = 0.0f;
+    float maxIntensity = 2.0f;
+
+    float clampSpeed(float v) const { return v < minSpeed ? minSpeed : (v > maxSpeed ? maxSpeed : v); }
+    float clampIntensity(float v) const { return v < minIntensity ? minIntensity : (v > maxIntensity ? maxIntensity : v); }
+};
+
+/**
+ * @brief Defaults for effect types: no state, no init
+ */
+struct EffectBase {
+    struct State {};
+    static constexpr uint8_t PIXEL_STATE = 0;
+    static constexpr EffectFn init = nullptr;
+};
+
+/**
+ * @brief One registry row, built from an effect type by EffectDescriptor::of
+ */
+struct EffectDescriptor {
+    const char* name;
+    const char* alias;       ///< Second accepted name, nullptr when none
+    EffectSchema schema;
+    uint16_t stateSize;
+    uint8_t pixelStateSize;
+    EffectFn init;           ///< Runs once on the zeroed state, nullptr when zero is enough
+    EffectFn render;
+
+    template<typename T>
+    static constexpr EffectDescriptor of(const char* name, const char* alias, EffectSchema schema) {
+        static_assert(alignof(typename T::State) <= alignof(uint32_t), "effect state is stored in a word aligned arena");
+        return EffectDescriptor{name, alias, schema,
+                                static_cast<uint16_t>(sizeof(typename T::State)),
+                                T::PIXEL_STATE, T::init, T::render};
+    }
+};
+
+/**
+ * @brief Compile time table of every effect, indexed by EffectType
+ *
+ * Each EffectState owns an arena sized for the largest state of the table,
+ * allocated once, so switching effects only clears and reuses it.
+ *
+ * Adding an effect (test/test_effects has a worked example):
+ *  1. Declare a type deriving from EffectBase with a State struct, a static
+ *     render(EffectContext&) and, if it needs one, a static init.
+ *  2. Append a row to the table in EffectRegistry.cpp. Its index is its
+ *     EffectType id, stored in presets, so rows are never reordered.
+ * No enum value is needed unless other code refers to the effect by name.
+ */
+namespace EffectRegistry {
+    size_t count();
+    // Falls back to the "none" row for unknown ids
+    const EffectDescriptor& get(EffectType type);
+    // Case sensitive, names are lower case. -1 when unknown.
+    int find(const char* name);
+
+    // Words needed by the largest registered effect on numPixels
+    size_t arenaWords(uint16_t numPixels);
+
+    // Clamps speed and intensity to the schema of s.type
+    void clampParams(EffectState& s);
+
+    // Clears the arena, reseeds s.rng and runs the init of s.type. Canvas must be sized.
+    void start(EffectState& s);
+    // Restarts s.rng from s.seed, or from hardware entropy when it is 0
+    void seed(EffectState& s);
+    void render(EffectState& s);
+
+    void describe(JsonArray& out);
+}
+
+// Canvas helpers shared by the effects
+void effectFade(EffectContext& ctx, float fadeAmount);
+void effectFill(EffectContext& ctx, const WColor& color);
+
+#endif // EFFECT_REGISTRY_H
@@ -0,0 +1,134 @@
+#include <cmath>
+#include <algorithm>
+#include <Arduino.h>
+#include "Effects.h"
+
+// Straight RGB blend, same as LEDStrip::blendColors
+static WColor blendLinear(const WColor& a, const WColor& b, float factor)
+{
+    factor = std::max(0.0f, std::min(1.0f, factor));
+    return WColor(static_cast<uint8_t>(a.r * (1.0f - factor) + b.r * factor),
+                  static_cast<uint8_t>(a.g * (1.0f - factor) + b.g * factor),
+                  static_cast<uint8_t>(a.b * (1.0f - factor) + b.b * factor));
+}
+
+// Black, red, yellow, white
+WColor effectHeatColor(uint8_t heat)
+{
+    if (heat < 85) {
+        return WColor(heat * 3, 0, 0);
+    } else if (heat < 170) {
+        return WColor(255, (heat - 85) * 3, 0);
+    }
+    return WColor(255, 255, (heat - 170) * 3);
+}
+
+void RainbowEffect::render(EffectContext& ctx)
+{
+    float hueStep = 360.0f / ctx.count;
+    float baseHue = fmod(ctx.frame * ctx.speed * 0.1f, 360.0f);
+
+    for (uint16_t i = 0; i < ctx.count; i++) {
+        float hue = fmod(baseHue + (i * hueStep), 360.0f);
+        ctx.pixels[i] = WColor::fromHSV(hue, 1.0f, ctx.intensity);
+    }
+}
+
+void BreathingEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    s.phase += ctx.speed * 0.02f;
+    if (s.phase >= 2.0f * M_PI) {
+        s.phase -= 2.0f * M_PI;
+    }
+
+    float intensity = (sinf(s.phase) + 1.0f) * 0.5f * ctx.intensity;
+    intensity = std::max(0.0f, std::min(1.0f, intensity)); // Clamp intensity
+
+    effectFill(ctx, ctx.color1.scale(intensity));
+}
+
+void WaveEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    s.phase += ctx.speed * 0.02f;
+    if (s.phase >= 2.0f * M_PI) {
+        s.phase -= 2.0f * M_PI;
+    }
+
+    for (uint16_t i = 0; i < ctx.count; i++) {
+        float pixelPhase = s.phase + (i * 2.0f * M_PI / (ctx.count * 0.5f));
+        float intensity = (sinf(pixelPhase) + 1.0f) * 0.5f * ctx.intensity;
+        intensity = std::max(0.0f, std::min(1.0f, intensity)); // Clamp intensity
+
+        ctx.pixels[i] = blendLinear(ctx.color2, ctx.color1, intensity);
+    }
+}
+
+void ChaseEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    uint16_t numPixels = ctx.count;
+
+    effectFade(ctx, 0.1f);
+
+    uint16_t chaseLength = std::max(1, static_cast<int>(numPixels * 0.1f));
+    uint16_t headPos = s.position % numPixels;
+
+    for (uint16_t i = 0; i < chaseLength; i++) {
+        uint16_t pos = (headPos + numPixels - i) % numPixels;
+        float intensity = (1.0f - (static_cast<float>(i) / chaseLength)) * ctx.intensity;
+        intensity = std::max(0.0f, std::min(1.0f, intensity));
+
+        ctx.pixels[pos] = ctx.color1.scale(intensity);
+    }
+
+    // Update chase position with bounds checking
+    uint16_t speedStep = std::max(1, static_cast<int>(ctx.speed));
+    s.position = (s.position + speedStep) % numPixels;
+}
+
+void FireEffect::init(EffectContext& ctx)
+{
+    // Pre-seed with some heat at the bottom
+    for (int i = 0; i < std::min(3, static_cast<int>(ctx.count)); i++) {
+        ctx.pixelState[i] = ctx.rng->between(50, 100);
+    }
+}
+
+void FireEffect::render(EffectContext& ctx)
+{
+    uint16_t numPixels = ctx.count;
+    uint8_t* fireHeat = ctx.pixelState;
+
+    // Cool down every cell, noise drawn a block at a time
+    int maxCooldown = std::max(2, (55 * 10) / numPixels + 2);
+    uint8_t noise[32];
+    for (uint16_t base = 0; base < numPixels; base += sizeof(noise)) {
+        uint16_t n = std::min<uint16_t>(sizeof(noise), numPixels - base);
+        ctx.rng->fill(noise, n);
+        for (uint16_t j = 0; j < n; j++) {
+            int cooldown = (noise[j] * maxCooldown) >> 8;   // [0, maxCooldown)
+            uint8_t& heat = fireHeat[base + j];
+            heat = (cooldown >= heat) ? 0 : heat - cooldown;
+        }
+    }
+
+    // Heat diffusion from bottom to top
+    for (int k = numPixels - 1; k >= 2; k--) {
+        fireHeat[k] = (fireHeat[k - 1] + fireHeat[k - 2] + fireHeat[k - 2]) / 3;
+    }
+
+    // Random ignition with controlled intensity
+    uint8_t ignitionChance = static_cast<uint8_t>(std::min(200.0f, ctx.speed * 120.0f));
+    if (ctx.rng->below(255) < ignitionChance) {
+        int y = ctx.rng->below(std::min(7, static_cast<int>(numPixels)));
+        int heatIncrease = ctx.rng->between(160, 255);
+        fireHeat[y] = std::min(255, fireHeat[y] + heatIncrease);
+    }
+
+    // Render fire with proper bounds checking
+    for (uint16_t j = 0; j < numPixels; j++) {
+        ctx.pixels[j] = effectHeatColor(fireHeat[j]).scale(ctx.intensity);
+    }
+}
@@ -0,0 +1,175 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include "EffectRegistry.h"
+#include "ParticlePool.h"
+
+// Built-in effects, registered in EffectRegistry.cpp
+
+struct NoneEffect : EffectBase {
+    static void render(EffectContext&) {}
+};
+
+struct RainbowEffect : EffectBase {
+    static void render(EffectContext& ctx);
+};
+
+struct BreathingEffect : EffectBase {
+    struct State { float phase; };
+    static void render(EffectContext& ctx);
+};
+
+struct WaveEffect : EffectBase {
+    struct State { float phase; };
+    static void render(EffectContext& ctx);
+};
+
+struct ChaseEffect : EffectBase {
+    struct State { uint16_t position; };
+    static void render(EffectContext& ctx);
+};
+
+struct FireEffect : EffectBase {
+    static constexpr uint8_t PIXEL_STATE = 1;   ///< Heat
+    static void init(EffectContext& ctx);
+    static void render(EffectContext& ctx);
+};
+
+// Fire palette from a 0-255 heat, shared by the 1D and 2D fires
+WColor effectHeatColor(uint8_t heat);
+
+// Particle effects, see ParticleEffects.cpp for the emitter defaults
+
+struct ParticleState {
+    ParticlePool<PARTICLE_CAPACITY> pool;
+    uint32_t lastMs;          ///< Time of the previous frame, 0 before the first
+    float emitCredit;         ///< Fractional particles owed by the emitter
+};
+
+struct SparkleEffect : EffectBase {
+    typedef ParticleState State;
+    static void render(EffectContext& ctx);
+};
+
+struct TwinkleEffect : EffectBase {
+    typedef ParticleState State;
+    static void render(EffectContext& ctx);
+};
+
+struct MeteorEffect : EffectBase {
+    struct State : ParticleState {
+        float head;           ///< Pixels
+    };
+    static void render(EffectContext& ctx);
+};
+
+struct CometsEffect : EffectBase {
+    static constexpr uint8_t MAX_HEADS = 6;
+    struct State : ParticleState {
+        uint8_t heads;
+        float headPosition[MAX_HEADS];
+        float headVelocity[MAX_HEADS];
+        WColor headColor[MAX_HEADS];
+    };
+    static void render(EffectContext& ctx);
+};
+
+struct FireworksEffect : EffectBase {
+    static constexpr uint8_t MAX_SHELLS = 4;
+    static constexpr uint8_t SPARKS_PER_SHELL = 20;
+    struct State : ParticleState {
+        uint8_t shells;
+        float shellPosition[MAX_SHELLS];
+        float shellVelocity[MAX_SHELLS];
+        WColor shellColor[MAX_SHELLS];
+    };
+    static void render(EffectContext& ctx);
+};
+
+struct RainEffect : EffectBase {
+    typedef ParticleState State;
+    static void render(EffectContext& ctx);
+};
+
+struct BallsEffect : EffectBase {
+    static constexpr uint8_t MAX_BALLS = 8;
+    typedef ParticleState State;
+    static void render(EffectContext& ctx);
+};
+
+// 2D, render row by row through ctx.matrix, see MatrixEffects.cpp.
+// On a strip without a matrix they see a single row.
+
+struct PlasmaEffect : EffectBase {
+    struct State { float time; };
+    static void render(EffectContext& ctx);
+};
+
+struct Fire2DEffect : EffectBase {
+    static constexpr uint8_t PIXEL_STATE = 1;   ///< Heat, row major
+    static void render(EffectContext& ctx);
+};
+
+struct ScrollEffect : EffectBase {
+    struct State { float offset; };             ///< Fraction of the width
+    static void render(EffectContext& ctx);
+};
+
+struct NoiseFieldEffect : EffectBase {
+    struct State { float z; };                  ///< Depth in the noise, moves with time
+    static void render(EffectContext& ctx);
+};
+
+// Spatial, evaluated on ctx.coords, see SpatialEffects.cpp. Per-pixel terms
+// are cached in the pixel state and only recomputed when the geometry changes.
+
+struct SweepEffect : EffectBase {
+    static constexpr uint8_t PIXEL_STATE = 2;   ///< Position along the direction, 0-65535
+    struct State {
+        float front;                            ///< 0-1 of one pass, trail included
+        float direction[3];                     ///< Of the cached positions
+        bool projected;
+    };
+    static void render(EffectContext& ctx);
+};
+
+struct PulseEffect : EffectBase {
+    static constexpr uint8_t PIXEL_STATE = 2;   ///< Distance to the center, 0-65535
+    struct State {
+        float phase;
+        float center[3];                        ///< Of the cached distances
+        bool measured;
+    };
+    static void render(EffectContext& ctx);
+};
+
+struct Noise3DEffect : EffectBase {
+    struct State { float t; };
+    static void render(EffectContext& ctx);
+};
+
+// Audio reactive, read the AudioAnalyzer snapshot
+
+struct SpectrumEffect : EffectBase {
+    struct State { uint8_t peaks[16]; };          ///< Peak hold, one per audio band
+    static void render(EffectContext& ctx);
+};
+
+struct BeatPulseEffect : EffectBase {
+    struct State {
+        float pulse;                              ///< Envelope, 1 on a beat
+        uint32_t lastBeatCount;                   ///< AudioSnapshot::beatCount already handled
+    };
+    static void init(EffectContext& ctx);
+    static void render(EffectContext& ctx);
+};
+
+struct VuMeterEffect : EffectBase {
+    struct State {
+        float level;                              ///< With a slow release, 0-1
+        uint8_t peak;
+    };
+    static void render(EffectContext& ctx);
+};
+
+#endif // EFFECTS_H
@@ -12,18 +12,6 @@
 // Constructor with proper initialization
 EffectsManager::EffectsManager(LEDStrip* strip) :
     strip(strip),
-    effectCounter(0),
-    effectWColor1(WColor::WHITE),
-    effectWColor2(WColor::BLACK),
-    effectWColor3(WColor::BLACK),
-    chasePosition(0),
-    meteorPosition(0), // Added member variable instead of static
-    breathePhase(0.0f),
-    wavePhase(0.0f),
-    currentEffect(EFFECT_NONE),
-    effectSpeed(1.0f),
-    effectIntensity(1.0f),
-    lastEffectUpdate(0),
     isInitialized(false)
 {
     if (strip == nullptr) {
@@ -44,255 +32,55 @@ void EffectsManager::renderEffect()
         return;
     }
 
-    // Throttle effect updates to prevent excessive CPU usage
-    uint32_t currentTime = millis();
-    uint32_t minInterval = static_cast<uint32_t>(16.0f / effectSpeed); // Base 60fps, adjusted by speed
-    if (currentTime - lastEffectUpdate < minInterval) {
+    if (state.type == EFFECT_NONE) {
         return;
     }
-    lastEffectUpdate = currentTime;
-
-    // Increment effect counter for time-based effects
-    effectCounter++;
-    if (effectCounter > 10000) { // Prevent overflow
-        effectCounter = 0;
-    }
-
-    // Render current effect with error handling
-    try {
-        switch (currentEffect) {
-            case EFFECT_RAINBOW:
-                renderRainbow();
-                break;
-            case EFFECT_BREATHING:
-                renderBreathing();
-                break;
-            case EFFECT_WAVE:
-                renderWave();
-                break;
-            case EFFECT_SPARKLE:
-                renderSparkle();
-                break;
-            case EFFECT_CHASE:
-                renderChase();
-                break;
-            case EFFECT_FIRE:
-                renderFire();
-                break;
-            case EFFECT_TWINKLE:
-                renderTwinkle();
-                break;
-            case EFFECT_METEOR:
-                renderMeteor();
-                break;
-            case EFFECT_NONE:
-            default:
-                // No effect - maintain current state
-                break;
-        }
-    } catch (...) {
-        Serial.println("ERROR: Exception in effect rendering");
-        currentEffect = EFFECT_NONE; // Fallback to safe state
-    }
-}
-
-void EffectsManager::renderRainbow()
-{
-    if (strip->neopixel.numPixels() == 0) return;
-    
-    float hueStep = 360.0f / strip->neopixel.numPixels();
-    float baseHue = fmod(effectCounter * effectSpeed * 0.1f, 360.0f);
-
-    for (uint16_t i = 0; i < strip->neopixel.numPixels(); i++) {
-        float hue = fmod(baseHue + (i * hueStep), 360.0f);
-        WColor color = WColor::fromHSV(hue, 1.0f, effectIntensity);
-        strip->safeSetPixelWColor(i, color);
-    }
-}
-
-void EffectsManager::renderBreathing()
-{
-    breathePhase += effectSpeed * 0.02f;
-    if (breathePhase >= 2.0f * M_PI) {
-        breathePhase -= 2.0f * M_PI;
-    }
-
-    float intensity = (sinf(breathePhase) + 1.0f) * 0.5f * effectIntensity;
-    intensity = std::max(0.0f, std::min(1.0f, intensity)); // Clamp intensity
-    
-    WColor color = effectWColor1.scale(intensity);
-    strip->fill(color);
-}
-
-void EffectsManager::renderWave()
-{
-    if (strip->neopixel.numPixels() == 0) return;
-    
-    wavePhase += effectSpeed * 0.02f;
-    if (wavePhase >= 2.0f * M_PI) {
-        wavePhase -= 2.0f * M_PI;
-    }
 
-    for (uint16_t i = 0; i < strip->neopixel.numPixels(); i++) {
-        float pixelPhase = wavePhase + (i * 2.0f * M_PI / (strip->neopixel.numPixels() * 0.5f));
-        float intensity = (sinf(pixelPhase) + 1.0f) * 0.5f * effectIntensity;
-        intensity = std::max(0.0f, std::min(1.0f, intensity)); // Clamp intensity
-        
-        WColor color = strip->blendColors(effectWColor2, effectWColor1, intensity);
-        strip->safeSetPixelWColor(i, color);
-    }
+    advanceState(state, strip->now());
+    commitState(state);
 }
 
-void EffectsManager::renderSparkle()
+// Advance one effect instance into its own canvas.
+// Returns false when the frame was throttled and the canvas is unchanged.
+bool EffectsManager::advanceState(EffectState& s, uint32_t now)
 {
-    // Thread-safe fade operation
-    if (xSemaphoreTake(strip->stripMutex, pdMS_TO_TICKS(10))) { // Timeout to prevent deadlock
-        float fadeAmount = std::max(0.01f, std::min(0.2f, 0.05f + (effectSpeed * 0.01f)));
-        strip->fadeToBlack(fadeAmount);
-        xSemaphoreGive(strip->stripMutex);
-    } else {
-        return; // Skip this frame if mutex unavailable
+    if (s.type == EFFECT_NONE || s.pixels.empty()) {
+        return false;
     }
 
-    // Add new sparkles with controlled randomness
-    uint8_t sparkleChance = static_cast<uint8_t>(std::min(50.0f, effectSpeed * 20.0f));
-    if (random(100) < sparkleChance) {
-        uint16_t pos = random(strip->neopixel.numPixels());
-        strip->safeSetPixelWColor(pos, effectWColor1.scale(effectIntensity));
+    // Throttle effect updates to prevent excessive CPU usage
+    uint32_t minInterval = static_cast<uint32_t>(16.0f / s.speed); // Base 60fps, adjusted by speed
+    if (now - s.lastUpdate < minInterval) {
+        return false;
     }
-}
+    s.lastUpdate = now;
 
-void EffectsManager::renderChase()
-{
-    if (strip->neopixel.numPixels() == 0) return;
-    
-    // Thread-safe fade operation
-    if (xSemaphoreTake(strip->stripMutex, pdMS_TO_TICKS(10))) {
-        strip->fadeToBlack(0.1f);
-        xSemaphoreGive(strip->stripMutex);
-    } else {
-        return; // Skip this frame if mutex unavailable
+    // Increment effect counter for time-based effects
+    s.counter++;
+    if (s.counter > EFFECT_COUNTER_RESET) { // Prevent overflow
+        s.counter = 0;
     }
 
-    uint16_t chaseLength = std::max(1, static_cast<int>(strip->neopixel.numPixels() * 0.1f));
-    uint16_t headPos = chasePosition % strip->neopixel.numPixels();
-
-    for (uint16_t i = 0; i < chaseLength; i++) {
-        uint16_t pos = (headPos + strip->neopixel.numPixels() - i) % strip->neopixel.numPixels();
-        float intensity = (1.0f - (static_cast<float>(i) / chaseLength)) * effectIntensity;
-        intensity = std::max(0.0f, std::min(1.0f, intensity));
-        
-        WColor color = effectWColor1.scale(intensity);
-        strip->safeSetPixelWColor(pos, color);
+    // Render effect with error handling
+    try {
+        EffectRegistry::render(s);
+    } catch (...) {
+        Serial.println("ERROR: Exception in effect rendering");
+        s.type = EFFECT_NONE; // Fallback to safe state
+        return false;
     }
-
-    // Update chase position with bounds checking
-    uint16_t speedStep = std::max(1, static_cast<int>(effectSpeed));
-    chasePosition = (chasePosition + speedStep) % strip->neopixel.numPixels();
+    return true;
 }
 
-void EffectsManager::renderFire()
+// Copy an instance canvas to the strip (caller holds the strip mutex)
+void EffectsManager::commitState(const EffectState& s)
 {
-    if (fireHeat.empty() || strip->neopixel.numPixels() == 0) return;
-    
-    uint16_t numPixels = strip->neopixel.numPixels();
-    
-    // Ensure fireHeat array is the right size
-    if (fireHeat.size() != numPixels) {
-        fireHeat.resize(numPixels, 0);
-    }
-
-    // Cool down every cell
+    uint16_t numPixels = std::min<uint16_t>(strip->numPixels(), s.pixels.size());
     for (uint16_t i = 0; i < numPixels; i++) {
-        int cooldown = random(0, std::max(2, (55 * 10) / numPixels + 2));
-        fireHeat[i] = (cooldown >= fireHeat[i]) ? 0 : fireHeat[i] - cooldown;
-    }
-
-    // Heat diffusion from bottom to top
-    for (int k = numPixels - 1; k >= 2; k--) {
-        fireHeat[k] = (fireHeat[k - 1] + fireHeat[k - 2] + fireHeat[k - 2]) / 3;
-    }
-
-    // Random ignition with controlled intensity
-    uint8_t ignitionChance = static_cast<uint8_t>(std::min(200.0f, effectSpeed * 120.0f));
-    if (random(255) < ignitionChance) {
-        int y = random(std::min(7, static_cast<int>(numPixels)));
-        int heatIncrease = random(160, 255);
-        fireHeat[y] = std::min(255, fireHeat[y] + heatIncrease);
-    }
-
-    // Render fire with proper bounds checking
-    for (uint16_t j = 0; j < numPixels; j++) {
-        int temp = std::max(0, std::min(255, static_cast<int>(fireHeat[j])));
-        WColor color;
-
-        if (temp < 85) {
-            color = WColor(temp * 3, 0, 0);
-        } else if (temp < 170) {
-            color = WColor(255, (temp - 85) * 3, 0);
-        } else {
-            color = WColor(255, 255, (temp - 170) * 3);
-        }
-
-        color = color.scale(effectIntensity);
-        strip->safeSetPixelWColor(j, color);
-    }
-}
-
-void EffectsManager::renderTwinkle()
-{
-    // Thread-safe fade operation
-    if (xSemaphoreTake(strip->stripMutex, pdMS_TO_TICKS(10))) {
-        float fadeAmount = std::max(0.01f, std::min(0.1f, 0.02f + (effectSpeed * 0.005f)));
-        strip->fadeToBlack(fadeAmount);
-        xSemaphoreGive(strip->stripMutex);
-    } else {
-        return; // Skip this frame if mutex unavailable
-    }
-
-    // Add new twinkles
-    uint8_t twinkleChance = static_cast<uint8_t>(std::min(30.0f, effectSpeed * 10.0f));
-    if (random(100) < twinkleChance) {
-        uint16_t pos = random(strip->neopixel.numPixels());
-        WColor colors[] = {effectWColor1, effectWColor2, effectWColor3};
-        WColor selectedColor = colors[random(3)].scale(effectIntensity);
-        strip->safeSetPixelWColor(pos, selectedColor);
+        strip->safeSetPixelWColor(i, s.pixels[i]);
     }
 }
 
-void EffectsManager::renderMeteor()
-{
-    if (strip->neopixel.numPixels() == 0) return;
-    
-    // Thread-safe fade operation
-    if (xSemaphoreTake(strip->stripMutex, pdMS_TO_TICKS(10))) {
-        strip->fadeToBlack(0.1f);
-        xSemaphoreGive(strip->stripMutex);
-    } else {
-        return; // Skip this frame if mutex unavailable
-    }
-
-    uint16_t numPixels = strip->neopixel.numPixels();
-    uint16_t meteorLength = std::max(1, static_cast<int>(numPixels * 0.05f));
-    uint16_t totalTravel = numPixels + meteorLength;
-    uint16_t headPos = meteorPosition % totalTravel;
-
-    for (uint16_t i = 0; i < meteorLength; i++) {
-        int pos = headPos - i;
-        if (pos >= 0 && pos < static_cast<int>(numPixels)) {
-            float intensity = (1.0f - (static_cast<float>(i) / meteorLength)) * effectIntensity;
-            intensity = std::max(0.0f, std::min(1.0f, intensity));
-            
-            WColor color = effectWColor1.scale(intensity);
-            strip->safeSetPixelWColor(static_cast<uint16_t>(pos), color);
-        }
-    }
-
-    // Update meteor position with bounds checking
-    uint16_t speedStep = std::max(1, static_cast<int>(effectSpeed));
-    meteorPosition = (meteorPosition + speedStep) % totalTravel;
-}
-
 // Safe effect type parsing with validation
 EffectType EffectsManager::parseEffectType(const char *effectName)
 {
@@ -302,15 +90,8 @@ EffectType EffectsManager::parseEffectType(const char *effectName)
     effect.toLowerCase();
     effect.trim(); // Remove whitespace
 
-    if (effect == "none") return EFFECT_NONE;
-    if (effect == "rainbow") return EFFECT_RAINBOW;
-    if (effect == "breathing" || effect == "breathe") return EFFECT_BREATHING;
-    if (effect == "wave") return EFFECT_WAVE;
-    if (effect == "sparkle") return EFFECT_SPARKLE;
-    if (effect == "chase") return EFFECT_CHASE;
-    if (effect == "fire") return EFFECT_FIRE;
-    if (effect == "twinkle") return EFFECT_TWINKLE;
-    if (effect == "meteor") return EFFECT_METEOR;
+    int id = EffectRegistry::find(effect.c_str());
+    if (id >= 0) return static_cast<EffectType>(id);
 
     Serial.printf("WARNING: Unknown effect type: %s\n", effectName);
     return EFFECT_NONE;
@@ -322,8 +103,8 @@ void EffectsManager::setEffect(EffectType effect)
     if (!isInitialized || strip == nullptr) return;
     
     if (xSemaphoreTake(strip->stripMutex, pdMS_TO_TICKS(100))) {
-        if (currentEffect != effect) {
-            currentEffect = effect;
+        if (state.type != effect) {
+            state.type = effect;
             initializeEffectData();
             Serial.printf("Effect changed to: %d\n", static_cast<int>(effect));
         }
@@ -339,7 +120,7 @@ void EffectsManager::setEffectSpeed(float speed)
 {
     if (!isInitialized) return;
     
-    float clampedSpeed = std::max(0.1f, std::min(speed, 10.0f));
+    float clampedSpeed = schema().clampSpeed(speed);
     
     // Increased timeout and added retry logic
     const int maxRetries = 3;
@@ -347,7 +128,7 @@ void EffectsManager::setEffectSpeed(float speed)
     
     for (int retry = 0; retry < maxRetries; retry++) {
         if (xSemaphoreTake(strip->stripMutex, timeout)) {
-            effectSpeed = clampedSpeed;
+            state.speed = clampedSpeed;
             xSemaphoreGive(strip->stripMutex);
             Serial.printf("Effect speed set to: %.2f\n", clampedSpeed);
             return;
@@ -367,7 +148,7 @@ void EffectsManager::setEffectIntensity(float intensity)
 {
     if (!isInitialized) return;
     
-    float clampedIntensity = std::max(0.0f, std::min(intensity, 2.0f));
+    float clampedIntensity = schema().clampIntensity(intensity);
     
     // Increased timeout and added retry logic
     const int maxRetries = 3;
@@ -375,7 +156,7 @@ void EffectsManager::setEffectIntensity(float intensity)
     
     for (int retry = 0; retry < maxRetries; retry++) {
         if (xSemaphoreTake(strip->stripMutex, timeout)) {
-            effectIntensity = clampedIntensity;
+            state.intensity = clampedIntensity;
             xSemaphoreGive(strip->stripMutex);
             Serial.printf("Effect intensity set to: %.2f\n", clampedIntensity);
             return;
@@ -393,50 +174,83 @@ void EffectsManager::setEffectWColors(const WColor &color1, const WColor &color2
     if (!isInitialized) return;
     
     if (xSemaphoreTake(strip->stripMutex, pdMS_TO_TICKS(100))) {
-        effectWColor1 = color1;
-        effectWColor2 = color2;
-        effectWColor3 = color3;
+        state.color1 = color1;
+        state.color2 = color2;
+        state.color3 = color3;
         xSemaphoreGive(strip->stripMutex);
     } else {
         Serial.println("WARNING: Failed to acquire mutex for setEffectWColors");
     }
 }
 
+void EffectsManager::setEmitter(const EmitterConfig &emitter)
+{
+    if (!isInitialized) return;
+
+    if (xSemaphoreTake(strip->stripMutex, pdMS_TO_TICKS(100))) {
+        state.emitter = emitter;
+        xSemaphoreGive(strip->stripMutex);
+    } else {
+        Serial.println("WARNING: Failed to acquire mutex for setEmitter");
+    }
+}
+
+// Spatial effects notice the change and recompute their cached terms
+void EffectsManager::setSpatial(const SpatialConfig &spatial)
+{
+    if (!isInitialized) return;
+
+    if (xSemaphoreTake(strip->stripMutex, pdMS_TO_TICKS(100))) {
+        state.spatial = spatial;
+        xSemaphoreGive(strip->stripMutex);
+    } else {
+        Serial.println("WARNING: Failed to acquire mutex for setSpatial");
+    }
+}
+
+// Restarts the random sequence of the running effect, 0 picks a fresh seed
+void EffectsManager::setSeed(uint32_t seed)
+{
+    if (!isInitialized) return;
+
+    if (xSemaphoreTake(strip->stripMutex, pdMS_TO_TICKS(100))) {
+        state.seed = seed;
+        EffectRegistry::seed(state);
+        xSemaphoreGive(strip->stripMutex);
+    } else {
+        Serial.println("WARNING: Failed to acquire mutex for setSeed");
+    }
+}
+
 // Improved initialization with proper error handling
 void EffectsManager::initializeEffectData()
 {
-    if (strip == nullptr || strip->neopixel.numPixels() == 0) {
+    initializeState(state, true);
+}
+
+// Reset the animation state of an instance and size its canvas.
+// Buffers keep their capacity, so re-initializing does not allocate.
+void EffectsManager::initializeState(EffectState& s, bool seedFromStrip)
+{
+    if (strip == nullptr || strip->numPixels() == 0) {
         Serial.println("ERROR: Cannot initialize effect data - invalid strip");
         return;
     }
 
-    uint16_t numPixels = strip->neopixel.numPixels();
+    uint16_t numPixels = strip->numPixels();
     
-    // Clear existing data
-    sparklePositions.clear();
-    sparkleIntensities.clear();
-    fireHeat.clear();
-
-    // Initialize effect-specific data based on current effect
     try {
-        switch (currentEffect) {
-            case EFFECT_SPARKLE:
-            case EFFECT_TWINKLE:
-                sparklePositions.reserve(numPixels / 4);
-                sparkleIntensities.reserve(numPixels / 4);
-                break;
-
-            case EFFECT_FIRE:
-                fireHeat.resize(numPixels, 0);
-                // Pre-seed with some heat at the bottom
-                for (int i = 0; i < std::min(3, static_cast<int>(numPixels)); i++) {
-                    fireHeat[i] = random(50, 100);
-                }
-                break;
-
-            default:
-                break;
+        s.pixels.resize(numPixels, WColor::BLACK);
+        s.matrix = &strip->matrix;
+        s.coords = &strip->coords;
+
+        // Fading effects start from what is currently shown
+        for (uint16_t i = 0; i < numPixels; i++) {
+            s.pixels[i] = seedFromStrip ? strip->getPixelWColor(i) : WColor::BLACK;
         }
+
+        // Zeroes the arena and runs the effect init
+        EffectRegistry::start(s);
     } catch (const std::exception& e) {
         Serial.printf("ERROR: Exception during effect data initialization: %s\n", e.what());
     } catch (...) {
@@ -444,11 +258,8 @@ void EffectsManager::initializeEffectData()
     }
 
     // Reset animation state
-    chasePosition = 0;
-    meteorPosition = 0;
-    breathePhase = 0.0f;
-    wavePhase = 0.0f;
-    effectCounter = 0;
+    s.counter = 0;
+    s.lastUpdate = 0;
 }
 
 // Smooth transition methods with improved error handling
@@ -494,7 +305,7 @@ void EffectsManager::setEffectSpeedSmooth(float speed)
         return;
     }
 
-    float clampedSpeed = std::max(0.1f, std::min(speed, 10.0f));
+    float clampedSpeed = schema().clampSpeed(speed);
     const TickType_t timeout = pdMS_TO_TICKS(500);
     
     if (xSemaphoreTake(strip->stripMutex, timeout)) {
@@ -503,17 +314,17 @@ void EffectsManager::setEffectSpeedSmooth(float speed)
 
         // Set up transition parameters
         strip->transitionsManager->transition.active = true;
-        strip->transitionsManager->transition.startTime = millis();
+        strip->transitionsManager->transition.startTime = strip->now();
         strip->transitionsManager->transition.duration = strip->transitionsManager->defaultTransitionDuration;
         strip->transitionsManager->transition.type = strip->transitionsManager->defaultTransitionType;
-        strip->transitionsManager->transition.targetEffect = currentEffect;
+        strip->transitionsManager->transition.targetEffect = state.type;
         strip->transitionsManager->transition.targetSpeed = clampedSpeed;
         
         // Keep other parameters unchanged
-        strip->transitionsManager->transition.targetIntensity = effectIntensity;
-        strip->transitionsManager->transition.targetColor1 = effectWColor1;
-        strip->transitionsManager->transition.targetColor2 = effectWColor2;
-        strip->transitionsManager->transition.targetColor3 = effectWColor3;
+        strip->transitionsManager->transition.targetIntensity = state.intensity;
+        strip->transitionsManager->transition.targetColor1 = state.color1;
+        strip->transitionsManager->transition.targetColor2 = state.color2;
+        strip->transitionsManager->transition.targetColor3 = state.color3;
         strip->transitionsManager->transition.targetBrightness = strip->neopixel.getBrightness();
 
         Serial.printf("Started smooth speed transition to: %.2f\n", clampedSpeed);
@@ -528,11 +339,11 @@ void EffectsManager::setEffectSpeedNonBlocking(float speed)
 {
     if (!isInitialized) return;
     
-    float clampedSpeed = std::max(0.1f, std::min(speed, 10.0f));
+    float clampedSpeed = schema().clampSpeed(speed);
     
     // Try to acquire mutex without blocking
     if (xSemaphoreTake(strip->stripMutex, 0)) {
-        effectSpeed = clampedSpeed;
+        state.speed = clampedSpeed;
         xSemaphoreGive(strip->stripMutex);
         Serial.printf("Effect speed set to: %.2f (non-blocking)\n", clampedSpeed);
     } else {
@@ -549,10 +360,10 @@ void EffectsManager::setEffectIntensityNonBlocking(float intensity)
 {
     if (!isInitialized) return;
     
-    float clampedIntensity = std::max(0.0f, std::min(intensity, 2.0f));
+    float clampedIntensity = schema().clampIntensity(intensity);
     
     if (xSemaphoreTake(strip->stripMutex, 0)) {
-        effectIntensity = clampedIntensity;
+        state.intensity = clampedIntensity;
         xSemaphoreGive(strip->stripMutex);
         Serial.printf("Effect intensity set to: %.2f (non-blocking)\n", clampedIntensity);
     } else {
@@ -573,15 +384,16 @@ void EffectsManager::processPendingUpdates()
     // Try to acquire mutex without blocking
     if (xSemaphoreTake(strip->stripMutex, 0)) {
         if (hasPendingSpeedUpdate) {
-            effectSpeed = pendingSpeedUpdate;
+            // The effect may have changed since the update was queued
+            state.speed = schema().clampSpeed(pendingSpeedUpdate);
             hasPendingSpeedUpdate = false;
-            Serial.printf("Applied pending speed update: %.2f\n", pendingSpeedUpdate);
+            Serial.printf("Applied pending speed update: %.2f\n", state.speed);
         }
         
         if (hasPendingIntensityUpdate) {
-            effectIntensity = pendingIntensityUpdate;
+            state.intensity = schema().clampIntensity(pendingIntensityUpdate);
             hasPendingIntensityUpdate = false;
-            Serial.printf("Applied pending intensity update: %.2f\n", pendingIntensityUpdate);
+            Serial.printf("Applied pending intensity update: %.2f\n", state.intensity);
         }
         
         xSemaphoreGive(strip->stripMutex);
@@ -603,24 +415,24 @@ void EffectsManager::setEffectIntensitySmooth(float intensity)
         return;
     }
 
-    float clampedIntensity = std::max(0.0f, std::min(intensity, 2.0f));
+    float clampedIntensity = schema().clampIntensity(intensity);
     const TickType_t timeout = pdMS_TO_TICKS(500);
     
     if (xSemaphoreTake(strip->stripMutex, timeout)) {
         strip->captureCurrentState();
 
         strip->transitionsManager->transition.active = true;
-        strip->transitionsManager->transition.startTime = millis();
+        strip->transitionsManager->transition.startTime = strip->now();
         strip->transitionsManager->transition.duration = strip->transitionsManager->defaultTransitionDuration;
         strip->transitionsManager->transition.type = strip->transitionsManager->defaultTransitionType;
-        strip->transitionsManager->transition.targetEffect = currentEffect;
+        strip->transitionsManager->transition.targetEffect = state.type;
         strip->transitionsManager->transition.targetIntensity = clampedIntensity;
         
         // Keep other parameters unchanged
-        strip->transitionsManager->transition.targetSpeed = effectSpeed;
-        strip->transitionsManager->transition.targetColor1 = effectWColor1;
-        strip->transitionsManager->transition.targetColor2 = effectWColor2;
-        strip->transitionsManager->transition.targetColor3 = effectWColor3;
+        strip->transitionsManager->transition.targetSpeed = state.speed;
+        strip->transitionsManager->transition.targetColor1 = state.color1;
+        strip->transitionsManager->transition.targetColor2 = state.color2;
+        strip->transitionsManager->transition.targetColor3 = state.color3;
         strip->transitionsManager->transition.targetBrightness = strip->neopixel.getBrightness();
 
         Serial.printf("Started smooth intensity transition to: %.2f\n", clampedIntensity);
@@ -642,10 +454,10 @@ void EffectsManager::setEffectWColorsSmooth(const WColor &color1, const WColor &
         strip->captureCurrentState();
 
         strip->transitionsManager->transition.active = true;
-        strip->transitionsManager->transition.startTime = millis();
+        strip->transitionsManager->transition.startTime = strip->now();
         strip->transitionsManager->transition.duration = strip->transitionsManager->defaultTransitionDuration;
         strip->transitionsManager->transition.type = strip->transitionsManager->defaultTransitionType;
-        strip->transitionsManager->transition.targetEffect = currentEffect;
+        strip->transitionsManager->transition.targetEffect = state.type;
         strip->transitionsManager->transition.targetColor1 = color1;
         strip->transitionsManager->transition.targetColor2 = color2;
         strip->transitionsManager->transition.targetColor3 = color3;
@@ -667,12 +479,12 @@ void EffectsManager::blendEffectParameters(float factor)
     // Blend speed with bounds checking
     float newSpeed = strip->transitionsManager->transition.sourceSpeed * (1.0f - factor) + 
                      strip->transitionsManager->transition.targetSpeed * factor;
-    effectSpeed = std::max(0.1f, std::min(10.0f, newSpeed));
+    state.speed = schema().clampSpeed(newSpeed);
 
     // Blend intensity with bounds checking
     float newIntensity = strip->transitionsManager->transition.sourceIntensity * (1.0f - factor) + 
                          strip->transitionsManager->transition.targetIntensity * factor;
-    effectIntensity = std::max(0.0f, std::min(2.0f, newIntensity));
+    state.intensity = schema().clampIntensity(newIntensity);
 
     // Blend brightness with bounds checking
     float newBrightness = strip->transitionsManager->transition.sourceBrightness * (1.0f - factor) + 
@@ -681,10 +493,10 @@ void EffectsManager::blendEffectParameters(float factor)
     strip->neopixel.setBrightness(brightness);
 
     // Blend colors
-    effectWColor1 = strip->blendColors(strip->transitionsManager->transition.sourceColor1, 
+    state.color1 = strip->blendColors(strip->transitionsManager->transition.sourceColor1, 
                                        strip->transitionsManager->transition.targetColor1, factor);
-    effectWColor2 = strip->blendColors(strip->transitionsManager->transition.sourceColor2, 
+    state.color2 = strip->blendColors(strip->transitionsManager->transition.sourceColor2, 
                                        strip->transitionsManager->transition.targetColor2, factor);
-    effectWColor3 = strip->blendColors(strip->transitionsManager->transition.sourceColor3, 
+    state.color3 = strip->blendColors(strip->transitionsManager->transition.sourceColor3, 
                                        strip->transitionsManager->transition.targetColor3, factor);
 }
\ No newline at end of file
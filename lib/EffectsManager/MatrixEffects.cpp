@@ -0,0 +1,181 @@
+#include <cmath>
+#include <algorithm>
+#include <Arduino.h>
+#include "Effects.h"
+#include "Noise.h"
+
+// Columns whose per-frame terms are precomputed at once. Keeps the scratch
+// on the render task stack small whatever the matrix width.
+static constexpr uint16_t COLUMN_BLOCK = 32;
+
+static inline int8_t sinQ7(float angle)
+{
+    return static_cast<int8_t>(sinf(angle) * 127.0f);
+}
+
+// Three interfering waves: one along x, one along y and one along the
+// diagonal. Column terms are computed per block, row terms per row, so the
+// inner loop is integer adds and a palette read.
+void PlasmaEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    const MatrixLayout* m = ctx.matrix;
+    if (m == nullptr) return;
+
+    s.time += 0.04f * ctx.speed;
+    float t = s.time;
+    uint16_t w = m->width();
+    uint16_t h = m->height();
+    float k = 6.0f / std::max<uint16_t>(8, std::max(w, h));   // Same look on any size
+
+    WColor palette[64];
+    float brightness = std::min(1.0f, ctx.intensity);
+    float hueShift = fmodf(t * 20.0f, 360.0f);
+    for (uint8_t i = 0; i < 64; i++) {
+        palette[i] = WColor::fromHSV(fmodf(hueShift + i * (360.0f / 64.0f), 360.0f), 1.0f, brightness);
+    }
+
+    int8_t colWave[COLUMN_BLOCK], colSin[COLUMN_BLOCK], colCos[COLUMN_BLOCK];
+    for (uint16_t x0 = 0; x0 < w; x0 += COLUMN_BLOCK) {
+        uint16_t n = std::min<uint16_t>(COLUMN_BLOCK, w - x0);
+        for (uint16_t j = 0; j < n; j++) {
+            float x = x0 + j;
+            colWave[j] = sinQ7(x * k + t);
+            colSin[j] = sinQ7(x * k * 0.6f + t * 0.5f);
+            colCos[j] = sinQ7(x * k * 0.6f + t * 0.5f + static_cast<float>(M_PI_2));
+        }
+
+        for (uint16_t y = 0; y < h; y++) {
+            int rowWave = sinQ7(y * k * 0.8f - t * 0.7f);
+            int rowSin = sinQ7(y * k * 0.6f);
+            int rowCos = sinQ7(y * k * 0.6f + static_cast<float>(M_PI_2));
+            const uint16_t* row = m->row(y) + x0;
+            for (uint16_t j = 0; j < n; j++) {
+                // sin(a + b) from the column and row halves
+                int diagonal = (colSin[j] * rowCos + colCos[j] * rowSin) >> 7;
+                int sum = colWave[j] + rowWave + diagonal + 384;   // 0-767
+                ctx.pixels[row[j]] = palette[(sum * 21) >> 8];
+            }
+        }
+    }
+}
+
+// Heat rises from the bottom row, spreading sideways and cooling on the way
+void Fire2DEffect::render(EffectContext& ctx)
+{
+    const MatrixLayout* m = ctx.matrix;
+    if (m == nullptr) return;
+
+    uint16_t w = m->width();
+    uint16_t h = m->height();
+    uint8_t* heat = ctx.pixelState;
+
+    // Cool every cell, taller fires cool slower so flames reach the top
+    int maxCooldown = 55 / h + 2;
+    uint8_t noise[32];
+    uint32_t cells = static_cast<uint32_t>(w) * h;
+    for (uint32_t base = 0; base < cells; base += sizeof(noise)) {
+        uint16_t n = std::min<uint32_t>(sizeof(noise), cells - base);
+        ctx.rng->fill(noise, n);
+        for (uint16_t j = 0; j < n; j++) {
+            int cooldown = (noise[j] * maxCooldown) >> 8;
+            uint8_t& cell = heat[base + j];
+            cell = (cooldown >= cell) ? 0 : cell - cooldown;
+        }
+    }
+
+    // Each cell takes the heat of the three cells below it and the one under those
+    for (uint16_t y = 0; y + 1 < h; y++) {
+        const uint8_t* below = heat + (y + 1) * w;
+        const uint8_t* below2 = heat + std::min<uint16_t>(y + 2, h - 1) * w;
+        uint8_t* row = heat + y * w;
+        for (uint16_t x = 0; x < w; x++) {
+            uint16_t left = x > 0 ? x - 1 : x;
+            uint16_t right = x + 1 < w ? x + 1 : x;
+            row[x] = (below[left] + below[x] + below[right] + below2[x]) >> 2;
+        }
+    }
+
+    // Sparks along the bottom row
+    uint8_t* base = heat + (h - 1) * w;
+    uint8_t ignitionChance = static_cast<uint8_t>(std::min(200.0f, ctx.speed * 60.0f));
+    for (uint16_t x = 0; x < w; x++) {
+        if (ctx.rng->below(255) < ignitionChance) {
+            base[x] = std::max<int>(base[x], ctx.rng->between(160, 255));
+        }
+    }
+
+    for (uint16_t y = 0; y < h; y++) {
+        const uint16_t* row = m->row(y);
+        const uint8_t* cells = heat + y * w;
+        for (uint16_t x = 0; x < w; x++) {
+            ctx.pixels[row[x]] = effectHeatColor(cells[x]).scale(ctx.intensity);
+        }
+    }
+}
+
+// Gradient through the effect colors, scrolling horizontally and wrapping
+// back to the first color. Each block of columns is computed once and
+// copied down the rows.
+void ScrollEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    const MatrixLayout* m = ctx.matrix;
+    if (m == nullptr) return;
+
+    s.offset += 0.004f * ctx.speed;
+    s.offset -= floorf(s.offset);
+
+    const WColor* stops[3] = {&ctx.color1, &ctx.color2, &ctx.color3};
+    uint8_t stopCount = ctx.color3 != WColor::BLACK ? 3 : 2;
+    float brightness = std::min(1.0f, ctx.intensity);
+
+    uint16_t w = m->width();
+    uint16_t h = m->height();
+    WColor column[COLUMN_BLOCK];
+    for (uint16_t x0 = 0; x0 < w; x0 += COLUMN_BLOCK) {
+        uint16_t n = std::min<uint16_t>(COLUMN_BLOCK, w - x0);
+        for (uint16_t j = 0; j < n; j++) {
+            float u = static_cast<float>(x0 + j) / w + s.offset;
+            u = (u - floorf(u)) * stopCount;
+            uint8_t from = static_cast<uint8_t>(u);
+            const WColor& a = *stops[from];
+            const WColor& b = *stops[(from + 1) % stopCount];
+            column[j] = a.lerp(b, u - from).scale(brightness);
+        }
+        for (uint16_t y = 0; y < h; y++) {
+            const uint16_t* row = m->row(y) + x0;
+            for (uint16_t j = 0; j < n; j++) {
+                ctx.pixels[row[j]] = column[j];
+            }
+        }
+    }
+}
+
+// Slowly drifting clouds of value noise. Hues when no second color is set,
+// otherwise a blend from color2 (low) to color1 (high).
+void NoiseFieldEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    const MatrixLayout* m = ctx.matrix;
+    if (m == nullptr) return;
+
+    s.z += 0.015f * ctx.speed;
+    uint16_t w = m->width();
+    uint16_t h = m->height();
+    float scale = 4.0f / std::max<uint16_t>(4, std::max(w, h));   // About four blobs across
+    float brightness = std::min(1.0f, ctx.intensity);
+    bool hues = ctx.color2 == WColor::BLACK;
+    float hueShift = fmodf(s.z * 30.0f, 360.0f);
+
+    for (uint16_t y = 0; y < h; y++) {
+        const uint16_t* row = m->row(y);
+        float fy = y * scale;
+        for (uint16_t x = 0; x < w; x++) {
+            float v = valueNoise3(x * scale, fy, s.z);
+            ctx.pixels[row[x]] = hues
+                ? WColor::fromHSV(fmodf(hueShift + v * 540.0f, 360.0f), 1.0f, brightness)
+                : ctx.color2.lerp(ctx.color1, v).scale(brightness);
+        }
+    }
+}
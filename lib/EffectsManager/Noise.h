@@ -0,0 +1,53 @@
+#ifndef EFFECT_NOISE_H
+#define EFFECT_NOISE_H
+
+#include <stdint.h>
+#include <math.h>
+
+// Value noise: random values on an integer lattice, smoothly interpolated
+// between its points. Stateless, so the same coordinates give the same value
+// on every frame and every instance.
+
+inline uint32_t noiseHash(int32_t x, int32_t y, int32_t z)
+{
+    uint32_t h = static_cast<uint32_t>(x) * 0x8DA6B343u ^
+                 static_cast<uint32_t>(y) * 0xD8163841u ^
+                 static_cast<uint32_t>(z) * 0xCB1AB31Fu;
+    h ^= h >> 13;
+    h *= 0x5BD1E995u;
+    h ^= h >> 15;
+    return h;
+}
+
+inline float noiseLattice(int32_t x, int32_t y, int32_t z)
+{
+    return (noiseHash(x, y, z) & 0xFFFF) * (1.0f / 65535.0f);
+}
+
+// 0-1, smooth in all three axes
+inline float valueNoise3(float x, float y, float z)
+{
+    float fx = floorf(x), fy = floorf(y), fz = floorf(z);
+    int32_t ix = static_cast<int32_t>(fx);
+    int32_t iy = static_cast<int32_t>(fy);
+    int32_t iz = static_cast<int32_t>(fz);
+    float tx = x - fx, ty = y - fy, tz = z - fz;
+    tx = tx * tx * (3.0f - 2.0f * tx);
+    ty = ty * ty * (3.0f - 2.0f * ty);
+    tz = tz * tz * (3.0f - 2.0f * tz);
+
+    float c000 = noiseLattice(ix, iy, iz),     c100 = noiseLattice(ix + 1, iy, iz);
+    float c010 = noiseLattice(ix, iy + 1, iz), c110 = noiseLattice(ix + 1, iy + 1, iz);
+    float c001 = noiseLattice(ix, iy, iz + 1), c101 = noiseLattice(ix + 1, iy, iz + 1);
+    float c011 = noiseLattice(ix, iy + 1, iz + 1), c111 = noiseLattice(ix + 1, iy + 1, iz + 1);
+
+    float x00 = c000 + (c100 - c000) * tx;
+    float x10 = c010 + (c110 - c010) * tx;
+    float x01 = c001 + (c101 - c001) * tx;
+    float x11 = c011 + (c111 - c011) * tx;
+    float y0 = x00 + (x10 - x00) * ty;
+    float y1 = x01 + (x11 - x01) * ty;
+    return y0 + (y1 - y0) * tz;
+}
+
+#endif // EFFECT_NOISE_H
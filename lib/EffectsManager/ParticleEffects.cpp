@@ -0,0 +1,284 @@
+#include <cmath>
+#include <algorithm>
+#include <Arduino.h>
+#include "Effects.h"
+
+// Emitter defaults, overridden field by field by the "emitter" object of the
+// effect command. Velocities and gravity are in strip lengths so the same
+// settings look alike on short and long strips.
+static EmitterConfig emitterDefaults(float rate, float life, float velocity,
+                                     float spread, float gravity, float size)
+{
+    EmitterConfig c;
+    c.rate = rate;
+    c.life = life;
+    c.velocity = velocity;
+    c.spread = spread;
+    c.gravity = gravity;
+    c.size = size;
+    return c;
+}
+
+//                                                    rate   life   velocity spread gravity size
+static const EmitterConfig SPARKLE_EMITTER   = emitterDefaults(12.0f, 0.35f, 0.0f, 0.0f, 0.0f, 1.0f);
+static const EmitterConfig TWINKLE_EMITTER   = emitterDefaults(4.0f,  1.6f,  0.0f, 0.0f, 0.0f, 1.0f);
+static const EmitterConfig METEOR_EMITTER    = emitterDefaults(60.0f, 0.5f,  1.0f, 0.0f, 0.0f, 2.0f);
+static const EmitterConfig COMETS_EMITTER    = emitterDefaults(1.2f,  0.5f,  0.5f, 0.5f, 0.0f, 2.0f);
+static const EmitterConfig FIREWORKS_EMITTER = emitterDefaults(0.8f,  1.2f,  0.4f, 1.0f, 1.0f, 1.0f);
+static const EmitterConfig RAIN_EMITTER      = emitterDefaults(6.0f,  4.0f,  0.2f, 0.5f, 0.8f, 1.5f);
+static const EmitterConfig BALLS_EMITTER     = emitterDefaults(3.0f,  0.0f,  1.7f, 0.2f, 1.5f, 2.0f);
+
+// Seconds to simulate since the previous frame, scaled by the effect speed.
+// Capped so a stalled render task does not make particles jump.
+static float stepSeconds(EffectContext& ctx, ParticleState& s)
+{
+    float dt = s.lastMs == 0 ? 0.016f : (ctx.now - s.lastMs) / 1000.0f;
+    s.lastMs = ctx.now;
+    return std::min(dt, 0.1f) * ctx.speed;
+}
+
+// Whole particles the emitter owes for this frame
+static uint16_t emitCount(ParticleState& s, float rate, float dt)
+{
+    s.emitCredit += rate * dt;
+    uint16_t n = static_cast<uint16_t>(s.emitCredit);
+    s.emitCredit -= n;
+    return n;
+}
+
+// One of the non-black effect colors, or a random hue when only color1 is set
+static WColor pickColor(const EffectContext& ctx, bool hueWhenSingle)
+{
+    const WColor* colors[3];
+    uint8_t n = 0;
+    if (ctx.color1 != WColor::BLACK) colors[n++] = &ctx.color1;
+    if (ctx.color2 != WColor::BLACK) colors[n++] = &ctx.color2;
+    if (ctx.color3 != WColor::BLACK) colors[n++] = &ctx.color3;
+    if (hueWhenSingle && n <= 1 && ctx.color1 == WColor::WHITE) {
+        return WColor::fromHSV(ctx.rng->below(360), 1.0f, 1.0f);
+    }
+    return n == 0 ? WColor::WHITE : *colors[ctx.rng->below(n)];
+}
+
+static void clearCanvas(EffectContext& ctx)
+{
+    effectFill(ctx, WColor::BLACK);
+}
+
+// Short lived points at random positions
+void SparkleEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    EmitterConfig e = ctx.emitter.resolve(SPARKLE_EMITTER);
+    float dt = stepSeconds(ctx, s);
+
+    s.pool.update(dt, e.gravity * ctx.count, -e.size, ctx.count + e.size);
+    for (uint16_t n = emitCount(s, e.rate, dt); n > 0; n--) {
+        float velocity = e.velocity * ctx.count * (ctx.rng->unit() * 2.0f - 1.0f);
+        s.pool.spawn(ctx.rng->below(ctx.count) + 0.5f, velocity, ctx.color1, e.life);
+    }
+
+    clearCanvas(ctx);
+    s.pool.splat(ctx.pixels, ctx.count, e.size, 2.0f, ctx.intensity);
+}
+
+// Points that fade in and out, in any of the effect colors
+void TwinkleEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    EmitterConfig e = ctx.emitter.resolve(TWINKLE_EMITTER);
+    float dt = stepSeconds(ctx, s);
+
+    s.pool.update(dt, e.gravity * ctx.count, -e.size, ctx.count + e.size);
+    for (uint16_t n = emitCount(s, e.rate, dt); n > 0; n--) {
+        float lifetime = e.life * (1.0f - e.spread * ctx.rng->unit());
+        s.pool.spawn(ctx.rng->below(ctx.count) + 0.5f, 0.0f, pickColor(ctx, false), lifetime);
+    }
+
+    clearCanvas(ctx);
+    ParticlePool<PARTICLE_CAPACITY>& p = s.pool;
+    for (uint16_t i = 0; i < p.count; i++) {
+        float brightness = sinf(static_cast<float>(M_PI) * p.life[i]) * ctx.intensity;
+        splatOne(ctx.pixels, ctx.count, p.position[i], e.size,
+                 WColor(p.red[i], p.green[i], p.blue[i]), brightness);
+    }
+}
+
+// Head crossing the strip, shedding a trail of fading particles
+void MeteorEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    EmitterConfig e = ctx.emitter.resolve(METEOR_EMITTER);
+    float dt = stepSeconds(ctx, s);
+
+    float tail = std::max(1.0f, ctx.count * 0.05f);
+    s.head += e.velocity * ctx.count * dt;
+    if (s.head > ctx.count + tail) {
+        s.head = -e.size;
+    }
+
+    s.pool.update(dt, e.gravity * ctx.count, -e.size, ctx.count + e.size);
+    for (uint16_t n = emitCount(s, e.rate, dt); n > 0; n--) {
+        float jitter = (ctx.rng->unit() - 0.5f) * e.spread * tail;
+        s.pool.spawn(s.head + jitter, 0.0f, ctx.color1, e.life);
+    }
+
+    clearCanvas(ctx);
+    s.pool.splat(ctx.pixels, ctx.count, 1.0f, 2.0f, ctx.intensity * 0.6f);
+    splatOne(ctx.pixels, ctx.count, s.head, e.size, ctx.color1, std::min(1.0f, ctx.intensity));
+}
+
+// Several meteors launched from both ends at different speeds
+void CometsEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    EmitterConfig e = ctx.emitter.resolve(COMETS_EMITTER);
+    float dt = stepSeconds(ctx, s);
+    float n = ctx.count;
+
+    // Launches use the emitter rate, trails a fixed rate per comet
+    for (uint16_t k = emitCount(s, e.rate, dt); k > 0 && s.heads < MAX_HEADS; k--) {
+        bool fromStart = ctx.rng->below(2) == 0;
+        float velocity = e.velocity * n * (1.0f - e.spread * ctx.rng->unit() * 0.8f);
+        s.headPosition[s.heads] = fromStart ? -e.size : n + e.size;
+        s.headVelocity[s.heads] = fromStart ? velocity : -velocity;
+        s.headColor[s.heads] = pickColor(ctx, true);
+        s.heads++;
+    }
+
+    s.pool.update(dt, e.gravity * n, -e.size, n + e.size);
+
+    uint8_t h = 0;
+    while (h < s.heads) {
+        s.headPosition[h] += s.headVelocity[h] * dt;
+        float pos = s.headPosition[h];
+        if (pos < -2.0f * e.size || pos > n + 2.0f * e.size) {
+            // Swap remove, like the pool
+            s.heads--;
+            s.headPosition[h] = s.headPosition[s.heads];
+            s.headVelocity[h] = s.headVelocity[s.heads];
+            s.headColor[h] = s.headColor[s.heads];
+            continue;
+        }
+        if (ctx.rng->unit() < dt * 30.0f) {
+            s.pool.spawn(pos, s.headVelocity[h] * 0.1f, s.headColor[h], e.life);
+        }
+        h++;
+    }
+
+    clearCanvas(ctx);
+    s.pool.splat(ctx.pixels, ctx.count, 1.0f, 2.0f, ctx.intensity * 0.6f);
+    for (h = 0; h < s.heads; h++) {
+        splatOne(ctx.pixels, ctx.count, s.headPosition[h], e.size, s.headColor[h], std::min(1.0f, ctx.intensity));
+    }
+}
+
+// Shells rise from the first pixel and burst into sparks at their apex
+void FireworksEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    EmitterConfig e = ctx.emitter.resolve(FIREWORKS_EMITTER);
+    float dt = stepSeconds(ctx, s);
+    float n = ctx.count;
+    float gravity = std::max(0.05f, e.gravity) * n;
+
+    for (uint16_t k = emitCount(s, e.rate, dt); k > 0 && s.shells < MAX_SHELLS; k--) {
+        // Launch speed that reaches 50-90% of the strip
+        float apex = n * (0.5f + 0.4f * ctx.rng->unit());
+        s.shellPosition[s.shells] = 0.0f;
+        s.shellVelocity[s.shells] = sqrtf(2.0f * gravity * apex);
+        s.shellColor[s.shells] = pickColor(ctx, true);
+        s.shells++;
+    }
+
+    // Sparks fall slower than shells, as if slowed by the air
+    s.pool.update(dt, gravity * 0.25f, -e.size, n + e.size);
+
+    uint8_t i = 0;
+    while (i < s.shells) {
+        s.shellVelocity[i] -= gravity * dt;
+        s.shellPosition[i] += s.shellVelocity[i] * dt;
+        if (s.shellVelocity[i] > 0.0f) {
+            i++;
+            continue;
+        }
+        for (uint8_t k = 0; k < SPARKS_PER_SHELL; k++) {
+            float velocity = e.velocity * n * (ctx.rng->unit() * 2.0f - 1.0f) * e.spread;
+            float lifetime = e.life * (0.6f + 0.4f * ctx.rng->unit());
+            s.pool.spawn(s.shellPosition[i], velocity, s.shellColor[i], lifetime);
+        }
+        s.shells--;
+        s.shellPosition[i] = s.shellPosition[s.shells];
+        s.shellVelocity[i] = s.shellVelocity[s.shells];
+        s.shellColor[i] = s.shellColor[s.shells];
+    }
+
+    clearCanvas(ctx);
+    s.pool.splat(ctx.pixels, ctx.count, e.size, 1.5f, ctx.intensity);
+    for (i = 0; i < s.shells; i++) {
+        splatOne(ctx.pixels, ctx.count, s.shellPosition[i], 1.0f, WColor(255, 180, 80), 0.5f * ctx.intensity);
+    }
+}
+
+// Drops falling from the last pixel toward the first
+void RainEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    EmitterConfig e = ctx.emitter.resolve(RAIN_EMITTER);
+    float dt = stepSeconds(ctx, s);
+    float n = ctx.count;
+
+    s.pool.update(dt, e.gravity * n, -e.size, n + e.size);
+    for (uint16_t k = emitCount(s, e.rate, dt); k > 0; k--) {
+        float velocity = -e.velocity * n * (1.0f - e.spread * ctx.rng->unit());
+        s.pool.spawn(n - 0.5f - ctx.rng->unit() * 2.0f, velocity, ctx.color1, e.life);
+    }
+
+    clearCanvas(ctx);
+    ParticlePool<PARTICLE_CAPACITY>& p = s.pool;
+    for (uint16_t i = 0; i < p.count; i++) {
+        // Short streak behind each drop, brighter when falling faster
+        float streak = std::min(4.0f, e.size + fabsf(p.velocity[i]) * 0.02f);
+        float brightness = std::min(1.0f, ctx.intensity) * (e.size / streak + 0.3f);
+        splatOne(ctx.pixels, ctx.count, p.position[i] + streak * 0.5f, streak,
+                 WColor(p.red[i], p.green[i], p.blue[i]), std::min(1.0f, brightness));
+    }
+}
+
+// Balls dropped on the first pixel, losing energy at each bounce and
+// thrown again once they settle. The emitter rate is the number of balls.
+void BallsEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    EmitterConfig e = ctx.emitter.resolve(BALLS_EMITTER);
+    float dt = stepSeconds(ctx, s);
+    float n = ctx.count;
+    float gravity = std::max(0.05f, e.gravity) * n;
+    float launch = e.velocity * n;
+    static constexpr float DAMPING = 0.85f;
+
+    uint16_t balls = std::max(1, std::min<int>(MAX_BALLS, static_cast<int>(e.rate)));
+    ParticlePool<PARTICLE_CAPACITY>& p = s.pool;
+    while (p.count > balls) p.kill(p.count - 1);
+    while (p.count < balls) {
+        // Staggered launch speeds so the balls drift apart
+        float velocity = launch * (1.0f - e.spread * p.count / balls);
+        const WColor* colors[] = {&ctx.color1, &ctx.color2, &ctx.color3};
+        const WColor& color = *colors[p.count % 3] != WColor::BLACK ? *colors[p.count % 3] : ctx.color1;
+        p.spawn(0.0f, velocity, color, 0.0f);   // No decay, balls never die
+    }
+
+    p.update(dt, gravity, -INFINITY, INFINITY);
+    for (uint16_t i = 0; i < p.count; i++) {
+        if (p.position[i] >= 0.0f) continue;
+        p.position[i] = -p.position[i];
+        p.velocity[i] = -p.velocity[i] * DAMPING;
+        // Settled: relaunch at full height
+        if (p.velocity[i] < launch * 0.15f) {
+            p.velocity[i] = launch * (1.0f - e.spread * ctx.rng->unit());
+        }
+    }
+
+    clearCanvas(ctx);
+    p.splat(ctx.pixels, ctx.count, e.size, 1.0f, std::min(1.0f, ctx.intensity));
+}
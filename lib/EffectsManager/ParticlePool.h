@@ -0,0 +1,115 @@
+#ifndef PARTICLE_POOL_H
+#define PARTICLE_POOL_H
+
+#include <stdint.h>
+#include <math.h>
+#include <wcolor.h>
+
+#define PARTICLE_CAPACITY 96   // Per effect instance, lives in the effect arena
+
+/**
+ * @brief Additive, anti-aliased draw of a size pixels wide particle centered on pos
+ *
+ * Each covered pixel receives the color weighted by how much of it the
+ * particle overlaps, so a particle moving by a fraction of a pixel moves
+ * smoothly instead of jumping. Channels saturate at 255.
+ */
+inline void splatOne(WColor* pixels, uint16_t pixelCount, float pos, float size,
+                     const WColor& color, float brightness)
+{
+    float start = pos - size * 0.5f;
+    float end = start + size;
+    int first = static_cast<int>(floorf(start));
+    int last = static_cast<int>(ceilf(end)) - 1;
+    if (first < 0) first = 0;
+    if (last >= pixelCount) last = pixelCount - 1;
+
+    for (int p = first; p <= last; p++) {
+        float lo = start > p ? start : static_cast<float>(p);
+        float hi = end < p + 1 ? end : static_cast<float>(p + 1);
+        float weight = (hi - lo) * brightness;
+        if (weight <= 0.0f) continue;
+        WColor& px = pixels[p];
+        int r = px.r + static_cast<int>(color.r * weight);
+        int g = px.g + static_cast<int>(color.g * weight);
+        int b = px.b + static_cast<int>(color.b * weight);
+        px.r = r > 255 ? 255 : r;
+        px.g = g > 255 ? 255 : g;
+        px.b = b > 255 ? 255 : b;
+    }
+}
+
+/**
+ * @brief Fixed capacity particle pool, one array per attribute
+ *
+ * Live particles are kept packed at the front: a dead particle is replaced
+ * by the last one, so update and splat walk contiguous arrays and never
+ * test a liveness flag. Positions are in pixels, velocities in pixels per
+ * second, life falls from 1 to 0 at decay per second. Spawning into a full
+ * pool is a no-op.
+ */
+template<uint16_t N>
+struct ParticlePool {
+    uint16_t count;
+    float position[N];
+    float velocity[N];
+    float life[N];
+    float decay[N];
+    uint8_t red[N];
+    uint8_t green[N];
+    uint8_t blue[N];
+
+    static constexpr uint16_t capacity() { return N; }
+
+    int spawn(float pos, float vel, const WColor& color, float lifetime) {
+        if (count >= N) return -1;
+        uint16_t i = count++;
+        position[i] = pos;
+        velocity[i] = vel;
+        life[i] = 1.0f;
+        decay[i] = lifetime > 0.0f ? 1.0f / lifetime : 0.0f;
+        red[i] = color.r;
+        green[i] = color.g;
+        blue[i] = color.b;
+        return i;
+    }
+
+    void kill(uint16_t i) {
+        uint16_t last = --count;
+        position[i] = position[last];
+        velocity[i] = velocity[last];
+        life[i] = life[last];
+        decay[i] = decay[last];
+        red[i] = red[last];
+        green[i] = green[last];
+        blue[i] = blue[last];
+    }
+
+    // Integrates motion, ages particles and drops the dead and the ones
+    // that left [low, high]. gravity pulls toward pixel 0.
+    void update(float dt, float gravity, float low, float high) {
+        uint16_t i = 0;
+        while (i < count) {
+            velocity[i] -= gravity * dt;
+            position[i] += velocity[i] * dt;
+            life[i] -= decay[i] * dt;
+            if (life[i] <= 0.0f || position[i] < low || position[i] > high) {
+                kill(i);   // The last particle moves here and is updated next
+            } else {
+                i++;
+            }
+        }
+    }
+
+    // Adds every particle, brightness = life^falloff * gain
+    void splat(WColor* pixels, uint16_t pixelCount, float size, float falloff, float gain) const {
+        for (uint16_t i = 0; i < count; i++) {
+            float brightness = (falloff == 1.0f ? life[i] : powf(life[i], falloff)) * gain;
+            splatOne(pixels, pixelCount, position[i], size, WColor(red[i], green[i], blue[i]), brightness);
+        }
+    }
+
+    void clear() { count = 0; }
+};
+
+#endif // PARTICLE_POOL_H
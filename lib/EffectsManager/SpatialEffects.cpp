@@ -0,0 +1,164 @@
+#include <cmath>
+#include <algorithm>
+#include <Arduino.h>
+#include <PixelLayout.h>
+#include "Effects.h"
+#include "Noise.h"
+
+// Entries of the per-frame color tables, indexed by the top 6 bits of a
+// 16 bit position so the inner loops are a subtraction and a table read
+static constexpr uint8_t SHADES = 64;
+
+// Sweep front plus trail: a quarter of the install behind the front
+static constexpr int32_t SWEEP_TRAIL = 16384;
+// Ring spacing of the pulse, two rings from the center to the farthest pixel
+static constexpr uint32_t PULSE_PERIOD = 32768;
+
+static bool hasCoords(const EffectContext& ctx)
+{
+    return ctx.coords != nullptr && ctx.coords->size() == ctx.count && ctx.count > 0;
+}
+
+// Color 1 at the head fading into color 2 (black by default) along the tail
+static void buildTail(const EffectContext& ctx, float power, WColor* shades)
+{
+    float brightness = std::min(1.0f, ctx.intensity);
+    for (uint8_t i = 0; i < SHADES; i++) {
+        float f = powf(1.0f - static_cast<float>(i) / (SHADES - 1), power);
+        shades[i] = ctx.color2.lerp(ctx.color1, f).scale(brightness);
+    }
+}
+
+// Every pixel projected on the direction once, stretched to 0-65535
+static void project(const EffectContext& ctx, const float direction[3])
+{
+    const PixelCoords& c = *ctx.coords;
+    float length = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] +
+                         direction[2] * direction[2]);
+    float unit[3] = {1.0f, 0.0f, 0.0f};
+    if (length > 1e-6f) {
+        for (uint8_t a = 0; a < 3; a++) unit[a] = direction[a] / length;
+    }
+    // Q14 so that three products of Q15 coordinates stay within 32 bits
+    int32_t dx = lroundf(unit[0] * 16384.0f);
+    int32_t dy = lroundf(unit[1] * 16384.0f);
+    int32_t dz = lroundf(unit[2] * 16384.0f);
+
+    const int16_t* x = c.x();
+    const int16_t* y = c.y();
+    const int16_t* z = c.z();
+    int32_t low = INT32_MAX, high = INT32_MIN;
+    for (uint16_t i = 0; i < ctx.count; i++) {
+        int32_t p = dx * x[i] + dy * y[i] + dz * z[i];
+        low = std::min(low, p);
+        high = std::max(high, p);
+    }
+
+    uint16_t* out = reinterpret_cast<uint16_t*>(ctx.pixelState);
+    int64_t range = std::max<int64_t>(1, static_cast<int64_t>(high) - low);
+    for (uint16_t i = 0; i < ctx.count; i++) {
+        int32_t p = dx * x[i] + dy * y[i] + dz * z[i];
+        out[i] = static_cast<uint16_t>((static_cast<int64_t>(p) - low) * 65535 / range);
+    }
+}
+
+// Plane crossing the install along ctx.spatial.direction, dragging a trail
+void SweepEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    if (!hasCoords(ctx)) return;
+
+    const float* direction = ctx.spatial.direction;
+    if (!s.projected || !std::equal(direction, direction + 3, s.direction)) {
+        project(ctx, direction);
+        std::copy(direction, direction + 3, s.direction);
+        s.projected = true;
+    }
+
+    s.front += 0.008f * ctx.speed;
+    s.front -= floorf(s.front);
+    int32_t front = static_cast<int32_t>(s.front * (65536 + SWEEP_TRAIL));
+
+    WColor shades[SHADES];
+    buildTail(ctx, 2.0f, shades);
+    WColor background = ctx.color2.scale(std::min(1.0f, ctx.intensity));
+
+    const uint16_t* position = reinterpret_cast<const uint16_t*>(ctx.pixelState);
+    for (uint16_t i = 0; i < ctx.count; i++) {
+        uint32_t behind = static_cast<uint32_t>(front - position[i]);
+        ctx.pixels[i] = behind < static_cast<uint32_t>(SWEEP_TRAIL) ? shades[behind >> 8] : background;
+    }
+}
+
+// Rings expanding from ctx.spatial.center, distances measured once per center
+void PulseEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    if (!hasCoords(ctx)) return;
+
+    uint16_t* distance = reinterpret_cast<uint16_t*>(ctx.pixelState);
+    const float* center = ctx.spatial.center;
+    if (!s.measured || !std::equal(center, center + 3, s.center)) {
+        const PixelCoords& c = *ctx.coords;
+        float cx = center[0] * PixelCoords::UNIT;
+        float cy = center[1] * PixelCoords::UNIT;
+        float cz = center[2] * PixelCoords::UNIT;
+        float farthest = 1.0f;
+        for (uint16_t i = 0; i < ctx.count; i++) {
+            float dx = c.x()[i] - cx, dy = c.y()[i] - cy, dz = c.z()[i] - cz;
+            farthest = std::max(farthest, dx * dx + dy * dy + dz * dz);
+        }
+        float scale = 65535.0f / sqrtf(farthest);
+        for (uint16_t i = 0; i < ctx.count; i++) {
+            float dx = c.x()[i] - cx, dy = c.y()[i] - cy, dz = c.z()[i] - cz;
+            distance[i] = static_cast<uint16_t>(sqrtf(dx * dx + dy * dy + dz * dz) * scale);
+        }
+        std::copy(center, center + 3, s.center);
+        s.measured = true;
+    }
+
+    s.phase += 0.01f * ctx.speed;
+    s.phase -= floorf(s.phase);
+    uint32_t ring = static_cast<uint32_t>(s.phase * PULSE_PERIOD);
+
+    WColor shades[SHADES];
+    buildTail(ctx, 3.0f, shades);
+
+    for (uint16_t i = 0; i < ctx.count; i++) {
+        uint32_t behind = (ring - distance[i]) & (PULSE_PERIOD - 1);
+        ctx.pixels[i] = shades[behind >> 9];
+    }
+}
+
+// Value noise sampled at each pixel position, drifting along z and x.
+// Hues when no second color is set, otherwise color2 (low) to color1 (high).
+void Noise3DEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    if (!hasCoords(ctx)) return;
+
+    s.t += 0.015f * ctx.speed;
+    float brightness = std::min(1.0f, ctx.intensity);
+
+    WColor palette[SHADES];
+    bool hues = ctx.color2 == WColor::BLACK;
+    float hueShift = fmodf(s.t * 30.0f, 360.0f);
+    for (uint8_t i = 0; i < SHADES; i++) {
+        float v = static_cast<float>(i) / (SHADES - 1);
+        palette[i] = hues
+            ? WColor::fromHSV(fmodf(hueShift + v * 540.0f, 360.0f), 1.0f, brightness)
+            : ctx.color2.lerp(ctx.color1, v).scale(brightness);
+    }
+
+    // About four blobs across the longest axis
+    const float k = 2.0f / PixelCoords::UNIT;
+    float ox = s.t * 0.3f;
+    float oz = s.t;
+    const int16_t* x = ctx.coords->x();
+    const int16_t* y = ctx.coords->y();
+    const int16_t* z = ctx.coords->z();
+    for (uint16_t i = 0; i < ctx.count; i++) {
+        float v = valueNoise3(x[i] * k + ox, y[i] * k, z[i] * k + oz);
+        ctx.pixels[i] = palette[static_cast<uint8_t>(v * (SHADES - 0.01f))];
+    }
+}
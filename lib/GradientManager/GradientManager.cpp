@@ -4,9 +4,14 @@
 #include <LEDStrip.h>
 
 GradientManager::GradientManager(LEDStrip *strip):
+      strip(nullptr),
+      lutDirty(true),
+      lutReverse(false),
       gradientEnabled(false),
       gradientReverse(false),
-      strip(nullptr) {
+      animation(GRADIENT_STATIC),
+      animationSpeed(0.0f),
+      animationStart(0) {
     if (strip) {
         this->strip = strip;
     }
@@ -55,7 +60,7 @@ void GradientManager::setGradientSmooth(const std::vector<GradientStop> &stops,
         return;
     }
     
-    strip->transitionsManager->transition.targetEffect = strip->effectsManager->currentEffect;
+    strip->transitionsManager->transition.targetEffect = strip->effectsManager->state.type;
     
     if (!takeMutexSafely()) {
         return;
@@ -70,12 +75,14 @@ void GradientManager::setGradientSmooth(const std::vector<GradientStop> &stops,
             strip->startRendering();
         }
         
-        strip->transitionsManager->transition.startTime = millis();
+        strip->transitionsManager->transition.startTime = strip->now();
         strip->transitionsManager->transition.duration = duration;
         strip->transitionsManager->transition.type = type;
         strip->transitionsManager->transition.targetEffect = EFFECT_NONE;
         strip->transitionsManager->transition.targetGradientEnabled = true;
         strip->transitionsManager->transition.targetGradientStops = stops;
+        std::sort(strip->transitionsManager->transition.targetGradientStops.begin(),
+                  strip->transitionsManager->transition.targetGradientStops.end());
         strip->transitionsManager->transition.targetGradientReverse = gradientReverse;
     } catch (...) {
         // Ensure mutex is released even if an exception occurs
@@ -109,7 +116,7 @@ void GradientManager::setGradientEnabledSmooth(bool enabled,
         strip->captureCurrentState();
 
         strip->transitionsManager->transition.active = true;
-        strip->transitionsManager->transition.startTime = millis();
+        strip->transitionsManager->transition.startTime = strip->now();
         strip->transitionsManager->transition.duration = duration;
         strip->transitionsManager->transition.type = type;
         strip->transitionsManager->transition.targetGradientEnabled = enabled;
@@ -126,71 +133,121 @@ void GradientManager::renderGradient()
         return;
     }
 
-    const uint16_t numPixels = strip->neopixel.numPixels();
+    const uint16_t numPixels = strip->numPixels();
     if (numPixels == 0) {
         return;
     }
 
-    const float pixelStep = (numPixels > 1) ? 1.0f / static_cast<float>(numPixels - 1) : 0.0f;
-    
-    for (uint16_t i = 0; i < numPixels; i++) {
-        float position = static_cast<float>(i) * pixelStep;
-        
-        if (gradientReverse) {
-            position = 1.0f - position;
-        }
+    if (lutDirty || lutReverse != gradientReverse || lut.size() != numPixels) {
+        rebuildLut(numPixels);
+    }
+
+    if (animation != GRADIENT_STATIC && animationSpeed != 0.0f && numPixels > 1) {
+        renderAnimated(numPixels);
+        return;
+    }
 
-        WColor color = interpolateGradient(position);
-        strip->safeSetPixelWColor(i, color);
+    for (uint16_t i = 0; i < numPixels; i++) {
+        strip->safeSetPixelWColor(i, lut[i]);
     }
 }
 
-WColor GradientManager::interpolateGradient(float position)
+void GradientManager::rebuildLut(uint16_t numPixels)
 {
-    if (gradientStops.empty()) {
-        return WColor::BLACK;
-    }
-    
-    if (gradientStops.size() == 1) {
-        return gradientStops[0].color;
+    lut.reserve(numPixels);
+    rasterizeGradient(gradientStops, gradientReverse, lut);
+    lutReverse = gradientReverse;
+    lutDirty = false;
+}
+
+// Shift the cached table by a time based offset. The offset is tracked in
+// 1/256 pixel steps so neighbouring entries are blended for sub-pixel motion.
+void GradientManager::renderAnimated(uint16_t numPixels)
+{
+    // Scroll walks the table forth and back so both ends meet without a seam
+    const uint32_t period = (animation == GRADIENT_SCROLL) ? 2u * (numPixels - 1) : numPixels;
+
+    const uint32_t elapsed = strip->now() - animationStart;
+    int64_t offset = static_cast<int64_t>(animationSpeed * 256.0f) * elapsed / 1000;
+    const int64_t span = static_cast<int64_t>(period) * 256;
+    offset %= span;
+    if (offset < 0) {
+        offset += span;
     }
 
-    // Clamp position to valid range
-    position = std::max(0.0f, std::min(1.0f, position));
+    // Pixel i samples the table at (i - offset): start one entry back when
+    // the offset has a fractional part and blend towards the next entry.
+    const uint32_t whole = static_cast<uint32_t>(offset >> 8);
+    const uint32_t frac = static_cast<uint32_t>(offset & 0xFF);
+    uint32_t index = (period - whole % period) % period;
+    float blend = 0.0f;
+    if (frac > 0) {
+        index = (index + period - 1) % period;
+        blend = 1.0f - static_cast<float>(frac) / 256.0f;
+    }
 
-    // Find the appropriate gradient segment
-    size_t leftIndex = 0;
-    size_t rightIndex = gradientStops.size() - 1;
+    auto sample = [&](uint32_t k) -> const WColor & {
+        return lut[k < numPixels ? k : period - k];
+    };
 
-    // Handle edge cases first
-    if (position <= gradientStops[0].position) {
-        return gradientStops[0].color;
+    for (uint16_t i = 0; i < numPixels; i++) {
+        uint32_t next = (index + 1 == period) ? 0 : index + 1;
+        if (blend > 0.0f) {
+            strip->safeSetPixelWColor(i, strip->blendColors(sample(index), sample(next), blend));
+        } else {
+            strip->safeSetPixelWColor(i, sample(index));
+        }
+        index = next;
     }
-    if (position >= gradientStops[rightIndex].position) {
-        return gradientStops[rightIndex].color;
+}
+
+void GradientManager::setAnimation(GradientAnimation mode, float pixelsPerSecond)
+{
+    if (!takeMutexSafely()) {
+        return;
     }
+    animation = mode;
+    animationSpeed = pixelsPerSecond;
+    animationStart = strip->now();
+    xSemaphoreGive(strip->stripMutex);
+}
 
-    // Find the correct segment
-    for (size_t i = 0; i < gradientStops.size() - 1; i++) {
-        if (position >= gradientStops[i].position && position <= gradientStops[i + 1].position) {
-            leftIndex = i;
-            rightIndex = i + 1;
-            break;
-        }
+GradientAnimation GradientManager::parseAnimation(const char *name)
+{
+    if (!name) return GRADIENT_STATIC;
+    if (strcmp(name, "scroll") == 0) return GRADIENT_SCROLL;
+    if (strcmp(name, "rotate") == 0) return GRADIENT_ROTATE;
+    return GRADIENT_STATIC;
+}
+
+// Resolve a gradient into one color per pixel. The output buffer is reused,
+// so callers that reserved it up front do not allocate here.
+void GradientManager::rasterizeGradient(const std::vector<GradientStop> &stops, bool reverse,
+                                        std::vector<WColor> &out) const
+{
+    if (!strip) {
+        return;
     }
 
-    const GradientStop &left = gradientStops[leftIndex];
-    const GradientStop &right = gradientStops[rightIndex];
+    const uint16_t numPixels = strip->numPixels();
+    out.resize(numPixels);
 
-    // Handle identical positions
-    if (std::abs(left.position - right.position) < 1e-6f) {
-        return left.color;
+    const float pixelStep = (numPixels > 1) ? 1.0f / static_cast<float>(numPixels - 1) : 0.0f;
+    for (uint16_t i = 0; i < numPixels; i++) {
+        float position = static_cast<float>(i) * pixelStep;
+        if (reverse) {
+            position = 1.0f - position;
+        }
+        out[i] = strip->interpolateGradient(stops, position);
     }
+}
 
-    float localPosition = (position - left.position) / (right.position - left.position);
-    localPosition = std::max(0.0f, std::min(1.0f, localPosition)); // Extra safety clamp
-    
-    return strip->blendColors(left.color, right.color, localPosition);
+WColor GradientManager::interpolateGradient(float position)
+{
+    if (!strip) {
+        return WColor::BLACK;
+    }
+    return strip->interpolateGradient(gradientStops, position);
 }
 
 void GradientManager::setGradient(const WColor &startColor, const WColor &endColor)
@@ -209,6 +266,7 @@ void GradientManager::setGradient(const WColor &startColor, const WColor &endCol
         gradientStops.emplace_back(0.0f, startColor);
         gradientStops.emplace_back(1.0f, endColor);
         gradientEnabled = true;
+        lutDirty = true;
     } catch (...) {
         // Handle potential memory allocation failures
         gradientStops.clear();
@@ -236,6 +294,7 @@ void GradientManager::setGradient(const std::vector<GradientStop> &stops)
         gradientStops = stops;
         std::sort(gradientStops.begin(), gradientStops.end());
         gradientEnabled = true;
+        lutDirty = true;
     } catch (...) {
         // Handle potential memory allocation or sorting failures
         gradientStops.clear();
@@ -263,6 +322,7 @@ void GradientManager::addGradientStop(float position, const WColor &color)
     try {
         gradientStops.emplace_back(position, color);
         std::sort(gradientStops.begin(), gradientStops.end());
+        lutDirty = true;
     } catch (...) {
         // Handle potential memory allocation failures
         // Don't modify gradientEnabled state on failure
@@ -283,6 +343,8 @@ void GradientManager::clearGradient()
     
     gradientStops.clear();
     gradientEnabled = false;
+    animation = GRADIENT_STATIC;
+    lutDirty = true;
     
     xSemaphoreGive(strip->stripMutex);
 }
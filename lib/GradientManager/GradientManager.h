@@ -8,7 +8,6 @@
 #include <vector>
 #include <wcolor.h>
 #include <ArduinoJson.h>
-#include <set>
 #include <algorithm>  // Added for std::sort
 #include "utils.h"
 #include <output.h>
@@ -19,6 +18,13 @@ private:
     bool isValidStrip() const;
     bool takeMutexSafely() const;
     bool validateGradientStops(const std::vector<GradientStop> &stops) const;
+
+    // Per-pixel color table, rebuilt only when stops, direction or length change
+    std::vector<WColor> lut;
+    bool lutDirty;
+    bool lutReverse;
+    void rebuildLut(uint16_t numPixels);
+    void renderAnimated(uint16_t numPixels);
 public:
     GradientManager(LEDStrip *strip);
     ~GradientManager();
@@ -39,12 +45,22 @@ public:
     void renderGradient();
     
     WColor interpolateGradient(float position);
+    void rasterizeGradient(const std::vector<GradientStop>& stops, bool reverse,
+                           std::vector<WColor>& out) const;
     
     void setGradient(const WColor& startColor, const WColor& endColor);
     void setGradient(const std::vector<GradientStop>& stops);
     void addGradientStop(float position, const WColor& color);
     void clearGradient();
-    void setGradientReverse(bool reverse) { gradientReverse = reverse; }
+    void setGradientReverse(bool reverse) { gradientReverse = reverse; lutDirty = true; }
+    void invalidateCache() { lutDirty = true; }
+
+    // Animated scroll/rotate, speed in pixels per second (negative runs backwards)
+    GradientAnimation animation;
+    float animationSpeed;
+    uint32_t animationStart;
+    void setAnimation(GradientAnimation mode, float pixelsPerSecond);
+    static GradientAnimation parseAnimation(const char* name);
     void enableGradient(bool enable) { gradientEnabled = enable; }
     bool isGradientEnabled() const { return gradientEnabled; }
 };
@@ -0,0 +1,280 @@
+#include "HeapStats.h"
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#ifdef ARDUINO_ARCH_ESP32
+#include <esp_heap_caps.h>
+#else
+#include <malloc.h>
+#include <new>
+#endif
+
+namespace {
+    struct SubsystemCounters {
+        std::atomic<uint32_t> count;
+        std::atomic<uint32_t> bytes;
+        std::atomic<int32_t> live;
+        std::atomic<int32_t> peak;
+    };
+
+    SubsystemCounters subsystemCounters[ALLOC_SUBSYSTEM_COUNT];
+
+    const char* const SUBSYSTEM_NAMES[ALLOC_SUBSYSTEM_COUNT] = {
+        "other",
+        "render",
+        "command",
+        "router",
+        "input",
+        "journal"
+    };
+
+#ifdef ARDUINO_ARCH_ESP32
+    // Task to subsystem, scanned by every hook. Before the scheduler starts
+    // the current task handle is null and matches no entry.
+    constexpr size_t MAX_TAGGED_TASKS = 16;
+    std::atomic<TaskHandle_t> taggedTasks[MAX_TAGGED_TASKS];
+    volatile uint8_t taggedSubsystems[MAX_TAGGED_TASKS];
+#else
+    // The host task shim allocates a handle on first use, which the hooks
+    // must not do: host threads keep their subsystem in a thread local
+    thread_local AllocSubsystem threadSubsystem = ALLOC_OTHER;
+#endif
+}
+
+void HeapStats::tagTask(AllocSubsystem subsystem)
+{
+    if (subsystem >= ALLOC_SUBSYSTEM_COUNT) return;
+#ifdef ARDUINO_ARCH_ESP32
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (size_t i = 0; i < MAX_TAGGED_TASKS; i++) {
+        if (taggedTasks[i].load(std::memory_order_relaxed) == self) {
+            taggedSubsystems[i] = subsystem;
+            return;
+        }
+    }
+    for (size_t i = 0; i < MAX_TAGGED_TASKS; i++) {
+        TaskHandle_t empty = nullptr;
+        if (taggedTasks[i].compare_exchange_strong(empty, self)) {
+            taggedSubsystems[i] = subsystem;
+            return;
+        }
+    }
+    // Table full: the task stays in ALLOC_OTHER
+#else
+    threadSubsystem = subsystem;
+#endif
+}
+
+// Before the task ends, FreeRTOS reuses handles
+void HeapStats::untagTask()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (size_t i = 0; i < MAX_TAGGED_TASKS; i++) {
+        if (taggedTasks[i].load(std::memory_order_relaxed) == self) {
+            taggedSubsystems[i] = ALLOC_OTHER;
+            taggedTasks[i].store(nullptr);
+            return;
+        }
+    }
+#else
+    threadSubsystem = ALLOC_OTHER;
+#endif
+}
+
+AllocSubsystem HeapStats::currentSubsystem()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (self) {
+        for (size_t i = 0; i < MAX_TAGGED_TASKS; i++) {
+            if (taggedTasks[i].load(std::memory_order_relaxed) == self) {
+                return static_cast<AllocSubsystem>(taggedSubsystems[i]);
+            }
+        }
+    }
+    return ALLOC_OTHER;
+#else
+    return threadSubsystem;
+#endif
+}
+
+bool HeapStats::hooksEnabled()
+{
+#ifdef HEAP_STATS_HOOKS
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocCounters HeapStats::counters(AllocSubsystem subsystem)
+{
+    AllocCounters out = {};
+    if (subsystem >= ALLOC_SUBSYSTEM_COUNT) return out;
+    const SubsystemCounters& c = subsystemCounters[subsystem];
+    out.count = c.count.load(std::memory_order_relaxed);
+    out.bytes = c.bytes.load(std::memory_order_relaxed);
+    out.live = c.live.load(std::memory_order_relaxed);
+    out.peak = c.peak.load(std::memory_order_relaxed);
+    return out;
+}
+
+// Peaks restart from what is live now
+void HeapStats::resetPeaks()
+{
+    for (SubsystemCounters& c : subsystemCounters) {
+        c.peak.store(c.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+const char* HeapStats::subsystemName(AllocSubsystem subsystem)
+{
+    return subsystem < ALLOC_SUBSYSTEM_COUNT ? SUBSYSTEM_NAMES[subsystem] : "unknown";
+}
+
+uint32_t HeapStats::freeHeap()
+{
+    return ESP.getFreeHeap();
+}
+
+uint32_t HeapStats::minFreeHeap()
+{
+    return ESP.getMinFreeHeap();
+}
+
+// Walks the free list on the device, sample it rather than poll it
+uint32_t HeapStats::largestFreeBlock()
+{
+    return ESP.getMaxAllocHeap();
+}
+
+void HeapStats::getStats(JsonObject& out)
+{
+    uint32_t free = freeHeap();
+    uint32_t largest = largestFreeBlock();
+    out["free"] = free;
+    out["minFree"] = minFreeHeap();
+    out["largestBlock"] = largest;
+    // Share of the free heap unusable for a single allocation of that size
+    out["fragmentation"] = free ? 100 - static_cast<uint32_t>(static_cast<uint64_t>(largest) * 100 / free) : 0;
+    out["hooks"] = hooksEnabled();
+
+    JsonObject subsystems = out.createNestedObject("subsystems");
+    for (uint8_t i = 0; i < ALLOC_SUBSYSTEM_COUNT; i++) {
+        AllocCounters c = counters(static_cast<AllocSubsystem>(i));
+        JsonObject entry = subsystems.createNestedObject(SUBSYSTEM_NAMES[i]);
+        entry["count"] = c.count;
+        entry["bytes"] = c.bytes;
+        entry["live"] = c.live;
+        entry["peak"] = c.peak;
+    }
+}
+
+void HeapStats::recordAlloc(size_t bytes)
+{
+    SubsystemCounters& c = subsystemCounters[currentSubsystem()];
+    c.count.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(static_cast<uint32_t>(bytes), std::memory_order_relaxed);
+    int32_t live = c.live.fetch_add(static_cast<int32_t>(bytes), std::memory_order_relaxed) + static_cast<int32_t>(bytes);
+    int32_t peak = c.peak.load(std::memory_order_relaxed);
+    while (live > peak && !c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+void HeapStats::recordFree(size_t bytes)
+{
+    subsystemCounters[currentSubsystem()].live.fetch_sub(static_cast<int32_t>(bytes), std::memory_order_relaxed);
+}
+
+#ifdef HEAP_STATS_HOOKS
+
+// Block sizes as the allocator rounded them, so a free matches its malloc
+static size_t blockSize(void* block)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    return heap_caps_get_allocated_size(block);
+#else
+    return malloc_usable_size(block);
+#endif
+}
+
+// The linker sends every malloc, calloc, realloc and free of the firmware
+// here (--wrap), the __real_ symbols being the allocator's own
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* block, size_t size);
+void __real_free(void* block);
+
+void* __wrap_malloc(size_t size)
+{
+    void* block = __real_malloc(size);
+    if (block) HeapStats::recordAlloc(blockSize(block));
+    return block;
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    void* block = __real_calloc(count, size);
+    if (block) HeapStats::recordAlloc(blockSize(block));
+    return block;
+}
+
+// A resize counts as an allocation: it may move the block and is what
+// fragments the heap
+void* __wrap_realloc(void* block, size_t size)
+{
+    size_t before = block ? blockSize(block) : 0;
+    void* moved = __real_realloc(block, size);
+    if (moved) {
+        if (before) HeapStats::recordFree(before);
+        HeapStats::recordAlloc(blockSize(moved));
+    } else if (block && size == 0) {
+        HeapStats::recordFree(before);
+    }
+    return moved;
+}
+
+void __wrap_free(void* block)
+{
+    if (block) HeapStats::recordFree(blockSize(block));
+    __real_free(block);
+}
+}
+
+#ifndef ARDUINO_ARCH_ESP32
+// The host libstdc++ is a shared library, its operator new calls malloc
+// without going through the wrap. These replace it so std::vector and
+// std::function storage is counted as on the device.
+void* operator new(size_t size)
+{
+    void* block = malloc(size ? size : 1);
+    if (!block) throw std::bad_alloc();
+    return block;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return malloc(size ? size : 1);
+}
+
+void operator delete(void* block) noexcept { free(block); }
+void operator delete[](void* block) noexcept { free(block); }
+void operator delete(void* block, size_t) noexcept { free(block); }
+void operator delete[](void* block, size_t) noexcept { free(block); }
+void operator delete(void* block, const std::nothrow_t&) noexcept { free(block); }
+void operator delete[](void* block, const std::nothrow_t&) noexcept { free(block); }
+#endif
+
+#endif // HEAP_STATS_HOOKS
@@ -0,0 +1,68 @@
+#ifndef HEAPSTATS_H
+#define HEAPSTATS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+enum AllocSubsystem : uint8_t {
+    ALLOC_OTHER,      ///< Boot, loop task, network stacks, untagged tasks
+    ALLOC_RENDER,     ///< Strip render tasks
+    ALLOC_COMMAND,    ///< Command scheduler workers, where commands are applied
+    ALLOC_ROUTER,     ///< HTTP and WebSocket handlers
+    ALLOC_INPUT,      ///< Input check task
+    ALLOC_JOURNAL,    ///< Scene journal writer
+    ALLOC_SUBSYSTEM_COUNT
+};
+
+/**
+ * @brief Allocations seen by the malloc hooks of one subsystem
+ *
+ * Frees count against the subsystem of the task that frees, so live and
+ * peak are exact for memory a subsystem allocates and releases itself, and
+ * approximate for memory handed between tasks.
+ */
+struct AllocCounters {
+    uint32_t count;   ///< Allocations, a realloc counting as one
+    uint32_t bytes;   ///< Bytes allocated, wrapping
+    int32_t live;     ///< Bytes allocated minus bytes freed
+    int32_t peak;     ///< Highest live
+};
+
+/**
+ * @brief Per subsystem allocation counters and heap health sampling
+ *
+ * Built with -D HEAP_STATS_HOOKS and the linker flags
+ * -Wl,--wrap=malloc,--wrap=free,--wrap=realloc,--wrap=calloc, every
+ * malloc, String growth, JsonDocument pool and std::vector or std::function
+ * storage goes through a hook that attributes it to the subsystem of the
+ * calling task, at the cost of a scan of the tagged task table and a few
+ * relaxed atomics. Without them the counters stay at zero and only the heap
+ * figures are reported.
+ *
+ * Fragmentation is what ends long running nodes: free heap can look
+ * healthy while the largest free block shrinks below what a transition or a
+ * JSON document needs.
+ */
+namespace HeapStats {
+    // Attributes the calling task's allocations to subsystem, until untagged
+    void tagTask(AllocSubsystem subsystem);
+    void untagTask();
+    AllocSubsystem currentSubsystem();
+
+    bool hooksEnabled();
+    AllocCounters counters(AllocSubsystem subsystem);
+    void resetPeaks();
+    const char* subsystemName(AllocSubsystem subsystem);
+
+    uint32_t freeHeap();
+    uint32_t minFreeHeap();
+    uint32_t largestFreeBlock();
+
+    void getStats(JsonObject& out);
+
+    // Called by the hooks
+    void recordAlloc(size_t bytes);
+    void recordFree(size_t bytes);
+}
+
+#endif // HEAPSTATS_H
@@ -3,6 +3,10 @@
 #include <LEDStrip.h>
 #include <omniSourceRouter.h>
 #include <output.h>
+#include <InputEngine.h>
+#include <Telemetry.h>
+#include <HeapStats.h>
+#include <algorithm>
 
 IOWrapper::IOWrapper(OmniSourceRouter *router)
 {
@@ -14,6 +18,11 @@ IOWrapper::IOWrapper(OmniSourceRouter *router)
 IOWrapper::~IOWrapper()
 {
     stopCheckTask();
+    for (CommandScheduler *scheduler : schedulers)
+    {
+        delete scheduler;
+    }
+    schedulers.clear();
 }
 
 void IOWrapper::pushOutput(Output *output, String uid)
@@ -28,13 +37,19 @@ void IOWrapper::pushOutput(Output *output, String uid)
 
     int index = outputs.size();
     outputs.push_back(output); // Use push_back instead of emplace_back
+    output->telemetrySource = Telemetry::getInstance().registerSource(uid);
 
     Serial.println("Output added at index: " + String(index));
 
     // Store the pointer directly instead of using index
     Output *outputPtr = outputs[index];
 
-    router->addCallback(OmniSourceRouterCallback(uid, [this, outputPtr](JsonObject &data)
+    // Commands go through a priority queue drained by the scheduler task,
+    // so the router task never runs output code inline
+    CommandScheduler *scheduler = new CommandScheduler(outputPtr, uid);
+    schedulers.push_back(scheduler);
+
+    router->addCallback(OmniSourceRouterCallback(uid, [this, outputPtr, scheduler](JsonObject &data)
                                                  {
             // Validate the pointer is still in our vector
             bool found = false;
@@ -45,13 +60,17 @@ void IOWrapper::pushOutput(Output *output, String uid)
                 }
             }
             if (found && outputPtr) {
-                outputPtr->jsonInterpreter(data);
-            } }, 60));
+                scheduler->enqueue(data);
+            } }, CommandScheduler::ROUTER_COOLDOWN_MS));
+
+    router->addStatsProvider("scheduler/" + uid, [scheduler](JsonObject &out)
+                             { scheduler->getStats(out); });
 
     Serial.println("Starting rendering...");
     if (outputs[index]->begin())
     { // Call begin() first
         outputs[index]->startRendering();
+        scheduler->begin();
         Serial.println("Rendering started successfully");
     }
     else
@@ -64,6 +83,8 @@ void IOWrapper::pushDigitalInput(DInput *input, String uid, std::function<void(D
 {
     int index = dInputs.size();
     dInputs.push_back(input); // Use push_back instead of emplace_back
+    // Let a sleeping check task recompute its deadline
+    InputEngine::wake();
 
     Serial.println("@@@@@@@@@@@@@@@@@@@@@@@@@@@@");
     Serial.println("@@@@@@@@@@@@@@@@@@@@@@@@@@@@");
@@ -80,6 +101,18 @@ void IOWrapper::pushDigitalInput(DInput *input, String uid, std::function<void(D
     }
 }
 
+CommandScheduler* IOWrapper::findScheduler(const String& uid)
+{
+    for (CommandScheduler *scheduler : schedulers)
+    {
+        if (scheduler && scheduler->getName() == uid)
+        {
+            return scheduler;
+        }
+    }
+    return nullptr;
+}
+
 void IOWrapper::check()
 {
     for (DInput *input : dInputs)
@@ -98,22 +131,41 @@ void IOWrapper::checkTaskWrapper(void *parameter)
     instance->checkTaskLoop();
 }
 
-// The actual task loop
+// The actual task loop: sleeps until an input edge arrives or the nearest
+// debounce/gesture deadline expires, instead of polling at a fixed rate
 void IOWrapper::checkTaskLoop()
 {
-    const TickType_t xDelay = pdMS_TO_TICKS(10); // 10ms delay = 100Hz check rate
-    
     Serial.println("IOWrapper check task started");
-    
+    InputEngine::setConsumer(xTaskGetCurrentTaskHandle());
+    HeapStats::tagTask(ALLOC_INPUT);
+
     while (isTaskRunning)
     {
-        // Call the check method
+        InputEvent event;
+        while (InputEngine::pop(event))
+        {
+            event.input->lastEdgeUs = event.timeUs;
+            event.input->onEdge(event.level, event.timeMs);
+        }
+
         check();
-        
-        // Delay to prevent task from consuming too much CPU
-        vTaskDelay(xDelay);
+
+        uint32_t now = millis();
+        uint32_t waitMs = GestureDetector::NO_DEADLINE;
+        for (DInput *input : dInputs)
+        {
+            if (input)
+            {
+                waitMs = std::min(waitMs, input->msUntilDeadline(now));
+            }
+        }
+        TickType_t wait = (waitMs == GestureDetector::NO_DEADLINE) ? portMAX_DELAY : pdMS_TO_TICKS(waitMs);
+        ulTaskNotifyTake(pdTRUE, wait);
+        InputEngine::wakeups++;
     }
-    
+
+    InputEngine::setConsumer(nullptr);
+    HeapStats::untagTask();
     Serial.println("IOWrapper check task ended");
     vTaskDelete(NULL); // Delete this task
 }
@@ -130,7 +182,7 @@ bool IOWrapper::startCheckTask()
     BaseType_t result = xTaskCreate(
         checkTaskWrapper,        // Task function
         "IOWrapper_Check",       // Task name
-        2048,                    // Stack size (adjust as needed)
+        CHECK_TASK_STACK_SIZE,   // Stack size
         this,                    // Parameter passed to task
         1,                       // Task priority (adjust as needed)
         &checkTaskHandle         // Task handle
@@ -153,6 +205,7 @@ void IOWrapper::stopCheckTask()
     }
     
     isTaskRunning = false;
+    InputEngine::wake();
     
     // Wait a bit for the task to finish
     vTaskDelay(pdMS_TO_TICKS(20));
@@ -5,6 +5,7 @@
 #include <vector>
 #include <LEDStrip.h>
 #include <digitalInput.h>
+#include <CommandScheduler.h>
 
 class IOWrapper{
 public:
@@ -12,10 +13,12 @@ public:
     ~IOWrapper();
     OmniSourceRouter* router;
     std::vector<Output*> outputs;
+    std::vector<CommandScheduler*> schedulers;
     std::vector<DInput*> dInputs;
     void pushOutput(Output*, String uid);
     void pushDigitalInput(DInput*, String uid, std::function<void(DInput* btn)> onChangeCb);
     void check();
+    CommandScheduler* findScheduler(const String& uid);
 
 
     // New FreeRTOS task control methods
@@ -23,7 +26,10 @@ public:
     void stopCheckTask();
     void setCheckInterval(uint32_t intervalMs);
 private:
-    
+    // Gesture detection, input rule dispatch into the schedulers, telemetry
+    // and the inputs' own change callbacks all run on the check task
+    static constexpr uint32_t CHECK_TASK_STACK_SIZE = 4096;
+
     TaskHandle_t checkTaskHandle;
     volatile bool isTaskRunning;
     
@@ -0,0 +1,55 @@
+#ifndef EDGEQUEUE_H
+#define EDGEQUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+/**
+ * @brief Single producer / single consumer ring buffer, safe to push from an ISR
+ *
+ * The producer only writes head and the consumer only writes tail, so no
+ * lock or critical section is needed. N must be a power of two.
+ */
+template <typename T, size_t N>
+class EdgeQueue {
+    static_assert((N & (N - 1)) == 0, "EdgeQueue size must be a power of two");
+
+public:
+    bool push(const T& item)
+    {
+        uint32_t head = this->head.load(std::memory_order_relaxed);
+        if (head - tail.load(std::memory_order_acquire) >= N) {
+            overflows++;
+            return false;
+        }
+        items[head & (N - 1)] = item;
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item)
+    {
+        uint32_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items[tail & (N - 1)];
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    volatile uint32_t overflows = 0;
+
+private:
+    T items[N];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+};
+
+#endif // EDGEQUEUE_H
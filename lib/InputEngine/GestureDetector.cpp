@@ -0,0 +1,111 @@
+#include "GestureDetector.h"
+
+GestureDetector::GestureDetector(GestureTiming timing, bool pressed)
+    : timing(timing),
+      stable(pressed),
+      raw(pressed),
+      pending(false),
+      leading(false),
+      leadingMs(0),
+      lastCommitMs(0),
+      pressMs(0),
+      releaseMs(0),
+      phase(IDLE)
+{
+}
+
+void GestureDetector::edge(bool pressed, uint32_t timeMs)
+{
+    raw = pressed;
+    if (!pending && pressed != stable && reached(timeMs, lastCommitMs + timing.debounceMs)) {
+        // Leading edge: committed on the next update() with its own timestamp,
+        // even if the rest of the bounce burst is drained in the same batch
+        leading = true;
+        leadingMs = timeMs;
+    }
+    pending = leading || raw != stable;
+}
+
+uint8_t GestureDetector::commit(bool pressed, uint32_t timeMs, InputGesture* out, uint8_t count, uint8_t maxOut)
+{
+    auto emit = [&](InputGesture g) {
+        if (count < maxOut) out[count++] = g;
+    };
+
+    stable = pressed;
+    lastCommitMs = timeMs;
+
+    if (pressed) {
+        emit(GESTURE_PRESS);
+        pressMs = timeMs;
+        phase = (phase == WAIT_SECOND) ? SECOND_DOWN : DOWN;
+        return count;
+    }
+
+    emit(GESTURE_RELEASE);
+    releaseMs = timeMs;
+    switch (phase) {
+    case DOWN:
+        if (timing.doubleClickMs == 0) {
+            emit(GESTURE_CLICK);
+            phase = IDLE;
+        } else {
+            phase = WAIT_SECOND;
+        }
+        break;
+    case SECOND_DOWN:
+        emit(GESTURE_DOUBLE_CLICK);
+        phase = IDLE;
+        break;
+    default:
+        phase = IDLE;
+        break;
+    }
+    return count;
+}
+
+uint8_t GestureDetector::update(uint32_t nowMs, InputGesture* out, uint8_t maxOut)
+{
+    uint8_t count = 0;
+
+    if (leading) {
+        leading = false;
+        count = commit(!stable, leadingMs, out, count, maxOut);
+        pending = raw != stable;
+    }
+
+    // Level settled at the end of the lockout window
+    if (pending && reached(nowMs, lastCommitMs + timing.debounceMs)) {
+        pending = false;
+        if (raw != stable) {
+            count = commit(raw, lastCommitMs + timing.debounceMs, out, count, maxOut);
+        }
+    }
+
+    if ((phase == DOWN || phase == SECOND_DOWN) && reached(nowMs, pressMs + timing.longPressMs)) {
+        if (phase == SECOND_DOWN && count < maxOut) {
+            // The first click of an interrupted double click still counts
+            out[count++] = GESTURE_CLICK;
+        }
+        if (count < maxOut) out[count++] = GESTURE_LONG_PRESS;
+        phase = LONG_HELD;
+    } else if (phase == WAIT_SECOND && reached(nowMs, releaseMs + timing.doubleClickMs)) {
+        if (count < maxOut) out[count++] = GESTURE_CLICK;
+        phase = IDLE;
+    }
+    return count;
+}
+
+uint32_t GestureDetector::nextDeadline() const
+{
+    uint32_t deadline = NO_DEADLINE;
+    auto consider = [&](uint32_t t) {
+        if (deadline == NO_DEADLINE || static_cast<int32_t>(t - deadline) < 0) deadline = t;
+    };
+
+    if (leading) consider(leadingMs);
+    else if (pending) consider(lastCommitMs + timing.debounceMs);
+    if (phase == DOWN || phase == SECOND_DOWN) consider(pressMs + timing.longPressMs);
+    if (phase == WAIT_SECOND) consider(releaseMs + timing.doubleClickMs);
+    return deadline;
+}
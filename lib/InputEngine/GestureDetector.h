@@ -0,0 +1,75 @@
+#ifndef GESTUREDETECTOR_H
+#define GESTUREDETECTOR_H
+
+#include <stdint.h>
+
+enum InputGesture : uint8_t {
+    GESTURE_NONE,
+    GESTURE_PRESS,
+    GESTURE_RELEASE,
+    GESTURE_CLICK,
+    GESTURE_DOUBLE_CLICK,
+    GESTURE_LONG_PRESS
+};
+
+struct GestureTiming {
+    uint16_t debounceMs = 30;      ///< Edges closer than this to the last accepted one are bounces
+    uint16_t doubleClickMs = 250;  ///< 0 reports CLICK on release and disables DOUBLE_CLICK
+    uint16_t longPressMs = 600;
+};
+
+/**
+ * @brief Debounce and gesture state machine for one button
+ *
+ * Pure logic over timestamped edges, with no Arduino dependency, so edge
+ * timelines can be replayed on the host. Debouncing is leading edge: the
+ * first edge after a quiet period is accepted at once (no added latency),
+ * edges in the following debounceMs are ignored, and the level seen at the
+ * end of that window is committed if it differs.
+ *
+ * edge() records raw edges; update() commits them and fires timeouts,
+ * returning the resulting gestures; nextDeadline() tells the caller when
+ * update() must run again, so nothing is polled while the button is idle.
+ */
+class GestureDetector {
+public:
+    static constexpr uint32_t NO_DEADLINE = 0xFFFFFFFFu;
+    static constexpr uint8_t MAX_GESTURES_PER_UPDATE = 4;
+
+    explicit GestureDetector(GestureTiming timing = GestureTiming(), bool pressed = false);
+
+    void edge(bool pressed, uint32_t timeMs);
+    uint8_t update(uint32_t nowMs, InputGesture* out, uint8_t maxOut);
+    uint32_t nextDeadline() const;
+
+    bool isPressed() const { return stable; }
+
+    GestureTiming timing;
+
+private:
+    enum Phase : uint8_t {
+        IDLE,
+        DOWN,          ///< First press held
+        WAIT_SECOND,   ///< Released, a second press would make a double click
+        SECOND_DOWN,
+        LONG_HELD      ///< Long press reported, waiting for release
+    };
+
+    bool stable;
+    bool raw;
+    bool pending;            ///< raw differs from stable inside the lockout window
+    bool leading;            ///< Accepted leading edge not committed yet
+    uint32_t leadingMs;
+    uint32_t lastCommitMs;
+    uint32_t pressMs;
+    uint32_t releaseMs;
+    Phase phase;
+
+    uint8_t commit(bool pressed, uint32_t timeMs, InputGesture* out, uint8_t count, uint8_t maxOut);
+    static bool reached(uint32_t nowMs, uint32_t deadline)
+    {
+        return static_cast<int32_t>(nowMs - deadline) >= 0;
+    }
+};
+
+#endif // GESTUREDETECTOR_H
@@ -0,0 +1,45 @@
+#include "InputEngine.h"
+
+namespace {
+    EdgeQueue<InputEvent, INPUT_QUEUE_SIZE> queue;
+    TaskHandle_t consumer = nullptr;
+    volatile uint32_t edges = 0;
+}
+
+volatile uint32_t InputEngine::wakeups = 0;
+
+void InputEngine::setConsumer(TaskHandle_t task)
+{
+    consumer = task;
+}
+
+void InputEngine::wake()
+{
+    if (consumer) xTaskNotifyGive(consumer);
+}
+
+void IRAM_ATTR InputEngine::postFromISR(DInput* input, bool level)
+{
+    InputEvent event = { input, static_cast<uint32_t>(millis()), static_cast<uint32_t>(micros()), level };
+    if (!queue.push(event)) return;
+    edges++;
+
+    if (consumer) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(consumer, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    }
+}
+
+bool InputEngine::pop(InputEvent& event)
+{
+    return queue.pop(event);
+}
+
+void InputEngine::getStats(JsonObject& out)
+{
+    out["edges"] = edges;
+    out["wakeups"] = wakeups;
+    out["overflows"] = queue.overflows;
+    out["queued"] = queue.size();
+}
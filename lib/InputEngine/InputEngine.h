@@ -0,0 +1,39 @@
+#ifndef INPUTENGINE_H
+#define INPUTENGINE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "EdgeQueue.h"
+
+class DInput;
+
+#define INPUT_QUEUE_SIZE 64
+
+struct InputEvent {
+    DInput* input;
+    uint32_t timeMs;
+    uint32_t timeUs;
+    bool level;
+};
+
+/**
+ * @brief Edge events from GPIO interrupts to the input task
+ *
+ * ISRs push timestamped raw edges and wake the consumer task, which sleeps
+ * until an edge arrives or an input's next gesture deadline expires. The
+ * GPIO ISR service runs pin handlers one at a time, so the ISRs together
+ * are the single producer of the queue.
+ */
+namespace InputEngine {
+    void setConsumer(TaskHandle_t task);
+    void wake();
+    void IRAM_ATTR postFromISR(DInput* input, bool level);
+    bool pop(InputEvent& event);
+    void getStats(JsonObject& out);
+
+    extern volatile uint32_t wakeups;
+}
+
+#endif // INPUTENGINE_H
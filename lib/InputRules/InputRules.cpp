@@ -0,0 +1,218 @@
+#include "InputRules.h"
+#include <IOWrapper.h>
+#include <CommandScheduler.h>
+
+namespace {
+    struct GestureKey {
+        const char* key;
+        InputGesture gesture;
+    };
+
+    const GestureKey GESTURE_KEYS[] = {
+        { "onPress", GESTURE_PRESS },
+        { "onRelease", GESTURE_RELEASE },
+        { "onClick", GESTURE_CLICK },
+        { "onDoubleClick", GESTURE_DOUBLE_CLICK },
+        { "onLongPress", GESTURE_LONG_PRESS }
+    };
+}
+
+InputRules& InputRules::getInstance()
+{
+    static InputRules instance;
+    return instance;
+}
+
+InputRules::InputRules()
+    : dispatched(0),
+      failed(0),
+      latencySamples(0),
+      lastLatencyUs(0),
+      maxLatencyUs(0),
+      totalLatencyUs(0)
+{
+}
+
+const char* InputRules::gestureName(InputGesture gesture)
+{
+    switch (gesture) {
+        case GESTURE_PRESS: return "press";
+        case GESTURE_RELEASE: return "release";
+        case GESTURE_CLICK: return "click";
+        case GESTURE_DOUBLE_CLICK: return "doubleClick";
+        case GESTURE_LONG_PRESS: return "longPress";
+        default: return "none";
+    }
+}
+
+bool InputRules::hasRules(JsonVariantConst io)
+{
+    for (const GestureKey& g : GESTURE_KEYS) {
+        if (!io[g.key].isNull()) return true;
+    }
+    return false;
+}
+
+DynamicJsonDocument* InputRules::makeCommand(JsonVariantConst command)
+{
+    DynamicJsonDocument* doc = new DynamicJsonDocument(measureJson(command) + 128);
+    doc->set(command);
+    return doc;
+}
+
+DynamicJsonDocument* InputRules::presetCommand(int id)
+{
+    DynamicJsonDocument* doc = new DynamicJsonDocument(64);
+    (*doc)["preset"] = id;
+    return doc;
+}
+
+bool InputRules::compileRule(JsonObjectConst spec, InputGesture gesture, IOWrapper* wrapper, InputRule& out)
+{
+    const char* target = spec["target"];
+    if (!target) {
+        Serial.printf("WARNING: %s rule without target skipped\n", gestureName(gesture));
+        return false;
+    }
+    out.gesture = gesture;
+    out.cursor = 0;
+    out.scheduler = wrapper->findScheduler(target);
+    if (!out.scheduler) {
+        Serial.printf("WARNING: %s rule targets unknown output %s\n", gestureName(gesture), target);
+        return false;
+    }
+
+    // The action itself, also the "on" state of a toggle
+    DynamicJsonDocument* action = nullptr;
+    if (spec.containsKey("command")) {
+        action = makeCommand(spec["command"]);
+    } else if (spec.containsKey("preset")) {
+        action = presetCommand(spec["preset"].as<int>());
+    }
+
+    if (spec.containsKey("cycle")) {
+        for (JsonVariantConst step : spec["cycle"].as<JsonArrayConst>()) {
+            if (step.is<int>()) {
+                out.commands.push_back(presetCommand(step.as<int>()));
+            } else if (step.is<const char*>()) {
+                // Effect names cycle effects on the target
+                DynamicJsonDocument* doc = new DynamicJsonDocument(128);
+                (*doc)["effect"]["type"] = step.as<const char*>();
+                out.commands.push_back(doc);
+            } else if (step.is<JsonObjectConst>()) {
+                out.commands.push_back(makeCommand(step));
+            }
+        }
+        delete action;
+    } else if (!spec["toggle"].isNull()) {
+        JsonVariantConst toggle = spec["toggle"];
+        if (toggle.containsKey("on")) {
+            delete action;
+            action = makeCommand(toggle["on"]);
+        }
+        if (!action) {
+            action = new DynamicJsonDocument(128);
+            JsonObject color = (*action)["fill"].createNestedObject("color");
+            color["r"] = 255;
+            color["g"] = 255;
+            color["b"] = 255;
+        }
+        DynamicJsonDocument* off;
+        if (toggle.containsKey("off")) {
+            off = makeCommand(toggle["off"]);
+        } else {
+            off = new DynamicJsonDocument(64);
+            (*off)["blackout"] = true;
+        }
+        out.commands.push_back(action);
+        out.commands.push_back(off);
+    } else if (action) {
+        out.commands.push_back(action);
+    }
+
+    if (out.commands.empty()) {
+        Serial.printf("WARNING: %s rule for %s has no action\n", gestureName(gesture), target);
+        return false;
+    }
+    return true;
+}
+
+InputRuleSet* InputRules::compile(JsonVariantConst io, IOWrapper* wrapper)
+{
+    InputRuleSet* set = new InputRuleSet();
+
+    for (const GestureKey& g : GESTURE_KEYS) {
+        JsonVariantConst spec = io[g.key];
+        if (spec.isNull()) continue;
+
+        // A single rule or a list of rules, e.g. one per target
+        if (spec.is<JsonArrayConst>()) {
+            for (JsonObjectConst item : spec.as<JsonArrayConst>()) {
+                InputRule rule;
+                if (compileRule(item, g.gesture, wrapper, rule)) set->rules.push_back(rule);
+            }
+        } else if (spec.is<JsonObjectConst>()) {
+            InputRule rule;
+            if (compileRule(spec.as<JsonObjectConst>(), g.gesture, wrapper, rule)) set->rules.push_back(rule);
+        }
+    }
+
+    if (set->rules.empty()) {
+        delete set;
+        return nullptr;
+    }
+    sets.push_back(set);
+    Serial.printf("InputRules: %u rules compiled\n", static_cast<unsigned>(set->rules.size()));
+    return set;
+}
+
+// Runs on the input task
+void InputRules::dispatch(InputRuleSet& set, InputGesture gesture, uint32_t edgeUs)
+{
+    for (InputRule& rule : set.rules) {
+        if (rule.gesture != gesture) continue;
+
+        JsonObject command = rule.commands[rule.cursor]->as<JsonObject>();
+        rule.cursor = (rule.cursor + 1) % rule.commands.size();
+
+        Output* output = rule.scheduler->getOutput();
+        // A probe whose command never reached a frame is abandoned after a second
+        bool probe = output && (!output->probeStartUs || micros() - output->probeStartUs > 1000000);
+        if (probe) {
+            output->probeApplied = false;
+            output->probeStartUs = edgeUs ? edgeUs : micros();
+        }
+
+        if (rule.scheduler->enqueue(command, PRIORITY_HIGH, probe)) {
+            dispatched++;
+        } else {
+            failed++;
+            if (probe) output->probeStartUs = 0;
+        }
+    }
+}
+
+// Runs on the render task
+void InputRules::recordLatency(uint32_t us)
+{
+    lastLatencyUs = us;
+    maxLatencyUs = std::max(maxLatencyUs, us);
+    totalLatencyUs += us;
+    latencySamples++;
+}
+
+void InputRules::getStats(JsonObject& out)
+{
+    size_t ruleCount = 0;
+    for (InputRuleSet* set : sets) {
+        ruleCount += set->rules.size();
+    }
+    out["rules"] = ruleCount;
+    out["dispatched"] = dispatched;
+    out["failed"] = failed;
+    JsonObject latency = out.createNestedObject("pressToFrameUs");
+    latency["last"] = lastLatencyUs;
+    latency["max"] = maxLatencyUs;
+    latency["avg"] = latencySamples ? static_cast<uint32_t>(totalLatencyUs / latencySamples) : 0;
+    latency["samples"] = latencySamples;
+}
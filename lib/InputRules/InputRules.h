@@ -0,0 +1,76 @@
+#ifndef INPUTRULES_H
+#define INPUTRULES_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+#include <GestureDetector.h>
+
+class IOWrapper;
+class CommandScheduler;
+
+/**
+ * @brief One gesture → command binding, resolved at setup
+ *
+ * commands holds one entry for a plain action, and the sequence to step
+ * through for toggle and cycle rules.
+ */
+struct InputRule {
+    InputGesture gesture;
+    CommandScheduler* scheduler;
+    std::vector<DynamicJsonDocument*> commands;
+    size_t cursor;
+};
+
+struct InputRuleSet {
+    std::vector<InputRule> rules;
+};
+
+/**
+ * @brief Local input → output bindings, with no network round trip
+ *
+ * Rules come from the IO config of an input:
+ *
+ *   "onPress":       {"target": "target", "preset": 3}
+ *   "onClick":       {"target": "target", "toggle": true}
+ *   "onDoubleClick": {"target": "target", "cycle": ["rainbow", "fire"]}
+ *   "onLongPress":   [{"target": "target", "command": {"blackout": true}}]
+ *
+ * They are compiled once into prebuilt command documents bound to the
+ * target's CommandScheduler, so a gesture only costs a queue insert at
+ * high priority. Press-to-frame latency is measured from the raw edge to
+ * the first frame rendered after the command ran.
+ */
+class InputRules {
+public:
+    static InputRules& getInstance();
+
+    static bool hasRules(JsonVariantConst io);
+    InputRuleSet* compile(JsonVariantConst io, IOWrapper* wrapper);
+    void dispatch(InputRuleSet& set, InputGesture gesture, uint32_t edgeUs);
+
+    void recordLatency(uint32_t us);
+    void getStats(JsonObject& out);
+
+    static const char* gestureName(InputGesture gesture);
+
+private:
+    InputRules();
+    InputRules(const InputRules&) = delete;
+    InputRules& operator=(const InputRules&) = delete;
+
+    std::vector<InputRuleSet*> sets;
+
+    uint32_t dispatched;
+    uint32_t failed;
+    uint32_t latencySamples;
+    uint32_t lastLatencyUs;
+    uint32_t maxLatencyUs;
+    uint64_t totalLatencyUs;
+
+    static DynamicJsonDocument* makeCommand(JsonVariantConst command);
+    static DynamicJsonDocument* presetCommand(int id);
+    bool compileRule(JsonObjectConst spec, InputGesture gesture, IOWrapper* wrapper, InputRule& out);
+};
+
+#endif // INPUTRULES_H
@@ -3,12 +3,11 @@
 #include <TranstionsManager.h>
 #include <GradientManager.h>
 #include <EffectsManager.h>
+#include <Timeline.h>
+#include <PresetStore.h>
 
-LEDStripJsonParser::LEDStripJsonParser(LEDStrip* strip):
-      initialJson(_emptyObject),
-      nextJson(_emptyObject){
+LEDStripJsonParser::LEDStripJsonParser(LEDStrip* strip){
     this->strip = strip;
-    loopJsonDoc = new DynamicJsonDocument(0); 
 }
 
 
@@ -35,65 +34,56 @@ void LEDStripJsonParser::jsonInterpreter(JsonObject &json, bool first, int depth
     }
     Serial.println();
 
-    // Clear any pending callback if starting new sequence
-    if (first)
+    // Blackout overrides everything else in the command and any running sequence
+    if (json.containsKey("blackout") && json["blackout"].as<bool>())
     {
-        Serial.println("First run - clearing callbacks and state");
-        
-        // Clean up existing documents safely
-        if (nextJsonDoc) {
-            delete nextJsonDoc;
-            nextJsonDoc = nullptr;
-        }
-        if (loopJsonDoc) {
-            delete loopJsonDoc;
-            loopJsonDoc = nullptr;
-        }
-        
-        strip->transitionsManager->transitionEndCallback = nullptr;
-        strip->deferredCallback = nullptr;
-        strip->isLooping = false;
-        currentThenIndex = 0;
-        
-        // Check for loop flag
-        if (json.containsKey("loop") && json["loop"].as<bool>()) {
-            Serial.println("Loop enabled for this sequence");
-            strip->isLooping = true;
-            // Store the original command for looping
-            size_t docSize = measureJson(json) + 512;
-            loopJsonDoc = new(std::nothrow) DynamicJsonDocument(docSize);
-            if (loopJsonDoc) {
-                JsonObject loopCopy = loopJsonDoc->to<JsonObject>();
-                for (JsonPair kv : json) {
-                    if (strcmp(kv.key().c_str(), "loop") != 0) {
-                        loopCopy[kv.key()] = kv.value();
-                    }
-                }
-                Serial.println("Loop command stored successfully");
-            } else {
-                Serial.println("ERROR: Failed to allocate loop document");
-                strip->isLooping = false;
-            }
-        }
+        Serial.println("- Found blackout command");
+        handleBlackoutCommand();
+        Serial.println("=== JSON INTERPRETER END ===");
+        return;
     }
 
-    // Handle 'then' command
-    if (json.containsKey("then"))
+    // Stored scenes: recall by id, save or delete
+    if (json.containsKey("preset"))
     {
-        Serial.println("Processing 'then' command");
-        // ... existing then handling code ...
+        Serial.println("- Found preset command");
+        handlePresetCommand(json["preset"]);
+        Serial.println("=== JSON INTERPRETER END ===");
+        return;
     }
-    else if (strip->isLooping && loopJsonDoc) {
-        Serial.println("Setting up simple loop callback");
-        // Simple loop without then commands
-        strip->transitionsManager->setOnTransitionEnd([this](JsonObject obj) {
-            strip->deferredCallback = [this]() {
-                if (this->loopJsonDoc) {
-                    JsonObject loopObj = this->loopJsonDoc->as<JsonObject>();
-                    jsonInterpreter(loopObj, false);
-                }
-            };
-        });
+
+    // Pixel positions for the spatial effects, not part of the scene
+    if (json.containsKey("coords"))
+    {
+        Serial.println("- Found coords command");
+        handleCoordsCommand(json["coords"]);
+        Serial.println("=== JSON INTERPRETER END ===");
+        return;
+    }
+
+    // Playback control of the running sequence
+    if (json.containsKey("sequence"))
+    {
+        Serial.println("- Found sequence control");
+        handleSequenceControl(json["sequence"]);
+        Serial.println("=== JSON INTERPRETER END ===");
+        return;
+    }
+
+    // Chained or looping commands are compiled into a timeline and played by the render task
+    if (json.containsKey("then") || json.containsKey("loop"))
+    {
+        Serial.println("- Found sequence");
+        handleSequence(json);
+        Serial.println("=== JSON INTERPRETER END ===");
+        return;
+    }
+
+    // A plain command replaces whatever sequence was running
+    if (first && strip->timeline->isActive())
+    {
+        Serial.println("First run - stopping running sequence");
+        strip->timeline->stop();
     }
 
     // Process current commands
@@ -129,139 +119,268 @@ void LEDStripJsonParser::jsonInterpreter(JsonObject &json, bool first, int depth
 
 
 
-// Fixed method to process sequential then commands from array
-void LEDStripJsonParser::processNextThenCommand()
+// Compile a command and its then chain into keyframes and hand them to the timeline
+void LEDStripJsonParser::handleSequence(JsonObject &json)
 {
-    if (!nextJsonDoc || !nextJsonDoc->is<JsonArray>()) {
-        // Fallback to loop if no more then commands
-        if (strip->isLooping && loopJsonDoc) {
-            currentThenIndex = 0; // Reset index for loop
-            JsonObject loopObj = loopJsonDoc->as<JsonObject>();
-            jsonInterpreter(loopObj, false); // This will now properly reinitialize the then array
-        }
+    std::vector<Keyframe> program;
+    std::vector<EasingSpec> curves;
+    program.reserve(8);
+
+    compileSequence(json, program, curves, 0);
+    if (program.empty())
+    {
+        Serial.println("WARNING: Sequence has no playable steps");
         return;
     }
-    
-    JsonArray thenArray = nextJsonDoc->as<JsonArray>();
-    
-    if (currentThenIndex >= thenArray.size()) {
-        // All commands in array processed
-        if (strip->isLooping && loopJsonDoc) {
-            // For looping: clean up then array and restart the whole sequence
-            delete nextJsonDoc;
-            nextJsonDoc = nullptr;
-            currentThenIndex = 0;
-            JsonObject loopObj = loopJsonDoc->as<JsonObject>();
-            jsonInterpreter(loopObj, false); // This will recreate the then array and start over
-        } else {
-            // No loop, clean up completely
-            delete nextJsonDoc;
-            nextJsonDoc = nullptr;
-            currentThenIndex = 0;
-        }
-        return;
+
+    // "loop": true | <count> | {"count": <n>, "mode": "pingpong"}
+    bool looping = false;
+    bool pingPong = false;
+    uint32_t maxIterations = 0;
+    JsonVariant loopVar = json["loop"];
+    if (loopVar.is<bool>())
+    {
+        looping = loopVar.as<bool>();
     }
-    
-    // Get the current command
-    JsonVariant currentCmd = thenArray[currentThenIndex];
-    if (currentCmd.is<JsonObject>()) {
-        JsonObject cmdObj = currentCmd.as<JsonObject>();
-        currentThenIndex++;
-        
-        // Always set up callback for next command
-        strip->transitionsManager->setOnTransitionEnd([this](JsonObject obj) {
-            strip->deferredCallback = [this]() {
-                this->processNextThenCommand();
-            };
-        });
-        
-        // Execute the current command
-        jsonInterpreter(cmdObj, false);
-    } else {
-        // Skip invalid command and move to next
-        currentThenIndex++;
-        processNextThenCommand();
+    else if (loopVar.is<int>())
+    {
+        int count = loopVar.as<int>();
+        looping = count != 0;
+        maxIterations = count > 0 ? count : 0;
+    }
+    else if (loopVar.is<JsonObject>())
+    {
+        JsonObject loopObj = loopVar.as<JsonObject>();
+        int count = loopObj.containsKey("count") ? loopObj["count"].as<int>() : 0;
+        looping = true;
+        maxIterations = count > 0 ? count : 0;
+        const char *mode = loopObj["mode"].as<const char *>();
+        pingPong = mode && strcmp(mode, "pingpong") == 0;
     }
+
+    strip->timeline->load(program, curves, looping, maxIterations, pingPong);
 }
 
-// Safer copying function with bounds checking
-bool LEDStripJsonParser::copyJsonSafely(JsonObject &source, JsonObject &destination) {
-    if (!source || !destination) {
-        return false;
+// Depth first: a step, then its own then chain, then the following steps
+void LEDStripJsonParser::compileSequence(JsonObject &step, std::vector<Keyframe> &program,
+                                         std::vector<EasingSpec> &curves, int depth)
+{
+    if (depth > 10)
+    {
+        Serial.println("ERROR: Maximum nesting depth exceeded");
+        return;
     }
-    
-    size_t count = 0;
-    for (JsonPair kv : source) {
-        if (++count > 50) { // Prevent infinite loops
-            Serial.println("WARNING: Too many JSON keys, truncating");
-            break;
-        }
-        
-        const char* key = kv.key().c_str();
-        if (!key) continue;
-        
-        JsonVariant value = kv.value();
-        
-        // Handle different value types safely
-        if (value.is<JsonObject>()) {
-            JsonObject nestedSource = value.as<JsonObject>();
-            JsonObject nestedDest = destination.createNestedObject(key);
-            if (!copyJsonSafely(nestedSource, nestedDest)) {
-                return false;
-            }
-        }
-        else if (value.is<JsonArray>()) {
-            JsonArray sourceArray = value.as<JsonArray>();
-            JsonArray destArray = destination.createNestedArray(key);
-            if (!copyJsonArraySafely(sourceArray, destArray)) {
-                return false;
+    if (program.size() >= MAX_KEYFRAMES)
+    {
+        Serial.printf("WARNING: Sequence truncated at %d keyframes\n", MAX_KEYFRAMES);
+        return;
+    }
+
+    Keyframe kf;
+    compileStep(step, kf, curves);
+    program.push_back(kf);
+
+    if (!step.containsKey("then"))
+        return;
+
+    JsonVariant then = step["then"];
+    if (then.is<JsonObject>())
+    {
+        JsonObject next = then.as<JsonObject>();
+        compileSequence(next, program, curves, depth + 1);
+    }
+    else if (then.is<JsonArray>())
+    {
+        for (JsonVariant item : then.as<JsonArray>())
+        {
+            if (item.is<JsonObject>())
+            {
+                JsonObject next = item.as<JsonObject>();
+                compileSequence(next, program, curves, depth + 1);
             }
         }
-        else {
-            // Copy primitive values
-            destination[key] = value;
-        }
     }
-    return true;
 }
 
-// Safer array copying
-bool LEDStripJsonParser::copyJsonArraySafely(JsonArray &source, JsonArray &destination) {
-    if (!source || !destination) {
-        return false;
+void LEDStripJsonParser::compileStep(JsonObject &step, Keyframe &kf, std::vector<EasingSpec> &curves)
+{
+    // The longest transition in the step sets its duration and easing
+    auto useTiming = [&](uint32_t duration, JsonVariant easing, TransitionType fallback) {
+        if (duration < kf.duration || (duration == 0 && kf.flags != 0))
+            return;
+        kf.duration = duration;
+        kf.curve = -1;
+        if (easing.isNull())
+        {
+            kf.easing = fallback;
+            return;
+        }
+        EasingSpec spec;
+        kf.easing = strip->transitionsManager->parseEasing(easing, spec);
+        if (TranstionsManager::builtinEasing(kf.easing) == nullptr && curves.size() < 127)
+        {
+            curves.push_back(spec);
+            kf.curve = static_cast<int8_t>(curves.size() - 1);
+        }
+    };
+
+    if (step.containsKey("fill"))
+    {
+        JsonObject fillObj = step["fill"];
+        WColor color = parseColor(fillObj["color"]);
+        if (color != WColor::INVALID)
+        {
+            useTiming(fillObj["transitionDuration"] | 0u, fillObj["transitionType"], TRANSITION_EASE_IN_OUT);
+            kf.fillColor = color;
+            kf.flags |= Keyframe::FILL;
+        }
     }
-    
-    size_t count = 0;
-    for (JsonVariant element : source) {
-        if (++count > 100) { // Prevent huge arrays
-            Serial.println("WARNING: Array too large, truncating");
-            break;
+
+    if (step.containsKey("effect"))
+    {
+        JsonObject effectObj = step["effect"];
+        EffectState target;
+        uint16_t fields = 0;
+        if (parseEffectObject(effectObj, target, fields) && fields)
+        {
+            // Clamped when the keyframe fires, against the effect it lands on
+            kf.effectType = target.type;
+            kf.speed = target.speed;
+            kf.intensity = target.intensity;
+            kf.color1 = target.color1;
+            kf.color2 = target.color2;
+            kf.color3 = target.color3;
+            kf.emitter = target.emitter;
+            kf.spatial = target.spatial;
+            kf.seed = target.seed;
+            useTiming(effectObj["transitionDuration"] | 0u, effectObj["transitionType"], TRANSITION_EASE_IN_OUT);
+            kf.flags |= fields;
+        }
+    }
+
+    if (step.containsKey("gradient"))
+    {
+        JsonObject gradientObj = step["gradient"];
+        uint16_t flags = 0;
+        if (gradientObj["clear"] | false)
+        {
+            kf.gradientEnabled = false;
+            flags |= Keyframe::GRADIENT_ENABLED;
         }
-        
-        if (element.is<JsonObject>()) {
-            JsonObject sourceObj = element.as<JsonObject>();
-            JsonObject destObj = destination.createNestedObject();
-            if (!copyJsonSafely(sourceObj, destObj)) {
-                return false;
+        else
+        {
+            if (gradientObj.containsKey("start") && gradientObj.containsKey("end"))
+            {
+                WColor startColor = parseColor(gradientObj["start"]);
+                WColor endColor = parseColor(gradientObj["end"]);
+                if (startColor != WColor::INVALID && endColor != WColor::INVALID)
+                {
+                    kf.stops[0] = GradientStop(0.0f, startColor);
+                    kf.stops[1] = GradientStop(1.0f, endColor);
+                    kf.stopCount = 2;
+                    flags |= Keyframe::GRADIENT_STOPS;
+                }
             }
-        }
-        else if (element.is<JsonArray>()) {
-            JsonArray sourceArr = element.as<JsonArray>();
-            JsonArray destArr = destination.createNestedArray();
-            if (!copyJsonArraySafely(sourceArr, destArr)) {
-                return false;
+            else if (gradientObj["stops"].is<JsonArray>())
+            {
+                kf.stopCount = 0;
+                for (JsonObject stop : gradientObj["stops"].as<JsonArray>())
+                {
+                    if (kf.stopCount >= MAX_KEYFRAME_STOPS)
+                        break;
+                    WColor color = parseColor(stop["color"]);
+                    if (color == WColor::INVALID || !stop.containsKey("position"))
+                        continue;
+                    float position = constrain(stop["position"].as<float>(), 0.0f, 1.0f);
+                    kf.stops[kf.stopCount++] = GradientStop(position, color);
+                }
+                if (kf.stopCount > 0)
+                {
+                    std::sort(kf.stops, kf.stops + kf.stopCount);
+                    flags |= Keyframe::GRADIENT_STOPS;
+                }
+            }
+            if (gradientObj.containsKey("reverse"))
+            {
+                kf.gradientReverse = gradientObj["reverse"].as<bool>();
+                flags |= Keyframe::GRADIENT_REVERSE;
+            }
+            if (gradientObj.containsKey("enabled"))
+            {
+                kf.gradientEnabled = gradientObj["enabled"].as<bool>();
+                flags |= Keyframe::GRADIENT_ENABLED;
             }
         }
-        else {
-            destination.add(element);
+        if (flags)
+        {
+            uint32_t duration = (gradientObj["smooth"] | false)
+                ? (gradientObj["duration"] | strip->transitionsManager->defaultTransitionDuration)
+                : 0;
+            useTiming(duration, gradientObj["easing"], strip->transitionsManager->defaultTransitionType);
+            kf.flags |= flags;
         }
     }
-    return true;
+
+    if (step.containsKey("pixels") || step.containsKey("animation"))
+    {
+        Serial.println("WARNING: pixels and animation commands are ignored inside sequences");
+    }
+
+    kf.hold = step["hold"] | 0u;
 }
 
+// "preset": <id> | {"recall": <id>, "transitionDuration": ms} | {"save": <id>} | {"delete": <id>}
+void LEDStripJsonParser::handlePresetCommand(JsonVariant presetVar)
+{
+    PresetStore &store = PresetStore::getInstance();
 
+    if (presetVar.is<int>())
+    {
+        store.recall(presetVar.as<uint16_t>(), strip);
+        return;
+    }
+    if (!presetVar.is<JsonObject>())
+    {
+        Serial.println("WARNING: Invalid preset command");
+        return;
+    }
 
+    JsonObject presetObj = presetVar.as<JsonObject>();
+    if (presetObj.containsKey("save"))
+    {
+        store.save(presetObj["save"].as<uint16_t>(), strip);
+    }
+    else if (presetObj.containsKey("delete"))
+    {
+        store.remove(presetObj["delete"].as<uint16_t>());
+    }
+    else if (presetObj.containsKey("recall"))
+    {
+        uint32_t duration = presetObj["transitionDuration"] | 0u;
+        TransitionType type = presetObj.containsKey("transitionType")
+            ? strip->transitionsManager->parseEasing(presetObj["transitionType"])
+            : TRANSITION_EASE_IN_OUT;
+        store.recall(presetObj["recall"].as<uint16_t>(), strip, duration, type);
+    }
+}
 
+void LEDStripJsonParser::handleSequenceControl(const JsonObject &sequenceObj)
+{
+    if (sequenceObj["stop"] | false)
+    {
+        strip->timeline->stop();
+        return;
+    }
+    if (sequenceObj["break"] | false)
+    {
+        // Finish the current iteration, then stop looping
+        strip->timeline->requestBreak();
+    }
+    if (sequenceObj.containsKey("seek"))
+    {
+        strip->timeline->seek(sequenceObj["seek"].as<uint32_t>());
+    }
+}
 
 void LEDStripJsonParser::handleFillCommand(const JsonObject &fillObj)
 {
@@ -277,7 +396,7 @@ void LEDStripJsonParser::handleFillCommand(const JsonObject &fillObj)
         TransitionType transitionType = TRANSITION_EASE_IN_OUT;
         if (fillObj.containsKey("transitionType"))
         {
-            transitionType = strip->transitionsManager->parseTransitionType(fillObj["transitionType"].as<const char *>());
+            transitionType = strip->transitionsManager->parseEasing(fillObj["transitionType"]);
         }
 
         // Store current transition settings and restore after
@@ -305,7 +424,15 @@ void LEDStripJsonParser::handleGradientCommand(const JsonObject &gradientObj)
     // Set reverse flag if provided
     if (gradientObj.containsKey("reverse"))
     {
-        strip->gradientManager->gradientReverse = gradientObj["reverse"].as<bool>();
+        strip->gradientManager->setGradientReverse(gradientObj["reverse"].as<bool>());
+    }
+
+    // Scroll or rotate the cached gradient
+    if (gradientObj.containsKey("animate"))
+    {
+        GradientAnimation mode = GradientManager::parseAnimation(gradientObj["animate"].as<const char *>());
+        float speed = gradientObj.containsKey("speed") ? gradientObj["speed"].as<float>() : 10.0f;
+        strip->gradientManager->setAnimation(mode, speed);
     }
 
     // Check if smooth transition is requested
@@ -314,7 +441,7 @@ void LEDStripJsonParser::handleGradientCommand(const JsonObject &gradientObj)
     // Get transition parameters if provided
     uint32_t duration = gradientObj.containsKey("duration") ? gradientObj["duration"].as<uint32_t>() : strip->transitionsManager->defaultTransitionDuration;
 
-    TransitionType type = gradientObj.containsKey("easing") ? strip->transitionsManager->parseTransitionType(gradientObj["easing"].as<const char *>()) : strip->transitionsManager->defaultTransitionType;
+    TransitionType type = gradientObj.containsKey("easing") ? strip->transitionsManager->parseEasing(gradientObj["easing"]) : strip->transitionsManager->defaultTransitionType;
 
     // Handle two-color gradient
     if (gradientObj.containsKey("start") && gradientObj.containsKey("end"))
@@ -388,74 +515,181 @@ void LEDStripJsonParser::handleGradientCommand(const JsonObject &gradientObj)
     }
 }
 
-void LEDStripJsonParser::handleEffectCommand(const JsonObject &effectObj)
+// Only the fields present are flagged, the effect keeps its defaults for the others
+static void parseEmitter(JsonObject emitterObj, EmitterConfig &emitter)
 {
-    Serial.println("handleEffectCommand called");
-    
-    // Effect type
-    if (effectObj.containsKey("type"))
+    struct { const char *key; EmitterConfig::Field flag; float *value; float min, max; } fields[] = {
+        {"rate", EmitterConfig::RATE, &emitter.rate, 0.0f, 200.0f},
+        {"life", EmitterConfig::LIFE, &emitter.life, 0.01f, 30.0f},
+        {"velocity", EmitterConfig::VELOCITY, &emitter.velocity, 0.0f, 20.0f},
+        {"spread", EmitterConfig::SPREAD, &emitter.spread, 0.0f, 1.0f},
+        {"gravity", EmitterConfig::GRAVITY, &emitter.gravity, -20.0f, 20.0f},
+        {"size", EmitterConfig::SIZE, &emitter.size, 0.5f, 16.0f},
+    };
+    for (auto &field : fields)
     {
-        const char* effectTypeStr = effectObj["type"].as<const char*>();
-        Serial.printf("Setting effect type: %s\n", effectTypeStr);
-        
-        EffectType effect = strip->effectsManager->parseEffectType(effectTypeStr);
-        
-        if (effect == EFFECT_NONE && strcmp(effectTypeStr, "none") != 0) {
-            Serial.printf("WARNING: Unknown effect type: %s\n", effectTypeStr);
-            return;
+        if (emitterObj.containsKey(field.key))
+        {
+            *field.value = constrain(emitterObj[field.key].as<float>(), field.min, field.max);
+            emitter.mask |= field.flag;
         }
+    }
+}
 
-        bool useTransition = effectObj.containsKey("transitionDuration");
-        
-        if (useTransition)
+// Present vectors replace the current ones, missing components are 0
+static void parseSpatial(JsonObject spatialObj, SpatialConfig &spatial)
+{
+    struct { const char *key; float *value; } vectors[] = {
+        {"direction", spatial.direction},
+        {"center", spatial.center},
+    };
+    for (auto &vector : vectors)
+    {
+        JsonArray values = spatialObj[vector.key].as<JsonArray>();
+        if (values.isNull())
         {
-            uint32_t duration = effectObj["transitionDuration"].as<uint32_t>();
-            TransitionType transitionType = TRANSITION_EASE_IN_OUT;
-
-            if (effectObj.containsKey("transitionType"))
-            {
-                transitionType = strip->transitionsManager->parseTransitionType(effectObj["transitionType"].as<const char *>());
-            }
-
-            Serial.printf("Using smooth transition: duration=%d, type=%d\n", duration, transitionType);
-            strip->effectsManager->setEffectSmooth(effect, duration, transitionType);
+            continue;
         }
-        else
+        for (uint8_t a = 0; a < 3; a++)
         {
-            Serial.println("Setting effect immediately");
-            strip->effectsManager->setEffect(effect);
+            vector.value[a] = constrain(values[a] | 0.0f, -2.0f, 2.0f);
         }
     }
+}
 
-    // Effect parameters - handle these AFTER setting the effect
-    if (effectObj.containsKey("speed"))
+void LEDStripJsonParser::handleCoordsCommand(JsonVariant coordsVar)
+{
+    if (!strip->setCoords(coordsVar))
     {
-        float speed = constrain(effectObj["speed"].as<float>(), 0.1f, 10.0f);
-        Serial.printf("Setting effect speed: %.2f\n", speed);
-        
-        if (effectObj.containsKey("transitionDuration"))
+        Serial.println("WARNING: Invalid coords command ignored");
+    }
+}
+
+void LEDStripJsonParser::handleEffectCommand(const JsonObject &effectObj)
+{
+    Serial.println("handleEffectCommand called");
+
+    // Resolve the complete target first so a smooth change is a single transition
+    EffectState target;
+    target.copyParams(strip->effectsManager->state);
+    uint16_t fields = 0;
+    if (!parseEffectObject(effectObj, target, fields))
+    {
+        return;
+    }
+    EffectRegistry::clampParams(target);
+
+    if (effectObj.containsKey("transitionDuration"))
+    {
+        uint32_t duration = effectObj["transitionDuration"].as<uint32_t>();
+        TransitionType transitionType = TRANSITION_EASE_IN_OUT;
+
+        if (effectObj.containsKey("transitionType"))
         {
-            strip->effectsManager->setEffectSpeedNonBlocking(speed);
+            transitionType = strip->transitionsManager->parseEasing(effectObj["transitionType"]);
         }
-        else
-        {
-            strip->effectsManager->setEffectSpeed(speed);
+
+        Serial.printf("Using smooth transition: duration=%d, type=%d\n", duration, transitionType);
+        strip->transitionsManager->startTransition(target, duration, transitionType);
+        return;
+    }
+
+    if (fields & Keyframe::EFFECT_EMITTER)
+    {
+        strip->effectsManager->setEmitter(target.emitter);
+    }
+    if (fields & Keyframe::EFFECT_SPATIAL)
+    {
+        strip->effectsManager->setSpatial(target.spatial);
+    }
+    if (fields & Keyframe::EFFECT_SEED)
+    {
+        strip->effectsManager->setSeed(target.seed);
+    }
+    if (fields & Keyframe::EFFECT_TYPE)
+    {
+        Serial.println("Setting effect immediately");
+        strip->effectsManager->setEffect(target.type);
+    }
+    if (fields & Keyframe::EFFECT_SPEED)
+    {
+        strip->effectsManager->setEffectSpeed(target.speed);
+    }
+    if (fields & Keyframe::EFFECT_INTENSITY)
+    {
+        strip->effectsManager->setEffectIntensity(target.intensity);
+    }
+    if (fields & Keyframe::EFFECT_COLORS)
+    {
+        strip->effectsManager->setEffectWColors(target.color1, target.color2, target.color3);
+    }
+}
+
+// Shared by effect commands and sequence steps: applies the keys present in
+// effectObj to target and reports them as Keyframe::EFFECT_* fields. Values
+// are not clamped, the effect they end up on may not be known yet.
+// False for an unknown effect type.
+bool LEDStripJsonParser::parseEffectObject(const JsonObject &effectObj, EffectState &target, uint16_t &fields)
+{
+    fields = 0;
+
+    if (effectObj.containsKey("type"))
+    {
+        const char* effectTypeStr = effectObj["type"].as<const char*>();
+        Serial.printf("Setting effect type: %s\n", effectTypeStr);
+
+        EffectType effect = EffectsManager::parseEffectType(effectTypeStr);
+
+        if (effect == EFFECT_NONE && (!effectTypeStr || strcmp(effectTypeStr, "none") != 0)) {
+            Serial.printf("WARNING: Unknown effect type: %s\n", effectTypeStr ? effectTypeStr : "(null)");
+            return false;
         }
+        target.type = effect;
+        fields |= Keyframe::EFFECT_TYPE;
     }
 
-    if (effectObj.containsKey("intensity"))
+    // A new effect type starts from its own emitter defaults, otherwise the
+    // fields given are added to the current overrides
+    if (effectObj.containsKey("type") || effectObj.containsKey("emitter"))
     {
-        float intensity = constrain(effectObj["intensity"].as<float>(), 0.0f, 2.0f);
-        Serial.printf("Setting effect intensity: %.2f\n", intensity);
-        
-        if (effectObj.containsKey("transitionDuration"))
+        if (effectObj.containsKey("type"))
         {
-            strip->effectsManager->setEffectIntensitySmooth(intensity);
+            target.emitter = EmitterConfig();
         }
-        else
+        if (effectObj.containsKey("emitter"))
         {
-            strip->effectsManager->setEffectIntensity(intensity);
+            parseEmitter(effectObj["emitter"].as<JsonObject>(), target.emitter);
         }
+        fields |= Keyframe::EFFECT_EMITTER;
+    }
+
+    // Geometry of the spatial effects, kept across effect types
+    if (effectObj.containsKey("spatial"))
+    {
+        parseSpatial(effectObj["spatial"].as<JsonObject>(), target.spatial);
+        fields |= Keyframe::EFFECT_SPATIAL;
+    }
+
+    // Same seed, same frames; 0 or no seed draws a new one each time the effect starts
+    if (effectObj.containsKey("seed"))
+    {
+        target.seed = effectObj["seed"].as<uint32_t>();
+        Serial.printf("Setting effect seed: %u\n", target.seed);
+        fields |= Keyframe::EFFECT_SEED;
+    }
+
+    if (effectObj.containsKey("speed"))
+    {
+        target.speed = effectObj["speed"].as<float>();
+        Serial.printf("Setting effect speed: %.2f\n", target.speed);
+        fields |= Keyframe::EFFECT_SPEED;
+    }
+
+    if (effectObj.containsKey("intensity"))
+    {
+        target.intensity = effectObj["intensity"].as<float>();
+        Serial.printf("Setting effect intensity: %.2f\n", target.intensity);
+        fields |= Keyframe::EFFECT_INTENSITY;
     }
 
     // Effect colors - only set if the effect actually uses them
@@ -463,26 +697,22 @@ void LEDStripJsonParser::handleEffectCommand(const JsonObject &effectObj)
     if (effectObj.containsKey("colors"))
     {
         JsonArray colors = effectObj["colors"].as<JsonArray>();
-        WColor color1 = WColor::WHITE, color2 = WColor::BLACK, color3 = WColor::BLACK;
+        target.color1 = WColor::WHITE;
+        target.color2 = WColor::BLACK;
+        target.color3 = WColor::BLACK;
 
         if (colors.size() >= 1)
-            color1 = parseColor(colors[0]);
+            target.color1 = parseColor(colors[0]);
         if (colors.size() >= 2)
-            color2 = parseColor(colors[1]);
+            target.color2 = parseColor(colors[1]);
         if (colors.size() >= 3)
-            color3 = parseColor(colors[2]);
+            target.color3 = parseColor(colors[2]);
 
-        Serial.printf("Setting effect colors: RGB1=(%d,%d,%d)\n", color1.r, color1.g, color1.b);
-
-        if (effectObj.containsKey("transitionDuration"))
-        {
-            strip->effectsManager->setEffectWColorsSmooth(color1, color2, color3);
-        }
-        else
-        {
-            strip->effectsManager->setEffectWColors(color1, color2, color3);
-        }
+        Serial.printf("Setting effect colors: RGB1=(%d,%d,%d)\n", target.color1.r, target.color1.g, target.color1.b);
+        fields |= Keyframe::EFFECT_COLORS;
     }
+
+    return true;
 }
 
 void LEDStripJsonParser::handlePixelCommands(const JsonObject &pixelsObj)
@@ -498,7 +728,7 @@ void LEDStripJsonParser::handlePixelCommands(const JsonObject &pixelsObj)
                 uint16_t index = pixel["index"].as<uint16_t>();
                 WColor color = parseColor(pixel["color"]);
 
-                if (index < strip->neopixel.numPixels() && color != WColor::INVALID)
+                if (index < strip->numPixels() && color != WColor::INVALID)
                 {
                     strip->setPixelWColor(index, color);
                 }
@@ -517,7 +747,7 @@ void LEDStripJsonParser::handlePixelCommands(const JsonObject &pixelsObj)
 
             if (color != WColor::INVALID)
             {
-                for (uint16_t i = start; i <= end && i < strip->neopixel.numPixels(); i++)
+                for (uint16_t i = start; i <= end && i < strip->numPixels(); i++)
                 {
                     strip->setPixelWColor(i, color);
                 }
@@ -550,11 +780,19 @@ void LEDStripJsonParser::handleAnimationControl(const JsonObject &animObj)
 
 
 
+void LEDStripJsonParser::handleBlackoutCommand()
+{
+    // Stop sequences first so no pending step can relight the strip
+    strip->timeline->stop();
+
+    strip->transitionsManager->stopTransition();
+    strip->effectsManager->setEffect(EFFECT_NONE);
+    strip->gradientManager->clearGradient();
+    strip->fill(WColor::BLACK);
+}
+
 void LEDStripJsonParser::clean(){
-    if (nextJsonDoc) {
-        delete nextJsonDoc;
-        nextJsonDoc = nullptr;
-    }
+    strip->timeline->stop();
 }
 
 
@@ -1,37 +1,36 @@
 #ifndef STRIPARSER_H
 #define STRIPARSER_H
 #include <LEDStrip.h>
+#include <Timeline.h>
 
 
 class LEDStripJsonParser{
     public:
     LEDStripJsonParser(LEDStrip* strip);
-    DynamicJsonDocument* loopJsonDoc;
-    JsonObject& initialJson;
-    JsonObject& nextJson;
     void clean();
     
-    bool copyJsonSafely(JsonObject &source, JsonObject &destination);
-    bool copyJsonArraySafely(JsonArray &source, JsonArray &destination);
     void jsonInterpreter(JsonObject& json, bool first, int depth = 0);
     void handleFillCommand(const JsonObject &fillObj);
     void handleGradientCommand(const JsonObject &gradientObj);
     void handleEffectCommand(const JsonObject &effectObj);
+    bool parseEffectObject(const JsonObject &effectObj, EffectState &target, uint16_t &fields);
     void handlePixelCommands(const JsonObject &pixelsObj);
     void handleAnimationControl(const JsonObject &animObj);
-    void processNextThenCommand();
-    int currentThenIndex = 0;
+    void handleBlackoutCommand();
+    void handleSequence(JsonObject &json);
+    void handleSequenceControl(const JsonObject &sequenceObj);
+    void handlePresetCommand(JsonVariant presetVar);
+    void handleCoordsCommand(JsonVariant coordsVar);
+    void compileSequence(JsonObject &step, std::vector<Keyframe> &program,
+                         std::vector<EasingSpec> &curves, int depth);
+    void compileStep(JsonObject &step, Keyframe &kf, std::vector<EasingSpec> &curves);
     
     
     WColor parseColor(JsonVariant colorVar);
     WColor parseHexColor(const char* hex);
     WColor parseNamedColor(const char* name);
-    DynamicJsonDocument* nextJsonDoc = nullptr;
     private:
     LEDStrip* strip;
-    
-    StaticJsonDocument<1> _emptyDoc;
-    JsonObject _emptyObject;
 };
 
 #endif
\ No newline at end of file
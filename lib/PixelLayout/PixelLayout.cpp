@@ -0,0 +1,341 @@
+#include <Arduino.h>
+#include <algorithm>
+#include <math.h>
+#include "PixelLayout.h"
+
+static MatrixOrigin originFromString(const char* name)
+{
+    if (strcmp(name, "top-right") == 0) return MATRIX_TOP_RIGHT;
+    if (strcmp(name, "bottom-left") == 0) return MATRIX_BOTTOM_LEFT;
+    if (strcmp(name, "bottom-right") == 0) return MATRIX_BOTTOM_RIGHT;
+    return MATRIX_TOP_LEFT;
+}
+
+bool MatrixConfig::parse(JsonVariantConst json, MatrixConfig& out)
+{
+    if (!json["width"].is<uint16_t>() || !json["height"].is<uint16_t>()) return false;
+    out.width = json["width"];
+    out.height = json["height"];
+    out.serpentine = json["serpentine"] | false;
+    out.origin = originFromString(json["origin"] | "top-left");
+    out.rotation = json["rotation"] | 0;
+    JsonVariantConst panels = json["panels"];
+    out.panelsX = panels["x"] | 1;
+    out.panelsY = panels["y"] | 1;
+    out.panelSerpentine = panels["serpentine"] | false;
+
+    if (out.rotation % 90 != 0 || out.rotation >= 360) {
+        Serial.printf("Matrix: rotation %u ignored, use 0, 90, 180 or 270\n", out.rotation);
+        out.rotation = 0;
+    }
+    return out.width > 0 && out.height > 0 && out.panelsX > 0 && out.panelsY > 0;
+}
+
+MatrixLayout::MatrixLayout() : cols(0), rows(0), configured(false) {}
+
+void MatrixLayout::linear(uint16_t ledCount)
+{
+    cols = ledCount;
+    rows = ledCount > 0 ? 1 : 0;
+    configured = false;
+    table.resize(ledCount);
+    for (uint16_t i = 0; i < ledCount; i++) table[i] = i;
+}
+
+// Walks the LEDs in wiring order and records where each lands on the canvas
+bool MatrixLayout::compile(const MatrixConfig& config, uint16_t ledCount)
+{
+    uint16_t w = config.width;
+    uint16_t h = config.height;
+    bool sideways = config.rotation == 90 || config.rotation == 270;
+    uint16_t panelCols = sideways ? h : w;
+    uint16_t panelRows = sideways ? w : h;
+    uint32_t canvasCols = static_cast<uint32_t>(panelCols) * config.panelsX;
+    uint32_t canvasRows = static_cast<uint32_t>(panelRows) * config.panelsY;
+    uint32_t cells = canvasCols * canvasRows;
+
+    if (cells == 0 || cells > ledCount) {
+        Serial.printf("Matrix: %ux%u cells do not fit %u LEDs, ignored\n",
+                      (unsigned)canvasCols, (unsigned)canvasRows, ledCount);
+        return false;
+    }
+
+    cols = canvasCols;
+    rows = canvasRows;
+    table.assign(cells, 0);
+
+    uint32_t panelSize = static_cast<uint32_t>(w) * h;
+    uint16_t panelCount = static_cast<uint16_t>(config.panelsX) * config.panelsY;
+    for (uint16_t p = 0; p < panelCount; p++) {
+        uint16_t panelRow = p / config.panelsX;
+        uint16_t panelCol = p % config.panelsX;
+        if (config.panelSerpentine && (panelRow & 1)) panelCol = config.panelsX - 1 - panelCol;
+
+        for (uint32_t k = 0; k < panelSize; k++) {
+            // Position in the panel as wired
+            uint16_t r = k / w;
+            uint16_t c = k % w;
+            if (config.serpentine && (r & 1)) c = w - 1 - c;
+            if (config.origin == MATRIX_TOP_RIGHT || config.origin == MATRIX_BOTTOM_RIGHT) c = w - 1 - c;
+            if (config.origin == MATRIX_BOTTOM_LEFT || config.origin == MATRIX_BOTTOM_RIGHT) r = h - 1 - r;
+
+            // Position in the panel as mounted
+            uint16_t x, y;
+            switch (config.rotation) {
+                case 90:  x = h - 1 - r; y = c;         break;
+                case 180: x = w - 1 - c; y = h - 1 - r; break;
+                case 270: x = r;         y = w - 1 - c; break;
+                default:  x = c;         y = r;         break;
+            }
+
+            x += panelCol * panelCols;
+            y += panelRow * panelRows;
+            table[y * cols + x] = p * panelSize + k;
+        }
+    }
+
+    configured = true;
+    return true;
+}
+
+void MatrixLayout::getStats(JsonObject& out) const
+{
+    out["width"] = cols;
+    out["height"] = rows;
+    out["matrix"] = configured;
+    out["tableBytes"] = table.size() * sizeof(uint16_t);
+}
+
+// Binary table: magic, version, count, then the x, y and z arrays, little endian
+static const uint8_t COORDS_MAGIC[4] = {'W', 'X', 'Y', 'Z'};
+static const uint8_t COORDS_VERSION = 1;
+static const size_t COORDS_HEADER_SIZE = 8;
+
+PixelCoords::PixelCoords() : custom(false) {}
+
+// Bounds first, values second, so no float copy of the table is ever held
+bool PixelCoords::parse(JsonVariantConst json, uint16_t ledCount)
+{
+    JsonArrayConst axes[3] = {json["x"].as<JsonArrayConst>(),
+                              json["y"].as<JsonArrayConst>(),
+                              json["z"].as<JsonArrayConst>()};
+    if (axes[0].isNull()) {
+        Serial.println("Coords: x is required");
+        return false;
+    }
+    for (uint8_t a = 0; a < 3; a++) {
+        if (!axes[a].isNull() && axes[a].size() != ledCount) {
+            Serial.printf("Coords: %u values on axis %c, %u LEDs\n",
+                          (unsigned)axes[a].size(), 'x' + a, ledCount);
+            return false;
+        }
+    }
+
+    float center[3] = {0.0f, 0.0f, 0.0f};
+    float extent = 0.0f;
+    for (uint8_t a = 0; a < 3; a++) {
+        if (axes[a].isNull()) continue;
+        float low = INFINITY, high = -INFINITY;
+        for (JsonVariantConst v : axes[a]) {
+            float f = v.as<float>();
+            low = std::min(low, f);
+            high = std::max(high, f);
+        }
+        if (!(low <= high)) return false;
+        center[a] = (low + high) * 0.5f;
+        extent = std::max(extent, (high - low) * 0.5f);
+    }
+
+    float scale = extent > 0.0f ? UNIT / extent : 0.0f;
+    std::vector<int16_t>* out[3] = {&xs, &ys, &zs};
+    for (uint8_t a = 0; a < 3; a++) {
+        out[a]->assign(ledCount, 0);
+        if (axes[a].isNull()) continue;
+        uint16_t i = 0;
+        for (JsonVariantConst v : axes[a]) {
+            float n = (v.as<float>() - center[a]) * scale;
+            (*out[a])[i++] = static_cast<int16_t>(std::max(-32767.0f, std::min(32767.0f, roundf(n))));
+        }
+    }
+    custom = true;
+    return true;
+}
+
+// Cell centers on one scale for both axes, so circles stay round on any panel
+void PixelCoords::fromLayout(const MatrixLayout& layout, uint16_t ledCount)
+{
+    xs.assign(ledCount, 0);
+    ys.assign(ledCount, 0);
+    zs.assign(ledCount, 0);
+    custom = false;
+
+    int32_t w = layout.width();
+    int32_t h = layout.height();
+    int32_t span = std::max(w, h) - 1;
+    if (span <= 0) return;
+
+    for (int32_t y = 0; y < h; y++) {
+        const uint16_t* row = layout.row(y);
+        int16_t py = static_cast<int16_t>((h - 1 - 2 * y) * UNIT / span);   // Top row up
+        for (int32_t x = 0; x < w; x++) {
+            uint16_t index = row[x];
+            if (index >= ledCount) continue;
+            xs[index] = static_cast<int16_t>((2 * x - (w - 1)) * UNIT / span);
+            ys[index] = py;
+        }
+    }
+}
+
+void PixelCoords::encode(std::vector<uint8_t>& out) const
+{
+    uint16_t count = size();
+    out.resize(COORDS_HEADER_SIZE + 3u * count * sizeof(int16_t));
+    uint8_t* p = out.data();
+    memcpy(p, COORDS_MAGIC, 4);
+    p[4] = COORDS_VERSION;
+    p[5] = 0;
+    p[6] = count & 0xFF;
+    p[7] = count >> 8;
+    p += COORDS_HEADER_SIZE;
+    for (const std::vector<int16_t>* axis : {&xs, &ys, &zs}) {
+        memcpy(p, axis->data(), count * sizeof(int16_t));
+        p += count * sizeof(int16_t);
+    }
+}
+
+// A table for another LED count is refused, the layout default stays
+bool PixelCoords::decode(const uint8_t* data, size_t length, uint16_t ledCount)
+{
+    if (length < COORDS_HEADER_SIZE || memcmp(data, COORDS_MAGIC, 4) != 0 || data[4] != COORDS_VERSION) {
+        return false;
+    }
+    uint16_t count = data[6] | (data[7] << 8);
+    if (count != ledCount || length != COORDS_HEADER_SIZE + 3u * count * sizeof(int16_t)) {
+        return false;
+    }
+
+    const uint8_t* p = data + COORDS_HEADER_SIZE;
+    for (std::vector<int16_t>* axis : {&xs, &ys, &zs}) {
+        axis->resize(count);
+        memcpy(axis->data(), p, count * sizeof(int16_t));
+        p += count * sizeof(int16_t);
+    }
+    custom = true;
+    return true;
+}
+
+void PixelCoords::getStats(JsonObject& out) const
+{
+    out["count"] = size();
+    out["custom"] = custom;
+    out["tableBytes"] = 3u * size() * sizeof(int16_t);
+}
+
+// Below this average run length a table is smaller and packs as fast
+static const uint16_t MIN_AVERAGE_RUN = 4;
+
+PixelMap::PixelMap() : logicalCount(0), ledCount(0) {}
+
+void PixelMap::identity(uint16_t count)
+{
+    table.clear();
+    runs.assign(1, Run{0, count, 1});
+    logicalCount = count;
+    ledCount = count;
+}
+
+// {"table": [...]}: LED of each logical pixel.
+// {"segments": [{"start", "count", "reverse"}, ...]}: runs in logical order.
+// Otherwise "offset", "count", "skip": [[start, count], ...] and "reverse"
+// describe one strip with LEDs cut off at the start and gaps along it.
+bool PixelMap::parse(JsonVariantConst json, uint16_t leds)
+{
+    std::vector<uint16_t> order;
+    order.reserve(leds);
+
+    if (json["table"].is<JsonArrayConst>()) {
+        for (JsonVariantConst v : json["table"].as<JsonArrayConst>()) {
+            order.push_back(v.as<uint16_t>());
+        }
+    } else if (json["segments"].is<JsonArrayConst>()) {
+        for (JsonVariantConst segment : json["segments"].as<JsonArrayConst>()) {
+            uint32_t start = segment["start"] | 0;
+            uint32_t count = segment["count"] | 0;
+            if (start + count > leds) {
+                Serial.printf("Pixel map: segment %u+%u past %u LEDs\n", (unsigned)start, (unsigned)count, leds);
+                return false;
+            }
+            bool reverse = segment["reverse"] | false;
+            for (uint32_t k = 0; k < count; k++) {
+                order.push_back(reverse ? start + count - 1 - k : start + k);
+            }
+        }
+    } else {
+        uint32_t offset = json["offset"] | 0;
+        uint32_t end = std::min<uint32_t>(leds, offset + (json["count"] | static_cast<uint32_t>(leds)));
+        std::vector<bool> skipped(leds, false);
+        for (JsonVariantConst gap : json["skip"].as<JsonArrayConst>()) {
+            uint32_t start = gap[0] | 0;
+            uint32_t count = gap[1] | 1;
+            for (uint32_t i = start; i < start + count && i < leds; i++) skipped[i] = true;
+        }
+        for (uint32_t i = offset; i < end; i++) {
+            if (!skipped[i]) order.push_back(i);
+        }
+        if (json["reverse"] | false) std::reverse(order.begin(), order.end());
+    }
+
+    return compile(order, leds);
+}
+
+bool PixelMap::compile(const std::vector<uint16_t>& order, uint16_t leds)
+{
+    if (order.empty() || order.size() > leds) {
+        Serial.printf("Pixel map: %u pixels on %u LEDs\n", (unsigned)order.size(), leds);
+        return false;
+    }
+    std::vector<bool> used(leds, false);
+    for (uint16_t led : order) {
+        if (led >= leds || used[led]) {
+            Serial.printf("Pixel map: LED %u out of range or used twice\n", led);
+            return false;
+        }
+        used[led] = true;
+    }
+
+    // Longest runs of LEDs one apart, in either direction
+    std::vector<Run> compiled;
+    for (size_t i = 0; i < order.size();) {
+        Run run{order[i], 1, 1};
+        if (i + 1 < order.size()) {
+            int32_t delta = static_cast<int32_t>(order[i + 1]) - order[i];
+            if (delta == 1 || delta == -1) run.step = delta;
+        }
+        while (i + run.count < order.size() &&
+               static_cast<int32_t>(order[i + run.count]) == order[i] + run.step * run.count) {
+            run.count++;
+        }
+        compiled.push_back(run);
+        i += run.count;
+    }
+
+    logicalCount = order.size();
+    ledCount = leds;
+    if (compiled.size() * MIN_AVERAGE_RUN > order.size()) {
+        runs.clear();
+        table = order;
+    } else {
+        table.clear();
+        runs = std::move(compiled);
+    }
+    return true;
+}
+
+void PixelMap::getStats(JsonObject& out) const
+{
+    out["logical"] = logicalCount;
+    out["leds"] = ledCount;
+    out["runs"] = runs.size();
+    out["table"] = !table.empty();
+    out["mapBytes"] = runs.size() * sizeof(Run) + table.size() * sizeof(uint16_t);
+}
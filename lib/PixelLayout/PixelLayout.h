@@ -0,0 +1,160 @@
+#ifndef PIXELLAYOUT_H
+#define PIXELLAYOUT_H
+
+#include <stdint.h>
+#include <vector>
+#include <ArduinoJson.h>
+
+enum MatrixOrigin : uint8_t {
+    MATRIX_TOP_LEFT,
+    MATRIX_TOP_RIGHT,
+    MATRIX_BOTTOM_LEFT,
+    MATRIX_BOTTOM_RIGHT
+};
+
+/**
+ * @brief Wiring of a matrix, the "matrix" object of a strip <UID>.json
+ *
+ * width and height describe one panel as wired: rows of width LEDs, the
+ * first LED at origin. rotation (0, 90, 180, 270, clockwise) is how the
+ * panel is mounted. Panels are chained row by row, panelsX across.
+ */
+struct MatrixConfig {
+    uint16_t width = 0;
+    uint16_t height = 0;
+    bool serpentine = false;         ///< Every other row runs backwards
+    MatrixOrigin origin = MATRIX_TOP_LEFT;
+    uint16_t rotation = 0;
+    uint8_t panelsX = 1;
+    uint8_t panelsY = 1;
+    bool panelSerpentine = false;    ///< Every other row of panels runs backwards
+
+    static bool parse(JsonVariantConst json, MatrixConfig& out);
+};
+
+/**
+ * @brief XY to strip index table, compiled once from a MatrixConfig
+ *
+ * Effects render row by row through row(y), so the table is the only
+ * indirection per pixel. A strip without a matrix gets a single row of
+ * all its LEDs, and 2D effects still run on it.
+ */
+class MatrixLayout {
+public:
+    MatrixLayout();
+
+    bool compile(const MatrixConfig& config, uint16_t ledCount);
+    void linear(uint16_t ledCount);
+
+    uint16_t width() const { return cols; }
+    uint16_t height() const { return rows; }
+    bool isMatrix() const { return configured; }
+
+    const uint16_t* row(uint16_t y) const { return &table[y * cols]; }
+    uint16_t index(uint16_t x, uint16_t y) const { return table[y * cols + x]; }
+
+    void getStats(JsonObject& out) const;
+
+private:
+    std::vector<uint16_t> table;   ///< Row major, width * height entries
+    uint16_t cols;
+    uint16_t rows;
+    bool configured;
+};
+
+/**
+ * @brief Position of every pixel in space, for the spatial effects
+ *
+ * Three int16 arrays (structure of arrays), normalized so the longest axis
+ * spans -UNIT to UNIT around the center of the install, whatever the unit of
+ * the table they came from. x runs right, y up and z toward the viewer.
+ * Without an uploaded table positions follow the matrix layout, or the strip
+ * as a line along x.
+ */
+class PixelCoords {
+public:
+    static constexpr int16_t UNIT = 32767;
+
+    PixelCoords();
+
+    // {"x": [...], "y": [...], "z": [...]}, ledCount values each, y and z optional
+    bool parse(JsonVariantConst json, uint16_t ledCount);
+    void fromLayout(const MatrixLayout& layout, uint16_t ledCount);
+
+    // Binary form kept on flash, see LEDStrip::loadCoords
+    void encode(std::vector<uint8_t>& out) const;
+    bool decode(const uint8_t* data, size_t length, uint16_t ledCount);
+
+    uint16_t size() const { return xs.size(); }
+    bool isCustom() const { return custom; }
+    const int16_t* x() const { return xs.data(); }
+    const int16_t* y() const { return ys.data(); }
+    const int16_t* z() const { return zs.data(); }
+
+    void getStats(JsonObject& out) const;
+
+private:
+    std::vector<int16_t> xs;
+    std::vector<int16_t> ys;
+    std::vector<int16_t> zs;
+    bool custom;   ///< Uploaded or loaded, not derived from the layout
+};
+
+/**
+ * @brief Logical to physical pixel order, applied once when a frame is packed
+ *
+ * Effects render logical pixels 0 to size() - 1. The map places them on the
+ * LEDs as runs of consecutive LEDs, forward or reversed; LEDs no run covers
+ * are gaps and stay dark. Orders that do not compress into runs of a few
+ * pixels keep one LED index per logical pixel instead.
+ */
+class PixelMap {
+public:
+    struct Run {
+        uint16_t physical;   ///< LED of the first logical pixel of the run
+        uint16_t count;
+        int16_t step;        ///< +1 or -1
+    };
+
+    PixelMap();
+
+    void identity(uint16_t ledCount);
+    // "map" object of a strip <UID>.json
+    bool parse(JsonVariantConst json, uint16_t ledCount);
+    // order[i] is the LED of logical pixel i, each LED at most once
+    bool compile(const std::vector<uint16_t>& order, uint16_t ledCount);
+
+    uint16_t size() const { return logicalCount; }
+    bool usesTable() const { return !table.empty(); }
+    size_t runCount() const { return runs.size(); }
+
+    // Calls set(led, logical[i]) for every logical pixel, in LED order within a run
+    template <typename Pixel, typename Set>
+    void pack(const Pixel* logical, Set&& set) const {
+        if (!table.empty()) {
+            for (uint16_t i = 0; i < logicalCount; i++) set(table[i], logical[i]);
+            return;
+        }
+        // Direction hoisted out of the inner loops, which are then as plain as an unmapped pack
+        for (const Run& run : runs) {
+            const uint16_t first = run.physical;
+            const uint16_t count = run.count;
+            if (run.step > 0) {
+                for (uint16_t k = 0; k < count; k++) set(first + k, logical[k]);
+            } else {
+                for (uint16_t k = 0; k < count; k++) set(first - k, logical[k]);
+            }
+            logical += count;
+        }
+    }
+
+    void getStats(JsonObject& out) const;
+
+private:
+    std::vector<Run> runs;
+    std::vector<uint16_t> table;   ///< Only when the order does not compress into runs
+    uint16_t logicalCount;
+    uint16_t ledCount;
+};
+
+#endif // PIXELLAYOUT_H
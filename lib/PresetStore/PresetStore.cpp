@@ -0,0 +1,582 @@
+#include "PresetStore.h"
+#include <SPIFFS.h>
+#include <algorithm>
+#include <type_traits>
+#include <LEDStrip.h>
+#include <EffectsManager.h>
+#include <GradientManager.h>
+#include <TranstionsManager.h>
+#include <Timeline.h>
+#include <ConfigStore.h>
+
+// File layout: header, then records of [magic u16][id u16][length u32][payload].
+// A record with length 0 deletes the id. Multi-byte values are little endian.
+static const uint8_t FILE_MAGIC[4] = {'W', 'P', 'S', 'T'};
+static const uint16_t RECORD_MAGIC = 0x5350;
+static const uint32_t FILE_HEADER_SIZE = 10;
+static const uint32_t RECORD_HEADER_SIZE = 8;
+
+// Payload section flags
+static const uint8_t SCENE_PIXELS = 1 << 0;
+static const uint8_t SCENE_SEQUENCE = 1 << 1;
+static const uint8_t SCENE_EMITTER = 1 << 2;   // Right after the effect colors
+static const uint8_t SCENE_SEED = 1 << 3;      // After the emitter
+static const uint8_t SCENE_SPATIAL = 1 << 4;   // After the seed
+
+static_assert(std::is_trivially_copyable<Keyframe>::value, "Keyframe is stored raw");
+static_assert(std::is_trivially_copyable<EasingSpec>::value, "EasingSpec is stored raw");
+
+namespace {
+
+struct Writer {
+    std::vector<uint8_t>& out;
+    void u8(uint8_t v) { out.push_back(v); }
+    void u16(uint16_t v) { u8(v & 0xFF); u8(v >> 8); }
+    void u32(uint32_t v) { u16(v & 0xFFFF); u16(v >> 16); }
+    void f32(float v) { uint32_t bits; memcpy(&bits, &v, 4); u32(bits); }
+    void rgb(const WColor& c) { u8(c.r); u8(c.g); u8(c.b); }
+    void raw(const void* data, size_t len)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        out.insert(out.end(), p, p + len);
+    }
+};
+
+struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+
+    bool need(size_t n)
+    {
+        if (static_cast<size_t>(end - p) < n) ok = false;
+        return ok;
+    }
+    uint8_t u8() { return need(1) ? *p++ : 0; }
+    uint16_t u16() { uint16_t lo = u8(); return lo | (static_cast<uint16_t>(u8()) << 8); }
+    uint32_t u32() { uint32_t lo = u16(); return lo | (static_cast<uint32_t>(u16()) << 16); }
+    float f32() { uint32_t bits = u32(); float v; memcpy(&v, &bits, 4); return v; }
+    WColor rgb() { uint8_t r = u8(), g = u8(), b = u8(); return WColor(r, g, b); }
+    const uint8_t* raw(size_t len)
+    {
+        if (!need(len)) return nullptr;
+        const uint8_t* start = p;
+        p += len;
+        return start;
+    }
+};
+
+} // namespace
+
+PresetStore& PresetStore::getInstance()
+{
+    static PresetStore instance;
+    return instance;
+}
+
+PresetStore::PresetStore()
+    : ready(false),
+      storeMutex(nullptr),
+      fileSize(0),
+      liveBytes(0),
+      saves(0),
+      recalls(0),
+      lastRecallUs(0),
+      maxRecallUs(0)
+{
+    storeMutex = xSemaphoreCreateMutex();
+}
+
+bool PresetStore::begin(const char* path)
+{
+    if (ready) return true;
+    if (!ConfigStore::getInstance().mount()) {
+        Serial.println("ERROR: PresetStore could not mount SPIFFS");
+        return false;
+    }
+
+    this->path = path;
+    recordBuffer.reserve(1024);
+
+    if (!xSemaphoreTake(storeMutex, portMAX_DELAY)) return false;
+    ready = rebuildIndex();
+    if (ready) reopenReader();
+    xSemaphoreGive(storeMutex);
+
+    Serial.printf("PresetStore ready: %u presets, %u bytes\n",
+                  static_cast<unsigned>(index.size()), fileSize);
+    return ready;
+}
+
+// Walk the file once and keep the latest record of every id
+bool PresetStore::rebuildIndex()
+{
+    index.clear();
+    fileSize = 0;
+    liveBytes = 0;
+
+    if (!SPIFFS.exists(path)) {
+        File file = SPIFFS.open(path, FILE_WRITE);
+        if (!file) {
+            Serial.println("ERROR: PresetStore could not create preset file");
+            return false;
+        }
+        uint8_t header[FILE_HEADER_SIZE];
+        memcpy(header, FILE_MAGIC, 4);
+        uint16_t meta[3] = {PRESET_FILE_VERSION, sizeof(Keyframe), sizeof(EasingSpec)};
+        memcpy(header + 4, meta, sizeof(meta));
+        file.write(header, sizeof(header));
+        file.close();
+        fileSize = FILE_HEADER_SIZE;
+        return true;
+    }
+
+    File file = SPIFFS.open(path, FILE_READ);
+    if (!file) return false;
+
+    uint8_t header[FILE_HEADER_SIZE];
+    if (file.read(header, sizeof(header)) != sizeof(header) || memcmp(header, FILE_MAGIC, 4) != 0) {
+        Serial.println("WARNING: Preset file unreadable, starting empty");
+        file.close();
+        SPIFFS.remove(path);
+        return rebuildIndex();
+    }
+
+    uint32_t offset = FILE_HEADER_SIZE;
+    uint32_t size = file.size();
+    uint8_t recordHeader[RECORD_HEADER_SIZE];
+    while (offset + RECORD_HEADER_SIZE <= size) {
+        if (file.read(recordHeader, RECORD_HEADER_SIZE) != RECORD_HEADER_SIZE) break;
+        uint16_t magic = recordHeader[0] | (recordHeader[1] << 8);
+        uint16_t id = recordHeader[2] | (recordHeader[3] << 8);
+        uint32_t length = recordHeader[4] | (recordHeader[5] << 8) |
+                          (recordHeader[6] << 16) | (static_cast<uint32_t>(recordHeader[7]) << 24);
+        if (magic != RECORD_MAGIC || offset + RECORD_HEADER_SIZE + length > size) {
+            // Torn write at the tail: everything before it is still valid
+            Serial.println("WARNING: Truncated preset record ignored");
+            break;
+        }
+        setEntry(id, offset + RECORD_HEADER_SIZE, length);
+        offset += RECORD_HEADER_SIZE + length;
+        file.seek(offset);
+    }
+    file.close();
+    fileSize = offset;
+    return true;
+}
+
+void PresetStore::reopenReader()
+{
+    if (readHandle) readHandle.close();
+    readHandle = SPIFFS.open(path, FILE_READ);
+}
+
+PresetStore::IndexEntry* PresetStore::find(uint16_t id)
+{
+    auto it = std::lower_bound(index.begin(), index.end(), id,
+                               [](const IndexEntry& e, uint16_t key) { return e.id < key; });
+    return (it != index.end() && it->id == id) ? &*it : nullptr;
+}
+
+// Length 0 removes the id from the index
+void PresetStore::setEntry(uint16_t id, uint32_t offset, uint32_t length)
+{
+    auto it = std::lower_bound(index.begin(), index.end(), id,
+                               [](const IndexEntry& e, uint16_t key) { return e.id < key; });
+    bool exists = it != index.end() && it->id == id;
+    if (exists) {
+        liveBytes -= RECORD_HEADER_SIZE + it->length;
+    }
+
+    if (length == 0) {
+        if (exists) index.erase(it);
+        return;
+    }
+
+    liveBytes += RECORD_HEADER_SIZE + length;
+    if (exists) {
+        it->offset = offset;
+        it->length = length;
+    } else {
+        index.insert(it, IndexEntry{id, offset, length});
+    }
+}
+
+bool PresetStore::appendRecord(uint16_t id, const uint8_t* data, uint32_t length)
+{
+    File file = SPIFFS.open(path, FILE_APPEND);
+    if (!file) {
+        Serial.println("ERROR: PresetStore could not open preset file for append");
+        return false;
+    }
+
+    uint8_t header[RECORD_HEADER_SIZE] = {
+        static_cast<uint8_t>(RECORD_MAGIC & 0xFF), static_cast<uint8_t>(RECORD_MAGIC >> 8),
+        static_cast<uint8_t>(id & 0xFF), static_cast<uint8_t>(id >> 8),
+        static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8),
+        static_cast<uint8_t>(length >> 16), static_cast<uint8_t>(length >> 24)};
+
+    bool written = file.write(header, RECORD_HEADER_SIZE) == RECORD_HEADER_SIZE &&
+                   (length == 0 || file.write(data, length) == length);
+    file.close();
+    if (!written) {
+        Serial.println("ERROR: PresetStore write failed");
+        return false;
+    }
+
+    setEntry(id, fileSize + RECORD_HEADER_SIZE, length);
+    fileSize += RECORD_HEADER_SIZE + length;
+
+    if (fileSize > FILE_HEADER_SIZE + 2 * liveBytes + PRESET_COMPACT_SLACK) {
+        compact();
+    }
+    reopenReader();
+    return true;
+}
+
+// Copy live records to a fresh file and swap it in
+bool PresetStore::compact()
+{
+    String tmpPath = path + ".tmp";
+    if (readHandle) readHandle.close();
+
+    File src = SPIFFS.open(path, FILE_READ);
+    File dst = SPIFFS.open(tmpPath, FILE_WRITE);
+    if (!src || !dst) {
+        Serial.println("ERROR: PresetStore compaction could not open files");
+        return false;
+    }
+
+    uint8_t header[FILE_HEADER_SIZE];
+    src.read(header, FILE_HEADER_SIZE);
+    dst.write(header, FILE_HEADER_SIZE);
+
+    uint8_t chunk[128];
+    bool ok = true;
+    for (const IndexEntry& e : index) {
+        src.seek(e.offset - RECORD_HEADER_SIZE);
+        uint32_t remaining = RECORD_HEADER_SIZE + e.length;
+        while (remaining > 0 && ok) {
+            size_t n = std::min<uint32_t>(remaining, sizeof(chunk));
+            ok = src.read(chunk, n) == n && dst.write(chunk, n) == n;
+            remaining -= n;
+        }
+    }
+    src.close();
+    dst.close();
+
+    if (!ok) {
+        SPIFFS.remove(tmpPath);
+        Serial.println("ERROR: PresetStore compaction failed, keeping old file");
+        return false;
+    }
+
+    SPIFFS.remove(path);
+    SPIFFS.rename(tmpPath, path);
+    rebuildIndex();
+    Serial.printf("PresetStore compacted to %u bytes\n", fileSize);
+    return true;
+}
+
+bool PresetStore::save(uint16_t id, LEDStrip* strip)
+{
+    if (!ready || !strip) return false;
+
+    std::vector<uint8_t> payload;
+    payload.reserve(64 + strip->numPixels() * 3);
+    if (!xSemaphoreTake(strip->stripMutex, pdMS_TO_TICKS(100))) {
+        Serial.println("ERROR: PresetStore could not lock strip for capture");
+        return false;
+    }
+    encodeScene(strip, payload);
+    xSemaphoreGive(strip->stripMutex);
+
+    if (!xSemaphoreTake(storeMutex, portMAX_DELAY)) return false;
+    bool ok = appendRecord(id, payload.data(), payload.size());
+    if (ok) saves++;
+    xSemaphoreGive(storeMutex);
+
+    Serial.printf("Preset %u %s (%u bytes)\n", id, ok ? "saved" : "NOT saved",
+                  static_cast<unsigned>(payload.size()));
+    return ok;
+}
+
+bool PresetStore::recall(uint16_t id, LEDStrip* strip, uint32_t transitionMs, TransitionType type)
+{
+    if (!ready || !strip) return false;
+    uint32_t start = micros();
+
+    if (!xSemaphoreTake(storeMutex, portMAX_DELAY)) return false;
+
+    IndexEntry* entry = find(id);
+    bool ok = entry != nullptr && readHandle;
+    if (ok) {
+        recordBuffer.resize(entry->length);
+        ok = readHandle.seek(entry->offset) &&
+             readHandle.read(recordBuffer.data(), entry->length) == entry->length;
+    }
+    if (ok) {
+        ok = applyScene(recordBuffer.data(), recordBuffer.size(), strip, transitionMs, type);
+    }
+
+    if (ok) {
+        strip->activePreset = id;
+        recalls++;
+        lastRecallUs = micros() - start;
+        maxRecallUs = std::max(maxRecallUs, lastRecallUs);
+    }
+    xSemaphoreGive(storeMutex);
+
+    if (!entry) {
+        Serial.printf("WARNING: Preset %u not found\n", id);
+    } else {
+        Serial.printf("Preset %u recalled in %u us\n", id, lastRecallUs);
+    }
+    return ok;
+}
+
+bool PresetStore::remove(uint16_t id)
+{
+    if (!ready) return false;
+    if (!xSemaphoreTake(storeMutex, portMAX_DELAY)) return false;
+    bool ok = find(id) != nullptr && appendRecord(id, nullptr, 0);
+    xSemaphoreGive(storeMutex);
+    return ok;
+}
+
+bool PresetStore::contains(uint16_t id)
+{
+    if (!xSemaphoreTake(storeMutex, portMAX_DELAY)) return false;
+    bool found = find(id) != nullptr;
+    xSemaphoreGive(storeMutex);
+    return found;
+}
+
+size_t PresetStore::count()
+{
+    if (!xSemaphoreTake(storeMutex, portMAX_DELAY)) return 0;
+    size_t n = index.size();
+    xSemaphoreGive(storeMutex);
+    return n;
+}
+
+void PresetStore::getStats(JsonObject& out)
+{
+    if (!xSemaphoreTake(storeMutex, pdMS_TO_TICKS(50))) return;
+    out["count"] = index.size();
+    out["fileBytes"] = fileSize;
+    out["liveBytes"] = liveBytes;
+    out["saves"] = saves;
+    out["recalls"] = recalls;
+    out["lastRecallUs"] = lastRecallUs;
+    out["maxRecallUs"] = maxRecallUs;
+    JsonArray ids = out.createNestedArray("ids");
+    for (const IndexEntry& e : index) {
+        ids.add(e.id);
+    }
+    xSemaphoreGive(storeMutex);
+}
+
+// Caller holds the strip mutex
+void PresetStore::encodeScene(LEDStrip* strip, std::vector<uint8_t>& out)
+{
+    Writer w{out};
+    const EffectState& fx = strip->effectsManager->state;
+    GradientManager* gradient = strip->gradientManager;
+    Timeline* timeline = strip->timeline;
+
+    // Static scenes only exist as pixels
+    bool storePixels = fx.type == EFFECT_NONE && !gradient->gradientEnabled;
+    bool storeSequence = timeline->isActive() && timeline->getKeyframeCount() > 0;
+
+    bool storeEmitter = fx.emitter.mask != 0;
+    bool storeSeed = fx.seed != 0;
+    bool storeSpatial = !fx.spatial.isDefault();
+
+    w.u8((storePixels ? SCENE_PIXELS : 0) | (storeSequence ? SCENE_SEQUENCE : 0) |
+         (storeEmitter ? SCENE_EMITTER : 0) | (storeSeed ? SCENE_SEED : 0) |
+         (storeSpatial ? SCENE_SPATIAL : 0));
+
+    w.u8(fx.type);
+    w.f32(fx.speed);
+    w.f32(fx.intensity);
+    w.rgb(fx.color1);
+    w.rgb(fx.color2);
+    w.rgb(fx.color3);
+    if (storeEmitter) {
+        w.u8(fx.emitter.mask);
+        w.f32(fx.emitter.rate);
+        w.f32(fx.emitter.life);
+        w.f32(fx.emitter.velocity);
+        w.f32(fx.emitter.spread);
+        w.f32(fx.emitter.gravity);
+        w.f32(fx.emitter.size);
+    }
+    if (storeSeed) {
+        w.u32(fx.seed);
+    }
+    if (storeSpatial) {
+        for (float v : fx.spatial.direction) w.f32(v);
+        for (float v : fx.spatial.center) w.f32(v);
+    }
+    w.u8(strip->neopixel.getBrightness());
+
+    w.u8((gradient->gradientEnabled ? 1 : 0) | (gradient->gradientReverse ? 2 : 0));
+    w.u8(gradient->animation);
+    w.f32(gradient->animationSpeed);
+    uint8_t stopCount = std::min<size_t>(gradient->gradientStops.size(), MAX_PRESET_STOPS);
+    w.u8(stopCount);
+    for (uint8_t i = 0; i < stopCount; i++) {
+        w.f32(gradient->gradientStops[i].position);
+        w.rgb(gradient->gradientStops[i].color);
+    }
+
+    if (storePixels) {
+        uint16_t n = strip->numPixels();
+        w.u16(n);
+        for (uint16_t i = 0; i < n; i++) {
+            w.rgb(strip->getPixelWColor(i));
+        }
+    }
+
+    if (storeSequence) {
+        const std::vector<Keyframe>& keyframes = timeline->getKeyframes();
+        const std::vector<EasingSpec>& curves = timeline->getCurves();
+        w.u8(timeline->isLoopingProgram() ? 1 : 0);
+        w.u32(timeline->loop.maxIterations);
+        w.u16(sizeof(Keyframe));
+        w.u16(keyframes.size());
+        w.u8(curves.size());
+        w.raw(keyframes.data(), keyframes.size() * sizeof(Keyframe));
+        w.raw(curves.data(), curves.size() * sizeof(EasingSpec));
+    }
+}
+
+bool PresetStore::applyScene(const uint8_t* data, uint32_t length, LEDStrip* strip,
+                             uint32_t transitionMs, TransitionType type)
+{
+    Reader r{data, data + length};
+    uint8_t sections = r.u8();
+
+    EffectState target;
+    target.type = static_cast<EffectType>(r.u8());
+    target.speed = r.f32();
+    target.intensity = r.f32();
+    target.color1 = r.rgb();
+    target.color2 = r.rgb();
+    target.color3 = r.rgb();
+    if (sections & SCENE_EMITTER) {
+        target.emitter.mask = r.u8();
+        target.emitter.rate = r.f32();
+        target.emitter.life = r.f32();
+        target.emitter.velocity = r.f32();
+        target.emitter.spread = r.f32();
+        target.emitter.gravity = r.f32();
+        target.emitter.size = r.f32();
+    }
+    if (sections & SCENE_SEED) {
+        target.seed = r.u32();
+    }
+    if (sections & SCENE_SPATIAL) {
+        for (float& v : target.spatial.direction) v = r.f32();
+        for (float& v : target.spatial.center) v = r.f32();
+    }
+    uint8_t brightness = r.u8();
+
+    uint8_t gradientFlags = r.u8();
+    GradientAnimation animation = static_cast<GradientAnimation>(r.u8());
+    float animationSpeed = r.f32();
+    uint8_t stopCount = std::min<uint8_t>(r.u8(), MAX_PRESET_STOPS);
+    GradientStop stops[MAX_PRESET_STOPS];
+    for (uint8_t i = 0; i < stopCount; i++) {
+        stops[i].position = r.f32();
+        stops[i].color = r.rgb();
+    }
+
+    uint16_t pixelCount = 0;
+    const uint8_t* pixels = nullptr;
+    if (sections & SCENE_PIXELS) {
+        pixelCount = r.u16();
+        pixels = r.raw(pixelCount * 3u);
+    }
+    if (!r.ok) {
+        Serial.println("ERROR: Corrupt preset record");
+        return false;
+    }
+
+    // A running sequence would overwrite the recalled scene on its next keyframe
+    strip->timeline->stop();
+
+    if (!xSemaphoreTake(strip->stripMutex, pdMS_TO_TICKS(100))) return false;
+
+    TranstionsManager* transitions = strip->transitionsManager;
+    GradientManager* gradient = strip->gradientManager;
+    bool gradientEnabled = gradientFlags & 1;
+    bool gradientReverse = gradientFlags & 2;
+
+    if (transitionMs > 0 && !pixels) {
+        transitions->beginTransition(strip->now(), transitionMs, type);
+        transitions->setTargetEffect(target);
+        TransitionState& t = transitions->transition;
+        t.targetBrightness = brightness;
+        t.targetGradientEnabled = gradientEnabled;
+        t.targetGradientStops.assign(stops, stops + stopCount);
+        t.targetGradientReverse = gradientReverse;
+    } else {
+        transitions->transition.active = false;
+
+        EffectsManager* effects = strip->effectsManager;
+        bool effectChanged = effects->state.type != target.type;
+        bool seedChanged = effects->state.seed != target.seed;
+        effects->state.copyParams(target);
+        if (effectChanged) {
+            effects->initializeState(effects->state, true);
+        } else if (seedChanged) {
+            EffectRegistry::seed(effects->state);
+        }
+        strip->neopixel.setBrightness(brightness);
+
+        gradient->gradientEnabled = gradientEnabled;
+        gradient->gradientReverse = gradientReverse;
+        gradient->gradientStops.assign(stops, stops + stopCount);
+        gradient->invalidateCache();
+
+        if (pixels) {
+            uint16_t n = std::min<uint16_t>(pixelCount, strip->numPixels());
+            for (uint16_t i = 0; i < n; i++) {
+                strip->safeSetPixelWColor(i, WColor(pixels[i * 3], pixels[i * 3 + 1], pixels[i * 3 + 2]));
+            }
+        }
+    }
+    gradient->animation = animation;
+    gradient->animationSpeed = animationSpeed;
+    gradient->animationStart = strip->now();
+
+    xSemaphoreGive(strip->stripMutex);
+
+    if (sections & SCENE_SEQUENCE) {
+        bool looping = r.u8() != 0;
+        uint32_t maxIterations = r.u32();
+        uint16_t keyframeSize = r.u16();
+        uint16_t keyframeCount = r.u16();
+        uint8_t curveCount = r.u8();
+        const uint8_t* rawKeyframes = r.raw(keyframeCount * static_cast<size_t>(keyframeSize));
+        const uint8_t* rawCurves = r.raw(curveCount * sizeof(EasingSpec));
+
+        if (!r.ok || keyframeSize != sizeof(Keyframe)) {
+            Serial.println("WARNING: Preset sequence from another firmware layout skipped");
+        } else {
+            std::vector<Keyframe> program(keyframeCount);
+            std::vector<EasingSpec> curves(curveCount);
+            memcpy(program.data(), rawKeyframes, keyframeCount * sizeof(Keyframe));
+            memcpy(curves.data(), rawCurves, curveCount * sizeof(EasingSpec));
+            // Stored already expanded, so no ping-pong mirroring here
+            strip->timeline->load(program, curves, looping, maxIterations, false);
+        }
+    }
+
+    if (!strip->isRunning) {
+        strip->startRendering();
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef PRESETSTORE_H
+#define PRESETSTORE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FS.h>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "utils.h"
+
+class LEDStrip;
+
+#define PRESET_FILE_VERSION 1
+#define MAX_PRESET_STOPS 16
+#define PRESET_COMPACT_SLACK 4096
+
+/**
+ * @brief Binary scene presets on SPIFFS, recalled by numeric id
+ *
+ * Every preset is one record appended to a single file: the resolved effect,
+ * colors, brightness, gradient, the raw pixels of static scenes and the
+ * compiled keyframes of a running sequence. An index kept sorted in RAM maps
+ * ids to file offsets, so a recall is one seek + read of a few hundred bytes
+ * and a decode into the live state, without any JSON. Overwritten and
+ * deleted records are reclaimed by rewriting the file once the dead space
+ * outgrows the live data.
+ */
+class PresetStore {
+public:
+    static PresetStore& getInstance();
+
+    bool begin(const char* path = "/presets.bin");
+
+    bool save(uint16_t id, LEDStrip* strip);
+    bool recall(uint16_t id, LEDStrip* strip, uint32_t transitionMs = 0,
+                TransitionType type = TRANSITION_EASE_IN_OUT);
+    bool remove(uint16_t id);
+    bool contains(uint16_t id);
+    size_t count();
+    void getStats(JsonObject& out);
+
+    // Scene codec, shared with SceneJournal. encodeScene needs the strip mutex held.
+    static void encodeScene(LEDStrip* strip, std::vector<uint8_t>& out);
+    static bool applyScene(const uint8_t* data, uint32_t length, LEDStrip* strip,
+                           uint32_t transitionMs, TransitionType type);
+
+private:
+    PresetStore();
+    PresetStore(const PresetStore&) = delete;
+    PresetStore& operator=(const PresetStore&) = delete;
+
+    struct IndexEntry {
+        uint16_t id;
+        uint32_t offset;   ///< Payload offset in the file
+        uint32_t length;   ///< Payload length
+    };
+
+    String path;
+    bool ready;
+    SemaphoreHandle_t storeMutex;
+    File readHandle;                      ///< Kept open so a recall does not pay for open()
+    std::vector<IndexEntry> index;        ///< Sorted by id
+    std::vector<uint8_t> recordBuffer;    ///< Reused for every recall
+    uint32_t fileSize;
+    uint32_t liveBytes;
+
+    // Stats
+    uint32_t saves;
+    uint32_t recalls;
+    uint32_t lastRecallUs;
+    uint32_t maxRecallUs;
+
+    bool rebuildIndex();
+    bool appendRecord(uint16_t id, const uint8_t* data, uint32_t length);
+    bool compact();
+    void reopenReader();
+    IndexEntry* find(uint16_t id);
+    void setEntry(uint16_t id, uint32_t offset, uint32_t length);
+};
+
+#endif // PRESETSTORE_H
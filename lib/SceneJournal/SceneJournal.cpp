@@ -0,0 +1,246 @@
+#include "SceneJournal.h"
+#include <SPIFFS.h>
+#include <algorithm>
+#include <LEDStrip.h>
+#include <TranstionsManager.h>
+#include <Timeline.h>
+#include <PresetStore.h>
+#include <ConfigStore.h>
+#include <HeapStats.h>
+
+static const uint32_t SLOT_MAGIC = 0x4E4A5357; // "WSJN"
+static const uint32_t MAX_SCENE_PAYLOAD = 16384;
+
+std::vector<SceneJournal*> SceneJournal::journals;
+SemaphoreHandle_t SceneJournal::registryMutex = nullptr;
+TaskHandle_t SceneJournal::flushTaskHandle = nullptr;
+
+SceneJournal::SceneJournal(LEDStrip* strip, const String& uid)
+    : strip(strip),
+      uid(uid),
+      changeCount(0),
+      firstChangeMs(0),
+      lastChangeMs(0),
+      writtenCount(0),
+      sequence(0),
+      newestSlot(-1),
+      lastCrc(0),
+      writes(0),
+      unchangedSkips(0),
+      invalidSlots(0),
+      restoreUs(0)
+{
+    memset(slotWrites, 0, sizeof(slotWrites));
+
+    if (!registryMutex) {
+        registryMutex = xSemaphoreCreateMutex();
+    }
+    if (xSemaphoreTake(registryMutex, portMAX_DELAY)) {
+        journals.push_back(this);
+        xSemaphoreGive(registryMutex);
+    }
+    if (!flushTaskHandle) {
+        xTaskCreatePinnedToCore(flushTask, "SceneJrnl", 4096, nullptr, 1, &flushTaskHandle, 0);
+    }
+}
+
+SceneJournal::~SceneJournal()
+{
+    if (xSemaphoreTake(registryMutex, portMAX_DELAY)) {
+        journals.erase(std::remove(journals.begin(), journals.end(), this), journals.end());
+        xSemaphoreGive(registryMutex);
+    }
+}
+
+String SceneJournal::slotPath(int slot) const
+{
+    return "/scene_" + uid + "." + String(slot);
+}
+
+uint32_t SceneJournal::crc32(const uint8_t* data, size_t length, uint32_t crc)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+// A slot is valid only if the header and the whole payload made it to flash
+bool SceneJournal::readSlot(int slot, SlotHeader& header, std::vector<uint8_t>* payload)
+{
+    File file = SPIFFS.open(slotPath(slot), FILE_READ);
+    if (!file) return false;
+
+    bool valid = file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+                 header.magic == SLOT_MAGIC &&
+                 header.version == SCENE_JOURNAL_VERSION &&
+                 header.length >= 4 && header.length <= MAX_SCENE_PAYLOAD &&
+                 file.size() >= sizeof(header) + header.length;
+
+    if (valid) {
+        std::vector<uint8_t> scratch;
+        std::vector<uint8_t>& buffer = payload ? *payload : scratch;
+        buffer.resize(header.length);
+        valid = file.read(buffer.data(), header.length) == header.length &&
+                crc32(buffer.data(), header.length) == header.crc;
+    }
+    file.close();
+
+    if (!valid) invalidSlots++;
+    return valid;
+}
+
+bool SceneJournal::writeSlot(int slot, const std::vector<uint8_t>& payload, uint32_t crc)
+{
+    File file = SPIFFS.open(slotPath(slot), FILE_WRITE);
+    if (!file) return false;
+
+    SlotHeader header = {};
+    header.magic = SLOT_MAGIC;
+    header.version = SCENE_JOURNAL_VERSION;
+    header.sequence = sequence + 1;
+    header.length = payload.size();
+    header.crc = crc;
+
+    bool ok = file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+              file.write(payload.data(), payload.size()) == payload.size();
+    file.close();
+    return ok;
+}
+
+bool SceneJournal::restore()
+{
+    if (!ConfigStore::getInstance().mount()) return false;
+    uint32_t start = micros();
+
+    // Headers first, then only the newest valid payload is applied
+    int best = -1;
+    uint32_t bestSequence = 0;
+    SlotHeader header;
+    for (int slot = 0; slot < SCENE_JOURNAL_SLOTS; slot++) {
+        if (readSlot(slot, header, nullptr) && (best < 0 || header.sequence > bestSequence)) {
+            best = slot;
+            bestSequence = header.sequence;
+        }
+    }
+    if (best < 0) {
+        Serial.printf("SceneJournal %s: nothing to restore\n", uid.c_str());
+        return false;
+    }
+
+    std::vector<uint8_t> payload;
+    if (!readSlot(best, header, &payload)) return false;
+
+    newestSlot = best;
+    sequence = header.sequence;
+    lastCrc = header.crc;
+
+    int32_t preset;
+    memcpy(&preset, payload.data(), sizeof(preset));
+    bool ok = PresetStore::applyScene(payload.data() + 4, payload.size() - 4, strip, 0, TRANSITION_LINEAR);
+    if (ok) {
+        strip->activePreset = preset;
+    }
+
+    restoreUs = micros() - start;
+    Serial.printf("SceneJournal %s: restored slot %d (seq %u) in %u us\n",
+                  uid.c_str(), best, sequence, restoreUs);
+    return ok;
+}
+
+void SceneJournal::touch()
+{
+    uint32_t now = millis();
+    if (changeCount == writtenCount) {
+        firstChangeMs = now;
+    }
+    lastChangeMs = now;
+    changeCount++;
+}
+
+bool SceneJournal::due(uint32_t now) const
+{
+    if (changeCount == writtenCount) return false;
+    return now - lastChangeMs >= QUIET_MS || now - firstChangeMs >= MAX_DELAY_MS;
+}
+
+bool SceneJournal::flush()
+{
+    uint32_t pending = changeCount;
+    if (pending == writtenCount) return true;
+
+    std::vector<uint8_t> payload;
+    payload.reserve(64 + strip->numPixels() * 3);
+    int32_t preset = strip->activePreset;
+    payload.resize(4);
+    memcpy(payload.data(), &preset, sizeof(preset));
+
+    if (!xSemaphoreTake(strip->stripMutex, pdMS_TO_TICKS(100))) return false;
+    // Wait for a transition to land, so the journal holds the final scene. A
+    // running sequence is stored as its keyframes, and its transitions chain
+    // into each other, so it is written whatever frame it is on
+    if (strip->transitionsManager->transition.active && !strip->timeline->isActive()) {
+        xSemaphoreGive(strip->stripMutex);
+        return false;
+    }
+    PresetStore::encodeScene(strip, payload);
+    xSemaphoreGive(strip->stripMutex);
+
+    uint32_t crc = crc32(payload.data(), payload.size());
+    if (newestSlot >= 0 && crc == lastCrc) {
+        // Back to the scene already on flash
+        unchangedSkips++;
+        writtenCount = pending;
+        return true;
+    }
+
+    // Never overwrite the newest valid slot
+    int slot = (newestSlot + 1) % SCENE_JOURNAL_SLOTS;
+    if (!writeSlot(slot, payload, crc)) {
+        Serial.printf("ERROR: SceneJournal %s could not write slot %d\n", uid.c_str(), slot);
+        return false;
+    }
+
+    newestSlot = slot;
+    sequence++;
+    lastCrc = crc;
+    writtenCount = pending;
+    writes++;
+    slotWrites[slot]++;
+    return true;
+}
+
+void SceneJournal::getStats(JsonObject& out)
+{
+    out["sequence"] = sequence;
+    out["slot"] = newestSlot;
+    out["pending"] = changeCount != writtenCount;
+    out["writes"] = writes;
+    out["unchangedSkips"] = unchangedSkips;
+    out["invalidSlots"] = invalidSlots;
+    out["restoreUs"] = restoreUs;
+    JsonArray perSlot = out.createNestedArray("slotWrites");
+    for (int slot = 0; slot < SCENE_JOURNAL_SLOTS; slot++) {
+        perSlot.add(slotWrites[slot]);
+    }
+}
+
+void SceneJournal::flushTask(void*)
+{
+    HeapStats::tagTask(ALLOC_JOURNAL);
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(250));
+        uint32_t now = millis();
+        if (!xSemaphoreTake(registryMutex, portMAX_DELAY)) continue;
+        for (SceneJournal* journal : journals) {
+            if (journal->due(now)) {
+                journal->flush();
+            }
+        }
+        xSemaphoreGive(registryMutex);
+    }
+}
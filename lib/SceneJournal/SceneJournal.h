@@ -0,0 +1,87 @@
+#ifndef SCENEJOURNAL_H
+#define SCENEJOURNAL_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+class LEDStrip;
+
+#define SCENE_JOURNAL_VERSION 1
+#define SCENE_JOURNAL_SLOTS 4
+
+/**
+ * @brief Last scene of a strip, persisted so it survives a power cycle
+ *
+ * Commands only mark the journal dirty. A shared background task writes the
+ * scene once the strip has been quiet for QUIET_MS (or at the latest
+ * MAX_DELAY_MS after the first change), and skips writes whose payload did
+ * not change. Records rotate over SCENE_JOURNAL_SLOTS files, so consecutive
+ * writes land on different files and a torn write can only damage a slot
+ * older than the newest valid one. Each slot carries a sequence number and
+ * a CRC32; restore() picks the valid slot with the highest sequence.
+ *
+ * Slot layout, little endian: magic u32, version u8, reserved u8[3],
+ * sequence u32, length u32, crc32 u32, then the payload:
+ * active preset i32 followed by a PresetStore scene.
+ */
+class SceneJournal {
+public:
+    SceneJournal(LEDStrip* strip, const String& uid);
+    ~SceneJournal();
+
+    bool restore();
+    void touch();
+    bool flush();
+    void getStats(JsonObject& out);
+
+    static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+    static constexpr uint32_t QUIET_MS = 2000;
+    static constexpr uint32_t MAX_DELAY_MS = 30000;
+
+private:
+    struct SlotHeader {
+        uint32_t magic;
+        uint8_t version;
+        uint8_t reserved[3];
+        uint32_t sequence;
+        uint32_t length;
+        uint32_t crc;
+    };
+
+    LEDStrip* strip;
+    String uid;
+
+    // Written by command tasks, read by the flush task
+    volatile uint32_t changeCount;
+    volatile uint32_t firstChangeMs;
+    volatile uint32_t lastChangeMs;
+    uint32_t writtenCount;
+
+    uint32_t sequence;       ///< Sequence of the newest valid slot
+    int newestSlot;          ///< -1 when the journal is empty
+    uint32_t lastCrc;
+
+    // Stats
+    uint32_t writes;
+    uint32_t unchangedSkips;
+    uint32_t invalidSlots;   ///< Torn or corrupt slots seen by restore()
+    uint32_t slotWrites[SCENE_JOURNAL_SLOTS];
+    uint32_t restoreUs;
+
+    String slotPath(int slot) const;
+    bool readSlot(int slot, SlotHeader& header, std::vector<uint8_t>* payload);
+    bool writeSlot(int slot, const std::vector<uint8_t>& payload, uint32_t crc);
+    bool due(uint32_t now) const;
+
+    static std::vector<SceneJournal*> journals;
+    static SemaphoreHandle_t registryMutex;
+    static TaskHandle_t flushTaskHandle;
+    static void flushTask(void* parameter);
+};
+
+#endif // SCENEJOURNAL_H
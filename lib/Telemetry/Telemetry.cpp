@@ -0,0 +1,192 @@
+#include "Telemetry.h"
+#include <WiFi.h>
+
+static_assert(sizeof(TelemetryEvent) == 10, "TelemetryEvent is a wire format");
+static_assert(sizeof(TelemetryFrameHeader) == 16, "TelemetryFrameHeader is a wire format");
+
+Telemetry& Telemetry::getInstance()
+{
+    static Telemetry instance;
+    return instance;
+}
+
+Telemetry::Telemetry()
+    : active(0),
+      sealed(false),
+      lock(nullptr),
+      sourceCount(0),
+      sequence(0),
+      dropped(0),
+      lastStatsMs(0),
+      eventsRecorded(0),
+      eventsDropped(0),
+      framesSent(0),
+      bytesSent(0)
+{
+    frames[0].length = 0;
+    frames[1].length = 0;
+    lock = xSemaphoreCreateMutex();
+}
+
+uint8_t Telemetry::registerSource(const String& name)
+{
+    uint8_t id = TELEMETRY_NO_SOURCE;
+    if (!xSemaphoreTake(lock, portMAX_DELAY)) return id;
+    for (uint8_t i = 0; i < sourceCount; i++) {
+        if (sources[i] == name) {
+            id = i;
+            break;
+        }
+    }
+    bool added = false;
+    if (id == TELEMETRY_NO_SOURCE && sourceCount < TELEMETRY_MAX_SOURCES) {
+        id = sourceCount++;
+        sources[id] = name;
+        added = true;
+    }
+    xSemaphoreGive(lock);
+
+    if (added) {
+        append(TELEMETRY_SOURCE, id, name.length(), 0,
+               reinterpret_cast<const uint8_t*>(name.c_str()), name.length());
+    }
+    return id;
+}
+
+// Ids are only meaningful to a receiver that saw the names, so they are
+// sent again on every (re)connection
+void Telemetry::announceSources()
+{
+    for (uint8_t i = 0; i < sourceCount; i++) {
+        append(TELEMETRY_SOURCE, i, sources[i].length(), 0,
+               reinterpret_cast<const uint8_t*>(sources[i].c_str()), sources[i].length());
+    }
+}
+
+void Telemetry::record(TelemetryEventType type, uint8_t source, uint16_t code, int32_t value)
+{
+    append(type, source, code, value, nullptr, 0);
+}
+
+bool Telemetry::append(uint8_t type, uint8_t source, uint16_t code, int32_t value,
+                       const uint8_t* extra, size_t extraLength)
+{
+    size_t need = sizeof(TelemetryEvent) + extraLength;
+    if (need > TELEMETRY_FRAME_SIZE - sizeof(TelemetryFrameHeader)) return false;
+
+    // Never block the caller for long, an input or render task may be recording
+    if (!xSemaphoreTake(lock, pdMS_TO_TICKS(5))) {
+        eventsDropped++;
+        return false;
+    }
+
+    uint32_t now = millis();
+    Frame* frame = &frames[active];
+    if (frame->length > 0 && frame->length + need > TELEMETRY_FRAME_SIZE) {
+        if (sealed) {
+            // Both buffers full until the network loop catches up
+            dropped++;
+            eventsDropped++;
+            xSemaphoreGive(lock);
+            return false;
+        }
+        sealed = true;
+        active ^= 1;
+        frame = &frames[active];
+        frame->length = 0;
+    }
+    if (frame->length == 0) {
+        frame->length = sizeof(TelemetryFrameHeader);
+        frame->count = 0;
+        frame->baseMs = now;
+    }
+
+    TelemetryEvent event;
+    event.type = type;
+    event.source = source;
+    event.dtMs = static_cast<uint16_t>(std::min<uint32_t>(now - frame->baseMs, 0xFFFF));
+    event.code = code;
+    event.value = value;
+    memcpy(frame->data + frame->length, &event, sizeof(event));
+    frame->length += sizeof(event);
+    if (extraLength) {
+        memcpy(frame->data + frame->length, extra, extraLength);
+        frame->length += extraLength;
+    }
+    frame->count++;
+    eventsRecorded++;
+
+    xSemaphoreGive(lock);
+    return true;
+}
+
+void Telemetry::sampleStats()
+{
+    record(TELEMETRY_STAT, TELEMETRY_NO_SOURCE, TELEMETRY_STAT_FREE_HEAP, ESP.getFreeHeap());
+    record(TELEMETRY_STAT, TELEMETRY_NO_SOURCE, TELEMETRY_STAT_MIN_FREE_HEAP, ESP.getMinFreeHeap());
+    record(TELEMETRY_STAT, TELEMETRY_NO_SOURCE, TELEMETRY_STAT_LARGEST_BLOCK, ESP.getMaxAllocHeap());
+    record(TELEMETRY_STAT, TELEMETRY_NO_SOURCE, TELEMETRY_STAT_UPTIME_S, millis() / 1000);
+    if (WiFi.status() == WL_CONNECTED) {
+        record(TELEMETRY_STAT, TELEMETRY_NO_SOURCE, TELEMETRY_STAT_RSSI, WiFi.RSSI());
+    }
+}
+
+// Network loop only: the frame is sent without holding the lock
+void Telemetry::poll(uint32_t now, std::function<bool(const uint8_t*, size_t)> send)
+{
+    if (now - lastStatsMs >= statsIntervalMs) {
+        lastStatsMs = now;
+        sampleStats();
+    }
+
+    if (!xSemaphoreTake(lock, pdMS_TO_TICKS(5))) return;
+    Frame& current = frames[active];
+    if (!sealed && current.length > 0 && now - current.baseMs >= flushIntervalMs) {
+        sealed = true;
+        active ^= 1;
+        frames[active].length = 0;
+    }
+    if (!sealed) {
+        xSemaphoreGive(lock);
+        return;
+    }
+    Frame& frame = frames[active ^ 1];
+    uint16_t lost = dropped;
+    xSemaphoreGive(lock);
+
+    TelemetryFrameHeader header;
+    header.magic[0] = 'W';
+    header.magic[1] = 'T';
+    header.version = TELEMETRY_VERSION;
+    header.flags = 0;
+    header.sequence = sequence;
+    header.baseMs = frame.baseMs;
+    header.count = frame.count;
+    header.dropped = lost;
+    memcpy(frame.data, &header, sizeof(header));
+
+    // Kept sealed on failure and retried on the next poll
+    if (!send(frame.data, frame.length)) return;
+
+    framesSent++;
+    bytesSent += frame.length;
+    sequence++;
+
+    if (xSemaphoreTake(lock, portMAX_DELAY)) {
+        dropped -= lost;
+        frame.length = 0;
+        sealed = false;
+        xSemaphoreGive(lock);
+    }
+}
+
+void Telemetry::getStats(JsonObject& out)
+{
+    out["sources"] = sourceCount;
+    out["events"] = eventsRecorded;
+    out["dropped"] = eventsDropped;
+    out["frames"] = framesSent;
+    out["bytes"] = bytesSent;
+    out["sequence"] = sequence;
+    out["bytesPerEvent"] = eventsRecorded ? static_cast<float>(bytesSent) / eventsRecorded : 0.0f;
+}
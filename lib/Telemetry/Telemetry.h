@@ -0,0 +1,122 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <functional>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_FRAME_SIZE 512
+#define TELEMETRY_MAX_SOURCES 32
+#define TELEMETRY_NO_SOURCE 0xFF
+
+enum TelemetryEventType : uint8_t {
+    TELEMETRY_SOURCE = 1,        ///< code = name length, followed by the name bytes
+    TELEMETRY_INPUT_CHANGE = 2,  ///< value = debounced state
+    TELEMETRY_GESTURE = 3,       ///< code = InputGesture
+    TELEMETRY_SCENE = 4,         ///< code = EffectType, value = brightness | activePreset << 8
+    TELEMETRY_ERROR = 5,         ///< code = TelemetryError
+    TELEMETRY_STAT = 6           ///< code = TelemetryStat, value = sample
+};
+
+enum TelemetryError : uint16_t {
+    TELEMETRY_ERR_QUEUE_REJECTED = 1,
+    TELEMETRY_ERR_COMMAND_STALE = 2,
+    TELEMETRY_ERR_PARSE = 3,
+    TELEMETRY_ERR_LOW_MEMORY = 4   ///< value = largest free block, transition cut short
+};
+
+enum TelemetryStat : uint16_t {
+    TELEMETRY_STAT_FREE_HEAP = 1,
+    TELEMETRY_STAT_MIN_FREE_HEAP = 2,
+    TELEMETRY_STAT_UPTIME_S = 3,
+    TELEMETRY_STAT_RSSI = 4,
+    TELEMETRY_STAT_LARGEST_BLOCK = 5
+};
+
+/**
+ * @brief Wire layout of one event, little endian, 10 bytes
+ */
+struct __attribute__((packed)) TelemetryEvent {
+    uint8_t type;
+    uint8_t source;       ///< Id announced by a TELEMETRY_SOURCE event
+    uint16_t dtMs;        ///< Offset from the frame base time
+    uint16_t code;
+    int32_t value;
+};
+
+/**
+ * @brief Wire layout of the frame header, little endian, 16 bytes
+ */
+struct __attribute__((packed)) TelemetryFrameHeader {
+    uint8_t magic[2];     ///< "WT"
+    uint8_t version;
+    uint8_t flags;
+    uint32_t sequence;    ///< +1 per frame sent, gaps mean lost frames
+    uint32_t baseMs;      ///< millis() of the first event
+    uint16_t count;
+    uint16_t dropped;     ///< Events lost on the device since the previous frame
+};
+
+/**
+ * @brief Batched binary event uplink
+ *
+ * Events from any task are appended to a preallocated frame. The network
+ * loop calls poll(), which sends the frame as one binary WebSocket message
+ * once it is full or flushIntervalMs after its first event. A second
+ * buffer takes new events while a full frame waits for the network loop;
+ * events that find both buffers full are counted in the next header.
+ */
+class Telemetry {
+public:
+    static Telemetry& getInstance();
+
+    uint8_t registerSource(const String& name);
+    void announceSources();
+
+    void record(TelemetryEventType type, uint8_t source, uint16_t code, int32_t value);
+    void poll(uint32_t now, std::function<bool(const uint8_t*, size_t)> send);
+
+    void getStats(JsonObject& out);
+
+    uint32_t flushIntervalMs = 1000;
+    uint32_t statsIntervalMs = 10000;
+
+private:
+    Telemetry();
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    struct Frame {
+        uint8_t data[TELEMETRY_FRAME_SIZE];
+        size_t length;    ///< 0 when empty, header included otherwise
+        uint16_t count;
+        uint32_t baseMs;
+    };
+
+    Frame frames[2];
+    uint8_t active;       ///< Frame receiving events
+    bool sealed;          ///< The other frame is full and waiting to be sent
+    SemaphoreHandle_t lock;
+
+    String sources[TELEMETRY_MAX_SOURCES];
+    uint8_t sourceCount;
+
+    uint32_t sequence;
+    uint16_t dropped;
+    uint32_t lastStatsMs;
+
+    // Stats
+    uint32_t eventsRecorded;
+    uint32_t eventsDropped;
+    uint32_t framesSent;
+    uint32_t bytesSent;
+
+    bool append(uint8_t type, uint8_t source, uint16_t code, int32_t value,
+                const uint8_t* extra, size_t extraLength);
+    void sampleStats();
+};
+
+#endif // TELEMETRY_H
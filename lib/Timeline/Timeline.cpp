@@ -0,0 +1,257 @@
+#include "Timeline.h"
+#include <LEDStrip.h>
+#include <TranstionsManager.h>
+#include <EffectsManager.h>
+#include <EffectRegistry.h>
+
+Timeline::Timeline(LEDStrip* strip)
+    : strip(strip),
+      cycleLength(0),
+      looping(false),
+      next(0),
+      lastFired(-1)
+{
+    loop.isActive = false;
+    loop.currentIteration = 0;
+    loop.maxIterations = 0;
+    loop.loopStartTime = 0;
+    loop.shouldBreak = false;
+}
+
+void Timeline::load(std::vector<Keyframe>& program, std::vector<EasingSpec>& programCurves,
+                    bool looping, uint32_t maxIterations, bool pingPong)
+{
+    if (program.empty()) {
+        stop();
+        return;
+    }
+
+    if (pingPong) {
+        mirror(program);
+    }
+
+    // Absolute offsets from the per step spans
+    uint32_t offset = 0;
+    for (Keyframe& kf : program) {
+        kf.start = offset;
+        offset += kf.span();
+    }
+
+    if (looping && offset < MIN_TIMELINE_CYCLE_MS) {
+        Serial.printf("WARNING: Sequence cycle of %u ms is too short to loop, padded to %u ms\n",
+                      offset, MIN_TIMELINE_CYCLE_MS);
+        offset = MIN_TIMELINE_CYCLE_MS;
+    }
+
+    if (xSemaphoreTake(strip->stripMutex, portMAX_DELAY)) {
+        // The previous program is handed back to the caller and freed outside the lock
+        keyframes.swap(program);
+        curves.swap(programCurves);
+        cycleLength = offset;
+        this->looping = looping;
+        next = 0;
+        lastFired = -1;
+
+        loop.isActive = true;
+        loop.currentIteration = 0;
+        loop.maxIterations = maxIterations;
+        loop.loopStartTime = strip->now();
+        loop.shouldBreak = false;
+        strip->isLooping = looping;
+
+        xSemaphoreGive(strip->stripMutex);
+    }
+
+    Serial.printf("Timeline loaded: %u keyframes, cycle %u ms, loop %s\n",
+                  static_cast<unsigned>(keyframes.size()), cycleLength,
+                  looping ? (maxIterations ? "finite" : "infinite") : "off");
+
+    if (!strip->isRunning) {
+        strip->startRendering();
+    }
+}
+
+void Timeline::stop()
+{
+    if (xSemaphoreTake(strip->stripMutex, portMAX_DELAY)) {
+        loop.isActive = false;
+        strip->isLooping = false;
+        lastFired = -1;
+        xSemaphoreGive(strip->stripMutex);
+    }
+}
+
+void Timeline::seek(uint32_t positionMs)
+{
+    if (xSemaphoreTake(strip->stripMutex, portMAX_DELAY)) {
+        if (!keyframes.empty() && cycleLength > 0) {
+            positionMs = looping ? positionMs % cycleLength : std::min(positionMs, cycleLength);
+
+            // Replay the cycle up to the new position on the next frame;
+            // the keyframe spanning it gets a backdated, part way transition
+            strip->transitionsManager->finishTransition();
+            loop.isActive = true;
+            loop.loopStartTime = strip->now() - positionMs;
+            next = 0;
+            lastFired = -1;
+        }
+        xSemaphoreGive(strip->stripMutex);
+    }
+}
+
+void Timeline::requestBreak()
+{
+    if (xSemaphoreTake(strip->stripMutex, portMAX_DELAY)) {
+        loop.shouldBreak = true;
+        xSemaphoreGive(strip->stripMutex);
+    }
+}
+
+uint32_t Timeline::getPosition(uint32_t now) const
+{
+    return loop.isActive ? now - loop.loopStartTime : 0;
+}
+
+void Timeline::advance(uint32_t now)
+{
+    if (!loop.isActive || keyframes.empty()) {
+        return;
+    }
+
+    uint32_t elapsed = now - loop.loopStartTime;
+    while (true) {
+        while (next < keyframes.size() && elapsed >= keyframes[next].start) {
+            // Scheduled time, not now: lateness never carries into later steps
+            fire(next, loop.loopStartTime + keyframes[next].start);
+            next++;
+        }
+
+        if (next < keyframes.size() || elapsed < cycleLength) {
+            return;
+        }
+
+        // Cycle complete. A one-shot ends here, even one whose steps all sit
+        // at offset 0 and so span no time at all.
+        if (!looping || cycleLength == 0) {
+            loop.currentIteration++;
+            loop.isActive = false;
+            strip->isLooping = false;
+            return;
+        }
+
+        // Whole cycles missed (e.g. a stalled task) are skipped
+        uint32_t cycles = elapsed / cycleLength;
+        loop.currentIteration += cycles;
+        if (loop.shouldBreak || (loop.maxIterations > 0 && loop.currentIteration >= loop.maxIterations)) {
+            loop.isActive = false;
+            strip->isLooping = false;
+            return;
+        }
+
+        loop.loopStartTime += cycles * cycleLength;
+        elapsed -= cycles * cycleLength;
+        next = 0;
+    }
+}
+
+void Timeline::fire(size_t index, uint32_t startTime)
+{
+    const Keyframe& kf = keyframes[index];
+    TranstionsManager* transitions = strip->transitionsManager;
+
+    // Land the previous step on its target before capturing the new source
+    settle();
+
+    transitions->beginTransition(startTime, kf.duration, kf.easing);
+    if (kf.curve >= 0 && static_cast<size_t>(kf.curve) < curves.size()) {
+        transitions->customEasing = curves[kf.curve];
+    }
+
+    TransitionState& t = transitions->transition;
+    if (kf.flags & Keyframe::FILL) {
+        t.targetEffect = EFFECT_NONE;
+        t.targetColor1 = kf.fillColor;
+        t.targetColor2 = kf.fillColor;
+        t.targetColor3 = kf.fillColor;
+    }
+
+    if (kf.flags & Keyframe::EFFECT_ANY) {
+        EffectState target;
+        target.copyParams(strip->effectsManager->state);
+        if (kf.flags & Keyframe::EFFECT_TYPE) target.type = kf.effectType;
+        if (kf.flags & Keyframe::EFFECT_SPEED) target.speed = kf.speed;
+        if (kf.flags & Keyframe::EFFECT_INTENSITY) target.intensity = kf.intensity;
+        if (kf.flags & Keyframe::EFFECT_COLORS) {
+            target.color1 = kf.color1;
+            target.color2 = kf.color2;
+            target.color3 = kf.color3;
+        }
+        if (kf.flags & Keyframe::EFFECT_EMITTER) {
+            if (kf.flags & Keyframe::EFFECT_TYPE) {
+                target.emitter = kf.emitter;
+            } else {
+                uint8_t mask = target.emitter.mask | kf.emitter.mask;
+                target.emitter = kf.emitter.resolve(target.emitter);
+                target.emitter.mask = mask;
+            }
+        }
+        if (kf.flags & Keyframe::EFFECT_SPATIAL) target.spatial = kf.spatial;
+        if (kf.flags & Keyframe::EFFECT_SEED) target.seed = kf.seed;
+        EffectRegistry::clampParams(target);
+        transitions->setTargetEffect(target);
+    }
+
+    if (kf.flags & Keyframe::GRADIENT_STOPS) {
+        t.targetGradientStops.assign(kf.stops, kf.stops + kf.stopCount);
+        t.targetGradientEnabled = true;
+    }
+    if (kf.flags & Keyframe::GRADIENT_REVERSE) {
+        t.targetGradientReverse = kf.gradientReverse;
+    }
+    if (kf.flags & Keyframe::GRADIENT_ENABLED) {
+        t.targetGradientEnabled = kf.gradientEnabled;
+    }
+
+    lastFired = static_cast<int>(index);
+    if (kf.duration == 0) {
+        settle();
+    }
+}
+
+void Timeline::settle()
+{
+    if (lastFired < 0) {
+        return;
+    }
+
+    const Keyframe& kf = keyframes[lastFired];
+    lastFired = -1;
+
+    bool wasRunning = strip->transitionsManager->transition.active;
+    strip->transitionsManager->finishTransition();
+
+    // A cut-short fill never drew its final frame
+    if (wasRunning && (kf.flags & Keyframe::FILL) && !(kf.flags & Keyframe::EFFECT_ANY)) {
+        paintFill(kf.fillColor);
+    }
+}
+
+void Timeline::paintFill(const WColor& color)
+{
+    for (uint16_t i = 0; i < strip->numPixels(); i++) {
+        strip->safeSetPixelWColor(i, color);
+    }
+}
+
+// Ping-pong: play the steps forward, then back down without repeating the ends
+void Timeline::mirror(std::vector<Keyframe>& program)
+{
+    if (program.size() < 3) {
+        return;
+    }
+    size_t forward = program.size();
+    program.reserve(forward * 2 - 2);
+    for (size_t i = forward - 2; i >= 1; i--) {
+        program.push_back(program[i]);
+    }
+}
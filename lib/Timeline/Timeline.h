@@ -0,0 +1,122 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <Arduino.h>
+#include <vector>
+#include <algorithm>
+#include <wcolor.h>
+#include <ArduinoJson.h>
+#include <EasingCurve.h>
+#include "utils.h"
+
+class LEDStrip;
+
+#define MAX_KEYFRAME_STOPS 8
+#define MAX_KEYFRAMES 64
+#define MIN_TIMELINE_CYCLE_MS 16
+
+/**
+ * @brief One compiled sequence step
+ *
+ * Everything the step changes is resolved at compile time, so playback never
+ * touches JSON. Fields not flagged keep whatever the strip shows when the
+ * keyframe fires.
+ */
+struct Keyframe {
+    enum Flags : uint16_t {
+        FILL             = 1 << 0,
+        EFFECT_TYPE      = 1 << 1,
+        EFFECT_SPEED     = 1 << 2,
+        EFFECT_INTENSITY = 1 << 3,
+        EFFECT_COLORS    = 1 << 4,
+        GRADIENT_STOPS   = 1 << 5,
+        GRADIENT_REVERSE = 1 << 6,
+        GRADIENT_ENABLED = 1 << 7,
+        EFFECT_EMITTER   = 1 << 8,
+        EFFECT_SEED      = 1 << 9,
+        EFFECT_SPATIAL   = 1 << 10,
+        EFFECT_ANY       = EFFECT_TYPE | EFFECT_SPEED | EFFECT_INTENSITY | EFFECT_COLORS |
+                           EFFECT_EMITTER | EFFECT_SEED | EFFECT_SPATIAL
+    };
+
+    uint32_t start;          ///< Offset from the start of the cycle, ms
+    uint32_t duration;       ///< Transition duration, ms
+    uint32_t hold;           ///< Dwell after the transition before the next step, ms
+    TransitionType easing;
+    int8_t curve;            ///< Index into the timeline curve pool, -1 for built-in easings
+    uint16_t flags;
+
+    WColor fillColor;
+
+    EffectType effectType;
+    float speed;
+    float intensity;
+    WColor color1, color2, color3;
+    EmitterConfig emitter;   ///< Overrides only; with EFFECT_TYPE they replace the current ones
+    SpatialConfig spatial;
+    uint32_t seed;
+
+    bool gradientEnabled;
+    bool gradientReverse;
+    uint8_t stopCount;
+    GradientStop stops[MAX_KEYFRAME_STOPS];
+
+    Keyframe() : start(0), duration(0), hold(0), easing(TRANSITION_LINEAR), curve(-1), flags(0),
+                 fillColor(WColor::BLACK), effectType(EFFECT_NONE), speed(1.0f), intensity(1.0f),
+                 color1(WColor::WHITE), color2(WColor::BLACK), color3(WColor::BLACK), seed(0),
+                 gradientEnabled(false), gradientReverse(false), stopCount(0) {}
+
+    uint32_t span() const { return duration + hold; }
+};
+
+/**
+ * @brief Flat keyframe player driven by the render task
+ *
+ * A sequence is compiled once into keyframes with absolute offsets. The
+ * render task calls advance() every frame; it fires every keyframe whose
+ * offset has passed, backdating its transition to the scheduled time so
+ * late frames never accumulate drift. Cycle boundaries are computed by
+ * adding the exact cycle length to the cycle origin.
+ */
+class Timeline {
+public:
+    explicit Timeline(LEDStrip* strip);
+
+    // Control, called without the strip mutex
+    void load(std::vector<Keyframe>& keyframes, std::vector<EasingSpec>& curves,
+              bool looping, uint32_t maxIterations, bool pingPong);
+    void stop();
+    void seek(uint32_t positionMs);
+    void requestBreak();
+
+    // Render task, strip mutex held
+    void advance(uint32_t now);
+
+    bool isActive() const { return loop.isActive; }
+    uint32_t getCycleLength() const { return cycleLength; }
+    uint32_t getPosition(uint32_t now) const;
+    size_t getKeyframeCount() const { return keyframes.size(); }
+    bool isLoopingProgram() const { return looping; }
+
+    // Loaded program, valid while the strip mutex is held
+    const std::vector<Keyframe>& getKeyframes() const { return keyframes; }
+    const std::vector<EasingSpec>& getCurves() const { return curves; }
+
+    LoopState loop;
+
+private:
+    LEDStrip* strip;
+    std::vector<Keyframe> keyframes;
+    std::vector<EasingSpec> curves;
+    uint32_t cycleLength;
+    bool looping;
+    size_t next;             ///< Next keyframe to fire in the current cycle
+    int lastFired;           ///< Keyframe whose transition may still be running
+
+    void fire(size_t index, uint32_t startTime);
+    void settle();
+    void paintFill(const WColor& color);
+    static void mirror(std::vector<Keyframe>& keyframes);
+};
+
+#endif // TIMELINE_H
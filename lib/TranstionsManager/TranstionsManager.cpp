@@ -5,12 +5,25 @@
 #include <Arduino.h>
 #include <EffectsManager.h>
 #include <GradientManager.h>
+#include <HeapStats.h>
+#include <Telemetry.h>
 
 TranstionsManager::TranstionsManager(LEDStrip *strip):
+      activeEasing(&EasingTables::IN_OUT_QUAD),
       defaultTransitionDuration(1000),
       defaultTransitionType(TRANSITION_EASE_IN_OUT)
 {
     this->strip = strip;
+
+    // Preallocate crossfade scratch memory so transitions never allocate per frame
+    uint16_t numPixels = strip->numPixels();
+    transition.sourcePixels.reserve(numPixels);
+    transition.sourceState.pixels.reserve(numPixels);
+    transition.sourceState.arena.reserve(EffectRegistry::arenaWords(numPixels));
+    transition.targetState.pixels.reserve(numPixels);
+    transition.targetState.arena.reserve(EffectRegistry::arenaWords(numPixels));
+    transition.sourceGradientPixels.reserve(numPixels);
+    transition.targetGradientPixels.reserve(numPixels);
 }
 void TranstionsManager::renderTransition() {
     float progress = calculateTransitionProgress();
@@ -20,87 +33,153 @@ void TranstionsManager::renderTransition() {
     if (progress >= 1.0f) {
         progress = 1.0f; // Clamp to exactly 1.0
         transitionCompleted = true;
-        
-        // Update state immediately
-        strip->effectsManager->currentEffect = transition.targetEffect;
-        strip->effectsManager->effectWColor1 = transition.targetColor1;
-        strip->effectsManager->effectWColor2 = transition.targetColor2;
-        strip->effectsManager->effectWColor3 = transition.targetColor3;
-        strip->effectsManager->effectSpeed = transition.targetSpeed;
-        strip->effectsManager->effectIntensity = transition.targetIntensity;
-        strip->neopixel.setBrightness(transition.targetBrightness);
-        strip->gradientManager->gradientEnabled = transition.targetGradientEnabled;
-        strip->gradientManager->gradientStops = transition.targetGradientStops;
-        strip->gradientManager->gradientReverse = transition.targetGradientReverse;
     }
 
-    // Apply easing function
-    float easedProgress = applyEasing(progress, transition.type);
+    if (transition.memoryError) {
+        // No scratch for a blend: cut to the target, drawn from the next frame
+        transitionCompleted = true;
+    } else {
+        float easedProgress = easeProgress(progress);
+        renderTransitionFrame(easedProgress, strip->numPixels());
+        strip->show();
+    }
+
+    // Handle transition completion AFTER rendering
+    if (transitionCompleted) {
+        applyTargetState();
+        transition.active = false; // Mark transition as complete
+    }
+}
+
+// Ease the raw progress with the running transition's curve, baking custom
+// curves on first use
+float TranstionsManager::easeProgress(float progress)
+{
+    if (!transition.easingPrepared) {
+        prepareEasing();
+    }
+    return EasingCurve::sample(*activeEasing, progress);
+}
 
+// One blended frame into the strip buffer, without show() or completion
+void TranstionsManager::renderTransitionFrame(float easedProgress, uint16_t numPixels)
+{
     // Blend effect parameters
     strip->effectsManager->blendEffectParameters(easedProgress);
 
     // Create blended frame
-    if (transition.sourceEffect == EFFECT_NONE && transition.targetEffect == EFFECT_NONE) {
-        for (uint16_t i = 0; i < strip->neopixel.numPixels(); i++) {
-            WColor sourceColor = (i < transition.sourcePixels.size()) 
-                ? transition.sourcePixels[i] 
-                : WColor::BLACK;
-            WColor targetColor = transition.targetColor1;
-            WColor blendedColor = strip->blendColors(sourceColor, targetColor, easedProgress);
-            strip->safeSetPixelWColor(i, blendedColor);
+    EffectsManager *effects = strip->effectsManager;
+    uint32_t now = strip->now();
+    bool sourceAnimated = transition.sourceEffect != EFFECT_NONE;
+
+    if (transition.targetEffect == EFFECT_NONE) {
+        // Fade the source, still animating if it is an effect, into the target color
+        if (sourceAnimated) {
+            effects->advanceState(transition.sourceState, now);
         }
-    }
-    else if (transition.targetEffect == EFFECT_NONE) {
-        for (uint16_t i = 0; i < strip->neopixel.numPixels(); i++) {
-            WColor sourceColor = (i < transition.sourcePixels.size()) 
-                ? transition.sourcePixels[i] 
-                : WColor::BLACK;
-            WColor targetColor = transition.targetColor1;
-            WColor blendedColor = strip->blendColors(sourceColor, targetColor, easedProgress);
+        for (uint16_t i = 0; i < numPixels; i++) {
+            WColor blendedColor = strip->blendColors(sourcePixelAt(i), transition.targetColor1, easedProgress);
             strip->safeSetPixelWColor(i, blendedColor);
         }
     }
+    else if (!transition.useTargetState) {
+        // Same effect, only its parameters change: render the live instance
+        effects->advanceState(effects->state, now);
+        effects->commitState(effects->state);
+    }
     else {
-        // Simplified effect-to-effect blend
-        WColor blendedColor = strip->blendColors(transition.sourceColor1, transition.targetColor1, easedProgress);
-        strip->fill(blendedColor);
+        // Effect-to-effect crossfade between two live instances
+        if (sourceAnimated) {
+            effects->advanceState(transition.sourceState, now);
+        }
+        effects->advanceState(transition.targetState, now);
+
+        const std::vector<WColor> &targetPixels = transition.targetState.pixels;
+        for (uint16_t i = 0; i < numPixels; i++) {
+            WColor targetColor = (i < targetPixels.size()) ? targetPixels[i] : WColor::BLACK;
+            WColor blendedColor = strip->blendColors(sourcePixelAt(i), targetColor, easedProgress);
+            strip->safeSetPixelWColor(i, blendedColor);
+        }
     }
 
     // Blend gradient states
-    bool blendGradient = transition.sourceGradientEnabled || transition.targetGradientEnabled;
-    
-    if (blendGradient) {
-        std::vector<GradientStop> blendedStops = strip->blendGradientStops(
-            transition.sourceGradientStops,
-            transition.targetGradientStops,
-            easedProgress);
-        
-        bool blendedReverse = easedProgress < 0.5f 
-            ? transition.sourceGradientReverse 
-            : transition.targetGradientReverse;
-
-        // Render blended gradient
-        for (uint16_t i = 0; i < strip->neopixel.numPixels(); i++) {
-            float position = static_cast<float>(i) / static_cast<float>(strip->neopixel.numPixels() - 1);
-            if (blendedReverse) position = 1.0f - position;
-            WColor color = strip->interpolateGradient(blendedStops, position);
-            strip->safeSetPixelWColor(i, color);
-        }
+    if (transition.sourceGradientEnabled || transition.targetGradientEnabled) {
+        renderGradientTransition(easedProgress, numPixels);
+    }
+}
+
+void TranstionsManager::renderGradientTransition(float easedProgress, uint16_t numPixels)
+{
+    // Resolve both gradients once, then every frame is a per-pixel lerp
+    if (!transition.gradientPrepared) {
+        strip->gradientManager->rasterizeGradient(transition.sourceGradientStops,
+                                                  transition.sourceGradientReverse,
+                                                  transition.sourceGradientPixels);
+        strip->gradientManager->rasterizeGradient(transition.targetGradientStops,
+                                                  transition.targetGradientReverse,
+                                                  transition.targetGradientPixels);
+        transition.gradientPrepared = true;
     }
 
-    strip->neopixel.show();
+    const std::vector<WColor> &from = transition.sourceGradientPixels;
+    const std::vector<WColor> &to = transition.targetGradientPixels;
+    uint16_t count = std::min<size_t>(numPixels, std::min(from.size(), to.size()));
+    for (uint16_t i = 0; i < count; i++) {
+        strip->safeSetPixelWColor(i, strip->blendColors(from[i], to[i], easedProgress));
+    }
+}
 
-    // Handle transition completion AFTER rendering
-    if (transitionCompleted) {
-        transition.active = false; // Mark transition as complete
-        
-        // Execute callback if present
-        if (transitionEndCallback) {
-            JsonObject emptyObj = strip->_emptyObject; // Use empty object
-            transitionEndCallback(emptyObj);
-        }
+// Source pixel for the current frame: live source effect or captured pixels
+WColor TranstionsManager::sourcePixelAt(uint16_t i) const
+{
+    const std::vector<WColor> &pixels = (transition.sourceEffect != EFFECT_NONE)
+        ? transition.sourceState.pixels
+        : transition.sourcePixels;
+    return (i < pixels.size()) ? pixels[i] : WColor::BLACK;
+}
+
+// Make the transition target the live state (caller holds the strip mutex)
+void TranstionsManager::applyTargetState()
+{
+    EffectsManager *effects = strip->effectsManager;
+    // Read before the swap below hands targetState the old live state
+    EmitterConfig emitter = transition.targetState.emitter;
+    SpatialConfig spatial = transition.targetState.spatial;
+    uint32_t seed = transition.targetState.seed;
+
+    bool restart = false;
+    if (transition.useTargetState) {
+        // The target instance keeps animating from where the crossfade left it
+        std::swap(effects->state, transition.targetState);
+        transition.useTargetState = false;
+    } else if (transition.memoryError) {
+        // Cut without a target instance: the live one becomes the target effect
+        restart = transition.targetEffect != EFFECT_NONE && transition.targetEffect != effects->state.type;
     }
+
+    effects->state.type = transition.targetEffect;
+    effects->state.color1 = transition.targetColor1;
+    effects->state.color2 = transition.targetColor2;
+    effects->state.color3 = transition.targetColor3;
+    effects->state.speed = transition.targetSpeed;
+    effects->state.intensity = transition.targetIntensity;
+    effects->state.emitter = emitter;
+    effects->state.spatial = spatial;
+    if (restart) {
+        effects->state.seed = seed;
+        effects->initializeState(effects->state, true);
+    } else if (effects->state.seed != seed) {
+        // Same effect kept running: only its random sequence restarts
+        effects->state.seed = seed;
+        EffectRegistry::seed(effects->state);
+    }
+    strip->neopixel.setBrightness(transition.targetBrightness);
+    strip->gradientManager->gradientEnabled = transition.targetGradientEnabled;
+    // Swapped, not copied: the render task must not grow the live stops. The
+    // target list is rewritten before the next transition reads it.
+    strip->gradientManager->gradientStops.swap(transition.targetGradientStops);
+    strip->gradientManager->gradientReverse = transition.targetGradientReverse;
+    strip->gradientManager->invalidateCache();
 }
 
 float TranstionsManager::getTransitionProgress()
@@ -108,29 +187,14 @@ float TranstionsManager::getTransitionProgress()
     if (!transition.active)
         return 1.0f;
 
-    uint32_t elapsed = millis() - transition.startTime;
+    uint32_t elapsed = strip->now() - transition.startTime;
     return std::min(1.0f, static_cast<float>(elapsed) / static_cast<float>(transition.duration));
 }
 void TranstionsManager::skipTransition()
 {
     if (xSemaphoreTake(strip->stripMutex, portMAX_DELAY))
     {
-        if (transition.active)
-        {
-            transition.active = false;
-            strip->effectsManager->currentEffect = transition.targetEffect;
-            strip->effectsManager->effectWColor1 = transition.targetColor1;
-            strip->effectsManager->effectWColor2 = transition.targetColor2;
-            strip->effectsManager->effectWColor3 = transition.targetColor3;
-            strip->effectsManager->effectSpeed = transition.targetSpeed;
-            strip->effectsManager->effectIntensity = transition.targetIntensity;
-            strip->setBrightness(transition.targetBrightness);
-
-            // ADD THIS: Save gradient settings
-            strip->gradientManager->gradientEnabled = transition.targetGradientEnabled;
-            strip->gradientManager->gradientStops = transition.targetGradientStops;
-            strip->gradientManager->gradientReverse = transition.targetGradientReverse;
-        }
+        finishTransition();
         xSemaphoreGive(strip->stripMutex);
     }
 }
@@ -149,79 +213,55 @@ float TranstionsManager::calculateTransitionProgress()
     if (!transition.active)
         return 1.0f;
 
-    uint32_t elapsed = millis() - transition.startTime;
+    uint32_t elapsed = strip->now() - transition.startTime;
     return std::min(1.0f, static_cast<float>(elapsed) / static_cast<float>(transition.duration));
 }
 float TranstionsManager::applyEasing(float t, TransitionType type)
 {
-    // Clamp input
-    t = std::max(0.0f, std::min(1.0f, t));
+    const EasingTable *table = builtinEasing(type);
+    return EasingCurve::sample(table ? *table : bakedEasing, t);
+}
 
+// Built-in curves are constexpr tables in flash. Aliases share one table:
+// the plain ease curves have always been the quadratic ones.
+const EasingTable *TranstionsManager::builtinEasing(TransitionType type)
+{
     switch (type)
     {
     case TRANSITION_LINEAR:
-        return t;
-
+        return &EasingTables::LINEAR;
     case TRANSITION_EASE_IN:
-        return t * t;
-
-    case TRANSITION_EASE_OUT:
-        return 1.0f - (1.0f - t) * (1.0f - t);
-
-    case TRANSITION_EASE_IN_OUT:
-        return t < 0.5f ? 2.0f * t * t : 1.0f - 2.0f * (1.0f - t) * (1.0f - t);
-
     case TRANSITION_EASE_IN_QUAD:
-        return t * t;
-
+        return &EasingTables::IN_QUAD;
+    case TRANSITION_EASE_OUT:
     case TRANSITION_EASE_OUT_QUAD:
-        return 1.0f - (1.0f - t) * (1.0f - t);
-
+        return &EasingTables::OUT_QUAD;
+    case TRANSITION_EASE_IN_OUT:
     case TRANSITION_EASE_IN_OUT_QUAD:
-        return t < 0.5f ? 2.0f * t * t : 1.0f - 2.0f * (1.0f - t) * (1.0f - t);
-
+        return &EasingTables::IN_OUT_QUAD;
     case TRANSITION_EASE_IN_CUBIC:
-        return t * t * t;
-
+        return &EasingTables::IN_CUBIC;
     case TRANSITION_EASE_OUT_CUBIC:
-        return 1.0f - (1.0f - t) * (1.0f - t) * (1.0f - t);
-
+        return &EasingTables::OUT_CUBIC;
     case TRANSITION_EASE_IN_OUT_CUBIC:
-        return t < 0.5f ? 4.0f * t * t * t : 1.0f - 4.0f * (1.0f - t) * (1.0f - t) * (1.0f - t);
-
+        return &EasingTables::IN_OUT_CUBIC;
     case TRANSITION_BOUNCE_OUT:
-    {
-        if (t < 1.0f / 2.75f)
-        {
-            return 7.5625f * t * t;
-        }
-        else if (t < 2.0f / 2.75f)
-        {
-            t -= 1.5f / 2.75f;
-            return 7.5625f * t * t + 0.75f;
-        }
-        else if (t < 2.5f / 2.75f)
-        {
-            t -= 2.25f / 2.75f;
-            return 7.5625f * t * t + 0.9375f;
-        }
-        else
-        {
-            t -= 2.625f / 2.75f;
-            return 7.5625f * t * t + 0.984375f;
-        }
-    }
-
+        return &EasingTables::BOUNCE_OUT;
     case TRANSITION_ELASTIC_OUT:
-    {
-        if (t == 0.0f || t == 1.0f)
-            return t;
-        return powf(2.0f, -10.0f * t) * sinf((t - 0.075f) * (2.0f * M_PI) / 0.3f) + 1.0f;
+        return &EasingTables::ELASTIC_OUT;
+    default:
+        return nullptr;
     }
+}
 
-    default:
-        return t;
+void TranstionsManager::prepareEasing()
+{
+    activeEasing = builtinEasing(transition.type);
+    if (!activeEasing) {
+        EasingCurve::bake(customEasing, bakedEasing);
+        activeEasing = &bakedEasing;
     }
+    transition.easingPrepared = true;
 }
 
 void TranstionsManager::startTransition(EffectType newEffect)
@@ -230,50 +270,167 @@ void TranstionsManager::startTransition(EffectType newEffect)
 }
 
 void TranstionsManager::startTransition(EffectType newEffect, uint32_t duration, TransitionType type)
+{
+    // Keep the current effect parameters, only the effect type changes
+    EffectState target;
+    target.copyParams(strip->effectsManager->state);
+    target.type = newEffect;
+    startTransition(target, duration, type);
+}
+
+void TranstionsManager::startTransition(const EffectState &target, uint32_t duration, TransitionType type)
 {
     if (xSemaphoreTake(strip->stripMutex, portMAX_DELAY))
     {
-        strip->captureCurrentState();
-
-        transition.active = true;
+        beginTransition(strip->now(), duration, type);
+        setTargetEffect(target);
         if (!strip->isRunning) {
             strip->startRendering();
         }
-        transition.startTime = millis();
-        transition.duration = duration;
-        transition.type = type;
-        transition.targetEffect = newEffect;
-
-        // Set target parameters (you might want to make these configurable)
-        transition.targetColor1 = strip->effectsManager->effectWColor1;
-        transition.targetColor2 = strip->effectsManager->effectWColor2;
-        transition.targetColor3 = strip->effectsManager->effectWColor3;
-        transition.targetSpeed = strip->effectsManager->effectSpeed;
-        transition.targetIntensity = strip->effectsManager->effectIntensity;
-        transition.targetBrightness = strip->neopixel.getBrightness();
-        transition.targetGradientEnabled = strip->gradientManager->gradientEnabled;
-        transition.targetGradientStops = strip->gradientManager->gradientStops;
-        transition.targetGradientReverse = strip->gradientManager->gradientReverse;
         xSemaphoreGive(strip->stripMutex);
     }
 }
 
-void TranstionsManager::setTransitionDuration(uint32_t duration)
+// Start a transition whose target is the current state; callers then override
+// the target fields they change. Caller holds the strip mutex.
+void TranstionsManager::beginTransition(uint32_t startTime, uint32_t duration, TransitionType type)
 {
-    defaultTransitionDuration = duration;
+    reserveScratch(strip->numPixels());
+    strip->captureCurrentState();
+
+    transition.active = true;
+    transition.startTime = startTime;
+    transition.duration = duration;
+    transition.type = type;
+
+    transition.targetColor1 = transition.sourceColor1;
+    transition.targetColor2 = transition.sourceColor2;
+    transition.targetColor3 = transition.sourceColor3;
+    transition.targetState.emitter = strip->effectsManager->state.emitter;
+    transition.targetState.spatial = strip->effectsManager->state.spatial;
+    transition.targetState.seed = strip->effectsManager->state.seed;
+    transition.targetSpeed = transition.sourceSpeed;
+    transition.targetIntensity = transition.sourceIntensity;
+    transition.targetBrightness = transition.sourceBrightness;
 }
 
-void TranstionsManager::setOnTransitionEnd(std::function<void(JsonObject)> callback) {
-    if (xSemaphoreTake(strip->stripMutex, portMAX_DELAY)) {
-        transitionEndCallback = callback;
-        xSemaphoreGive(strip->stripMutex);
+// Grows the blend buffers when the strip got longer than at construction,
+// here on the command task rather than on a frame. A heap too low or too
+// fragmented for them sets memoryError and the transition becomes a cut.
+// Caller holds the strip mutex.
+bool TranstionsManager::reserveScratch(uint16_t numPixels)
+{
+    size_t words = EffectRegistry::arenaWords(numPixels);
+    std::vector<WColor> *colorBuffers[] = {
+        &transition.sourcePixels, &transition.sourceState.pixels, &transition.targetState.pixels,
+        &transition.sourceGradientPixels, &transition.targetGradientPixels};
+
+    size_t largest = 0;
+    size_t total = 0;
+    for (std::vector<WColor> *buffer : colorBuffers) {
+        if (buffer->capacity() < numPixels) {
+            largest = std::max(largest, numPixels * sizeof(WColor));
+            total += numPixels * sizeof(WColor);
+        }
+    }
+    for (EffectState *state : {&transition.sourceState, &transition.targetState}) {
+        if (state->arena.capacity() < words) {
+            largest = std::max(largest, words * sizeof(state->arena[0]));
+            total += words * sizeof(state->arena[0]);
+        }
+    }
+    if (total == 0) {
+        transition.memoryError = false;
+        return true;
+    }
+
+    uint32_t now = millis();
+    if (transition.memoryError && now - transition.lastMemoryCheck < MEMORY_RETRY_MS) {
+        return false;
+    }
+    transition.lastMemoryCheck = now;
+    uint32_t largestBlock = HeapStats::largestFreeBlock();
+    transition.memoryError = largestBlock < largest || HeapStats::freeHeap() < total + HEAP_HEADROOM_BYTES;
+    if (transition.memoryError) {
+        Serial.printf("WARNING: %u bytes of transition scratch do not fit, largest block %u\n",
+                      static_cast<unsigned>(total), static_cast<unsigned>(largestBlock));
+        Telemetry::getInstance().record(TELEMETRY_ERROR, strip->telemetrySource, TELEMETRY_ERR_LOW_MEMORY,
+                                        static_cast<int32_t>(largestBlock));
+        return false;
+    }
+
+    for (std::vector<WColor> *buffer : colorBuffers) {
+        buffer->reserve(numPixels);
+    }
+    transition.sourceState.arena.reserve(words);
+    transition.targetState.arena.reserve(words);
+    return true;
+}
+
+// Caller holds the strip mutex
+void TranstionsManager::setTargetEffect(const EffectState &target)
+{
+    transition.targetEffect = target.type;
+    transition.targetColor1 = target.color1;
+    transition.targetColor2 = target.color2;
+    transition.targetColor3 = target.color3;
+    transition.targetSpeed = target.speed;
+    transition.targetIntensity = target.intensity;
+    transition.targetState.emitter = target.emitter;
+    transition.targetState.spatial = target.spatial;
+    transition.targetState.seed = target.seed;
+
+    // A different effect gets its own instance so both keep animating during the fade,
+    // unless there is no scratch for it: the live instance then restarts at the cut
+    transition.useTargetState = target.type != EFFECT_NONE && target.type != transition.sourceEffect &&
+                                !transition.memoryError;
+    if (transition.useTargetState) {
+        transition.targetState.copyParams(target);
+        strip->effectsManager->initializeState(transition.targetState, true);
     }
 }
 
+// Jump a running transition to its end. Caller holds the strip mutex.
+void TranstionsManager::finishTransition()
+{
+    if (transition.active)
+    {
+        transition.active = false;
+        applyTargetState();
+    }
+}
+
+void TranstionsManager::setTransitionDuration(uint32_t duration)
+{
+    defaultTransitionDuration = duration;
+}
+
 TransitionType TranstionsManager::parseTransitionType(const char *transitionName)
+{
+    return parseTransitionType(transitionName, customEasing);
+}
+
+// Curve parameters of bezier and steps easings are written to spec
+TransitionType TranstionsManager::parseTransitionType(const char *transitionName, EasingSpec &spec)
 {
     String transition = String(transitionName);
     transition.toLowerCase();
+    transition.trim();
+
+    if (transition.startsWith("cubic-bezier("))
+    {
+        if (EasingCurve::parseBezier(transition.c_str(), spec))
+            return TRANSITION_CUBIC_BEZIER;
+        Serial.println("WARNING: Invalid cubic-bezier easing, using default");
+        return TRANSITION_EASE_IN_OUT;
+    }
+    if (transition.startsWith("steps("))
+    {
+        if (EasingCurve::parseSteps(transition.c_str(), spec))
+            return TRANSITION_STEPS;
+        Serial.println("WARNING: Invalid steps easing, using default");
+        return TRANSITION_EASE_IN_OUT;
+    }
 
     if (transition == "linear")
         return TRANSITION_LINEAR;
@@ -302,3 +459,38 @@ TransitionType TranstionsManager::parseTransitionType(const char *transitionName
 
     return TRANSITION_EASE_IN_OUT;
 }
+
+// Easing given either as a name / CSS style function string, or as an array
+// of evenly spaced samples describing a custom curve
+TransitionType TranstionsManager::parseEasing(JsonVariant easing)
+{
+    return parseEasing(easing, customEasing);
+}
+
+TransitionType TranstionsManager::parseEasing(JsonVariant easing, EasingSpec &spec)
+{
+    if (easing.is<JsonArray>())
+    {
+        JsonArray samples = easing.as<JsonArray>();
+        uint8_t count = 0;
+        for (JsonVariant sample : samples)
+        {
+            if (count >= MAX_EASING_SAMPLES)
+                break;
+            spec.samples[count++] = sample.as<float>();
+        }
+        if (count < 2)
+        {
+            Serial.println("WARNING: Custom easing needs at least 2 samples, using default");
+            return defaultTransitionType;
+        }
+        spec.kind = EasingSpec::SAMPLED;
+        spec.sampleCount = count;
+        return TRANSITION_CUSTOM;
+    }
+
+    const char *name = easing.as<const char *>();
+    if (!name)
+        return defaultTransitionType;
+    return parseTransitionType(name, spec);
+}
@@ -10,10 +10,10 @@
 #include <vector>
 #include <wcolor.h>
 #include <ArduinoJson.h>
-#include <set>
 #include <algorithm>  // Added for std::sort
 #include "utils.h"
 #include <output.h>
+#include <EasingCurve.h>
 
 // Forward declarations instead of includes to avoid circular dependency
 class LEDStrip;
@@ -22,7 +22,17 @@ class EffectsManager;
 class TranstionsManager{
     private:
     LEDStrip *strip;
+    WColor sourcePixelAt(uint16_t i) const;
+    void applyTargetState();
+    bool reserveScratch(uint16_t numPixels);
+
+    // Easing table of the running transition, resolved on its first frame
+    EasingTable bakedEasing;
+    const EasingTable *activeEasing;
+    void prepareEasing();
     public:
+    // Frame pieces of renderTransition, also driven directly by the benchmarks
+    float easeProgress(float progress);
     void renderGradientTransition(float easedProgress, uint16_t numPixels);
     void renderTransitionFrame(float easedProgress, uint16_t numPixels);
     TransitionState transition;
@@ -30,18 +40,27 @@ class TranstionsManager{
     float getTransitionProgress();
     
     float applyEasing(float t, TransitionType type); 
+    static const EasingTable *builtinEasing(TransitionType type);
+    EasingSpec customEasing;   ///< Parameters for bezier, steps and sampled curves
     float calculateTransitionProgress();
     void skipTransition();
     void stopTransition();
-    std::function<void(JsonObject)> transitionEndCallback;  // Changed from JsonObject&
     
     void startTransition(EffectType newEffect);
     void startTransition(EffectType newEffect, uint32_t duration, TransitionType type);
+    void startTransition(const EffectState& target, uint32_t duration, TransitionType type);
+
+    // Building blocks for callers that already hold the strip mutex
+    void beginTransition(uint32_t startTime, uint32_t duration, TransitionType type);
+    void setTargetEffect(const EffectState& target);
+    void finishTransition();
     uint32_t defaultTransitionDuration;
     TransitionType defaultTransitionType;
     void setTransitionDuration(uint32_t duration);
-    void setOnTransitionEnd(std::function<void(JsonObject)> callback);
     TransitionType parseTransitionType(const char* transitionName);
+    TransitionType parseTransitionType(const char* transitionName, EasingSpec& spec);
+    TransitionType parseEasing(JsonVariant easing);
+    TransitionType parseEasing(JsonVariant easing, EasingSpec& spec);
     TranstionsManager(LEDStrip *strip);
     
     void setTransitionType(TransitionType type) { defaultTransitionType = type; }
@@ -49,5 +68,11 @@ class TranstionsManager{
     TransitionType getTransitionType() const { return defaultTransitionType; }
     bool isTransitioning() const { return transition.active; }
 
+    // Free heap kept beyond the scratch a transition reserves, for the
+    // network stack and the next JSON document
+    static constexpr uint32_t HEAP_HEADROOM_BYTES = 8192;
+    // Heap walked at most this often while it is too low for the scratch
+    static constexpr uint32_t MEMORY_RETRY_MS = 1000;
+
 };
 #endif  // TRANSTIONS_H
\ No newline at end of file
@@ -1,19 +1,29 @@
 #ifndef DINPUT_H
 #define DINPUT_H
 #include <Arduino.h>
+#include <GestureDetector.h>
 
 // Virtual base class
 class DInput {
     public:
     std::function<void(DInput*)> onChangeCb;
+    std::function<void(DInput*, InputGesture)> onGestureCb;
     // Virtual destructor is essential for proper cleanup
     virtual ~DInput() = default;
     virtual bool getState() = 0;
     unsigned long lastcheck;
+    uint32_t lastEdgeUs = 0;   ///< micros() of the last raw edge, for latency probes
     void onChange(std::function<void(DInput*)> cb){
         this->onChangeCb = cb;
     }
+    void onGesture(std::function<void(DInput*, InputGesture)> cb){
+        this->onGestureCb = cb;
+    }
+    // Raw edge drained from the input queue
+    virtual void onEdge(bool /*level*/, uint32_t /*timeMs*/) {}
+    // Ms until check() must run again; inputs without interrupts keep the 10 ms poll
+    virtual uint32_t msUntilDeadline(uint32_t /*now*/) { return 10; }
     virtual void check()=0;
 };
 
-#endif
\ No newline at end of file
+#endif
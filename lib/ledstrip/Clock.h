@@ -0,0 +1,56 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <Arduino.h>
+#include <atomic>
+
+/**
+ * @brief Time source of a strip and its managers, in milliseconds
+ *
+ * Everything that animates reads the time through LEDStrip::now(), so a
+ * strip given a VirtualClock renders the same frames on every run.
+ */
+class Clock {
+public:
+    virtual ~Clock() {}
+    virtual uint32_t now() = 0;
+    // A stepped clock only moves when told to; the owner of the strip then
+    // renders frames itself with LEDStrip::renderStep() instead of the task
+    virtual bool stepped() const { return false; }
+};
+
+/**
+ * @brief millis(), the clock every strip starts with
+ */
+class SystemClock : public Clock {
+public:
+    uint32_t now() override { return millis(); }
+
+    static SystemClock& instance()
+    {
+        static SystemClock clock;
+        return clock;
+    }
+};
+
+/**
+ * @brief Clock moved by hand, for reproducible frames and fast-forward
+ *
+ * Read from the command task and stepped from the rendering thread, hence
+ * atomic.
+ */
+class VirtualClock : public Clock {
+public:
+    explicit VirtualClock(uint32_t startMs = 0) : ms(startMs) {}
+
+    uint32_t now() override { return ms.load(std::memory_order_relaxed); }
+    bool stepped() const override { return true; }
+
+    void set(uint32_t nowMs) { ms.store(nowMs, std::memory_order_relaxed); }
+    void advance(uint32_t deltaMs) { ms.fetch_add(deltaMs, std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> ms;
+};
+
+#endif // CLOCK_H
@@ -6,32 +6,47 @@
 #include <vector>
 #include <wcolor.h>
 #include <ArduinoJson.h>
-#include <set>
 #include "utils.h"
 #include <TranstionsManager.h>
 #include <EffectsManager.h>
 #include <GradientManager.h>
 #include <LEDStripJsonParser.h>
+#include <Timeline.h>
+#include <BootProfile.h>
+#include <SceneJournal.h>
+#include <InputRules.h>
+#include <Telemetry.h>
+#include <HeapStats.h>
+#include <ConfigStore.h>
+#include <SPIFFS.h>
 
 LEDStrip::LEDStrip(uint16_t numPixels, uint8_t pin, neoPixelType type)
-    : neopixel(numPixels, pin, type),
-      renderTaskHandle(nullptr),
+    : isRunning(false),
+      neopixel(numPixels, pin, type),
       stripMutex(nullptr),
-      isRunning(false),
-      frameRate(60),
-      frameDelay(1000 / 60),
-      meteorPosition(0),
       effectsManager(nullptr),
       transitionsManager(nullptr),
-      gradientManager(nullptr)  // Initialize this too
+      gradientManager(nullptr),  // Initialize this too
+      timeline(nullptr),
+      journal(nullptr),
+      activePreset(-1),
+      renderTaskHandle(nullptr),
+      clock(&SystemClock::instance()),
+      frameRate(60),
+      frameDelay(1000 / 60)
 {
     stripMutex = xSemaphoreCreateMutex();
+    framebuffer.assign(numPixels, WColor::BLACK);
+    pixelMap.identity(numPixels);
+    matrix.linear(numPixels);
+    coords.fromLayout(matrix, numPixels);
     
     // Create the manager objects dynamically
     effectsManager = new EffectsManager(this);
     transitionsManager = new TranstionsManager(this);
     gradientManager = new GradientManager(this);
     ledStripJsonInterpreter = new LEDStripJsonParser(this);
+    timeline = new Timeline(this);
     
     effectsManager->initializeEffectData();
 }
@@ -43,6 +58,11 @@ LEDStrip::~LEDStrip()
     {
         vSemaphoreDelete(stripMutex);
     }
+    delete timeline;
+    delete ledStripJsonInterpreter;
+    delete gradientManager;
+    delete transitionsManager;
+    delete effectsManager;
 }
 
 bool LEDStrip::begin()
@@ -53,7 +73,7 @@ bool LEDStrip::begin()
     }
 
     clear();
-    neopixel.show();
+    show();
     return true;
 }
 
@@ -69,7 +89,7 @@ void LEDStrip::end()
 
 void LEDStrip::startRendering()
 {
-    if (isRunning)
+    if (isRunning || clock->stepped())
         return;
 
     isRunning = true;
@@ -96,38 +116,52 @@ void LEDStrip::stopRendering() {
 void LEDStrip::renderTask(void* parameter) {
     LEDStrip* strip = static_cast<LEDStrip*>(parameter);
     TickType_t lastWakeTime = xTaskGetTickCount();
+    HeapStats::tagTask(ALLOC_RENDER);
     
     while (strip->isRunning) {
-        // Take mutex for rendering
-        if (xSemaphoreTake(strip->stripMutex, pdMS_TO_TICKS(10))) {
-            // Render frame
-            strip->renderFrame();
-            
-            // Process any pending deferred callbacks AFTER rendering
-            if (strip->deferredCallback) {
-                auto callback = strip->deferredCallback;
-                strip->deferredCallback = nullptr; // Clear before executing
-                
-                // Release mutex before executing callback to avoid deadlocks
-                xSemaphoreGive(strip->stripMutex);
-                
-                // Execute callback (this may call jsonInterpreter again)
-                callback();
-            } else {
-                xSemaphoreGive(strip->stripMutex);
-            }
-        }
+        strip->renderStep();
         
         // Maintain frame rate
         vTaskDelayUntil(&lastWakeTime, pdMS_TO_TICKS(strip->frameDelay));
     }
+    HeapStats::untagTask();
     strip->renderTaskHandle = nullptr;  // Critical fix
     vTaskDelete(NULL);
 }
 
+// One frame of the render task, also called directly under a stepped clock
+void LEDStrip::renderStep()
+{
+    // Take mutex for rendering
+    if (!xSemaphoreTake(stripMutex, pdMS_TO_TICKS(10))) {
+        return;
+    }
+
+    // Render frame
+    renderFrame();
+    if (bootFrameArmed) {
+        bootFrameArmed = false;
+        BootProfile::mark(BOOT_FIRST_FRAME);
+    }
+    if (probeApplied) {
+        InputRules::getInstance().recordLatency(micros() - probeStartUs);
+        probeApplied = false;
+        probeStartUs = 0;
+    }
+    xSemaphoreGive(stripMutex);
+}
+
+void LEDStrip::setClock(Clock* clock)
+{
+    this->clock = clock ? clock : &SystemClock::instance();
+}
+
 
 void LEDStrip::renderFrame()
 {
+    // Fire due sequence keyframes before drawing
+    timeline->advance(now());
+
     // Handle transitions first
     if (transitionsManager->transition.active)
     {
@@ -144,15 +178,8 @@ void LEDStrip::renderFrame()
     effectsManager->renderEffect();
 
     // Show the result
-    neopixel.show();
-    effectsManager->effectCounter++;
-}
-void LEDStrip::processCallbacks() {
-    if (deferredCallback) {
-        auto callback = deferredCallback;
-        deferredCallback = nullptr; // Clear before executing
-        callback(); // Execute the callback
-    }
+    show();
+    effectsManager->state.counter++;
 }
 
 
@@ -169,28 +196,43 @@ WColor LEDStrip::blendColors(const WColor &color1, const WColor &color2, float f
 
 void LEDStrip::captureCurrentState()
 {
-    transitionsManager->transition.sourceEffect = effectsManager->currentEffect;
-    transitionsManager->transition.sourceColor1 = effectsManager->effectWColor1;
-    transitionsManager->transition.sourceColor2 = effectsManager->effectWColor2;
-    transitionsManager->transition.sourceColor3 = effectsManager->effectWColor3;
-    transitionsManager->transition.sourceSpeed = effectsManager->effectSpeed;
-    transitionsManager->transition.sourceIntensity = effectsManager->effectIntensity;
+    transitionsManager->transition.sourceEffect = effectsManager->state.type;
+    transitionsManager->transition.sourceColor1 = effectsManager->state.color1;
+    transitionsManager->transition.sourceColor2 = effectsManager->state.color2;
+    transitionsManager->transition.sourceColor3 = effectsManager->state.color3;
+    transitionsManager->transition.sourceSpeed = effectsManager->state.speed;
+    transitionsManager->transition.sourceIntensity = effectsManager->state.intensity;
     transitionsManager->transition.sourceBrightness = neopixel.getBrightness();
 
-    // Capture current pixel states
+    transitionsManager->transition.sourceEffect = effectsManager->state.type;
+    transitionsManager->transition.sourceGradientEnabled = gradientManager->gradientEnabled;
+    transitionsManager->transition.sourceGradientStops = gradientManager->gradientStops;
+    transitionsManager->transition.sourceGradientReverse = gradientManager->gradientReverse;
+    // The gradient stays as it is unless the caller targets another one
+    transitionsManager->transition.targetGradientEnabled = gradientManager->gradientEnabled;
+    transitionsManager->transition.targetGradientStops = gradientManager->gradientStops;
+    transitionsManager->transition.targetGradientReverse = gradientManager->gradientReverse;
 
-    transitionsManager->transition.sourcePixels.clear();
+    // A transition without scratch memory is cut, it needs no snapshot
+    if (!transitionsManager->transition.memoryError)
+    {
+        // Capture current pixel states
+        transitionsManager->transition.sourcePixels.clear();
+        transitionsManager->transition.sourcePixels.reserve(numPixels());
 
-    transitionsManager->transition.sourceEffect = effectsManager->currentEffect;
-    transitionsManager->transition.sourcePixels.reserve(neopixel.numPixels());
+        for (uint16_t i = 0; i < numPixels(); i++)
+        {
+            transitionsManager->transition.sourcePixels.push_back(getPixelWColor(i));
+        }
 
-    for (uint16_t i = 0; i < neopixel.numPixels(); i++)
-    {
-        transitionsManager->transition.sourcePixels.push_back(getPixelWColor(i));
+        // Keep the running effect animating as the crossfade source.
+        // Canvases are preallocated, so this copy does not allocate.
+        transitionsManager->transition.sourceState = effectsManager->state;
     }
-    transitionsManager->transition.sourceGradientEnabled = gradientManager->gradientEnabled;
-    transitionsManager->transition.sourceGradientStops = gradientManager->gradientStops;
-    transitionsManager->transition.sourceGradientReverse = gradientManager->gradientReverse;
+    transitionsManager->transition.targetEffect = effectsManager->state.type;
+    transitionsManager->transition.useTargetState = false;
+    transitionsManager->transition.gradientPrepared = false;
+    transitionsManager->transition.easingPrepared = false;
 }
 
 
@@ -205,16 +247,16 @@ void LEDStrip::fillSmooth(const WColor &color)
         captureCurrentState();
 
         transitionsManager->transition.active = true;
-        transitionsManager->transition.startTime = millis();
+        transitionsManager->transition.startTime = now();
         transitionsManager->transition.duration = transitionsManager->defaultTransitionDuration;
         transitionsManager->transition.type = transitionsManager->defaultTransitionType;
-        transitionsManager->transition.sourceEffect = effectsManager->currentEffect;
+        transitionsManager->transition.sourceEffect = effectsManager->state.type;
         transitionsManager->transition.targetEffect = EFFECT_NONE;
         transitionsManager->transition.targetColor1 = color;
         transitionsManager->transition.targetColor2 = color;
         transitionsManager->transition.targetColor3 = color;
-        transitionsManager->transition.targetSpeed = effectsManager->effectSpeed;
-        transitionsManager->transition.targetIntensity = effectsManager->effectIntensity;
+        transitionsManager->transition.targetSpeed = effectsManager->state.speed;
+        transitionsManager->transition.targetIntensity = effectsManager->state.intensity;
         transitionsManager->transition.targetBrightness = neopixel.getBrightness();
 
         Serial.println("Transition started successfully");
@@ -238,10 +280,10 @@ void LEDStrip::setBrightnessSmooth(uint8_t brightness)
         captureCurrentState();
 
         transitionsManager->transition.active = true;
-        transitionsManager->transition.startTime = millis();
+        transitionsManager->transition.startTime = now();
         transitionsManager->transition.duration = transitionsManager->defaultTransitionDuration;
         transitionsManager->transition.type = transitionsManager->defaultTransitionType;
-        transitionsManager->transition.targetEffect = effectsManager->currentEffect;
+        transitionsManager->transition.targetEffect = effectsManager->state.type;
         transitionsManager->transition.targetBrightness = brightness;
 
         xSemaphoreGive(stripMutex);
@@ -261,7 +303,7 @@ void LEDStrip::setBrightness(uint8_t brightness)
         xSemaphoreGive(stripMutex);
 
         // Call show() outside of mutex to avoid potential deadlock
-        neopixel.show();
+        show();
     }
 }
 
@@ -276,12 +318,22 @@ void LEDStrip::setFrameRate(uint32_t fps)
 
 void LEDStrip::safeSetPixelWColor(uint16_t n, const WColor &color)
 {
-    if (n < neopixel.numPixels())
+    if (n < numPixels())
     {
-        neopixel.setPixelColor(n, colorToNeoPixel(color));
+        framebuffer[n] = color;
     }
 }
 
+// The only place logical pixels meet LEDs: the map runs once per frame,
+// while the driver buffer is filled
+void LEDStrip::show()
+{
+    pixelMap.pack(framebuffer.data(), [this](uint16_t led, const WColor& color) {
+        neopixel.setPixelColor(led, color.r, color.g, color.b);
+    });
+    neopixel.show();
+}
+
 uint32_t LEDStrip::colorToNeoPixel(const WColor &color)
 {
     return (static_cast<uint32_t>(color.r) << 16) |
@@ -314,22 +366,17 @@ void LEDStrip::setPixelWColor(uint16_t n, uint32_t color)
 
 WColor LEDStrip::getPixelWColor(uint16_t n)
 {
-    if (n >= neopixel.numPixels())
+    if (n >= numPixels())
         return WColor::BLACK;
 
-    uint32_t color =  neopixel.getPixelColor(n);
-    uint8_t r = (color >> 16) & 0xFF;
-    uint8_t g = (color >> 8) & 0xFF;
-    uint8_t b = color & 0xFF;
-
-    return WColor(r, g, b);
+    return framebuffer[n];
 }
 
 void LEDStrip::fill(const WColor &color)
 {
     if (xSemaphoreTake(stripMutex, portMAX_DELAY))
     {
-        for (uint16_t i = 0; i < neopixel.numPixels(); i++)
+        for (uint16_t i = 0; i < numPixels(); i++)
         {
             safeSetPixelWColor(i, color);
         }
@@ -344,7 +391,7 @@ void LEDStrip::clear()
 
 void LEDStrip::fadeToBlack(float fadeAmount)
 {
-        for (uint16_t i = 0; i < neopixel.numPixels(); i++)
+        for (uint16_t i = 0; i < numPixels(); i++)
         {
             WColor currentColor = getPixelWColor(i);  // Use unsafe version
             WColor fadedColor = WColor(
@@ -357,26 +404,26 @@ void LEDStrip::fadeToBlack(float fadeAmount)
 
 void LEDStrip::shiftPixels(int positions)
 {
-    if (positions == 0 || neopixel.numPixels() == 0)
+    if (positions == 0 || numPixels() == 0)
         return;
 
     if (xSemaphoreTake(stripMutex, portMAX_DELAY))
     {
         std::vector<WColor> buffer;
-        buffer.reserve( neopixel.numPixels());
+        buffer.reserve( numPixels());
 
         // Copy current colors
-        for (uint16_t i = 0; i < neopixel.numPixels(); i++)
+        for (uint16_t i = 0; i < numPixels(); i++)
         {
             buffer.push_back(getPixelWColor(i));
         }
 
         // Shift and wrap
-        for (uint16_t i = 0; i < neopixel.numPixels(); i++)
+        for (uint16_t i = 0; i < numPixels(); i++)
         {
-            int sourceIndex = (i - positions) % static_cast<int>( neopixel.numPixels());
+            int sourceIndex = (i - positions) % static_cast<int>( numPixels());
             if (sourceIndex < 0)
-                sourceIndex += neopixel.numPixels();
+                sourceIndex += numPixels();
 
             safeSetPixelWColor(i, buffer[sourceIndex]);
         }
@@ -389,7 +436,7 @@ void LEDStrip::mirrorHalf(bool firstHalf)
 {
     if (xSemaphoreTake(stripMutex, portMAX_DELAY))
     {
-        uint16_t half = neopixel.numPixels() / 2;
+        uint16_t half = numPixels() / 2;
 
         if (firstHalf)
         {
@@ -397,7 +444,7 @@ void LEDStrip::mirrorHalf(bool firstHalf)
             for (uint16_t i = 0; i < half; i++)
             {
                 WColor color = getPixelWColor(i);
-                safeSetPixelWColor( neopixel.numPixels() - 1 - i, color);
+                safeSetPixelWColor( numPixels() - 1 - i, color);
             }
         }
         else
@@ -405,7 +452,7 @@ void LEDStrip::mirrorHalf(bool firstHalf)
             // Mirror second half to first half
             for (uint16_t i = 0; i < half; i++)
             {
-                WColor color = getPixelWColor( neopixel.numPixels() - 1 - i);
+                WColor color = getPixelWColor( numPixels() - 1 - i);
                 safeSetPixelWColor(i, color);
             }
         }
@@ -414,17 +461,99 @@ void LEDStrip::mirrorHalf(bool firstHalf)
     }
 }
 
-void LEDStrip::stopLoop() {
-    if (xSemaphoreTake(stripMutex, portMAX_DELAY)) {
-        isLooping = false;
-        Serial.println("Loop stopped");
-        xSemaphoreGive(stripMutex);
+// Compiles the XY table once; the running effect restarts on the new layout
+bool LEDStrip::setMatrix(const MatrixConfig& config)
+{
+    if (!xSemaphoreTake(stripMutex, portMAX_DELAY)) return false;
+    bool ok = matrix.compile(config, numPixels());
+    if (ok) {
+        if (!coords.isCustom()) coords.fromLayout(matrix, numPixels());
+        effectsManager->initializeState(effectsManager->state, true);
+        Serial.printf("Matrix: %ux%u\n", matrix.width(), matrix.height());
     }
+    xSemaphoreGive(stripMutex);
+    return ok;
 }
 
-// Method to check if currently looping
-bool LEDStrip::isCurrentlyLooping() const {
-    return isLooping;
+// The logical pixel count may change: the matrix and the coordinates go
+// back to a line over the new count, setupStrip applies them after the map
+bool LEDStrip::setPixelMap(const PixelMap& map)
+{
+    if (!xSemaphoreTake(stripMutex, portMAX_DELAY)) return false;
+    pixelMap = map;
+    framebuffer.assign(map.size(), WColor::BLACK);
+    neopixel.clear();   // Gaps are never written again
+    matrix.linear(map.size());
+    coords.fromLayout(matrix, map.size());
+    gradientManager->invalidateCache();
+    effectsManager->initializeState(effectsManager->state, false);
+    Serial.printf("Pixel map: %u pixels, %u runs%s\n", map.size(), (unsigned)map.runCount(),
+                  map.usesTable() ? ", table" : "");
+    xSemaphoreGive(stripMutex);
+    return true;
+}
+
+// Uploaded coordinates saved by setCoords, read once at boot
+bool LEDStrip::loadCoords(const String& path)
+{
+    coordsPath = path;
+    if (!ConfigStore::getInstance().mount() || !SPIFFS.exists(path)) return false;
+
+    File file = SPIFFS.open(path, FILE_READ);
+    if (!file) return false;
+    std::vector<uint8_t> data(file.size());
+    bool read = file.read(data.data(), data.size()) == data.size();
+    file.close();
+
+    PixelCoords loaded;
+    if (!read || !loaded.decode(data.data(), data.size(), numPixels())) {
+        Serial.printf("Coords: %s does not match this strip, ignored\n", path.c_str());
+        return false;
+    }
+    if (!xSemaphoreTake(stripMutex, portMAX_DELAY)) return false;
+    coords = std::move(loaded);
+    effectsManager->initializeState(effectsManager->state, true);
+    xSemaphoreGive(stripMutex);
+    return true;
+}
+
+// {"x": [...], "y": [...], "z": [...], "save": true} or {"clear": true}.
+// Parsed before the mutex is taken, the flash write happens after it is released.
+bool LEDStrip::setCoords(JsonVariantConst json)
+{
+    uint16_t count = numPixels();
+    bool clear = json["clear"] | false;
+    PixelCoords next;
+    if (clear) {
+        next.fromLayout(matrix, count);
+    } else if (!next.parse(json, count)) {
+        return false;
+    }
+
+    std::vector<uint8_t> data;
+    if (!clear && (json["save"] | false)) {
+        next.encode(data);
+    }
+
+    if (!xSemaphoreTake(stripMutex, portMAX_DELAY)) return false;
+    coords = std::move(next);
+    // Spatial effects cache per-pixel terms derived from the coordinates
+    effectsManager->initializeState(effectsManager->state, true);
+    xSemaphoreGive(stripMutex);
+
+    if (coordsPath.length() == 0 || !ConfigStore::getInstance().mount()) return true;
+    if (clear) {
+        SPIFFS.remove(coordsPath);
+    } else if (!data.empty()) {
+        File file = SPIFFS.open(coordsPath, FILE_WRITE);
+        bool written = file && file.write(data.data(), data.size()) == data.size();
+        if (file) file.close();
+        if (!written) {
+            Serial.printf("Coords: could not write %s\n", coordsPath.c_str());
+            return false;
+        }
+    }
+    return true;
 }
 
 void LEDStrip::setTaskPriority(UBaseType_t priority)
@@ -442,6 +571,26 @@ void LEDStrip::setTaskCore(BaseType_t core)
     Serial.println("Warning: setTaskCore requires task restart to take effect");
 }
 
+EffectType LEDStrip::getCurrentEffect() const
+{
+    return effectsManager->getCurrentEffect();
+}
+
+float LEDStrip::getEffectSpeed() const
+{
+    return effectsManager->getEffectSpeed();
+}
+
+float LEDStrip::getEffectIntensity() const
+{
+    return effectsManager->getEffectIntensity();
+}
+
+float LEDStrip::getTransitionProgress() const
+{
+    return transitionsManager->getTransitionProgress();
+}
+
 
 
 
@@ -452,5 +601,14 @@ void LEDStrip::setTaskCore(BaseType_t core)
 void LEDStrip::jsonInterpreter(JsonObject &json)
 {
     Serial.println("void LEDStrip::jsonInterpreter(JsonObject &json)");
+    // Anything but a recall or sequence control diverges from the preset
+    if (!json.containsKey("preset") && !json.containsKey("sequence")) {
+        activePreset = -1;
+    }
     this->ledStripJsonInterpreter->jsonInterpreter(json, true);
+    Telemetry::getInstance().record(TELEMETRY_SCENE, telemetrySource, getCurrentEffect(),
+                                    neopixel.getBrightness() | ((activePreset + 1) << 8));
+    if (journal) {
+        journal->touch();
+    }
 }
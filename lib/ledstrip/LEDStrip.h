@@ -8,17 +8,20 @@ _Pragma("once");
 #include <vector>
 #include <wcolor.h>
 #include <ArduinoJson.h>
-#include <set>
 #include <algorithm>  // Added for std::sort
 #include "utils.h"
 #include <output.h>
+#include <PixelLayout.h>
+#include "Clock.h"
 
 // Forward declarations to avoid circular dependencies
 class EffectsManager;
 class TranstionsManager;
 class GradientManager;
 class LEDStripJsonParser;
-enum EffectType; 
+class Timeline;
+class SceneJournal;
+enum EffectType : uint8_t;
 
 class LEDStrip: public Output{
     public:
@@ -32,26 +35,16 @@ class LEDStrip: public Output{
 
         position = std::max(0.0f, std::min(1.0f, position));
 
-        size_t leftIndex = 0;
-        size_t rightIndex = stops.size() - 1;
+        if (position <= stops.front().position) return stops.front().color;
+        if (position >= stops.back().position) return stops.back().color;
 
-        for (size_t i = 0; i < stops.size() - 1; i++) {
-            if (position >= stops[i].position && position <= stops[i+1].position) {
-                leftIndex = i;
-                rightIndex = i+1;
-                break;
-            }
-        }
+        // Stops are kept sorted: binary search the segment holding position.
+        // On stops sharing a position the first one wins, as with a linear search.
+        auto right = std::lower_bound(stops.begin(), stops.end(), GradientStop(position, WColor::BLACK));
+        auto left = right - 1;
 
-        const GradientStop &left = stops[leftIndex];
-        const GradientStop &right = stops[rightIndex];
-
-        if (left.position == right.position) {
-            return left.color;
-        }
-
-        float localPosition = (position - left.position) / (right.position - left.position);
-        return blendColors(left.color, right.color, localPosition);
+        float localPosition = (position - left->position) / (right->position - left->position);
+        return blendColors(left->color, right->color, localPosition);
     }
     WColor blendColors(const WColor& color1, const WColor& color2, float factor);
     SemaphoreHandle_t stripMutex;
@@ -61,19 +54,22 @@ class LEDStrip: public Output{
     TranstionsManager* transitionsManager;
     GradientManager* gradientManager;
     LEDStripJsonParser* ledStripJsonInterpreter;
-    std::function<void()> deferredCallback;
+    Timeline* timeline;
+    SceneJournal* journal;       ///< Last scene persistence, nullptr when not journaled
+    int32_t activePreset;        ///< Preset shown unmodified, -1 when none
+    PixelMap pixelMap;           ///< Logical pixels to LEDs, applied by show()
+    MatrixLayout matrix;         ///< XY view used by 2D effects, a single row by default
+    PixelCoords coords;          ///< Positions used by spatial effects, from matrix unless uploaded
+    String coordsPath;           ///< Flash file of the uploaded coordinates, empty when not stored
     
     bool isLooping;
     private:
-    uint16_t meteorPosition;
-    void stopLoop();
-    bool isCurrentlyLooping() const;
-    void processCallbacks();
-    bool isFinalCb = false;
-    bool thenLoop = false;
+    std::vector<WColor> framebuffer;   ///< Logical pixels, packed into the driver buffer by show()
     TaskHandle_t renderTaskHandle;
+    Clock* clock;
     uint32_t frameRate;
     uint32_t frameDelay;
+    volatile bool bootFrameArmed = false;
 
     static void renderTask(void* parameter);
     void renderFrame();
@@ -81,27 +77,10 @@ class LEDStrip: public Output{
     uint32_t colorToNeoPixel(const WColor& color);
     public:
     void safeSetPixelWColor(uint16_t n, const WColor& color);
-    std::vector<GradientStop> blendGradientStops(
-        const std::vector<GradientStop>& stops1,
-        const std::vector<GradientStop>& stops2,
-        float factor)
-    {
-        std::set<float> positions;
-        for (const auto& stop : stops1) positions.insert(stop.position);
-        for (const auto& stop : stops2) positions.insert(stop.position);
-        
-        std::vector<GradientStop> blended;
-        for (float pos : positions) {
-            WColor color1 = interpolateGradient(stops1, pos);
-            WColor color2 = interpolateGradient(stops2, pos);
-            blended.emplace_back(pos, blendColors(color1, color2, factor));
-        }
-        return blended;
-    }
-    
+    // Logical pixels, fewer than LEDs when the map leaves gaps
+    uint16_t numPixels() const { return framebuffer.size(); }
+    void show();
 
-    StaticJsonDocument<1> _emptyDoc;
-    JsonObject _emptyObject;
     LEDStrip(uint16_t numPixels, uint8_t pin, neoPixelType type = NEO_GRB + NEO_KHZ800);
     ~LEDStrip();
     bool begin()override;
@@ -112,6 +91,17 @@ class LEDStrip: public Output{
     
     void setFrameRate(uint32_t fps);
     uint32_t getFrameRate() const { return frameRate; }
+    uint32_t getFrameDelay() const { return frameDelay; }
+
+    // Time of the strip and its managers. Set before rendering starts;
+    // nullptr restores millis(). With a stepped clock no render task runs
+    // and the caller renders each frame with renderStep().
+    void setClock(Clock* clock);
+    uint32_t now() const { return clock->now(); }
+    void renderStep();
+    // The next frame rendered marks BOOT_FIRST_FRAME; armed at boot once the
+    // restored scene is on the strip, so a blank frame never counts
+    void armBootFrame() { bootFrameArmed = true; }
     
     
     // These methods will be implemented in the .cpp file to avoid circular dependency
@@ -137,6 +127,11 @@ class LEDStrip: public Output{
     void shiftPixels(int positions);
     void mirrorHalf(bool firstHalf = true);
     
+    bool setPixelMap(const PixelMap& map);
+    bool setMatrix(const MatrixConfig& config);
+    bool loadCoords(const String& path);
+    bool setCoords(JsonVariantConst json);
+
     void setTaskPriority(UBaseType_t priority);
     void setTaskCore(BaseType_t core);
     void jsonInterpreter(JsonObject& json)override;
@@ -4,6 +4,9 @@
 #include <wcolor.h>
 #include <vector>
 
+class MatrixLayout;
+class PixelCoords;
+
 struct GradientStop {
     float position;
     WColor color;
@@ -20,7 +23,9 @@ struct GradientStop {
     }
 };
 
-enum EffectType {
+// Row of the effect in the EffectRegistry table, stored in presets. Effects
+// added later only need a name here when code refers to them directly.
+enum EffectType : uint8_t {
     EFFECT_NONE,
     EFFECT_RAINBOW,
     EFFECT_BREATHING,
@@ -29,7 +34,10 @@ enum EffectType {
     EFFECT_CHASE,
     EFFECT_FIRE,
     EFFECT_TWINKLE,
-    EFFECT_METEOR
+    EFFECT_METEOR,
+    EFFECT_SPECTRUM,     // Audio reactive, need the AudioAnalyzer running
+    EFFECT_BEAT_PULSE,
+    EFFECT_VU_METER
 };
 
 enum TransitionType {
@@ -44,7 +52,168 @@ enum TransitionType {
     TRANSITION_EASE_OUT_CUBIC,
     TRANSITION_EASE_IN_OUT_CUBIC,
     TRANSITION_BOUNCE_OUT,
-    TRANSITION_ELASTIC_OUT
+    TRANSITION_ELASTIC_OUT,
+    TRANSITION_CUBIC_BEZIER,   // Baked from TranstionsManager::customEasing
+    TRANSITION_STEPS,
+    TRANSITION_CUSTOM
+};
+
+enum GradientAnimation {
+    GRADIENT_STATIC,
+    GRADIENT_SCROLL,   // Slides along the strip, mirrored so the motion is seamless
+    GRADIENT_ROTATE    // Wraps end to start, suited to rings and closed loops
+};
+
+// Particle emitter overrides from the "emitter" object of an effect command.
+// Only fields flagged in mask are used, the others keep the effect defaults.
+struct EmitterConfig {
+    enum Field : uint8_t {
+        RATE     = 1 << 0,
+        LIFE     = 1 << 1,
+        VELOCITY = 1 << 2,
+        SPREAD   = 1 << 3,
+        GRAVITY  = 1 << 4,
+        SIZE     = 1 << 5
+    };
+
+    uint8_t mask;
+    float rate;       ///< Particles (or bursts) per second
+    float life;       ///< Seconds
+    float velocity;   ///< Strip lengths per second
+    float spread;     ///< Random part of the velocity, 0-1
+    float gravity;    ///< Strip lengths per second squared, toward the first pixel
+    float size;       ///< Splat width, pixels
+
+    EmitterConfig() : mask(0), rate(0.0f), life(0.0f), velocity(0.0f),
+                      spread(0.0f), gravity(0.0f), size(0.0f) {}
+
+    // Overrides applied on top of the defaults of an effect
+    EmitterConfig resolve(const EmitterConfig& defaults) const {
+        EmitterConfig out = defaults;
+        if (mask & RATE) out.rate = rate;
+        if (mask & LIFE) out.life = life;
+        if (mask & VELOCITY) out.velocity = velocity;
+        if (mask & SPREAD) out.spread = spread;
+        if (mask & GRAVITY) out.gravity = gravity;
+        if (mask & SIZE) out.size = size;
+        return out;
+    }
+};
+
+// Geometry of the spatial effects from the "spatial" object of an effect
+// command, in the normalized space of PixelCoords (-1 to 1 on the longest axis)
+struct SpatialConfig {
+    float direction[3];   ///< Sweep travel, any length
+    float center[3];      ///< Pulse origin
+
+    SpatialConfig() : direction{1.0f, 0.0f, 0.0f}, center{0.0f, 0.0f, 0.0f} {}
+
+    bool isDefault() const {
+        return direction[0] == 1.0f && direction[1] == 0.0f && direction[2] == 0.0f &&
+               center[0] == 0.0f && center[1] == 0.0f && center[2] == 0.0f;
+    }
+};
+
+// Random numbers for effects: xorshift32, one generator per effect instance.
+// A few shifts per draw instead of a call into esp_random(), and the same seed
+// gives the same sequence on the device and on a host build.
+struct EffectRandom {
+    uint32_t state;
+
+    EffectRandom() : state(0x9E3779B9u) {}
+
+    // Any seed is valid, it is scrambled so that 0 and close seeds diverge
+    void seed(uint32_t value) {
+        value += 0x9E3779B9u;
+        value = (value ^ (value >> 16)) * 0x85EBCA6Bu;
+        value = (value ^ (value >> 13)) * 0xC2B2AE35u;
+        value ^= value >> 16;
+        state = value != 0 ? value : 0x9E3779B9u;
+    }
+
+    uint32_t next() {
+        uint32_t x = state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return state = x;
+    }
+
+    // [0, n), from the high bits without a division
+    uint32_t below(uint32_t n) {
+        return static_cast<uint32_t>((static_cast<uint64_t>(next()) * n) >> 32);
+    }
+
+    // [low, high), same contract as Arduino random(low, high)
+    int32_t between(int32_t low, int32_t high) {
+        return high > low ? low + static_cast<int32_t>(below(high - low)) : low;
+    }
+
+    // [0, 1)
+    float unit() {
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Four bytes per draw, for effects that need noise for every pixel
+    void fill(uint8_t* out, size_t count) {
+        while (count >= 4) {
+            uint32_t x = next();
+            out[0] = x;
+            out[1] = x >> 8;
+            out[2] = x >> 16;
+            out[3] = x >> 24;
+            out += 4;
+            count -= 4;
+        }
+        if (count > 0) {
+            uint32_t x = next();
+            while (count-- > 0) {
+                *out++ = x;
+                x >>= 8;
+            }
+        }
+    }
+};
+
+// Everything one running effect instance needs, so that several instances
+// (live effect, crossfade source and target) can render independently
+struct EffectState {
+    EffectType type;
+    float speed;
+    float intensity;
+    WColor color1, color2, color3;
+    EmitterConfig emitter;
+    SpatialConfig spatial;
+    uint32_t seed;                ///< Seed of rng at each start, 0 for a fresh one every time
+
+    // Animation state
+    uint32_t counter;
+    uint32_t lastUpdate;
+    EffectRandom rng;
+    // State of the running effect, sized by EffectRegistry for the largest one
+    std::vector<uint32_t> arena;
+
+    // Effect canvas, kept between frames so trails do not depend on the output buffer
+    std::vector<WColor> pixels;
+    const MatrixLayout* matrix;   ///< XY view of the canvas, set by EffectsManager::initializeState
+    const PixelCoords* coords;    ///< Position of every pixel, set with matrix
+
+    EffectState() : type(EFFECT_NONE), speed(1.0f), intensity(1.0f),
+                    color1(WColor::WHITE), color2(WColor::BLACK), color3(WColor::BLACK),
+                    seed(0), counter(0), lastUpdate(0), matrix(nullptr), coords(nullptr) {}
+
+    // Copy effect parameters only, leaving animation state and buffers untouched
+    void copyParams(const EffectState& other) {
+        type = other.type;
+        speed = other.speed;
+        intensity = other.intensity;
+        color1 = other.color1;
+        color2 = other.color2;
+        color3 = other.color3;
+        emitter = other.emitter;
+        spatial = other.spatial;
+        seed = other.seed;
+    }
 };
 
 struct TransitionState {
@@ -72,6 +241,17 @@ struct TransitionState {
     uint16_t targetSinglePixel = 0;
     WColor targetSinglePixelColor = WColor::BLACK;
     std::vector<WColor> targetPixels;
+
+    // Both gradient endpoints rasterized once per transition, lerped per frame
+    std::vector<WColor> sourceGradientPixels;
+    std::vector<WColor> targetGradientPixels;
+    bool gradientPrepared = false;
+    bool easingPrepared = false;
+
+    // Live effect instances rendered side by side during effect crossfades
+    EffectState sourceState;
+    EffectState targetState;
+    bool useTargetState = false;
     
     // Error handling
     bool memoryError = false;
@@ -87,10 +267,21 @@ struct TransitionState {
                        sourceGradientReverse(false) {}
 };
 
+    // Priority classes for queued commands, lowest first
+    enum CommandPriority {
+        PRIORITY_LOW = 0,      // effect parameter tweaks (speed, intensity, colors)
+        PRIORITY_NORMAL,       // scene commands (fill, gradient, effect change, pixels)
+        PRIORITY_HIGH,         // animation control
+        PRIORITY_SAFETY,       // blackout, pre-empts everything else
+        PRIORITY_CLASS_COUNT
+    };
+
     struct QueuedCommand {
-        DynamicJsonDocument* doc;
+        uint16_t offset;   // start of the command text in the scheduler text buffer
+        uint16_t length;   // serialized JSON bytes
         uint32_t priority;
         uint32_t queueTime;
+        uint32_t sequence; // FIFO order inside a priority class
     };
     #define MAX_RECURSION_DEPTH 16
         struct CommandState {
@@ -110,6 +301,7 @@ struct TransitionState {
         bool shouldBreak;
     };
     #define DEFAULT_COMMAND_TIMEOUT 2000
-    #define MAX_JSON_SIZE 2048
+    #define MAX_JSON_SIZE 2048     // largest command a scheduler accepts, serialized
     #define MAX_QUEUE_SIZE 20
+    #define MAX_QUEUED_JSON_BYTES 6144   // text of all commands queued on one scheduler
 #endif
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "networkManager.h"
 NetworkManager::NetworkManager(): asyncServer(80), ws("/ws"){
-
+    outboxLock = xSemaphoreCreateMutex();
 }
 // Utility method to send message to all WebSocket clients
 void NetworkManager::broadcastMessage(const String &message)
@@ -13,3 +13,44 @@ void NetworkManager::sendMessageToClient(uint32_t clientId, const String &messag
 {
     ws.text(clientId, message);
 }
+
+bool NetworkManager::queueMessage(const String &message)
+{
+    if (!xSemaphoreTake(outboxLock, pdMS_TO_TICKS(5))) return false;
+    bool queued = outboxCount < OUTBOX_DEPTH;
+    if (queued)
+    {
+        strlcpy(outbox[(outboxHead + outboxCount) % OUTBOX_DEPTH], message.c_str(), OUTBOX_MESSAGE_SIZE);
+        outboxCount++;
+    }
+    else
+    {
+        outboxDropped++;
+    }
+    xSemaphoreGive(outboxLock);
+    return queued;
+}
+
+void NetworkManager::flushOutbox(std::function<bool(const char*)> send)
+{
+    char text[OUTBOX_MESSAGE_SIZE];
+    while (true)
+    {
+        if (!xSemaphoreTake(outboxLock, pdMS_TO_TICKS(5))) return;
+        if (outboxCount == 0)
+        {
+            xSemaphoreGive(outboxLock);
+            return;
+        }
+        memcpy(text, outbox[outboxHead], sizeof(text));
+        xSemaphoreGive(outboxLock);
+
+        // Sent outside the lock, so a slow send never holds up queueMessage()
+        if (!send(text)) return;
+
+        xSemaphoreTake(outboxLock, portMAX_DELAY);
+        outboxHead = (outboxHead + 1) % OUTBOX_DEPTH;
+        outboxCount--;
+        xSemaphoreGive(outboxLock);
+    }
+}
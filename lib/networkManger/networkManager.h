@@ -4,6 +4,12 @@
 #include <ESPAsyncWebServer.h>  // ESPAsyncWebServer library
 #include <AsyncWebSocket.h>     // AsyncWebSocket from ESPAsyncWebServer
 #include <WebSocketsClient.h>   // For WebSocket client (outgoing connections)
+#include <functional>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define OUTBOX_DEPTH 16
+#define OUTBOX_MESSAGE_SIZE 128
 
 class NetworkManager{
 public:
@@ -13,10 +19,24 @@ public:
     void setupWebSocketServer();
     
     void sendMessageToClient(uint32_t clientId, const String& message);
+
+    // Outgoing WebSocket client text from any task, never blocks. The network
+    // loop hands it to send() in order; a message send() refuses is kept and
+    // retried on the next call
+    bool queueMessage(const String& message);
+    void flushOutbox(std::function<bool(const char*)> send);
+    uint32_t getOutboxDropped() const { return outboxDropped; }
+
     UDPManager udpManager;
     WebSocketsClient webSocket;  // For outgoing WebSocket connections
     AsyncWebServer asyncServer;  // Async HTTP server
     AsyncWebSocket ws;           // WebSocket server
+private:
+    char outbox[OUTBOX_DEPTH][OUTBOX_MESSAGE_SIZE];
+    uint8_t outboxHead = 0;
+    uint8_t outboxCount = 0;
+    uint32_t outboxDropped = 0;
+    SemaphoreHandle_t outboxLock;
 };
 
 #endif 
\ No newline at end of file
@@ -2,7 +2,10 @@
 #include <algorithm> // Pour std::remove et std::erase
 #include <ArduinoJson.h>
 #include <functional>
-#include <PrefManager.h>
+#include <ConfigStore.h>
+#include <Telemetry.h>
+#include <EffectRegistry.h>
+#include <HeapStats.h>
 #include <vector>
 #include <networkManager.h>
 
@@ -66,6 +69,7 @@ void OmniSourceRouter::onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketCl
         break;
     case WS_EVT_DATA:
     {
+        HeapStats::tagTask(ALLOC_ROUTER);
         AwsFrameInfo *info = (AwsFrameInfo *)arg;
         if (info->final && info->index == 0 && info->len == len)
         {
@@ -140,6 +144,8 @@ void OmniSourceRouter::setupHttpRoutes()
     nm->asyncServer.onRequestBody([this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
                               {
     if (request->method() == HTTP_POST) {
+        // The async TCP task, where bodies are parsed
+        HeapStats::tagTask(ALLOC_ROUTER);
         // Reconstituer le corps en String
         String body = "";
         for (size_t i = 0; i < len; i++) {
@@ -175,6 +181,26 @@ void OmniSourceRouter::setupHttpRoutes()
     nm->asyncServer.on("/", HTTP_GET, [](AsyncWebServerRequest *request)
                    { request->send(200, "text/plain", "OmniSourceRouter Server Running"); });
 
+    // Runtime stats from every registered provider
+    nm->asyncServer.on("/stats", HTTP_GET, [this](AsyncWebServerRequest *request)
+                   {
+        DynamicJsonDocument doc(2048);
+        JsonObject root = doc.to<JsonObject>();
+        this->collectStats(root);
+        String body;
+        serializeJson(doc, body);
+        request->send(200, "application/json", body); });
+
+    // Effect names and parameter ranges, for UIs
+    nm->asyncServer.on("/effects", HTTP_GET, [](AsyncWebServerRequest *request)
+                   {
+        DynamicJsonDocument doc(4096);
+        JsonArray effects = doc.to<JsonArray>();
+        EffectRegistry::describe(effects);
+        String body;
+        serializeJson(doc, body);
+        request->send(200, "application/json", body); });
+
     // Handle WebSocket upgrade requests
     nm->asyncServer.on("/ws", HTTP_GET, [](AsyncWebServerRequest *request)
                    { request->send(200, "text/plain", "WebSocket endpoint"); });
@@ -201,14 +227,10 @@ void OmniSourceRouter::webSocketEvent(WStype_t type, uint8_t *payload, size_t le
     case WStype_CONNECTED:
     {
         Serial.printf("WebSocket Client Connected to: %s\n", payload);
-        PrefManager pm;
-        DynamicJsonDocument config = pm.read("config.json");
-        String room = "orphan";
-        if(config.containsKey("room")){
-            room = config["room"].as<String>();
-            Serial.println("setFromFlash");
-        }
+        // Served from the config cache, no flash access on reconnect
+        String room = ConfigStore::getInstance().readString("config.json", "room", "orphan");
         nm->webSocket.sendTXT("{\"action\":\"join\", \"room\":\""+room+"\"}");
+        Telemetry::getInstance().announceSources();
         break;
     }
     case WStype_TEXT:
@@ -241,11 +263,20 @@ void OmniSourceRouter::handle()
 {
     if (!this->httpStarted)
     {
+        // The network loop, where WebSocket client messages are parsed
+        HeapStats::tagTask(ALLOC_ROUTER);
         nm->asyncServer.begin();
         this->httpStarted = true;
     }
     //this->udpManager.processUDP();
     nm->webSocket.loop(); // For WebSocket client
+
+    // Batched events recorded by the other tasks
+    Telemetry::getInstance().poll(millis(), [this](const uint8_t *data, size_t length)
+                                  { return nm->webSocket.isConnected() && nm->webSocket.sendBIN(data, length); });
+    // Text notifications queued by the input task, for servers without the uplink
+    nm->flushOutbox([this](const char *text)
+                    { return nm->webSocket.isConnected() && nm->webSocket.sendTXT(text); });
     
     // Process pending cooldown calls
     this->update();
@@ -294,6 +325,18 @@ void OmniSourceRouter::delCallback(String target) {
     }
 }
 
+void OmniSourceRouter::addStatsProvider(const String& name, std::function<void(JsonObject&)> provider) {
+    this->statsProviders.emplace_back(name, provider);
+}
+
+void OmniSourceRouter::collectStats(JsonObject& out) {
+    out["uptimeMs"] = millis();
+    for (auto& provider : this->statsProviders) {
+        JsonObject section = out.createNestedObject(provider.first);
+        provider.second(section);
+    }
+}
+
 // Update method to process pending calls (should be called in main loop)
 void OmniSourceRouter::update() {
     cooldownManager.processPendingCalls(routerCallbacks);
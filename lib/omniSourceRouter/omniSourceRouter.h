@@ -150,6 +150,10 @@ public:
     void addCallback(const String& target, std::function<void(JsonObject&)> callback, unsigned long cooldownMs = 1000);
     void delCallback(String target);
     
+    // Stats reporting, served as JSON on GET /stats
+    void addStatsProvider(const String& name, std::function<void(JsonObject&)> provider);
+    void collectStats(JsonObject& out);
+
     // Cooldown utility methods
     void update(); // Call this in your main loop to process pending calls
     unsigned long getRemainingCooldown(const String& target);
@@ -164,6 +168,7 @@ public:
 private:
     std::vector<std::string> sources;
     std::vector<OmniSourceRouterCallback> routerCallbacks;
+    std::vector<std::pair<String, std::function<void(JsonObject&)>>> statsProviders;
     CooldownManager cooldownManager; // Integrated cooldown system
     
     // Helper function to find callback by target
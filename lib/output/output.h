@@ -11,8 +11,17 @@ public:
     // Pure virtual functions that derived classes must implement
     virtual bool begin() = 0;
     virtual void end() = 0;
-    virtual void jsonInterpreter(JsonObject& json);
-    virtual void startRendering();
+    virtual void jsonInterpreter(JsonObject& json) { (void)json; }
+    virtual void startRendering() {}
+
+    // Local input latency probe: armed when an input rule queues a command,
+    // tagged with its scheduler sequence, completed by the first frame
+    // rendered after that command ran
+    volatile uint32_t probeStartUs = 0;
+    volatile uint32_t probeSequence = 0;
+    volatile bool probeApplied = false;
+
+    uint8_t telemetrySource = 0xFF;   ///< Telemetry source id of this output's UID
 };
 
 #endif
\ No newline at end of file
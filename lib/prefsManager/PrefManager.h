@@ -1,13 +0,0 @@
-#ifndef PREFMANAGER_H
-#define PREFMANAGER_H
-#include <ArduinoJson.h>
-
-class PrefManager {
-public:
-    static PrefManager& getInstance();
-    void write(const char* to, JsonDocument body); 
-    DynamicJsonDocument read(const char* from);
-    PrefManager(); // Constructeur privé
-};
-
-#endif // PREFMANAGER_H
\ No newline at end of file
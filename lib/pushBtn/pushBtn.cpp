@@ -1,17 +1,45 @@
 #include "pushBtn.h"
 #include <digitalInput.h>
-PushBtn::PushBtn(int pin)
+#include <InputEngine.h>
+
+PushBtn::PushBtn(int pin, bool activeLow, GestureTiming timing)
+    : pin(pin),
+      activeLow(activeLow),
+      state(false),
+      detector(timing)
+{
+    pinMode(pin, activeLow ? INPUT_PULLUP : INPUT);
+    state = (digitalRead(pin) == HIGH) != activeLow;
+    detector = GestureDetector(timing, state);
+    attachInterruptArg(digitalPinToInterrupt(pin), PushBtn::isr, this, CHANGE);
+}
+
+void IRAM_ATTR PushBtn::isr(void* arg)
 {
-    this->pin = pin;
-    this->uid = uid;
-    pinMode(pin, INPUT);
+    PushBtn* btn = static_cast<PushBtn*>(arg);
+    InputEngine::postFromISR(btn, digitalRead(btn->pin) == HIGH);
+}
+
+void PushBtn::onEdge(bool level, uint32_t timeMs){
+    detector.edge(level != activeLow, timeMs);
+}
+
+uint32_t PushBtn::msUntilDeadline(uint32_t now){
+    uint32_t deadline = detector.nextDeadline();
+    if (deadline == GestureDetector::NO_DEADLINE) return deadline;
+    int32_t remaining = static_cast<int32_t>(deadline - now);
+    return remaining > 0 ? remaining : 0;
 }
 
 void PushBtn::check(){
-    bool current = digitalRead(pin);
-    if(current != state){
-        onChangeCb(this);
-        state = current;
+    InputGesture gestures[GestureDetector::MAX_GESTURES_PER_UPDATE];
+    uint8_t count = detector.update(millis(), gestures, GestureDetector::MAX_GESTURES_PER_UPDATE);
+    for (uint8_t i = 0; i < count; i++) {
+        if (gestures[i] == GESTURE_PRESS || gestures[i] == GESTURE_RELEASE) {
+            state = gestures[i] == GESTURE_PRESS;
+            if (onChangeCb) onChangeCb(this);
+        }
+        if (onGestureCb) onGestureCb(this, gestures[i]);
     }
 }
 
@@ -21,4 +49,5 @@ bool PushBtn::getState(){
 
 PushBtn::~PushBtn()
 {
+    detachInterrupt(digitalPinToInterrupt(pin));
 }
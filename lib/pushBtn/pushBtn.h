@@ -2,23 +2,25 @@
 #define PSH_BTN_H
 #include <pushBtn.h>
 #include<digitalInput.h>
+#include <GestureDetector.h>
 
 class PushBtn: public DInput
 {
 private:
     int pin;
-    String uid;
-    bool state;
-    bool lastButtonState;  // Added this missing variable
-    unsigned long lastDebounceTime;
-    static constexpr unsigned long debounceDelay = 50; // 50 ms, tu peux ajuster
+    bool activeLow;
+    bool state;              ///< Debounced pressed state
+    GestureDetector detector;
     bool getState()override;
+    static void IRAM_ATTR isr(void* arg);
 public:
-    PushBtn(int pin);
+    PushBtn(int pin, bool activeLow = false, GestureTiming timing = GestureTiming());
     ~PushBtn()override;
+    void onEdge(bool level, uint32_t timeMs)override;
+    uint32_t msUntilDeadline(uint32_t now)override;
     void check()override;
 };
 
 
 
-#endif
\ No newline at end of file
+#endif
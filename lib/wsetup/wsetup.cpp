@@ -1,107 +1,229 @@
 #include "wsetup.h"
 #include <ArduinoJson.h>
-#include <PrefManager.h>
 #include <IOWrapper.h>
 #include <Adafruit_NeoPixel.h>
 #include <pushBtn.h>
 #include <networkManager.h>
-WSetup::WSetup(IOWrapper* wrapper, NetworkManager* nm):prefs(),config(2048)
+#include <PresetStore.h>
+#include <ConfigStore.h>
+#include <BootProfile.h>
+#include <SceneJournal.h>
+#include <InputEngine.h>
+#include <InputRules.h>
+#include <Telemetry.h>
+#include <AudioAnalyzer.h>
+#include <HeapStats.h>
+#include <esp_timer.h>
+#include <functional>
+// <UID>.json sections the IO blob only flags, parsed at boot and counted
+static void viewAtBoot(const char* uid, std::function<void(JsonVariantConst)> fn)
+{
+    int64_t start = esp_timer_get_time();
+    ConfigStore::getInstance().view((String(uid) + ".json").c_str(), fn);
+    BootProfile::countJsonRead(static_cast<uint32_t>(esp_timer_get_time() - start));
+}
+
+WSetup::WSetup(IOWrapper* wrapper, NetworkManager* nm)
 {
     this->nm = nm;
     this->wrapper = wrapper;
-    this->config = prefs.read("config.json");
-    Serial.println("📦 Config lue from wsetup:");
-    serializeJsonPretty(this->config, Serial);  // ou serializeJson(doc, Serial);
-    if (this->config.containsKey("ioIndex")) {
-        if (this->config["ioIndex"].is<JsonArray>()) {
-            JsonArray array = this->config["ioIndex"].as<JsonArray>();
-
-            for (JsonObject io : array) {
-                this->parseIO(io);
-            }
-        } else {
-            Serial.println("🛑 ioIndex n'est pas un tableau !");
-        }
+
+    ConfigStore& store = ConfigStore::getInstance();
+    store.mount();
+    BootProfile::mark(BOOT_FS_MOUNT);
+
+    // Outputs first, so the render task lights the strip while the rest boots
+    BootConfig& bootConfig = BootConfig::getInstance();
+    bootConfig.load();
+    BootProfile::mark(BOOT_CONFIG_PARSE);
+    // Outputs before inputs, so input rules can resolve their targets
+    for (const PackedIO& io : bootConfig.getEntries()) {
+        if (io.kind == PACKED_IO_LEDSTRIP) this->setupIO(io);
+    }
+    BootProfile::mark(BOOT_OUTPUT_INIT);
+    // Every strip has its restored scene: the next frame is the first lit one
+    for (LEDStrip* strip : strips) {
+        strip->armBootFrame();
+    }
+
+    // Ready before input rules can recall presets
+    PresetStore::getInstance().begin();
+
+    // Servers written before the uplink read a text message per button
+    // change, on unless config.json sets "buttonText": false
+    buttonText = true;
+    store.view("config.json", [&](JsonVariantConst config) {
+        buttonText = config["buttonText"] | true;
+    });
+
+    for (const PackedIO& io : bootConfig.getEntries()) {
+        if (io.kind != PACKED_IO_LEDSTRIP) this->setupIO(io);
     }
-}
 
+    // Not in the IO blob: only read once the strips are already rendering
+    this->setupAudio();
 
-void WSetup::parseIO(JsonObject io){
-    Serial.println("📦 Objet IO reçu :");
-    serializeJsonPretty(io, Serial);
-    Serial.println(); // Pour sauter une ligne
-    String uid = io["UID"].as<String>();
-    this->setupIO(this->prefs.read((uid+".json").c_str()));
+    wrapper->router->addStatsProvider("presets", [](JsonObject &out) {
+        PresetStore::getInstance().getStats(out);
+    });
+    wrapper->router->addStatsProvider("config", [](JsonObject &out) {
+        ConfigStore::getInstance().getStats(out);
+    });
+    wrapper->router->addStatsProvider("inputs", [](JsonObject &out) {
+        InputEngine::getStats(out);
+        JsonObject rules = out.createNestedObject("rules");
+        InputRules::getInstance().getStats(rules);
+    });
+    wrapper->router->addStatsProvider("telemetry", [nm](JsonObject &out) {
+        Telemetry::getInstance().getStats(out);
+        out["textDropped"] = nm->getOutboxDropped();
+    });
+    wrapper->router->addStatsProvider("audio", [](JsonObject &out) {
+        AudioAnalyzer::getInstance().getStats(out);
+    });
+    wrapper->router->addStatsProvider("boot", [](JsonObject &out) {
+        BootProfile::getStats(out);
+        JsonObject blob = out.createNestedObject("ioConfig");
+        BootConfig::getInstance().getStats(blob);
+    });
+    wrapper->router->addStatsProvider("heap", [](JsonObject &out) {
+        HeapStats::getStats(out);
+    });
 }
 
-void WSetup::setupIO(DynamicJsonDocument io){
-    Serial.println("io json in setupio :");
-    serializeJson(io, Serial);
-    Serial.println();
-    String type = io["type"].as<String>();
-    if(type == "ledstrip"){
+
+void WSetup::setupIO(const PackedIO& io){
+    Serial.printf("io %s : kind %u, pin %u\n", io.uid, io.kind, io.pin);
+    if(io.kind == PACKED_IO_LEDSTRIP){
         this->setupStrip(io);
     }
-    if(type == "btn"){
-        this->setupBtn(io);
+    if(io.kind == PACKED_IO_BUTTON){
+        this->setupBtn(io, buttonText);
+    }
+}
+
+void WSetup::setupAudio(){
+    AudioSource* source = nullptr;
+    uint32_t sampleRate = 22050;
+    size_t fftSize = 512;
+
+    ConfigStore::getInstance().view("config.json", [&](JsonVariantConst config) {
+        JsonVariantConst audio = config["audio"];
+        if (audio.isNull()) return;
+
+        sampleRate = audio["sampleRate"] | 22050;
+        fftSize = audio["fftSize"] | 512;
+        String kind = audio["source"] | "i2s";
+        if (kind == "synthetic") {
+            source = new SyntheticSource(audio["bpm"] | 120.0f);
+        } else if (kind == "wav") {
+            source = new WavFileSource(audio["path"] | "/spiffs/audio.wav");
+        } else {
+            JsonVariantConst pins = audio["pins"];
+            source = new I2SMicSource(pins["bck"] | 26, pins["ws"] | 25, pins["data"] | 33);
+        }
+    });
+
+    if (source == nullptr) return;
+    if (!AudioAnalyzer::getInstance().begin(source, sampleRate, fftSize)) {
+        Serial.println("Audio analyzer disabled");
     }
 }
 
-void WSetup::setupStrip(DynamicJsonDocument strip){
-    Serial.println("in setup strip ");
-    Serial.println("********");
-    Serial.println("********");
-    Serial.println("********");
-    if(strip.containsKey("UID") && 
-       strip.containsKey("ledCount") && 
-       strip.containsKey("pin") && 
-       strip.containsKey("ledType")){
-        String ledTypeStr = strip["ledType"].as<String>();
-        uint8_t ledtype = this->ledTypeFromString(ledTypeStr);
-        String uid = strip["UID"].as<String>();
-        uint16_t ledcount = strip["ledCount"].as<uint16_t>();
-        uint8_t pin = strip["pin"].as<uint8_t>();
-        Serial.println("type : " + ledTypeStr);
-        Serial.println(ledcount);
-        Serial.println(pin);
-        Serial.println("uid : " + uid);
-
-        if(ledtype > 0 &&
-            ledcount > 0 &&
-            pin >= 0
-            ){
-                Serial.println("strip pushed");
-                this->wrapper->pushOutput(new LEDStrip(ledcount, pin, ledtype), uid);
-            }
-       }
+void WSetup::setupStrip(const PackedIO& strip){
+    Serial.printf("strip pushed : %u leds on pin %u\n", strip.ledCount, strip.pin);
+    LEDStrip* ledStrip = new LEDStrip(strip.ledCount, strip.pin, strip.ledType);
+    this->wrapper->pushOutput(ledStrip, strip.uid);
+    strips.push_back(ledStrip);
+
+    // The LED order comes first, layouts and coordinates index logical pixels
+    if (strip.flags & PACKED_IO_HAS_MAP) {
+        PixelMap map;
+        bool parsed = false;
+        viewAtBoot(strip.uid, [&](JsonVariantConst io) {
+            parsed = map.parse(io["map"], strip.ledCount);
+        });
+        if (!parsed || !ledStrip->setPixelMap(map)) {
+            Serial.printf("strip %s : invalid pixel map, LEDs kept in order\n", strip.uid);
+        }
+    }
+
+    // Layouts are only parsed for strips that have one
+    if (strip.flags & PACKED_IO_HAS_LAYOUT) {
+        MatrixConfig matrix;
+        bool parsed = false;
+        viewAtBoot(strip.uid, [&](JsonVariantConst io) {
+            parsed = MatrixConfig::parse(io["matrix"], matrix);
+        });
+        if (!parsed || !ledStrip->setMatrix(matrix)) {
+            Serial.printf("strip %s : invalid matrix, kept as a line\n", strip.uid);
+        }
+    }
+
+    // Uploaded pixel positions, if any were saved for this strip
+    ledStrip->loadCoords(String("/coords_") + strip.uid + ".bin");
+
+    // Last scene is back on the strip before the network starts
+    SceneJournal* journal = new SceneJournal(ledStrip, strip.uid);
+    ledStrip->journal = journal;
+    journal->restore();
+    this->wrapper->router->addStatsProvider(String("journal_") + strip.uid, [journal](JsonObject &out) {
+        journal->getStats(out);
+    });
+    this->wrapper->router->addStatsProvider(String("coords_") + strip.uid, [ledStrip](JsonObject &out) {
+        ledStrip->coords.getStats(out);
+    });
+    this->wrapper->router->addStatsProvider(String("map_") + strip.uid, [ledStrip](JsonObject &out) {
+        ledStrip->pixelMap.getStats(out);
+    });
+    if (ledStrip->matrix.isMatrix()) {
+        this->wrapper->router->addStatsProvider(String("matrix_") + strip.uid, [ledStrip](JsonObject &out) {
+            ledStrip->matrix.getStats(out);
+        });
+    }
 }
 
-void WSetup::setupBtn(DynamicJsonDocument btn){
+void WSetup::setupBtn(const PackedIO& btn, bool sendText){
     Serial.println("in setup btn ");
     
-    int pin = btn["pin"].as<int>();
-    String uid = btn["UID"].as<String>();
+    int pin = btn.pin;
+    String uid = btn.uid;
+    GestureTiming timing;
+    timing.debounceMs = btn.debounceMs;
+    timing.doubleClickMs = btn.doubleClickMs;
+    timing.longPressMs = btn.longPressMs;
     
-    // Capture nm directly instead of this
-    NetworkManager* networkManager = this->nm;
-    
-    wrapper->pushDigitalInput(new PushBtn(pin), uid, [uid, networkManager](DInput* btn){
-        Serial.println("btn changed from setup");
-        Serial.println(uid);
-        String s = btn->getState() ? "true" : "false";
-        if (networkManager) {
-            networkManager->webSocket.sendTXT("btn changed from setup, UID : " + uid + ", state : " + s);
-        } else {
-            Serial.println("NetworkManager not available");
+    // Rules are only parsed for inputs that have some
+    InputRuleSet* rules = nullptr;
+    if (btn.flags & PACKED_IO_HAS_RULES) {
+        viewAtBoot(btn.uid, [&](JsonVariantConst io) {
+            rules = InputRules::getInstance().compile(io, this->wrapper);
+        });
+    }
+
+    // Events are batched into the telemetry uplink, sent by the network loop
+    uint8_t source = Telemetry::getInstance().registerSource(uid);
+
+    PushBtn* pushBtn = new PushBtn(pin, btn.flags & PACKED_IO_ACTIVE_LOW, timing);
+    pushBtn->onGesture([rules, source](DInput* input, InputGesture gesture){
+        // Local outputs first, the server only hears about it afterwards
+        if (rules) {
+            InputRules::getInstance().dispatch(*rules, gesture, input->lastEdgeUs);
+        }
+        if (gesture >= GESTURE_CLICK) {
+            Telemetry::getInstance().record(TELEMETRY_GESTURE, source, gesture, 0);
         }
     });
-}
+    // The legacy text message is queued here and sent by the network loop
+    NetworkManager* networkManager = sendText ? this->nm : nullptr;
 
-uint8_t WSetup::ledTypeFromString(const String& typeStr) {
-    if(typeStr == "NEO_GRB + NEO_KHZ800") return NEO_GRB | NEO_KHZ800;
-    if(typeStr == "NEO_GRB") return NEO_GRB;
-    if(typeStr == "NEO_KHZ800") return NEO_KHZ800;
-    return 0; // inconnu
+    wrapper->pushDigitalInput(pushBtn, uid, [source, uid, networkManager](DInput* btn){
+        Telemetry::getInstance().record(TELEMETRY_INPUT_CHANGE, source, 0, btn->getState() ? 1 : 0);
+        if (networkManager) {
+            String s = btn->getState() ? "true" : "false";
+            networkManager->queueMessage("btn changed from setup, UID : " + uid + ", state : " + s);
+        }
+    });
 }
 
 WSetup::~WSetup()
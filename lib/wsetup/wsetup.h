@@ -2,28 +2,30 @@
 #define WSETUP_H
 
 #include <ArduinoJson.h>
-#include <PrefManager.h>
 #include <omniSourceRouter.h>
 #include <IOWrapper.h>
 #include <networkManager.h>
+#include <BootConfig.h>
+#include <vector>
+
+class LEDStrip;
 
 
 class WSetup
 {
 private:
     NetworkManager* nm;
-    DynamicJsonDocument config;
-    PrefManager prefs;
-    void parseIO(JsonObject io);
-    void setupIO(DynamicJsonDocument io);
-    void setupStrip(DynamicJsonDocument strip);
-    void setupBtn(DynamicJsonDocument strip);
+    void setupIO(const PackedIO& io);
+    void setupStrip(const PackedIO& strip);
+    void setupBtn(const PackedIO& btn, bool sendText);
+    void setupAudio();
     IOWrapper* wrapper;
-    uint8_t ledTypeFromString(const String& typeStr);
+    std::vector<LEDStrip*> strips;   ///< Set up at boot, in blob order
+    bool buttonText;                 ///< config.json "buttonText", read once at boot
 public:
     WSetup(IOWrapper* wrapper, NetworkManager* nm);
     ~WSetup();
 };
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,129 @@
+#include "Adafruit_NeoPixel.h"
+#include <mutex>
+
+static std::mutex hookMutex;
+static Adafruit_NeoPixel::ShowHook showHook;
+
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t pin, neoPixelType type)
+    : numLEDs(0), pin(pin), brightness(0), shows(0)
+{
+    updateType(type);
+    updateLength(n);
+}
+
+Adafruit_NeoPixel::Adafruit_NeoPixel() : Adafruit_NeoPixel(0, -1, NEO_GRB + NEO_KHZ800) {}
+
+void Adafruit_NeoPixel::updateLength(uint16_t n)
+{
+    numLEDs = n;
+    pixels.assign(static_cast<size_t>(n) * bytesPerPixel(), 0);
+}
+
+void Adafruit_NeoPixel::updateType(neoPixelType type)
+{
+    bool hadWhite = !pixels.empty() && hasWhite();
+    wOffset = (type >> 6) & 0b11;
+    rOffset = (type >> 4) & 0b11;
+    gOffset = (type >> 2) & 0b11;
+    bOffset = type & 0b11;
+    if (!pixels.empty() && hadWhite != hasWhite()) updateLength(numLEDs);
+}
+
+void Adafruit_NeoPixel::show()
+{
+    shows++;
+    ShowHook hook;
+    {
+        std::lock_guard<std::mutex> lock(hookMutex);
+        hook = showHook;
+    }
+    if (hook) hook(*this);
+}
+
+void Adafruit_NeoPixel::setShowHook(ShowHook hook)
+{
+    std::lock_guard<std::mutex> lock(hookMutex);
+    showHook = hook;
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b)
+{
+    setPixelColor(n, r, g, b, 0);
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+{
+    if (n >= numLEDs) return;
+    if (brightness) {
+        r = (r * brightness) >> 8;
+        g = (g * brightness) >> 8;
+        b = (b * brightness) >> 8;
+        w = (w * brightness) >> 8;
+    }
+    uint8_t* p = &pixels[static_cast<size_t>(n) * bytesPerPixel()];
+    p[rOffset] = r;
+    p[gOffset] = g;
+    p[bOffset] = b;
+    if (hasWhite()) p[wOffset] = w;
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c)
+{
+    setPixelColor(n, (c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF, (c >> 24) & 0xFF);
+}
+
+// Brightness is lossy: the stored bytes are scaled back up, as in the library
+uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const
+{
+    if (n >= numLEDs) return 0;
+    const uint8_t* p = &pixels[static_cast<size_t>(n) * bytesPerPixel()];
+    uint32_t r = p[rOffset], g = p[gOffset], b = p[bOffset];
+    uint32_t w = hasWhite() ? p[wOffset] : 0;
+    if (brightness) {
+        r = (r << 8) / brightness;
+        g = (g << 8) / brightness;
+        b = (b << 8) / brightness;
+        w = (w << 8) / brightness;
+    }
+    return (w << 24) | (r << 16) | (g << 8) | b;
+}
+
+uint32_t Adafruit_NeoPixel::shownColor(uint16_t n) const
+{
+    if (n >= numLEDs) return 0;
+    const uint8_t* p = &pixels[static_cast<size_t>(n) * bytesPerPixel()];
+    return (static_cast<uint32_t>(p[rOffset]) << 16) | (static_cast<uint32_t>(p[gOffset]) << 8) | p[bOffset];
+}
+
+void Adafruit_NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count)
+{
+    if (first >= numLEDs) return;
+    uint16_t end = count == 0 ? numLEDs : std::min<uint32_t>(numLEDs, first + count);
+    for (uint16_t i = first; i < end; i++) setPixelColor(i, c);
+}
+
+void Adafruit_NeoPixel::clear()
+{
+    std::fill(pixels.begin(), pixels.end(), 0);
+}
+
+void Adafruit_NeoPixel::setBrightness(uint8_t b)
+{
+    uint8_t newBrightness = b + 1;
+    if (newBrightness == brightness) return;
+
+    // Rescale what is already in the buffer
+    uint8_t oldBrightness = brightness - 1;
+    uint16_t scale;
+    if (oldBrightness == 0) {
+        scale = 0;
+    } else if (b == 255) {
+        scale = 65535 / oldBrightness;
+    } else {
+        scale = ((static_cast<uint16_t>(newBrightness) << 8) - 1) / oldBrightness;
+    }
+    for (uint8_t& c : pixels) {
+        c = (c * scale) >> 8;
+    }
+    brightness = newBrightness;
+}
@@ -0,0 +1,85 @@
+#ifndef HOST_ADAFRUIT_NEOPIXEL_H
+#define HOST_ADAFRUIT_NEOPIXEL_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+typedef uint16_t neoPixelType;
+
+// Color order: byte offsets of white, red, green and blue, as in the library
+#define NEO_RGB ((0 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_RBG ((0 << 6) | (0 << 4) | (2 << 2) | (1))
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_GBR ((2 << 6) | (2 << 4) | (0 << 2) | (1))
+#define NEO_BRG ((1 << 6) | (1 << 4) | (2 << 2) | (0))
+#define NEO_BGR ((2 << 6) | (2 << 4) | (1 << 2) | (0))
+#define NEO_RGBW ((3 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_GRBW ((3 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_KHZ800 0x0000
+#define NEO_KHZ400 0x0100
+
+/**
+ * @brief NeoPixel driver writing to memory instead of a data pin
+ *
+ * The pixel buffer is laid out and brightness scaled as the real library
+ * does, so getPixels() holds the exact bytes the LEDs would receive.
+ * show() counts frames and hands the buffer to the host show hook.
+ */
+class Adafruit_NeoPixel {
+public:
+    // Host only: called from whichever task calls show(), with the strip's buffer
+    typedef std::function<void(const Adafruit_NeoPixel&)> ShowHook;
+
+    Adafruit_NeoPixel(uint16_t n, int16_t pin = 6, neoPixelType type = NEO_GRB + NEO_KHZ800);
+    Adafruit_NeoPixel();
+
+    bool begin() { return true; }
+    void show();
+    bool canShow() const { return true; }
+    void setPin(int16_t p) { pin = p; }
+    void updateLength(uint16_t n);
+    void updateType(neoPixelType type);
+
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+    void setPixelColor(uint16_t n, uint32_t c);
+    uint32_t getPixelColor(uint16_t n) const;
+    void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0);
+    void clear();
+
+    void setBrightness(uint8_t b);
+    uint8_t getBrightness() const { return brightness - 1; }
+
+    uint8_t* getPixels() { return pixels.data(); }
+    const uint8_t* getPixels() const { return pixels.data(); }
+    uint16_t numPixels() const { return numLEDs; }
+    int16_t getPin() const { return pin; }
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b)
+    {
+        return (static_cast<uint32_t>(r) << 16) | (static_cast<uint32_t>(g) << 8) | b;
+    }
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+    {
+        return (static_cast<uint32_t>(w) << 24) | Color(r, g, b);
+    }
+
+    // Host only: the displayed color of LED n, brightness applied, as 0xRRGGBB
+    uint32_t shownColor(uint16_t n) const;
+    uint32_t showCount() const { return shows; }
+    bool hasWhite() const { return wOffset != rOffset; }
+    static void setShowHook(ShowHook hook);
+
+private:
+    uint16_t numLEDs;
+    int16_t pin;
+    uint8_t brightness;   ///< Stored plus one, 0 meaning full scale, as in the library
+    uint8_t rOffset, gOffset, bOffset, wOffset;
+    std::vector<uint8_t> pixels;
+    uint32_t shows;
+
+    uint8_t bytesPerPixel() const { return hasWhite() ? 4 : 3; }
+};
+
+#endif // HOST_ADAFRUIT_NEOPIXEL_H
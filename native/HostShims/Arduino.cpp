@@ -0,0 +1,273 @@
+#include "Arduino.h"
+#include "esp_timer.h"
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static std::chrono::steady_clock::time_point startTime()
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return start;
+}
+
+// Started before main, so the first caller does not reset the origin
+[[maybe_unused]] static const bool clockStarted = (startTime(), true);
+
+unsigned long millis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime()).count();
+}
+
+unsigned long micros()
+{
+    // Wraps at 32 bits like the device, so elapsed time math sees the same overflow
+    return static_cast<uint32_t>(esp_timer_get_time());
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime()).count();
+}
+
+void delay(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield()
+{
+    std::this_thread::yield();
+}
+
+// random() is deterministic until randomSeed(), as in the Arduino core
+static std::mutex randomMutex;
+static std::mt19937 randomEngine(1);
+
+long random(long max)
+{
+    if (max <= 0) return 0;
+    std::lock_guard<std::mutex> lock(randomMutex);
+    return std::uniform_int_distribution<long>(0, max - 1)(randomEngine);
+}
+
+long random(long min, long max)
+{
+    if (min >= max) return min;
+    return min + random(max - min);
+}
+
+void randomSeed(unsigned long seed)
+{
+    if (seed == 0) return;
+    std::lock_guard<std::mutex> lock(randomMutex);
+    randomEngine.seed(static_cast<uint32_t>(seed));
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+    if (inMax == inMin) return outMin;
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t strlcpy(char* dst, const char* src, size_t size)
+{
+    size_t length = strlen(src);
+    if (size > 0) {
+        size_t n = length < size - 1 ? length : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return length;
+}
+
+size_t strlcat(char* dst, const char* src, size_t size)
+{
+    size_t used = strnlen(dst, size);
+    if (used == size) return size + strlen(src);
+    return used + strlcpy(dst + used, src, size - used);
+}
+#endif
+
+uint32_t esp_random(void)
+{
+    static std::mutex mutex;
+    static std::mt19937 engine(std::random_device{}());
+    std::lock_guard<std::mutex> lock(mutex);
+    return engine();
+}
+
+void esp_restart(void)
+{
+    fflush(stdout);
+    Serial.flush();
+    std::_Exit(0);
+}
+
+void EspClass::restart()
+{
+    esp_restart();
+}
+
+// GPIO
+
+static const uint8_t PIN_COUNT = 64;
+
+struct HostPin {
+    uint8_t level = LOW;
+    int mode = 0;
+    void (*isr)(void*) = nullptr;
+    void* arg = nullptr;
+};
+
+static HostPin pins[PIN_COUNT];
+static std::mutex pinMutex;
+
+static void plainIsr(void* isr)
+{
+    reinterpret_cast<void (*)(void)>(isr)();
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin >= PIN_COUNT) return;
+    std::lock_guard<std::mutex> lock(pinMutex);
+    if (mode == INPUT_PULLUP) pins[pin].level = HIGH;
+    if (mode == INPUT_PULLDOWN) pins[pin].level = LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level)
+{
+    if (pin >= PIN_COUNT) return;
+    std::lock_guard<std::mutex> lock(pinMutex);
+    pins[pin].level = level ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (pin >= PIN_COUNT) return LOW;
+    std::lock_guard<std::mutex> lock(pinMutex);
+    return pins[pin].level;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode)
+{
+    attachInterruptArg(pin, plainIsr, reinterpret_cast<void*>(isr), mode);
+}
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode)
+{
+    if (pin >= PIN_COUNT) return;
+    std::lock_guard<std::mutex> lock(pinMutex);
+    pins[pin].isr = isr;
+    pins[pin].arg = arg;
+    pins[pin].mode = mode;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    if (pin >= PIN_COUNT) return;
+    std::lock_guard<std::mutex> lock(pinMutex);
+    pins[pin].isr = nullptr;
+    pins[pin].arg = nullptr;
+}
+
+// The handler runs on the calling thread, standing in for the interrupt
+void hostPinWrite(uint8_t pin, uint8_t level)
+{
+    if (pin >= PIN_COUNT) return;
+    void (*isr)(void*) = nullptr;
+    void* arg = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(pinMutex);
+        HostPin& p = pins[pin];
+        uint8_t previous = p.level;
+        p.level = level ? HIGH : LOW;
+        bool fires = p.level != previous &&
+                     (p.mode == CHANGE || (p.mode == RISING && p.level == HIGH) ||
+                      (p.mode == FALLING && p.level == LOW));
+        if (fires) {
+            isr = p.isr;
+            arg = p.arg;
+        }
+    }
+    if (isr) isr(arg);
+}
+
+// Serial
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    if (!out) return 1;
+    fputc(c, out);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+    if (!out) return size;
+    return fwrite(buffer, 1, size, out);
+}
+
+void HardwareSerial::flush()
+{
+    if (out) fflush(out);
+}
+
+// Print and Stream
+
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+    size_t n = 0;
+    while (n < size && write(buffer[n])) n++;
+    return n;
+}
+
+size_t Print::printf(const char* format, ...)
+{
+    char small[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(small, sizeof(small), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+    if (static_cast<size_t>(length) < sizeof(small)) {
+        return write(reinterpret_cast<const uint8_t*>(small), length);
+    }
+
+    std::string large(length + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&large[0], large.size(), format, args);
+    va_end(args);
+    return write(reinterpret_cast<const uint8_t*>(large.data()), length);
+}
+
+size_t Stream::readBytes(char* buffer, size_t length)
+{
+    size_t n = 0;
+    while (n < length) {
+        int c = read();
+        if (c < 0) break;
+        buffer[n++] = static_cast<char>(c);
+    }
+    return n;
+}
+
+String Stream::readString()
+{
+    String out;
+    int c;
+    while ((c = read()) >= 0) out += static_cast<char>(c);
+    return out;
+}
@@ -0,0 +1,140 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Host stand-in for the ESP32 Arduino core, enough for the firmware
+// libraries: time, GPIO, random numbers, String, Serial and the ESP object.
+// Nothing here talks to hardware; pins are a table that tests can drive.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <avr/pgmspace.h>
+#include "WString.h"
+#include "Print.h"
+#include "IPAddress.h"
+#include "esp_system.h"
+
+using std::min;
+using std::max;
+using std::isnan;
+using std::isinf;
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef unsigned int word;
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+#define sq(x) ((x) * (x))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bit(b) (1UL << (b))
+
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+#define IRAM_ATTR
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define digitalPinToInterrupt(p) (p)
+
+// newlib has these on the device, glibc only from 2.38
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t strlcpy(char* dst, const char* src, size_t size);
+size_t strlcat(char* dst, const char* src, size_t size);
+#endif
+
+// Time since the program started, from the steady clock
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+// Pins keep the last level written, interrupts fire on hostPinWrite
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+// Host only: drives an input pin the way a button or sensor would
+void hostPinWrite(uint8_t pin, uint8_t level);
+
+/**
+ * @brief Serial port printing to a host stream, stderr by default
+ *
+ * Reads from stdin are not wired: the firmware never reads Serial.
+ */
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    void flush() override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    operator bool() const { return true; }
+
+    // Host only: nullptr silences the firmware logs
+    void setOutput(FILE* stream) { out = stream; }
+
+private:
+    FILE* out = stderr;
+};
+
+extern HardwareSerial Serial;
+
+/**
+ * @brief The ESP object, reporting a fixed heap on the host
+ *
+ * Tests lower hostFreeHeap and hostLargestBlock to play a low or
+ * fragmented heap.
+ */
+class EspClass {
+public:
+    uint32_t getHeapSize() { return 327680; }
+    uint32_t getFreeHeap() { return hostFreeHeap; }
+    uint32_t getMinFreeHeap() { return hostFreeHeap; }
+    uint32_t getMaxAllocHeap() { return hostLargestBlock; }
+    uint8_t getChipRevision() { return 3; }
+    uint32_t getCpuFreqMHz() { return 240; }
+    const char* getSdkVersion() { return "host"; }
+    void restart();
+
+    uint32_t hostFreeHeap = 262144;
+    uint32_t hostLargestBlock = 114688;
+};
+
+extern EspClass ESP;
+
+#endif // HOST_ARDUINO_H
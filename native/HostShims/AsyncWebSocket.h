@@ -0,0 +1,80 @@
+#ifndef HOST_ASYNCWEBSOCKET_H
+#define HOST_ASYNCWEBSOCKET_H
+
+#include <ESPAsyncWebServer.h>
+
+typedef enum {
+    WS_EVT_CONNECT,
+    WS_EVT_DISCONNECT,
+    WS_EVT_PONG,
+    WS_EVT_ERROR,
+    WS_EVT_DATA
+} AwsEventType;
+
+typedef enum {
+    WS_CONTINUATION,
+    WS_TEXT,
+    WS_BINARY,
+    WS_DISCONNECT = 0x08,
+    WS_PING,
+    WS_PONG
+} AwsFrameType;
+
+typedef struct {
+    uint8_t message_opcode;
+    uint32_t num;
+    uint8_t final;
+    uint8_t masked;
+    uint8_t opcode;
+    uint64_t len;
+    uint8_t mask[4];
+    uint64_t index;
+} AwsFrameInfo;
+
+class AsyncWebSocket;
+
+class AsyncWebSocketClient {
+public:
+    explicit AsyncWebSocketClient(uint32_t id) : clientId(id) {}
+    uint32_t id() const { return clientId; }
+    IPAddress remoteIP() const { return IPAddress(127, 0, 0, 1); }
+
+private:
+    uint32_t clientId;
+};
+
+typedef std::function<void(AsyncWebSocket*, AsyncWebSocketClient*, AwsEventType, void*, uint8_t*, size_t)> AwsEventHandler;
+
+/**
+ * @brief WebSocket endpoint without clients; hostReceive() stands in for one
+ */
+class AsyncWebSocket : public AsyncWebHandler {
+public:
+    explicit AsyncWebSocket(const String& url) : url(url) {}
+
+    void onEvent(AwsEventHandler handler) { eventHandler = handler; }
+    void textAll(const String& message) { (void)message; }
+    void text(uint32_t id, const String& message) { (void)id; (void)message; }
+    void cleanupClients() {}
+    size_t count() const { return 0; }
+
+    // Host only: a complete text frame from client 1
+    void hostReceive(const String& message)
+    {
+        if (!eventHandler) return;
+        AsyncWebSocketClient client(1);
+        AwsFrameInfo info = {};
+        info.final = 1;
+        info.opcode = WS_TEXT;
+        info.message_opcode = WS_TEXT;
+        info.len = message.length();
+        eventHandler(this, &client, WS_EVT_DATA, &info,
+                     reinterpret_cast<uint8_t*>(const_cast<char*>(message.c_str())), message.length());
+    }
+
+private:
+    String url;
+    AwsEventHandler eventHandler;
+};
+
+#endif // HOST_ASYNCWEBSOCKET_H
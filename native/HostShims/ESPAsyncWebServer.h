@@ -0,0 +1,134 @@
+#ifndef HOST_ESPASYNCWEBSERVER_H
+#define HOST_ESPASYNCWEBSERVER_H
+
+// The routes the firmware registers, served in process: nothing listens on
+// a socket, hostRequest() plays a request through the handlers
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+typedef enum {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_DELETE = 0b00000100,
+    HTTP_PUT = 0b00001000,
+    HTTP_PATCH = 0b00010000,
+    HTTP_HEAD = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY = 0b01111111
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServerRequest {
+public:
+    AsyncWebServerRequest(WebRequestMethodComposite method, const String& url) : requestMethod(method), requestUrl(url) {}
+
+    WebRequestMethodComposite method() const { return requestMethod; }
+    const String& url() const { return requestUrl; }
+    void send(int code, const String& contentType = String(), const String& content = String())
+    {
+        responseCode = code;
+        responseType = contentType;
+        responseBody = content;
+    }
+
+    int responseCode = 0;   ///< 0 until a handler answered
+    String responseType;
+    String responseBody;
+
+private:
+    WebRequestMethodComposite requestMethod;
+    String requestUrl;
+};
+
+typedef std::function<void(AsyncWebServerRequest*)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest*, uint8_t*, size_t, size_t, size_t)> ArBodyHandlerFunction;
+
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() = default;
+    virtual bool canHandle(AsyncWebServerRequest* request) { (void)request; return false; }
+    virtual void handleRequest(AsyncWebServerRequest* request) { (void)request; }
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+public:
+    AsyncCallbackWebHandler(const String& uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest)
+        : uri(uri), method(method), onRequest(onRequest) {}
+
+    // "/x*" matches by prefix, "/x" itself and what is below it otherwise
+    bool canHandle(AsyncWebServerRequest* request) override
+    {
+        if (!(method & request->method())) return false;
+        const String& url = request->url();
+        if (uri.length() > 0 && uri.charAt(uri.length() - 1) == '*') {
+            return url.startsWith(uri.substring(0, uri.length() - 1));
+        }
+        return url == uri || url.startsWith(uri + "/");
+    }
+    void handleRequest(AsyncWebServerRequest* request) override { if (onRequest) onRequest(request); }
+
+private:
+    String uri;
+    WebRequestMethodComposite method;
+    ArRequestHandlerFunction onRequest;
+};
+
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t port) : port(port) {}
+    ~AsyncWebServer()
+    {
+        for (AsyncWebHandler* handler : owned) delete handler;
+    }
+
+    void begin() {}
+    void end() {}
+    void reset() { handlers.clear(); }
+
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest)
+    {
+        AsyncCallbackWebHandler* handler = new AsyncCallbackWebHandler(uri, method, onRequest);
+        owned.push_back(handler);
+        handlers.push_back(handler);
+        return *handler;
+    }
+    AsyncWebHandler& addHandler(AsyncWebHandler* handler)
+    {
+        handlers.push_back(handler);
+        return *handler;
+    }
+    void onNotFound(ArRequestHandlerFunction fn) { notFound = fn; }
+    void onRequestBody(ArBodyHandlerFunction fn) { body = fn; }
+
+    // Host only: the body goes to the body callback, then the first handler
+    // that accepts the request answers it. Returns the status code.
+    int hostRequest(WebRequestMethod method, const String& url, const String& content = String(),
+                    String* response = nullptr);
+
+private:
+    uint16_t port;
+    std::vector<AsyncWebHandler*> handlers;
+    std::vector<AsyncWebHandler*> owned;
+    ArRequestHandlerFunction notFound;
+    ArBodyHandlerFunction body;
+};
+
+class DefaultHeaders {
+public:
+    static DefaultHeaders& Instance()
+    {
+        static DefaultHeaders instance;
+        return instance;
+    }
+    void addHeader(const String& name, const String& value) { headers.emplace_back(name, value); }
+
+private:
+    std::vector<std::pair<String, String>> headers;
+};
+
+#include "AsyncWebSocket.h"
+
+#endif // HOST_ESPASYNCWEBSERVER_H
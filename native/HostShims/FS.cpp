@@ -0,0 +1,215 @@
+#include "FS.h"
+#include "SPIFFS.h"
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <filesystem>
+
+namespace fs {
+
+struct HostFile {
+    FILE* file = nullptr;
+    std::string path;   ///< As the firmware named it, "/config.json"
+
+    ~HostFile()
+    {
+        if (file) fclose(file);
+    }
+};
+
+size_t File::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buffer, size_t size)
+{
+    if (!impl || !impl->file) return 0;
+    return fwrite(buffer, 1, size, impl->file);
+}
+
+void File::flush()
+{
+    if (impl && impl->file) fflush(impl->file);
+}
+
+int File::available()
+{
+    if (!impl || !impl->file) return 0;
+    return static_cast<int>(size() - position());
+}
+
+int File::read()
+{
+    if (!impl || !impl->file) return -1;
+    int c = fgetc(impl->file);
+    return c == EOF ? -1 : c;
+}
+
+int File::peek()
+{
+    if (!impl || !impl->file) return -1;
+    int c = fgetc(impl->file);
+    if (c == EOF) return -1;
+    ungetc(c, impl->file);
+    return c;
+}
+
+size_t File::read(uint8_t* buffer, size_t size)
+{
+    if (!impl || !impl->file) return 0;
+    return fread(buffer, 1, size, impl->file);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode)
+{
+    if (!impl || !impl->file) return false;
+    int whence = mode == SeekCur ? SEEK_CUR : mode == SeekEnd ? SEEK_END : SEEK_SET;
+    return fseek(impl->file, pos, whence) == 0;
+}
+
+size_t File::position() const
+{
+    if (!impl || !impl->file) return 0;
+    long pos = ftell(impl->file);
+    return pos < 0 ? 0 : static_cast<size_t>(pos);
+}
+
+// From the file itself, so writes through another handle are counted
+size_t File::size() const
+{
+    if (!impl || !impl->file) return 0;
+    fflush(impl->file);
+    struct stat info;
+    if (fstat(fileno(impl->file), &info) != 0) return 0;
+    return static_cast<size_t>(info.st_size);
+}
+
+void File::close()
+{
+    impl.reset();
+}
+
+const char* File::path() const
+{
+    return impl ? impl->path.c_str() : nullptr;
+}
+
+const char* File::name() const
+{
+    if (!impl) return nullptr;
+    size_t slash = impl->path.rfind('/');
+    return impl->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+File::operator bool() const
+{
+    return impl && impl->file;
+}
+
+std::string FS::hostPath(const char* path) const
+{
+    std::string relative = path ? path : "";
+    while (!relative.empty() && relative[0] == '/') relative.erase(0, 1);
+    return (std::filesystem::path(root) / relative).string();
+}
+
+File FS::open(const char* path, const char* mode, bool create)
+{
+    (void)create;
+    std::string full = hostPath(path);
+    const char* hostMode = "rb";
+    if (mode[0] == 'w') hostMode = "wb";
+    if (mode[0] == 'a') hostMode = "ab";
+    if (mode[0] != 'r') {
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(full).parent_path(), error);
+    }
+
+    FILE* file = fopen(full.c_str(), hostMode);
+    if (!file) return File();
+    auto impl = std::make_shared<HostFile>();
+    impl->file = file;
+    impl->path = path;
+    return File(impl);
+}
+
+bool FS::exists(const char* path)
+{
+    std::error_code error;
+    return std::filesystem::exists(hostPath(path), error);
+}
+
+bool FS::remove(const char* path)
+{
+    std::error_code error;
+    return std::filesystem::remove(hostPath(path), error);
+}
+
+// Fails onto an existing file, as on SPIFFS
+bool FS::rename(const char* from, const char* to)
+{
+    if (exists(to)) return false;
+    std::error_code error;
+    std::filesystem::rename(hostPath(from), hostPath(to), error);
+    return !error;
+}
+
+bool FS::mkdir(const char* path)
+{
+    std::error_code error;
+    std::filesystem::create_directories(hostPath(path), error);
+    return !error;
+}
+
+bool FS::rmdir(const char* path)
+{
+    std::error_code error;
+    return std::filesystem::remove(hostPath(path), error);
+}
+
+bool SPIFFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel)
+{
+    (void)formatOnFail;
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    if (root.empty()) {
+        const char* env = getenv("LEDSIM_SPIFFS");
+        std::error_code error;
+        root = env ? std::string(env)
+                   : (std::filesystem::temp_directory_path(error) / "spiffs").string();
+    }
+    std::error_code error;
+    std::filesystem::create_directories(root, error);
+    return !error;
+}
+
+bool SPIFFSFS::format()
+{
+    if (root.empty()) return false;
+    std::error_code error;
+    std::filesystem::remove_all(root, error);
+    std::filesystem::create_directories(root, error);
+    return !error;
+}
+
+// Same size as the default 1.5 MB SPIFFS partition
+size_t SPIFFSFS::totalBytes()
+{
+    return 1507328;
+}
+
+size_t SPIFFSFS::usedBytes()
+{
+    size_t used = 0;
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator(root, error);
+         !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        if (it->is_regular_file(error)) used += it->file_size(error);
+    }
+    return used;
+}
+
+} // namespace fs
+
+fs::SPIFFSFS SPIFFS;
@@ -0,0 +1,93 @@
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+struct HostFile;
+
+/**
+ * @brief Open file handle; copies share it, the last one closes it
+ */
+class File : public Stream {
+public:
+    File() {}
+    explicit File(std::shared_ptr<HostFile> impl) : impl(impl) {}
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    void flush() override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buffer, size_t size);
+    size_t readBytes(char* buffer, size_t length) override { return read(reinterpret_cast<uint8_t*>(buffer), length); }
+    using Stream::readBytes;
+
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    const char* path() const;
+    const char* name() const;
+    bool isDirectory() const { return false; }
+    operator bool() const;
+
+private:
+    std::shared_ptr<HostFile> impl;
+};
+
+/**
+ * @brief Flash file system backed by a directory of the host
+ */
+class FS {
+public:
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    File open(const String& path, const char* mode = FILE_READ, bool create = false)
+    {
+        return open(path.c_str(), mode, create);
+    }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+    bool rmdir(const char* path);
+    bool rmdir(const String& path) { return rmdir(path.c_str()); }
+
+    // Host only: directory holding the files, created on begin
+    void setRoot(const std::string& directory) { root = directory; }
+    const std::string& getRoot() const { return root; }
+
+protected:
+    std::string root;
+    std::string hostPath(const char* path) const;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif // HOST_FS_H
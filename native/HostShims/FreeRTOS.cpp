@@ -0,0 +1,214 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <Arduino.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct HostTask {
+    std::string name;
+    UBaseType_t priority = 1;
+    std::mutex mutex;
+    std::condition_variable notified;
+    uint32_t notifications = 0;
+};
+
+struct HostSemaphore {
+    std::mutex mutex;
+    std::condition_variable released;
+    UBaseType_t count;
+    UBaseType_t maxCount;
+};
+
+// Set for tasks started here; other threads get a handle on first use.
+// Handles outlive their task so a late vTaskDelete or notify stays harmless.
+static thread_local HostTask* currentTask = nullptr;
+
+template <typename Predicate>
+static bool waitTicks(std::condition_variable& cv, std::unique_lock<std::mutex>& lock,
+                      TickType_t ticks, Predicate ready)
+{
+    if (ticks == portMAX_DELAY) {
+        cv.wait(lock, ready);
+        return true;
+    }
+    return cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+// Tasks
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                                   void* parameter, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core)
+{
+    (void)stackDepth;
+    (void)core;
+    HostTask* task = new HostTask();
+    task->name = name ? name : "";
+    task->priority = priority;
+    // Published before the task runs, like the FreeRTOS handle
+    if (handle) *handle = task;
+
+    std::thread([function, parameter, task]() {
+        currentTask = task;
+        function(parameter);
+    }).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                       void* parameter, UBaseType_t priority, TaskHandle_t* handle)
+{
+    return xTaskCreatePinnedToCore(function, name, stackDepth, parameter, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    (void)task;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t increment)
+{
+    *previousWake += increment;
+    int32_t remaining = static_cast<int32_t>(*previousWake - xTaskGetTickCount());
+    if (remaining > 0) {
+        vTaskDelay(remaining);
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return static_cast<TickType_t>(millis());
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (!currentTask) {
+        currentTask = new HostTask();
+        currentTask->name = "host";
+    }
+    return currentTask;
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority)
+{
+    if (!task) task = xTaskGetCurrentTaskHandle();
+    task->priority = priority;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    if (!task) task = xTaskGetCurrentTaskHandle();
+    return task->priority;
+}
+
+// Thread stacks are megabytes on the host, never the limit
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    (void)task;
+    return 4096;
+}
+
+const char* pcTaskGetName(TaskHandle_t task)
+{
+    if (!task) task = xTaskGetCurrentTaskHandle();
+    return task->name.c_str();
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    if (!task) return pdFAIL;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->notifications++;
+    }
+    task->notified.notify_one();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken)
+{
+    xTaskNotifyGive(task);
+    if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdFALSE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait)
+{
+    HostTask* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    waitTicks(task->notified, lock, ticksToWait, [task]() { return task->notifications > 0; });
+    uint32_t value = task->notifications;
+    if (value > 0) {
+        task->notifications = clearOnExit ? 0 : value - 1;
+    }
+    return value;
+}
+
+// Semaphores
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount)
+{
+    HostSemaphore* semaphore = new HostSemaphore();
+    semaphore->maxCount = maxCount;
+    semaphore->count = initialCount;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    delete semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait)
+{
+    if (!semaphore) return pdFALSE;
+    std::unique_lock<std::mutex> lock(semaphore->mutex);
+    if (!waitTicks(semaphore->released, lock, ticksToWait, [semaphore]() { return semaphore->count > 0; })) {
+        return pdFALSE;
+    }
+    semaphore->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    if (!semaphore) return pdFALSE;
+    {
+        std::lock_guard<std::mutex> lock(semaphore->mutex);
+        if (semaphore->count >= semaphore->maxCount) return pdFALSE;
+        semaphore->count++;
+    }
+    semaphore->released.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* higherPriorityTaskWoken)
+{
+    if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdFALSE;
+    return xSemaphoreGive(semaphore);
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore)
+{
+    if (!semaphore) return 0;
+    std::lock_guard<std::mutex> lock(semaphore->mutex);
+    return semaphore->count;
+}
@@ -0,0 +1,26 @@
+#include <WiFi.h>
+#include <ESPAsyncWebServer.h>
+
+WiFiClass WiFi;
+
+int AsyncWebServer::hostRequest(WebRequestMethod method, const String& url, const String& content, String* response)
+{
+    AsyncWebServerRequest request(method, url);
+    if (content.length() > 0 && body) {
+        String copy = content;
+        body(&request, reinterpret_cast<uint8_t*>(&copy[0]), copy.length(), 0, copy.length());
+    }
+    if (request.responseCode == 0) {
+        bool handled = false;
+        for (AsyncWebHandler* handler : handlers) {
+            if (handler->canHandle(&request)) {
+                handler->handleRequest(&request);
+                handled = true;
+                break;
+            }
+        }
+        if (!handled && notFound) notFound(&request);
+    }
+    if (response) *response = request.responseBody;
+    return request.responseCode;
+}
@@ -0,0 +1,68 @@
+#ifndef HOST_PRINT_H
+#define HOST_PRINT_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+/**
+ * @brief Arduino Print: text formatting over a byte sink
+ */
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return str ? write(reinterpret_cast<const uint8_t*>(str), strlen(str)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write(reinterpret_cast<const uint8_t*>(buffer), size); }
+    virtual void flush() {}
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    size_t print(const __FlashStringHelper* str) { return print(reinterpret_cast<const char*>(str)); }
+    size_t print(const String& str) { return write(str.c_str(), str.length()); }
+    size_t print(const char* str) { return write(str); }
+    size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+    size_t print(unsigned char value, int base = DEC) { return print(String(value, base)); }
+    size_t print(int value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned int value, int base = DEC) { return print(String(value, base)); }
+    size_t print(long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(long long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned long long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(double value, int digits = 2) { return print(String(value, digits)); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    template <typename T>
+    size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+/**
+ * @brief Arduino Stream: a Print that can also be read
+ */
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long ms) { timeoutMs = ms; }
+    // No blocking on the host: what is not available now never arrives
+    virtual size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes(reinterpret_cast<char*>(buffer), length); }
+    String readString();
+
+protected:
+    unsigned long timeoutMs = 1000;
+};
+
+#endif // HOST_PRINT_H
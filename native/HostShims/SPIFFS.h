@@ -0,0 +1,28 @@
+#ifndef HOST_SPIFFS_H
+#define HOST_SPIFFS_H
+
+#include "FS.h"
+
+namespace fs {
+
+/**
+ * @brief SPIFFS partition stand-in
+ *
+ * Files live under $LEDSIM_SPIFFS, or spiffs/ in the system temp directory,
+ * unless setRoot() picks another directory before begin().
+ */
+class SPIFFSFS : public FS {
+public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/spiffs",
+               uint8_t maxOpenFiles = 10, const char* partitionLabel = nullptr);
+    bool format();
+    size_t totalBytes();
+    size_t usedBytes();
+    void end() {}
+};
+
+} // namespace fs
+
+extern fs::SPIFFSFS SPIFFS;
+
+#endif // HOST_SPIFFS_H
@@ -0,0 +1,142 @@
+#include "WString.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+static std::string formatInteger(unsigned long long magnitude, bool negative, unsigned char base)
+{
+    if (base < 2 || base > 36) base = 10;
+    char digits[72];
+    int n = 0;
+    do {
+        unsigned digit = magnitude % base;
+        digits[n++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        magnitude /= base;
+    } while (magnitude > 0);
+    std::string out = negative ? "-" : "";
+    while (n > 0) out += digits[--n];
+    return out;
+}
+
+static std::string formatSigned(long long value, unsigned char base)
+{
+    // Like the Arduino core, only base 10 prints a sign
+    if (base == 10 && value < 0) {
+        return formatInteger(0ULL - static_cast<unsigned long long>(value), true, base);
+    }
+    return formatInteger(static_cast<unsigned long long>(value), false, base);
+}
+
+String::String(unsigned char value, unsigned char base) : s(formatInteger(value, false, base)) {}
+String::String(int value, unsigned char base) : s(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : s(formatInteger(value, false, base)) {}
+String::String(long value, unsigned char base) : s(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : s(formatInteger(value, false, base)) {}
+String::String(long long value, unsigned char base) : s(formatSigned(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : s(formatInteger(value, false, base)) {}
+
+String::String(float value, unsigned int decimals) : String(static_cast<double>(value), decimals) {}
+
+String::String(double value, unsigned int decimals)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", static_cast<int>(decimals), value);
+    s = buffer;
+}
+
+bool String::equalsIgnoreCase(const String& other) const
+{
+    return s.length() == other.s.length() && strcasecmp(s.c_str(), other.s.c_str()) == 0;
+}
+
+bool String::endsWith(const String& suffix) const
+{
+    return s.length() >= suffix.s.length() &&
+           s.compare(s.length() - suffix.s.length(), suffix.s.length(), suffix.s) == 0;
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+    size_t at = s.find(c, from);
+    return at == std::string::npos ? -1 : static_cast<int>(at);
+}
+
+int String::indexOf(const String& str, unsigned int from) const
+{
+    size_t at = s.find(str.s, from);
+    return at == std::string::npos ? -1 : static_cast<int>(at);
+}
+
+int String::lastIndexOf(char c) const
+{
+    size_t at = s.rfind(c);
+    return at == std::string::npos ? -1 : static_cast<int>(at);
+}
+
+// Bounds swapped or past the end are clamped, as in the Arduino core
+String String::substring(unsigned int from, unsigned int to) const
+{
+    if (from > to) std::swap(from, to);
+    if (from >= s.length()) return String();
+    to = std::min<unsigned int>(to, s.length());
+    return String(s.substr(from, to - from));
+}
+
+void String::replace(const String& find, const String& with)
+{
+    if (find.s.empty()) return;
+    size_t at = 0;
+    while ((at = s.find(find.s, at)) != std::string::npos) {
+        s.replace(at, find.s.length(), with.s);
+        at += with.s.length();
+    }
+}
+
+void String::toLowerCase()
+{
+    for (char& c : s) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+}
+
+void String::toUpperCase()
+{
+    for (char& c : s) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+}
+
+void String::trim()
+{
+    size_t first = 0;
+    while (first < s.length() && isspace(static_cast<unsigned char>(s[first]))) first++;
+    size_t last = s.length();
+    while (last > first && isspace(static_cast<unsigned char>(s[last - 1]))) last--;
+    s = s.substr(first, last - first);
+}
+
+long String::toInt() const
+{
+    return strtol(s.c_str(), nullptr, 10);
+}
+
+float String::toFloat() const
+{
+    return static_cast<float>(toDouble());
+}
+
+double String::toDouble() const
+{
+    return strtod(s.c_str(), nullptr);
+}
+
+void String::toCharArray(char* buffer, unsigned int size, unsigned int index) const
+{
+    if (!buffer || size == 0) return;
+    if (index >= s.length()) {
+        buffer[0] = 0;
+        return;
+    }
+    size_t n = std::min<size_t>(size - 1, s.length() - index);
+    memcpy(buffer, s.data() + index, n);
+    buffer[n] = 0;
+}
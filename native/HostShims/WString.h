@@ -0,0 +1,144 @@
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+
+class __FlashStringHelper;
+class StringSumHelper;
+
+/**
+ * @brief Arduino String over std::string, the subset the firmware uses
+ */
+class String {
+public:
+    String() {}
+    String(const char* cstr) { if (cstr) s = cstr; }
+    String(const char* cstr, size_t length) { if (cstr) s.assign(cstr, length); }
+    String(const __FlashStringHelper* str) : String(reinterpret_cast<const char*>(str)) {}
+    String(const std::string& str) : s(str) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimals = 2);
+    explicit String(double value, unsigned int decimals = 2);
+
+    // ArduinoJson's writer resets its target with a null pointer
+    String& operator=(const char* cstr) { if (cstr) s = cstr; else s.clear(); return *this; }
+    String& operator=(const std::string& str) { s = str; return *this; }
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return s.length(); }
+    bool isEmpty() const { return s.empty(); }
+    bool reserve(unsigned int size) { s.reserve(size); return true; }
+    char charAt(unsigned int index) const { return index < s.length() ? s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return s[index]; }
+
+    bool concat(const String& str) { s += str.s; return true; }
+    bool concat(const char* cstr) { if (!cstr) return false; s += cstr; return true; }
+    bool concat(const char* cstr, unsigned int length) { if (!cstr) return false; s.append(cstr, length); return true; }
+    bool concat(char c) { s += c; return true; }
+    template <typename T>
+    bool concat(T value) { return concat(String(value)); }
+
+    String& operator+=(const String& str) { concat(str); return *this; }
+    String& operator+=(const char* cstr) { concat(cstr); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+    template <typename T>
+    String& operator+=(T value) { concat(String(value)); return *this; }
+
+    int compareTo(const String& other) const { return s.compare(other.s); }
+    bool equals(const String& other) const { return s == other.s; }
+    bool equals(const char* cstr) const { return cstr ? s == cstr : s.empty(); }
+    bool equalsIgnoreCase(const String& other) const;
+    bool operator==(const String& other) const { return equals(other); }
+    bool operator==(const char* cstr) const { return equals(cstr); }
+    bool operator!=(const String& other) const { return !equals(other); }
+    bool operator!=(const char* cstr) const { return !equals(cstr); }
+    bool operator<(const String& other) const { return s < other.s; }
+    bool operator>(const String& other) const { return s > other.s; }
+
+    bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.length(), prefix.s) == 0; }
+    bool endsWith(const String& suffix) const;
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& str, unsigned int from = 0) const;
+    int lastIndexOf(char c) const;
+    String substring(unsigned int from) const { return substring(from, s.length()); }
+    String substring(unsigned int from, unsigned int to) const;
+
+    void replace(const String& find, const String& with);
+    void remove(unsigned int index) { if (index < s.length()) s.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < s.length()) s.erase(index, count); }
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+
+    void toCharArray(char* buffer, unsigned int size, unsigned int index = 0) const;
+    void getBytes(unsigned char* buffer, unsigned int size, unsigned int index = 0) const
+    {
+        toCharArray(reinterpret_cast<char*>(buffer), size, index);
+    }
+
+    const std::string& str() const { return s; }
+
+private:
+    std::string s;
+};
+
+/**
+ * @brief Result of String concatenation, as in the Arduino core
+ */
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String& str) : String(str) {}
+    StringSumHelper(const char* cstr) : String(cstr) {}
+};
+
+// The left operand is always a StringSumHelper, as in the Arduino core: a
+// String or a C string converts to it, so each right-hand type has exactly
+// one overload and String + "literal" chains are never ambiguous
+inline StringSumHelper operator+(const StringSumHelper& lhs, const String& rhs)
+{
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+inline StringSumHelper operator+(const StringSumHelper& lhs, const char* rhs)
+{
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+inline StringSumHelper operator+(const StringSumHelper& lhs, char rhs)
+{
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+inline StringSumHelper operator+(const StringSumHelper& lhs, T rhs)
+{
+    StringSumHelper sum(lhs);
+    sum.concat(String(rhs));
+    return sum;
+}
+
+inline bool operator==(const char* lhs, const String& rhs) { return rhs == lhs; }
+inline bool operator!=(const char* lhs, const String& rhs) { return rhs != lhs; }
+
+#endif // HOST_WSTRING_H
@@ -0,0 +1,54 @@
+#ifndef HOST_WEBSOCKETSCLIENT_H
+#define HOST_WEBSOCKETSCLIENT_H
+
+#include <Arduino.h>
+#include <functional>
+
+typedef enum {
+    WStype_ERROR,
+    WStype_DISCONNECTED,
+    WStype_CONNECTED,
+    WStype_TEXT,
+    WStype_BIN,
+    WStype_FRAGMENT_TEXT_START,
+    WStype_FRAGMENT_BIN_START,
+    WStype_FRAGMENT,
+    WStype_FRAGMENT_FIN,
+    WStype_PING,
+    WStype_PONG
+} WStype_t;
+
+/**
+ * @brief Outgoing WebSocket that stays disconnected; hostDeliver() plays
+ * events from a server into the firmware's handler
+ */
+class WebSocketsClient {
+public:
+    typedef std::function<void(WStype_t type, uint8_t* payload, size_t length)> WebSocketClientEvent;
+
+    void begin(const char* host, uint16_t port, const char* url = "/", const char* protocol = "arduino")
+    {
+        (void)host; (void)port; (void)url; (void)protocol;
+    }
+    void onEvent(WebSocketClientEvent handler) { eventHandler = handler; }
+    void setReconnectInterval(unsigned long ms) { (void)ms; }
+    void loop() {}
+    void disconnect() {}
+    bool isConnected() { return false; }
+    bool sendTXT(const char* payload) { (void)payload; return false; }
+    bool sendTXT(const String& payload) { return sendTXT(payload.c_str()); }
+    bool sendBIN(const uint8_t* payload, size_t length) { (void)payload; (void)length; return false; }
+
+    // Host only
+    void hostDeliver(WStype_t type, const String& payload)
+    {
+        if (eventHandler) {
+            eventHandler(type, reinterpret_cast<uint8_t*>(const_cast<char*>(payload.c_str())), payload.length());
+        }
+    }
+
+private:
+    WebSocketClientEvent eventHandler;
+};
+
+#endif // HOST_WEBSOCKETSCLIENT_H
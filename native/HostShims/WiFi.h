@@ -0,0 +1,28 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+/**
+ * @brief Station that never associates: the host has no radio
+ */
+class WiFiClass {
+public:
+    wl_status_t status() { return WL_DISCONNECTED; }
+    bool isConnected() { return false; }
+    int8_t RSSI() { return 0; }
+    IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+    String macAddress() { return String("00:00:00:00:00:00"); }
+};
+
+extern WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
@@ -0,0 +1,24 @@
+#ifndef HOST_WIFIUDP_H
+#define HOST_WIFIUDP_H
+
+#include <Arduino.h>
+
+/**
+ * @brief UDP socket that never receives and drops what it sends
+ */
+class WiFiUDP {
+public:
+    uint8_t begin(uint16_t port) { (void)port; return 1; }
+    void stop() {}
+    int parsePacket() { return 0; }
+    int available() { return 0; }
+    int read(char* buffer, size_t length) { (void)buffer; (void)length; return 0; }
+    int read(uint8_t* buffer, size_t length) { (void)buffer; (void)length; return 0; }
+    int beginPacket(const char* host, uint16_t port) { (void)host; (void)port; return 1; }
+    size_t write(const uint8_t* buffer, size_t size) { (void)buffer; return size; }
+    int endPacket() { return 1; }
+    IPAddress remoteIP() { return IPAddress(); }
+    uint16_t remotePort() { return 0; }
+};
+
+#endif // HOST_WIFIUDP_H
@@ -0,0 +1,29 @@
+#ifndef HOST_PGMSPACE_H
+#define HOST_PGMSPACE_H
+
+// Flash and RAM share one address space, as on the ESP32: PROGMEM data is
+// read like any other memory
+
+#include <stdint.h>
+#include <string.h>
+
+class __FlashStringHelper;
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+
+#define pgm_read_byte(addr) (*(const unsigned char*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_float(addr) (*(const float*)(addr))
+#define pgm_read_double(addr) (*(const double*)(addr))
+#define pgm_read_ptr(addr) (*(const void* const*)(addr))
+
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define memcpy_P memcpy
+#define memcmp_P memcmp
+
+#endif // HOST_PGMSPACE_H
@@ -0,0 +1,14 @@
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+// Hardware RNG on the device, a seeded generator on the host
+uint32_t esp_random(void);
+void esp_restart(void);
+
+#endif // HOST_ESP_SYSTEM_H
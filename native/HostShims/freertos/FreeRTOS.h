@@ -0,0 +1,35 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+// FreeRTOS on threads: one tick per millisecond, tasks are std::threads
+// without priorities or core affinity, semaphores and task notifications
+// block on condition variables
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1)
+#define configTICK_RATE_HZ 1000
+#define configMAX_PRIORITIES 25
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define pdTICKS_TO_MS(ticks) ((uint32_t)(ticks))
+
+#define tskIDLE_PRIORITY 0
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+// Interrupt handlers are plain calls on the host, nothing to yield to
+#define portYIELD_FROM_ISR(...) ((void)0)
+#define portYIELD() ((void)0)
+
+#endif // HOST_FREERTOS_H
@@ -0,0 +1,176 @@
+// Render microbenchmarks, built by the bench environments only.
+//
+// On the host:
+//
+//   pio run -e native_bench
+//   .pio/build/native_bench/program [options] > new.json
+//
+//   --sizes A,B,...     strip lengths, 15,150,600,2400 by default
+//   --filter TEXT       only cases whose name contains TEXT
+//   --trials N          timed trials per case, 21 by default
+//   --trim N            fastest and slowest trials dropped at each end, 5 by default
+//   --out FILE          results go to FILE instead of stdout
+//   --baseline FILE     compare with an earlier run, exit 1 on slowdowns
+//   --threshold PCT     slowdown tolerated by --baseline and --compare, 10 by default
+//   --compare OLD NEW   only compare two result files
+//
+// On the board, `pio run -e esp32dev_bench -t upload` then the monitor shows
+// the same JSON once after boot; saved to a file it compares like a host run.
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <EffectBench.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(2000);
+    EffectBench bench;
+    bench.run(Serial);
+}
+
+void loop()
+{
+    delay(1000);
+}
+
+#else
+
+#include <string>
+
+namespace {
+
+// Print over a stdio stream
+class FilePrint : public Print {
+public:
+    explicit FilePrint(FILE* file) : file(file) {}
+    size_t write(uint8_t c) override { return fputc(c, file) == EOF ? 0 : 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { return fwrite(buffer, 1, size, file); }
+    using Print::write;
+
+private:
+    FILE* file;
+};
+
+void usage()
+{
+    fprintf(stderr, "usage: bench [--sizes A,B,...] [--filter TEXT] [--trials N] [--trim N] [--out FILE]\n"
+                    "             [--baseline FILE] [--threshold PCT]\n"
+                    "       bench --compare OLD NEW [--threshold PCT]\n");
+}
+
+// Board output may carry log lines around the document: it starts at {"bench"
+bool loadResults(const char* path, std::vector<BenchResult>& out)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "bench: cannot open %s\n", path);
+        return false;
+    }
+    std::string text;
+    char buffer[512];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) text.append(buffer, n);
+    fclose(file);
+
+    size_t start = text.find("{\"bench\"");
+    JsonDocument doc;
+    if (start == std::string::npos || deserializeJson(doc, text.c_str() + start) ||
+        !EffectBench::load(doc.as<JsonVariantConst>(), out)) {
+        fprintf(stderr, "bench: %s holds no results\n", path);
+        return false;
+    }
+    return true;
+}
+
+bool parseSizes(const char* list, BenchOptions& options)
+{
+    options.sizeCount = 0;
+    const char* p = list;
+    while (*p) {
+        char* end;
+        long size = strtol(p, &end, 10);
+        if (end == p || size <= 0 || size > 65535 || options.sizeCount == EFFECT_BENCH_MAX_SIZES) {
+            return false;
+        }
+        if (*end != ',' && *end != '\0') {
+            return false;
+        }
+        options.sizes[options.sizeCount++] = static_cast<uint16_t>(size);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return options.sizeCount > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    const char* output = nullptr;
+    const char* baseline = nullptr;
+    const char* compareOld = nullptr;
+    const char* compareNew = nullptr;
+    float threshold = 10.0f;
+
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--sizes" && hasValue) {
+            if (!parseSizes(argv[++i], options)) {
+                usage();
+                return 2;
+            }
+        } else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else if (arg == "--trials" && hasValue) {
+            int trials = atoi(argv[++i]);
+            options.trials = static_cast<uint8_t>(constrain(trials, 1, 255));
+        } else if (arg == "--trim" && hasValue) {
+            int trim = atoi(argv[++i]);
+            options.trim = static_cast<uint8_t>(constrain(trim, 0, 127));
+        } else if (arg == "--out" && hasValue) {
+            output = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baseline = argv[++i];
+        } else if (arg == "--threshold" && hasValue) {
+            threshold = atof(argv[++i]);
+        } else if (arg == "--compare" && i + 2 < argc) {
+            compareOld = argv[++i];
+            compareNew = argv[++i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    // The libraries log to Serial, the results own stdout
+    Serial.setOutput(nullptr);
+    FilePrint report(stderr);
+
+    if (compareOld) {
+        std::vector<BenchResult> before, after;
+        if (!loadResults(compareOld, before) || !loadResults(compareNew, after)) return 2;
+        return EffectBench::compare(before, after, threshold, report) > 0 ? 1 : 0;
+    }
+
+    std::vector<BenchResult> before;
+    if (baseline && !loadResults(baseline, before)) return 2;
+
+    FILE* file = output ? fopen(output, "wb") : stdout;
+    if (!file) {
+        fprintf(stderr, "bench: cannot write %s\n", output);
+        return 2;
+    }
+    FilePrint out(file);
+    EffectBench bench(options);
+    bench.run(out);
+    if (output) fclose(file);
+
+    int slower = baseline ? EffectBench::compare(before, bench.getResults(), threshold, report) : 0;
+    return slower > 0 ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,714 @@
+// Command path throughput benchmark, built by the native_cmdbench environment:
+//
+//   pio run -e native_cmdbench
+//   .pio/build/native_cmdbench/program [options] [trace.jsonl] > results.json
+//
+// Commands take the device path: the body text is parsed as the HTTP handler
+// does, then OmniSourceRouter::inspectBody, the IO wrapper callback, the
+// command scheduler task, LEDStrip::jsonInterpreter and the JSON parser,
+// while the render task draws frames on its own thread. Each mix is offered
+// at each rate for the run duration, then the queue is drained.
+//
+// Per run: commands applied per second, p50/p99/max latency from the body
+// arriving to the command applied and to the first frame showing it, and
+// frame deadline misses, a frame shown more than 1.5 frame intervals after
+// the one before. Rejected, stale and preempted commands are never applied.
+//
+// A trace is a file in the simulator input format, a JSON command per line,
+// its targets rewritten to the bench strip. With {"wait": ms} lines it is
+// replayed once with its own timing, without it is the mix, looped at each
+// rate.
+//
+// Without a trace, the first command of each mix but "mixed" is then saved as
+// a preset, and the "recall" results compare bringing that scene back by
+// PresetStore::recall with sending its JSON again: parsed and interpreted
+// (json), interpreted only (interpret), and recalled (recall), p50 and p99 of
+// RECALL_ROUNDS rounds of RECALL_BATCH each, outside the scheduler.
+//
+//   --leds N          LED count, 150 by default
+//   --mix A,B,...     fill, effect, pixels, gradient, sequence, mixed; all by default
+//   --rates A,B,...   commands offered per second, 0 for back to back; 50,200,0 by default
+//   --duration MS     sending time of each run, 2000 by default
+//   --out FILE        results go to FILE instead of stdout
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Adafruit_NeoPixel.h>
+#include <LEDStrip.h>
+#include <IOWrapper.h>
+#include <networkManager.h>
+#include <omniSourceRouter.h>
+#include <CommandScheduler.h>
+#include <EffectRegistry.h>
+#include <Timeline.h>
+#include <PresetStore.h>
+#include <ConfigStore.h>
+#include <SPIFFS.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* const BENCH_UID = "bench";
+const uint8_t PIXELS_PER_SET = 32;
+const uint8_t GRADIENT_STOPS = 8;
+const uint32_t RECALL_ROUNDS = 100;
+const uint32_t RECALL_BATCH = 16;   ///< Operations per timed round, a recall is about a microsecond
+const char* const PRESET_PATH = "/cmdbench_presets.bin";
+
+struct CmdBenchOptions {
+    uint16_t leds = 150;
+    std::vector<String> mixes;
+    std::vector<uint32_t> rates = {50, 200, 0};
+    uint32_t durationMs = 2000;
+    const char* trace = nullptr;
+    const char* output = nullptr;
+};
+
+// Send, apply and show times of the commands of one run, and its frames.
+// Written by the bench, scheduler and render threads.
+struct RunRecord {
+    std::mutex lock;
+    bool recording = false;
+    std::vector<int64_t> sentUs;      ///< By command id
+    std::vector<int64_t> appliedUs;   ///< 0 until applied
+    std::vector<int64_t> visibleUs;   ///< 0 until a frame followed the apply
+    std::vector<uint32_t> unseen;     ///< Applied, no frame yet
+    uint32_t frameDelayUs = 0;
+    int64_t lastFrameUs = 0;
+    uint32_t frames = 0;
+    uint32_t missedFrames = 0;
+    int64_t worstGapUs = 0;
+
+    void reset(uint32_t frameDelayMs)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        sentUs.clear();
+        appliedUs.clear();
+        visibleUs.clear();
+        unseen.clear();
+        frameDelayUs = frameDelayMs * 1000;
+        lastFrameUs = 0;
+        frames = 0;
+        missedFrames = 0;
+        worstGapUs = 0;
+    }
+};
+
+RunRecord record;
+
+// Shows from inside a command (a fill without transition, a sequence step)
+// are not frames of the render loop
+thread_local int commandDepth = 0;
+
+class BenchStrip : public LEDStrip {
+public:
+    using LEDStrip::LEDStrip;
+
+    void jsonInterpreter(JsonObject& json) override
+    {
+        commandDepth++;
+        LEDStrip::jsonInterpreter(json);
+        commandDepth--;
+
+        JsonVariant id = json["benchId"];
+        if (id.isNull()) return;
+        int64_t now = esp_timer_get_time();
+        std::lock_guard<std::mutex> guard(record.lock);
+        uint32_t index = id.as<uint32_t>();
+        if (record.recording && index < record.appliedUs.size()) {
+            record.appliedUs[index] = now;
+            record.unseen.push_back(index);
+        }
+    }
+};
+
+void onShow(const Adafruit_NeoPixel& pixels)
+{
+    (void)pixels;
+    if (commandDepth > 0) return;
+
+    int64_t now = esp_timer_get_time();
+    std::lock_guard<std::mutex> guard(record.lock);
+    if (!record.recording) return;
+    if (record.lastFrameUs) {
+        int64_t gap = now - record.lastFrameUs;
+        record.worstGapUs = std::max(record.worstGapUs, gap);
+        if (gap > record.frameDelayUs * 3 / 2) {
+            record.missedFrames++;
+        }
+    }
+    record.lastFrameUs = now;
+    record.frames++;
+    for (uint32_t index : record.unseen) {
+        record.visibleUs[index] = now;
+    }
+    record.unseen.clear();
+}
+
+// Command generators, n numbering the commands of the run
+
+JsonObject hsv(JsonObject color, uint32_t hue)
+{
+    color["h"] = hue % 360;
+    color["s"] = 1;
+    color["v"] = 1;
+    return color;
+}
+
+void fillCommand(uint32_t n, uint16_t leds, JsonObject cmd)
+{
+    (void)leds;
+    JsonObject fill = cmd["fill"].to<JsonObject>();
+    hsv(fill["color"].to<JsonObject>(), n * 37);
+    if (n % 4 == 0) fill["transitionDuration"] = 300;
+}
+
+void effectCommand(uint32_t n, uint16_t leds, JsonObject cmd)
+{
+    (void)leds;
+    // Every registered effect but "none"
+    size_t id = 1 + n % (EffectRegistry::count() - 1);
+    JsonObject effect = cmd["effect"].to<JsonObject>();
+    effect["type"] = EffectRegistry::get(static_cast<EffectType>(id)).name;
+    effect["speed"] = 1 + n % 3;
+    if (n % 2 == 0) effect["transitionDuration"] = 300;
+}
+
+void pixelsCommand(uint32_t n, uint16_t leds, JsonObject cmd)
+{
+    JsonArray set = cmd["pixels"]["set"].to<JsonArray>();
+    char hex[8];
+    for (uint8_t i = 0; i < PIXELS_PER_SET; i++) {
+        JsonObject pixel = set.add<JsonObject>();
+        pixel["index"] = (n * PIXELS_PER_SET + i) % leds;
+        snprintf(hex, sizeof(hex), "#%06x", static_cast<unsigned>((n * 0x2f1b3 + i * 0x10307) & 0xFFFFFF));
+        pixel["color"] = hex;
+    }
+}
+
+void gradientCommand(uint32_t n, uint16_t leds, JsonObject cmd)
+{
+    (void)leds;
+    JsonArray stops = cmd["gradient"]["stops"].to<JsonArray>();
+    for (uint8_t i = 0; i < GRADIENT_STOPS; i++) {
+        JsonObject stop = stops.add<JsonObject>();
+        hsv(stop["color"].to<JsonObject>(), n * 23 + i * 45);
+        stop["position"] = static_cast<float>(i) / (GRADIENT_STOPS - 1);
+    }
+}
+
+void sequenceCommand(uint32_t n, uint16_t leds, JsonObject cmd)
+{
+    (void)leds;
+    JsonObject fill = cmd["fill"].to<JsonObject>();
+    hsv(fill["color"].to<JsonObject>(), n * 37);
+    fill["transitionDuration"] = 200;
+    JsonArray then = cmd["then"].to<JsonArray>();
+    JsonObject effect = then.add<JsonObject>()["effect"].to<JsonObject>();
+    effect["type"] = "chase";
+    effect["transitionDuration"] = 200;
+    JsonObject gradient = then.add<JsonObject>()["gradient"].to<JsonObject>();
+    gradient["start"] = "red";
+    gradient["end"] = "blue";
+    cmd["loop"] = true;
+}
+
+typedef void (*CommandGenerator)(uint32_t n, uint16_t leds, JsonObject cmd);
+
+const CommandGenerator MIXED[] = {fillCommand, effectCommand, pixelsCommand, gradientCommand, sequenceCommand};
+
+void mixedCommand(uint32_t n, uint16_t leds, JsonObject cmd)
+{
+    const size_t kinds = sizeof(MIXED) / sizeof(MIXED[0]);
+    MIXED[n % kinds](n / kinds, leds, cmd);
+}
+
+struct Mix {
+    const char* name;
+    CommandGenerator generate;
+};
+
+const Mix MIXES[] = {
+    {"fill", fillCommand},
+    {"effect", effectCommand},
+    {"pixels", pixelsCommand},
+    {"gradient", gradientCommand},
+    {"sequence", sequenceCommand},
+    {"mixed", mixedCommand},
+};
+
+const Mix* findMix(const String& name)
+{
+    for (const Mix& mix : MIXES) {
+        if (name == mix.name) return &mix;
+    }
+    return nullptr;
+}
+
+// A trace line: a command, or a pause before the next one
+struct TraceEntry {
+    String command;
+    uint32_t waitMs;
+};
+
+bool loadTrace(const char* path, std::vector<TraceEntry>& out, bool& timed)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "cmdbench: cannot open %s\n", path);
+        return false;
+    }
+    timed = false;
+    std::string line;
+    int c;
+    while (true) {
+        line.clear();
+        while ((c = fgetc(file)) != EOF && c != '\n') line += static_cast<char>(c);
+        if (line.find_first_not_of(" \t\r") != std::string::npos) {
+            JsonDocument doc;
+            if (deserializeJson(doc, line) || !doc.is<JsonObject>()) {
+                fprintf(stderr, "cmdbench: skipped, not a JSON object: %s\n", line.c_str());
+            } else if (!doc["wait"].isNull()) {
+                out.push_back({String(), doc["wait"].as<uint32_t>()});
+                timed = true;
+            } else {
+                String text;
+                serializeJson(doc, text);
+                out.push_back({text, 0});
+            }
+        }
+        if (c == EOF) break;
+    }
+    fclose(file);
+    return true;
+}
+
+// The text the router would receive, tagged with its id in the run
+String tagCommand(JsonDocument& doc, uint32_t id)
+{
+    doc["target"] = BENCH_UID;
+    doc["benchId"] = id;
+    String text;
+    serializeJson(doc, text);
+    return text;
+}
+
+// As the HTTP body handler: parse, then hand the object to the router
+void deliver(OmniSourceRouter& router, const String& text)
+{
+    int64_t now = esp_timer_get_time();
+    {
+        std::lock_guard<std::mutex> guard(record.lock);
+        record.sentUs.push_back(now);
+        record.appliedUs.push_back(0);
+        record.visibleUs.push_back(0);
+    }
+    JsonDocument doc;
+    if (!deserializeJson(doc, text) && doc.is<JsonObject>()) {
+        router.inspectBody(doc.as<JsonObject>());
+    }
+}
+
+void waitUntil(int64_t dueUs)
+{
+    int64_t now = esp_timer_get_time();
+    if (dueUs > now) delayMicroseconds(static_cast<uint32_t>(dueUs - now));
+}
+
+uint32_t percentile(std::vector<uint32_t>& sorted, uint32_t pct)
+{
+    if (sorted.empty()) return 0;
+    size_t index = std::min(sorted.size() - 1, sorted.size() * pct / 100);
+    return sorted[index];
+}
+
+struct RunResult {
+    uint32_t sent;
+    uint32_t applied;
+    uint32_t rejected;
+    uint32_t stale;
+    uint32_t preempted;
+    float offeredPerSecond;
+    float appliedPerSecond;
+    uint32_t p50Us, p99Us, maxUs;
+    uint32_t visibleP50Us, visibleP99Us;
+    uint32_t frames;
+    uint32_t missedFrames;
+    float worstGapMs;
+};
+
+// Queue drained, then a few frames so the last commands reach the LEDs
+void drain(CommandScheduler* scheduler, LEDStrip* strip)
+{
+    int64_t start = esp_timer_get_time();
+    while (!scheduler->isIdle() && esp_timer_get_time() - start < 5000000) {
+        delay(1);
+    }
+    delay(strip->getFrameDelay() * 3);
+}
+
+RunResult summarize(CommandScheduler* scheduler, int64_t sendEndUs)
+{
+    RunResult result = {};
+    std::vector<uint32_t> latency;
+    std::vector<uint32_t> visible;
+    int64_t firstSent = 0;
+    int64_t lastApplied = 0;
+    {
+        std::lock_guard<std::mutex> guard(record.lock);
+        record.recording = false;
+        result.sent = record.sentUs.size();
+        firstSent = result.sent ? record.sentUs[0] : 0;
+        for (size_t i = 0; i < record.sentUs.size(); i++) {
+            if (!record.appliedUs[i]) continue;
+            latency.push_back(static_cast<uint32_t>(record.appliedUs[i] - record.sentUs[i]));
+            lastApplied = std::max(lastApplied, record.appliedUs[i]);
+            if (record.visibleUs[i]) {
+                visible.push_back(static_cast<uint32_t>(record.visibleUs[i] - record.sentUs[i]));
+            }
+        }
+        result.frames = record.frames;
+        result.missedFrames = record.missedFrames;
+        result.worstGapMs = record.worstGapUs / 1000.0f;
+    }
+
+    result.applied = latency.size();
+    if (result.sent && sendEndUs > firstSent) {
+        result.offeredPerSecond = result.sent * 1e6f / (sendEndUs - firstSent);
+    }
+    if (result.applied && lastApplied > firstSent) {
+        result.appliedPerSecond = result.applied * 1e6f / (lastApplied - firstSent);
+    }
+    std::sort(latency.begin(), latency.end());
+    std::sort(visible.begin(), visible.end());
+    result.p50Us = percentile(latency, 50);
+    result.p99Us = percentile(latency, 99);
+    result.maxUs = latency.empty() ? 0 : latency.back();
+    result.visibleP50Us = percentile(visible, 50);
+    result.visibleP99Us = percentile(visible, 99);
+
+    JsonDocument stats;
+    JsonObject out = stats.to<JsonObject>();
+    scheduler->getStats(out);
+    for (uint32_t p = 0; p < PRIORITY_CLASS_COUNT; p++) {
+        JsonObject cls = out[CommandScheduler::priorityName(p)];
+        result.rejected += cls["rejected"].as<uint32_t>();
+        result.stale += cls["droppedStale"].as<uint32_t>();
+        result.preempted += cls["preempted"].as<uint32_t>();
+    }
+    return result;
+}
+
+// Sends commands for durationMs at rate per second, back to back at 0
+int64_t sendMix(OmniSourceRouter& router, const Mix* mix, const std::vector<TraceEntry>* trace,
+                uint16_t leds, uint32_t rate, uint32_t durationMs)
+{
+    int64_t start = esp_timer_get_time();
+    int64_t end = start + static_cast<int64_t>(durationMs) * 1000;
+    uint32_t n = 0;
+    while (esp_timer_get_time() < end) {
+        JsonDocument doc;
+        if (trace) {
+            deserializeJson(doc, (*trace)[n % trace->size()].command);
+        } else {
+            mix->generate(n, leds, doc.to<JsonObject>());
+        }
+        String text = tagCommand(doc, n);
+        if (rate) waitUntil(start + static_cast<int64_t>(n) * 1000000 / rate);
+        deliver(router, text);
+        n++;
+    }
+    return esp_timer_get_time();
+}
+
+// A trace with waits, once, with its own timing
+int64_t replayTrace(OmniSourceRouter& router, const std::vector<TraceEntry>& trace)
+{
+    int64_t due = esp_timer_get_time();
+    uint32_t n = 0;
+    for (const TraceEntry& entry : trace) {
+        if (entry.command.isEmpty()) {
+            due += static_cast<int64_t>(entry.waitMs) * 1000;
+            continue;
+        }
+        JsonDocument doc;
+        deserializeJson(doc, entry.command);
+        String text = tagCommand(doc, n++);
+        waitUntil(due);
+        deliver(router, text);
+    }
+    return esp_timer_get_time();
+}
+
+void emit(FILE* out, bool first, const char* mix, uint32_t rate, const RunResult& r)
+{
+    fprintf(out, "%s\n  {\"mix\": \"%s\", \"rate\": %u, \"sent\": %u, \"applied\": %u, "
+                 "\"rejected\": %u, \"stale\": %u, \"preempted\": %u, "
+                 "\"offered_per_s\": %.1f, \"cmd_per_s\": %.1f, "
+                 "\"p50_us\": %u, \"p99_us\": %u, \"max_us\": %u, "
+                 "\"visible_p50_us\": %u, \"visible_p99_us\": %u, "
+                 "\"frames\": %u, \"missed_frames\": %u, \"worst_gap_ms\": %.1f}",
+            first ? "" : ",", mix, rate, r.sent, r.applied, r.rejected, r.stale, r.preempted,
+            r.offeredPerSecond, r.appliedPerSecond, r.p50Us, r.p99Us, r.maxUs,
+            r.visibleP50Us, r.visibleP99Us, r.frames, r.missedFrames, r.worstGapMs);
+    fflush(out);
+}
+
+struct RecallResult {
+    size_t jsonBytes;
+    float jsonP50Us, jsonP99Us;
+    float interpretP50Us, interpretP99Us;
+    float recallP50Us, recallP99Us;
+};
+
+float percentileOfBatch(std::vector<uint32_t>& sorted, uint32_t pct)
+{
+    return static_cast<float>(percentile(sorted, pct)) / RECALL_BATCH;
+}
+
+// The scene as JSON and as preset id, brought back alternately so both
+// see the same strip state
+bool timeRecall(LEDStrip* strip, const Mix* mix, uint16_t leds, uint16_t id, RecallResult& result)
+{
+    JsonDocument scene;
+    mix->generate(1, leds, scene.to<JsonObject>());
+    String text;
+    serializeJson(scene, text);
+    result.jsonBytes = text.length();
+
+    JsonObject command = scene.as<JsonObject>();
+    strip->jsonInterpreter(command);
+    if (!PresetStore::getInstance().save(id, strip)) return false;
+
+    std::vector<uint32_t> json, interpret, recall;
+    JsonDocument docs[RECALL_BATCH];
+    for (uint32_t round = 0; round < RECALL_ROUNDS; round++) {
+        int64_t start = esp_timer_get_time();
+        for (JsonDocument& doc : docs) {
+            deserializeJson(doc, text);
+            JsonObject parsed = doc.as<JsonObject>();
+            strip->jsonInterpreter(parsed);
+        }
+        json.push_back(static_cast<uint32_t>(esp_timer_get_time() - start));
+
+        for (JsonDocument& doc : docs) deserializeJson(doc, text);
+        start = esp_timer_get_time();
+        for (JsonDocument& doc : docs) {
+            JsonObject parsed = doc.as<JsonObject>();
+            strip->jsonInterpreter(parsed);
+        }
+        interpret.push_back(static_cast<uint32_t>(esp_timer_get_time() - start));
+
+        start = esp_timer_get_time();
+        for (uint32_t i = 0; i < RECALL_BATCH; i++) {
+            if (!PresetStore::getInstance().recall(id, strip)) return false;
+        }
+        recall.push_back(static_cast<uint32_t>(esp_timer_get_time() - start));
+    }
+    std::sort(json.begin(), json.end());
+    std::sort(interpret.begin(), interpret.end());
+    std::sort(recall.begin(), recall.end());
+    result.jsonP50Us = percentileOfBatch(json, 50);
+    result.jsonP99Us = percentileOfBatch(json, 99);
+    result.interpretP50Us = percentileOfBatch(interpret, 50);
+    result.interpretP99Us = percentileOfBatch(interpret, 99);
+    result.recallP50Us = percentileOfBatch(recall, 50);
+    result.recallP99Us = percentileOfBatch(recall, 99);
+    return true;
+}
+
+void emitRecall(FILE* out, bool first, const char* scene, const RecallResult& r)
+{
+    fprintf(out, "%s\n  {\"scene\": \"%s\", \"json_bytes\": %u, "
+                 "\"json_p50_us\": %.2f, \"json_p99_us\": %.2f, "
+                 "\"interpret_p50_us\": %.2f, \"interpret_p99_us\": %.2f, "
+                 "\"recall_p50_us\": %.2f, \"recall_p99_us\": %.2f, \"speedup\": %.1f}",
+            first ? "" : ",", scene, static_cast<unsigned>(r.jsonBytes),
+            r.jsonP50Us, r.jsonP99Us, r.interpretP50Us, r.interpretP99Us,
+            r.recallP50Us, r.recallP99Us,
+            r.recallP50Us > 0.0f ? r.jsonP50Us / r.recallP50Us : 0.0f);
+    fflush(out);
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: cmdbench [--leds N] [--mix A,B,...] [--rates A,B,...] [--duration MS]\n"
+                    "                [--out FILE] [trace.jsonl]\n");
+}
+
+bool parseList(const char* list, std::vector<String>& out)
+{
+    out.clear();
+    String text = list;
+    int start = 0;
+    while (start <= static_cast<int>(text.length())) {
+        int comma = text.indexOf(',', start);
+        if (comma < 0) comma = text.length();
+        String item = text.substring(start, comma);
+        if (item.isEmpty()) return false;
+        out.push_back(item);
+        start = comma + 1;
+    }
+    return !out.empty();
+}
+
+bool parseArgs(int argc, char** argv, CmdBenchOptions& options)
+{
+    std::vector<String> items;
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--leds" && hasValue) {
+            long leds = atol(argv[++i]);
+            if (leds <= 0 || leds > 65535) return false;
+            options.leds = static_cast<uint16_t>(leds);
+        } else if (arg == "--mix" && hasValue) {
+            if (!parseList(argv[++i], options.mixes)) return false;
+            for (const String& name : options.mixes) {
+                if (!findMix(name)) return false;
+            }
+        } else if (arg == "--rates" && hasValue) {
+            if (!parseList(argv[++i], items)) return false;
+            options.rates.clear();
+            for (const String& item : items) {
+                char* end;
+                unsigned long rate = strtoul(item.c_str(), &end, 10);
+                if (*end != '\0' || rate > 1000000) return false;
+                options.rates.push_back(static_cast<uint32_t>(rate));
+            }
+        } else if (arg == "--duration" && hasValue) {
+            options.durationMs = strtoul(argv[++i], nullptr, 10);
+            if (options.durationMs == 0) return false;
+        } else if (arg == "--out" && hasValue) {
+            options.output = argv[++i];
+        } else if (!arg.startsWith("--") && !options.trace) {
+            options.trace = argv[i];
+        } else {
+            return false;
+        }
+    }
+    if (options.mixes.empty()) {
+        for (const Mix& mix : MIXES) options.mixes.push_back(mix.name);
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    CmdBenchOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    std::vector<TraceEntry> trace;
+    bool timed = false;
+    if (options.trace && !loadTrace(options.trace, trace, timed)) return 2;
+    size_t commands = std::count_if(trace.begin(), trace.end(),
+                                    [](const TraceEntry& e) { return !e.command.isEmpty(); });
+    if (options.trace && commands == 0) {
+        fprintf(stderr, "cmdbench: %s holds no commands\n", options.trace);
+        return 2;
+    }
+    if (!timed) {
+        trace.erase(std::remove_if(trace.begin(), trace.end(),
+                                   [](const TraceEntry& e) { return e.command.isEmpty(); }),
+                    trace.end());
+    }
+
+    FILE* out = options.output ? fopen(options.output, "wb") : stdout;
+    if (!out) {
+        fprintf(stderr, "cmdbench: cannot write %s\n", options.output);
+        return 2;
+    }
+
+    // The libraries log every command to Serial, the results own stdout
+    Serial.setOutput(nullptr);
+    Adafruit_NeoPixel::setShowHook(onShow);
+
+    NetworkManager nm;
+    OmniSourceRouter router(&nm);
+    IOWrapper wrapper(&router);
+    BenchStrip* strip = new BenchStrip(options.leds, 2, NEO_GRB + NEO_KHZ800);
+    wrapper.pushOutput(strip, BENCH_UID);
+    CommandScheduler* scheduler = wrapper.findScheduler(BENCH_UID);
+    if (!scheduler) {
+        fprintf(stderr, "cmdbench: strip did not start\n");
+        return 1;
+    }
+
+    fprintf(out, "{\"cmdbench\": 1, \"leds\": %u, \"frame_ms\": %u, \"duration_ms\": %u, \"results\": [",
+            options.leds, static_cast<unsigned>(strip->getFrameDelay()), static_cast<unsigned>(options.durationMs));
+
+    bool first = true;
+    auto run = [&](const char* name, const Mix* mix, uint32_t rate) {
+        // Each run starts from a quiet strip with fresh counters
+        strip->timeline->stop();
+        drain(scheduler, strip);
+        scheduler->resetStats();
+        record.reset(strip->getFrameDelay());
+        {
+            std::lock_guard<std::mutex> guard(record.lock);
+            record.recording = true;
+        }
+
+        int64_t sendEnd = (timed && !mix)
+            ? replayTrace(router, trace)
+            : sendMix(router, mix, mix ? nullptr : &trace, options.leds, rate, options.durationMs);
+        drain(scheduler, strip);
+        emit(out, first, name, rate, summarize(scheduler, sendEnd));
+        first = false;
+    };
+
+    if (options.trace && timed) {
+        run("trace", nullptr, 0);
+    } else if (options.trace) {
+        for (uint32_t rate : options.rates) run("trace", nullptr, rate);
+    } else {
+        for (const String& name : options.mixes) {
+            const Mix* mix = findMix(name);
+            for (uint32_t rate : options.rates) run(mix->name, mix, rate);
+        }
+    }
+
+    fprintf(out, "\n]");
+
+    if (!options.trace) {
+        strip->timeline->stop();
+        drain(scheduler, strip);
+        // A store of its own, not the presets of a simulator run
+        if (ConfigStore::getInstance().mount()) SPIFFS.remove(PRESET_PATH);
+        if (!PresetStore::getInstance().begin(PRESET_PATH)) {
+            fprintf(stderr, "cmdbench: no preset store, recall skipped\n");
+        } else {
+            fprintf(out, ", \"recall\": [");
+            first = true;
+            uint16_t id = 1;
+            for (const String& name : options.mixes) {
+                const Mix* mix = findMix(name);
+                RecallResult result;
+                if (mix->generate == mixedCommand) continue;
+                if (!timeRecall(strip, mix, options.leds, id++, result)) {
+                    fprintf(stderr, "cmdbench: preset %s could not be saved or recalled\n", mix->name);
+                    continue;
+                }
+                emitRecall(out, first, mix->name, result);
+                first = false;
+            }
+            fprintf(out, "\n]");
+            SPIFFS.remove(PRESET_PATH);
+        }
+    }
+
+    fprintf(out, "}\n");
+    fflush(out);
+    // The render and scheduler tasks never return, so no destructors run
+    Adafruit_NeoPixel::setShowHook(nullptr);
+    std::_Exit(0);
+}
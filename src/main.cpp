@@ -5,7 +5,6 @@
 
 // Internal Modules
 #include <omniSourceRouter.h>
-#include <PrefManager.h>
 #include <wcolor.h>
 #include <LEDStrip.h>
 #include <NetworkManager.h>
@@ -16,6 +15,7 @@
 #include <wsetup.h>
 #include <IOWrapper.h>
 #include <ArduinoOTA.h>
+#include <BootProfile.h>
 
 
 const uint32_t HEARTBEAT_INTERVAL = 30000;
@@ -27,7 +27,6 @@ AsyncWebServer server(80);
 DNSServer dns;
 WiFiCaptiveManager captiveManager(server, dns);
 // Global Instances
-PrefManager pm;
 // LEDStrip strip(LED_COUNT, LED_PIN, LED_TYPE);
 NetworkManager nm;
 OmniSourceRouter controller(&nm);
@@ -68,16 +67,17 @@ void blankEEPROM()
   Serial.println("EEPROM blanking complete");
 }
 
-void setup()
+volatile bool networkReady = false;
+
+// WiFi can block for seconds (connect timeout, captive portal), so it runs
+// in its own task while the strips keep rendering the restored scene
+void networkTask(void *parameter)
 {
-  Serial.begin(115200);
-  // blankEEPROM();
   captiveManager.begin();
   if (!captiveManager.isCaptivePortalActive())
   {
     controller.begin();
   }
-  WSetup setup(&wrapper, &nm);
   ArduinoOTA
       .onStart([]()
                {
@@ -101,10 +101,31 @@ void setup()
   ArduinoOTA.setPassword("BobinouTKT42");
   ArduinoOTA.begin();
   Serial.println("OTA prêt !");
+  networkReady = true;
+  vTaskDelete(NULL);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  // blankEEPROM();
+  // Outputs and the journaled scene come up before any networking
+  WSetup setup(&wrapper, &nm);
+  WiFi.onEvent([](WiFiEvent_t event, WiFiEventInfo_t info)
+               {
+      BootProfile::mark(BOOT_WIFI_CONNECT);
+      BootProfile::report(); },
+               ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  xTaskCreatePinnedToCore(networkTask, "NetInit", 8192, nullptr, 1, nullptr, 0);
 }
 
 void loop()
 {
+  if (!networkReady)
+  {
+    delay(10);
+    return;
+  }
   ArduinoOTA.handle();
   if (captiveManager.isCaptivePortalActive())
   {
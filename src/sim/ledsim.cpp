@@ -0,0 +1,291 @@
+// Headless LED simulator, built by the native environment only:
+//
+//   pio run -e native
+//   .pio/build/native/program [options] [commands.jsonl] > frames.ppm
+//
+// The strip is wired as on the device, through the router, the IO wrapper
+// and the command scheduler, and every line of the input is POSTed to the
+// router as an HTTP body would be. Lines without a "target" go to the
+// simulated strip. {"wait": ms} lets the strip render for that long before
+// the next line. Every frame the strip shows is captured, brightness
+// applied, as one row of a PPM image (one column per LED) or as raw RGB.
+//
+// With --fast the strip runs on a virtual clock: every command is applied
+// before time moves on, waits and the tail are sequence time rendered as
+// fast as the host allows, and the same input always gives the same frames
+// (seed the random effects). Hours of a looping sequence take seconds.
+//
+//   --leds N        LED count, 15 by default
+//   --uid UID       strip uid, "sim" by default
+//   --layout FILE   JSON with "map" and/or "matrix", as in the strip config
+//   --fs DIR        directory standing in for SPIFFS
+//   --tail MS       rendering kept after the last line, 1000 by default
+//   --raw           stream raw RGB frames instead of writing a PPM at exit
+//   --out FILE      frames go to FILE instead of stdout
+//   --stats         print GET /stats to stderr before exiting
+//   --quiet         silence the firmware logs
+//   --fast          virtual clock, frames rendered back to back
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Adafruit_NeoPixel.h>
+#include <SPIFFS.h>
+#include <LEDStrip.h>
+#include <IOWrapper.h>
+#include <networkManager.h>
+#include <omniSourceRouter.h>
+#include <PixelLayout.h>
+#include <Clock.h>
+#include <CommandScheduler.h>
+#include <HeapStats.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct SimOptions {
+    uint16_t leds = 15;
+    String uid = "sim";
+    const char* layout = nullptr;
+    const char* fsRoot = nullptr;
+    const char* input = nullptr;
+    const char* output = nullptr;
+    uint32_t tailMs = 1000;
+    bool raw = false;
+    bool stats = false;
+    bool quiet = false;
+    bool fast = false;
+};
+
+std::mutex frameMutex;
+FILE* frameOut = stdout;
+bool streamRaw = false;
+uint16_t frameWidth = 0;
+std::vector<uint8_t> frames;
+uint32_t frameCount = 0;
+
+void captureFrame(const Adafruit_NeoPixel& pixels)
+{
+    std::vector<uint8_t> row(static_cast<size_t>(pixels.numPixels()) * 3);
+    for (uint16_t i = 0; i < pixels.numPixels(); i++) {
+        uint32_t c = pixels.shownColor(i);
+        row[i * 3] = (c >> 16) & 0xFF;
+        row[i * 3 + 1] = (c >> 8) & 0xFF;
+        row[i * 3 + 2] = c & 0xFF;
+    }
+
+    std::lock_guard<std::mutex> lock(frameMutex);
+    frameWidth = pixels.numPixels();
+    frameCount++;
+    if (streamRaw) {
+        fwrite(row.data(), 1, row.size(), frameOut);
+    } else {
+        frames.insert(frames.end(), row.begin(), row.end());
+    }
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: ledsim [--leds N] [--uid UID] [--layout FILE] [--fs DIR] [--tail MS]\n"
+                    "              [--raw] [--out FILE] [--stats] [--quiet] [--fast] [commands.jsonl]\n");
+}
+
+bool parseArgs(int argc, char** argv, SimOptions& options)
+{
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--leds" && hasValue) {
+            long leds = atol(argv[++i]);
+            if (leds <= 0 || leds > 65535) return false;
+            options.leds = static_cast<uint16_t>(leds);
+        } else if (arg == "--uid" && hasValue) {
+            options.uid = argv[++i];
+        } else if (arg == "--layout" && hasValue) {
+            options.layout = argv[++i];
+        } else if (arg == "--fs" && hasValue) {
+            options.fsRoot = argv[++i];
+        } else if (arg == "--tail" && hasValue) {
+            options.tailMs = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--out" && hasValue) {
+            options.output = argv[++i];
+        } else if (arg == "--raw") {
+            options.raw = true;
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--quiet") {
+            options.quiet = true;
+        } else if (arg == "--fast") {
+            options.fast = true;
+        } else if (!arg.startsWith("--") && !options.input) {
+            options.input = argv[i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Same order as WSetup::setupStrip: the LED order, then the matrix
+bool applyLayout(LEDStrip* strip, const char* path, uint16_t ledCount)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "ledsim: cannot open %s\n", path);
+        return false;
+    }
+    std::string text;
+    char buffer[512];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) text.append(buffer, n);
+    fclose(file);
+
+    JsonDocument doc;
+    if (deserializeJson(doc, text)) {
+        fprintf(stderr, "ledsim: %s is not JSON\n", path);
+        return false;
+    }
+    if (!doc["map"].isNull()) {
+        PixelMap map;
+        if (!map.parse(doc["map"], ledCount) || !strip->setPixelMap(map)) {
+            fprintf(stderr, "ledsim: invalid pixel map in %s\n", path);
+            return false;
+        }
+    }
+    if (!doc["matrix"].isNull()) {
+        MatrixConfig matrix;
+        if (!MatrixConfig::parse(doc["matrix"], matrix) || !strip->setMatrix(matrix)) {
+            fprintf(stderr, "ledsim: invalid matrix in %s\n", path);
+            return false;
+        }
+    }
+    return true;
+}
+
+// The device loop: router housekeeping every 10 ms
+void runFor(OmniSourceRouter& router, uint32_t ms)
+{
+    unsigned long start = millis();
+    do {
+        router.handle();
+        delay(10);
+    } while (millis() - start < ms);
+}
+
+// Fast mode: ms of sequence time, one frame per frame interval
+void stepFor(OmniSourceRouter& router, LEDStrip* strip, VirtualClock& clock, uint32_t ms)
+{
+    uint32_t t = 0;
+    while (t < ms) {
+        uint32_t step = std::min(strip->getFrameDelay(), ms - t);
+        router.handle();
+        clock.advance(step);
+        strip->renderStep();
+        t += step;
+    }
+}
+
+// Fast mode: commands run on the scheduler task in real time, let them land
+// before the clock moves on
+void settle(CommandScheduler* scheduler)
+{
+    unsigned long start = millis();
+    while (scheduler && !scheduler->isIdle() && millis() - start < 1000) {
+        delay(1);
+    }
+}
+
+void writePpm()
+{
+    std::lock_guard<std::mutex> lock(frameMutex);
+    if (frameCount == 0 || frameWidth == 0) return;
+    fprintf(frameOut, "P6\n%u %u\n255\n", frameWidth, frameCount);
+    fwrite(frames.data(), 1, frames.size(), frameOut);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    SimOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    if (options.quiet) Serial.setOutput(nullptr);
+    if (options.fsRoot) SPIFFS.setRoot(options.fsRoot);
+
+    FILE* input = options.input ? fopen(options.input, "r") : stdin;
+    if (!input) {
+        fprintf(stderr, "ledsim: cannot open %s\n", options.input);
+        return 1;
+    }
+    if (options.output) {
+        frameOut = fopen(options.output, "wb");
+        if (!frameOut) {
+            fprintf(stderr, "ledsim: cannot write %s\n", options.output);
+            return 1;
+        }
+    }
+    streamRaw = options.raw;
+    Adafruit_NeoPixel::setShowHook(captureFrame);
+
+    NetworkManager nm;
+    OmniSourceRouter router(&nm);
+    IOWrapper wrapper(&router);
+    LEDStrip* strip = new LEDStrip(options.leds, 2, NEO_GRB + NEO_KHZ800);
+    // Before pushOutput, which would start the render task on the real clock
+    VirtualClock clock;
+    if (options.fast) strip->setClock(&clock);
+    wrapper.pushOutput(strip, options.uid);
+    CommandScheduler* scheduler = wrapper.findScheduler(options.uid);
+    router.addStatsProvider("heap", [](JsonObject& out) { HeapStats::getStats(out); });
+    if (options.layout && !applyLayout(strip, options.layout, options.leds)) return 1;
+
+    std::string line;
+    int c;
+    while (true) {
+        line.clear();
+        while ((c = fgetc(input)) != EOF && c != '\n') line += static_cast<char>(c);
+        if (line.find_first_not_of(" \t\r") != std::string::npos) {
+            JsonDocument doc;
+            if (deserializeJson(doc, line) || !doc.is<JsonObject>()) {
+                fprintf(stderr, "ledsim: skipped, not a JSON object: %s\n", line.c_str());
+            } else if (!doc["wait"].isNull()) {
+                if (options.fast) {
+                    stepFor(router, strip, clock, doc["wait"].as<uint32_t>());
+                } else {
+                    runFor(router, doc["wait"].as<uint32_t>());
+                }
+            } else {
+                if (doc["target"].isNull()) doc["target"] = options.uid;
+                String body;
+                serializeJson(doc, body);
+                nm.asyncServer.hostRequest(HTTP_POST, "/", body);
+                router.handle();
+                if (options.fast) settle(scheduler);
+            }
+        }
+        if (c == EOF) break;
+    }
+    if (options.fast) {
+        stepFor(router, strip, clock, options.tailMs);
+    } else {
+        runFor(router, options.tailMs);
+    }
+
+    if (options.stats) {
+        String stats;
+        nm.asyncServer.hostRequest(HTTP_GET, "/stats", String(), &stats);
+        fprintf(stderr, "%s\n", stats.c_str());
+    }
+
+    // The render and scheduler tasks never return, so no destructors run
+    Adafruit_NeoPixel::setShowHook(nullptr);
+    if (!streamRaw) writePpm();
+    fflush(frameOut);
+    fflush(stderr);
+    std::_Exit(0);
+}
@@ -0,0 +1,101 @@
+// Config store flushing, run on the host: pio test -e native
+//
+// SPIFFS is a scratch directory of the host, and the flush task a thread.
+// Replacing the directory with a plain file makes every commit fail, as a
+// full or worn flash would: the write must stay pending, be retried with a
+// back-off rather than hammered, and land once the filesystem takes it again.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <SPIFFS.h>
+#include <ConfigStore.h>
+#include <filesystem>
+#include <fstream>
+
+static const uint32_t WRITE_DELAY_MS = 20;
+
+static std::filesystem::path root;
+
+static uint32_t statOf(const char* key)
+{
+    JsonDocument doc;
+    JsonObject out = doc.to<JsonObject>();
+    ConfigStore::getInstance().getStats(out);
+    return out[key].as<uint32_t>();
+}
+
+// Polls until the stat reaches at least value, false after timeoutMs
+static bool waitForStat(const char* key, uint32_t value, uint32_t timeoutMs)
+{
+    uint32_t start = millis();
+    while (statOf(key) < value) {
+        if (millis() - start > timeoutMs) return false;
+        delay(5);
+    }
+    return true;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_burst_of_writes_is_one_commit()
+{
+    ConfigStore& store = ConfigStore::getInstance();
+    uint32_t writes = statOf("flashWrites");
+    JsonDocument doc;
+    for (int i = 0; i < 10; i++) {
+        doc["value"] = i;
+        store.write("burst.json", doc);
+    }
+    TEST_ASSERT_TRUE(waitForStat("flashWrites", writes + 1, 2000));
+    delay(WRITE_DELAY_MS * 3);
+    TEST_ASSERT_EQUAL_UINT32(writes + 1, statOf("flashWrites"));
+
+    JsonDocument read;
+    TEST_ASSERT_TRUE(store.read("burst.json", read));
+    TEST_ASSERT_EQUAL_INT(9, read["value"].as<int>());
+}
+
+static void test_failed_commit_is_retried()
+{
+    ConfigStore& store = ConfigStore::getInstance();
+    uint32_t failed = statOf("failedWrites");
+    uint32_t retried = statOf("retriedWrites");
+
+    std::filesystem::remove_all(root);
+    std::ofstream(root.string()) << "not a directory";
+    JsonDocument doc;
+    doc["room"] = "hall";
+    store.write("retry.json", doc);
+    TEST_ASSERT_TRUE(waitForStat("failedWrites", failed + 1, 2000));
+    TEST_ASSERT_EQUAL_UINT32(1, statOf("pendingWrites"));
+
+    // Backed off: a few attempts a second, not one per write delay
+    delay(1000);
+    uint32_t attempts = statOf("failedWrites") - failed;
+    char message[64];
+    snprintf(message, sizeof(message), "%u failed commits in about 1 s", static_cast<unsigned>(attempts));
+    TEST_ASSERT_TRUE_MESSAGE(attempts >= 2 && attempts <= 5, message);
+
+    // Nothing else is written: the retry alone must bring the file back
+    std::filesystem::remove(root);
+    std::filesystem::create_directories(root);
+    TEST_ASSERT_TRUE(waitForStat("retriedWrites", retried + 1, 5000));
+    TEST_ASSERT_EQUAL_UINT32(0, statOf("pendingWrites"));
+    TEST_ASSERT_TRUE(SPIFFS.exists("/retry.json"));
+}
+
+int main()
+{
+    root = std::filesystem::temp_directory_path() / "test_configstore";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+    SPIFFS.setRoot(root.string());
+    ConfigStore::getInstance().setWriteDelay(WRITE_DELAY_MS);
+    ConfigStore::getInstance().mount();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_burst_of_writes_is_one_commit);
+    RUN_TEST(test_failed_commit_is_retried);
+    return UNITY_END();
+}
@@ -0,0 +1,196 @@
+// Easing table accuracy, run on the host: pio test -e native
+//
+// Transitions sample Q14 lookup tables (lib/EasingCurve) instead of
+// evaluating the curves. Every TransitionType is compared with its curve
+// evaluated in double precision at many points between the table entries,
+// and the worst error must stay under the bound of its kind. Bezier, steps
+// and sampled curves go through EasingCurve::bake, as prepareEasing does.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <EasingCurve.h>
+#include <TranstionsManager.h>
+#include <cmath>
+#include <functional>
+
+static const int POINTS = 4096;
+// Q14 rounding (3e-5) plus interpolation between 257 entries of a smooth curve
+static const double SMOOTH_BOUND = 1e-4;
+// Elastic oscillates fast near 0: |f''| up to ~440, so h^2 |f''| / 8 ~ 8.4e-4
+static const double ELASTIC_BOUND = 1e-3;
+// Bounce has corners where it touches 1: interpolating across one costs up to
+// |slope jump| * h / 4 ~ 5.4e-3, under one 8-bit brightness step
+static const double BOUNCE_BOUND = 5e-3;
+// Float Newton solve of the bezier x axis, then Q14
+static const double BEZIER_BOUND = 2e-4;
+
+using Curve = std::function<double(double)>;
+
+static double bounceOut(double t)
+{
+    if (t < 1.0 / 2.75) return 7.5625 * t * t;
+    if (t < 2.0 / 2.75) { t -= 1.5 / 2.75; return 7.5625 * t * t + 0.75; }
+    if (t < 2.5 / 2.75) { t -= 2.25 / 2.75; return 7.5625 * t * t + 0.9375; }
+    t -= 2.625 / 2.75;
+    return 7.5625 * t * t + 0.984375;
+}
+
+static double elasticOut(double t)
+{
+    if (t <= 0.0 || t >= 1.0) return t;
+    return std::pow(2.0, -10.0 * t) * std::sin((t - 0.075) * 2.0 * M_PI / 0.3) + 1.0;
+}
+
+static double bezier(double x, double x1, double y1, double x2, double y2)
+{
+    auto axis = [](double s, double p1, double p2) {
+        double inv = 1.0 - s;
+        return 3.0 * inv * inv * s * p1 + 3.0 * inv * s * s * p2 + s * s * s;
+    };
+    double lo = 0.0, hi = 1.0;
+    for (int i = 0; i < 60; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (axis(mid, x1, x2) < x) lo = mid; else hi = mid;
+    }
+    return axis(0.5 * (lo + hi), y1, y2);
+}
+
+// Worst |table - curve| over the points kept by include
+static double maxError(const EasingTable& table, const Curve& curve,
+                       const std::function<bool(double)>& include = nullptr)
+{
+    double worst = 0.0;
+    for (int i = 0; i <= POINTS; i++) {
+        double t = static_cast<double>(i) / POINTS;
+        if (include && !include(t)) continue;
+        double error = std::fabs(EasingCurve::sample(table, static_cast<float>(t)) - curve(t));
+        worst = std::max(worst, error);
+    }
+    return worst;
+}
+
+static void expectWithin(const char* name, const EasingTable& table, const Curve& curve, double bound,
+                         const std::function<bool(double)>& include = nullptr)
+{
+    double error = maxError(table, curve, include);
+    char message[96];
+    snprintf(message, sizeof(message), "%s: max error %.2e, bound %.1e", name, error, bound);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE_MESSAGE(error <= bound, message);
+    TEST_ASSERT_TRUE_MESSAGE(std::fabs(EasingCurve::sample(table, 0.0f) - curve(0.0)) <= bound, name);
+    TEST_ASSERT_TRUE_MESSAGE(std::fabs(EasingCurve::sample(table, 1.0f) - curve(1.0)) <= bound, name);
+}
+
+struct BuiltinCase {
+    TransitionType type;
+    const char* name;
+    Curve curve;
+    double bound;
+};
+
+void setUp() {}
+void tearDown() {}
+
+static void test_builtin_tables()
+{
+    const Curve inQuad = [](double t) { return t * t; };
+    const Curve outQuad = [](double t) { return 1.0 - (1.0 - t) * (1.0 - t); };
+    const Curve inOutQuad = [](double t) { return t < 0.5 ? 2.0 * t * t : 1.0 - 2.0 * (1.0 - t) * (1.0 - t); };
+    const BuiltinCase cases[] = {
+        {TRANSITION_LINEAR, "linear", [](double t) { return t; }, SMOOTH_BOUND},
+        {TRANSITION_EASE_IN, "ease_in", inQuad, SMOOTH_BOUND},
+        {TRANSITION_EASE_OUT, "ease_out", outQuad, SMOOTH_BOUND},
+        {TRANSITION_EASE_IN_OUT, "ease_in_out", inOutQuad, SMOOTH_BOUND},
+        {TRANSITION_EASE_IN_QUAD, "ease_in_quad", inQuad, SMOOTH_BOUND},
+        {TRANSITION_EASE_OUT_QUAD, "ease_out_quad", outQuad, SMOOTH_BOUND},
+        {TRANSITION_EASE_IN_OUT_QUAD, "ease_in_out_quad", inOutQuad, SMOOTH_BOUND},
+        {TRANSITION_EASE_IN_CUBIC, "ease_in_cubic", [](double t) { return t * t * t; }, SMOOTH_BOUND},
+        {TRANSITION_EASE_OUT_CUBIC, "ease_out_cubic",
+         [](double t) { return 1.0 - std::pow(1.0 - t, 3.0); }, SMOOTH_BOUND},
+        {TRANSITION_EASE_IN_OUT_CUBIC, "ease_in_out_cubic",
+         [](double t) { return t < 0.5 ? 4.0 * t * t * t : 1.0 - 4.0 * std::pow(1.0 - t, 3.0); }, SMOOTH_BOUND},
+        {TRANSITION_BOUNCE_OUT, "bounce_out", bounceOut, BOUNCE_BOUND},
+        {TRANSITION_ELASTIC_OUT, "elastic_out", elasticOut, ELASTIC_BOUND},
+    };
+
+    for (const BuiltinCase& c : cases) {
+        const EasingTable* table = TranstionsManager::builtinEasing(c.type);
+        TEST_ASSERT_NOT_NULL_MESSAGE(table, c.name);
+        expectWithin(c.name, *table, c.curve, c.bound);
+    }
+}
+
+static void test_cubic_bezier()
+{
+    const float points[][4] = {
+        {0.25f, 0.1f, 0.25f, 1.0f},      // CSS ease
+        {0.42f, 0.0f, 0.58f, 1.0f},      // ease-in-out
+        {0.68f, -0.55f, 0.27f, 1.55f},   // back in-out, overshoots both ends
+        {0.0f, 0.0f, 1.0f, 1.0f},
+    };
+    TEST_ASSERT_NULL(TranstionsManager::builtinEasing(TRANSITION_CUBIC_BEZIER));
+    for (const auto& p : points) {
+        EasingSpec spec;
+        spec.kind = EasingSpec::BEZIER;
+        spec.x1 = p[0]; spec.y1 = p[1]; spec.x2 = p[2]; spec.y2 = p[3];
+        EasingTable table;
+        EasingCurve::bake(spec, table);
+
+        char name[96];
+        snprintf(name, sizeof(name), "cubic-bezier(%g,%g,%g,%g)", p[0], p[1], p[2], p[3]);
+        expectWithin(name, table, [&](double t) { return bezier(t, p[0], p[1], p[2], p[3]); }, BEZIER_BOUND);
+    }
+}
+
+// Exact between jumps; the table entries either side of a jump ramp across it
+static void test_steps()
+{
+    TEST_ASSERT_NULL(TranstionsManager::builtinEasing(TRANSITION_STEPS));
+    const uint16_t counts[] = {1, 2, 3, 5, 10, 64};
+    for (uint16_t steps : counts) {
+        EasingSpec spec;
+        spec.kind = EasingSpec::STEPS;
+        spec.steps = steps;
+        EasingTable table;
+        EasingCurve::bake(spec, table);
+
+        auto curve = [steps](double t) { return t >= 1.0 ? 1.0 : std::floor(t * steps) / steps; };
+        auto awayFromJumps = [steps](double t) {
+            double jump = std::round(t * steps) / steps;
+            return jump <= 0.0 || std::fabs(t - jump) >= 1.0 / EASING_TABLE_SIZE;
+        };
+        char name[32];
+        snprintf(name, sizeof(name), "steps(%u)", steps);
+        expectWithin(name, table, curve, SMOOTH_BOUND, awayFromJumps);
+    }
+}
+
+// TRANSITION_CUSTOM plays evenly spaced samples joined by straight lines
+static void test_sampled_custom()
+{
+    TEST_ASSERT_NULL(TranstionsManager::builtinEasing(TRANSITION_CUSTOM));
+    EasingSpec spec;
+    spec.kind = EasingSpec::SAMPLED;
+    spec.sampleCount = 5;
+    const float samples[] = {0.0f, 0.6f, 0.2f, 1.2f, 1.0f};
+    memcpy(spec.samples, samples, sizeof(samples));
+    EasingTable table;
+    EasingCurve::bake(spec, table);
+
+    auto curve = [&](double t) {
+        double pos = t * (spec.sampleCount - 1);
+        int k = std::min(static_cast<int>(pos), spec.sampleCount - 2);
+        return samples[k] + (samples[k + 1] - samples[k]) * (pos - k);
+    };
+    expectWithin("sampled", table, curve, SMOOTH_BOUND);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_builtin_tables);
+    RUN_TEST(test_cubic_bezier);
+    RUN_TEST(test_steps);
+    RUN_TEST(test_sampled_custom);
+    return UNITY_END();
+}
@@ -0,0 +1,142 @@
+// Writing a new effect, by example, run on the host: pio test -e native
+//
+// ScannerEffect below is a complete effect: a State struct that lives in the
+// effect arena, zeroed before the first frame, and a render function that
+// only touches its context. To ship one like it, move the type into
+// lib/EffectsManager and append its row to the table in EffectRegistry.cpp:
+//   EffectDescriptor::of<ScannerEffect>("scanner", nullptr, SCANNER_SCHEMA),
+// The tests drive it the way EffectRegistry::render does, through the row
+// EffectDescriptor::of builds, on a canvas the arena and the context share.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <EffectRegistry.h>
+#include <algorithm>
+#include <vector>
+
+/**
+ * @brief Eye bouncing between both ends of the strip, leaving a fading trail
+ */
+struct ScannerEffect : EffectBase {
+    struct State {
+        uint32_t position;   ///< Eye position, 1/16 pixel
+        int8_t direction;    ///< +1 or -1, 0 before the first frame
+    };
+    static void render(EffectContext& ctx);
+};
+
+void ScannerEffect::render(EffectContext& ctx)
+{
+    State& s = ctx.stateAs<State>();
+    if (s.direction == 0) {
+        s.direction = 1;   // State starts zeroed, no init needed
+    }
+
+    // Longer trail at low speed
+    effectFade(ctx, std::min(0.5f, 0.08f + 0.03f * ctx.speed));
+
+    int32_t end = (static_cast<int32_t>(ctx.count) - 1) * 16;
+    int32_t step = static_cast<int32_t>(std::max(1.0f, ctx.speed * 8.0f));
+    int32_t next = static_cast<int32_t>(s.position) + s.direction * step;
+    if (next >= end) {
+        next = end;
+        s.direction = -1;
+    } else if (next <= 0) {
+        next = 0;
+        s.direction = 1;
+    }
+    s.position = next;
+
+    // Eye spread over the two pixels around the sub-pixel position
+    uint32_t pixel = s.position >> 4;
+    float frac = (s.position & 15) / 16.0f;
+    float brightness = std::min(1.0f, ctx.intensity);
+    ctx.pixels[pixel] = ctx.pixels[pixel].blend(ctx.color1.scale(brightness), 1.0f - frac);
+    if (pixel + 1 < ctx.count) {
+        ctx.pixels[pixel + 1] = ctx.pixels[pixel + 1].blend(ctx.color1.scale(brightness), frac);
+    }
+}
+
+// One color; intensity stops at 1 where the render caps brightness, and
+// below speed 0.125 the eye would stop moving
+static constexpr EffectSchema SCANNER_SCHEMA{1, 0.125f, 10.0f, 0.0f, 1.0f};
+static constexpr EffectDescriptor SCANNER = EffectDescriptor::of<ScannerEffect>("scanner", nullptr, SCANNER_SCHEMA);
+
+// A canvas and an arena bound the way the registry binds them
+struct ExampleInstance {
+    std::vector<WColor> pixels;
+    std::vector<uint32_t> arena;
+    EffectContext ctx;
+
+    ExampleInstance(uint16_t count, float speed)
+        : pixels(count), arena((SCANNER.stateSize + 3) / 4, 0), ctx()
+    {
+        ctx.pixels = pixels.data();
+        ctx.count = count;
+        ctx.speed = SCANNER.schema.clampSpeed(speed);
+        ctx.intensity = SCANNER.schema.clampIntensity(1.0f);
+        ctx.color1 = WColor(255, 0, 0);
+        ctx.state = arena.data();
+    }
+
+    const ScannerEffect::State& state() const { return ctx.stateAs<ScannerEffect::State>(); }
+
+    void frame()
+    {
+        SCANNER.render(ctx);
+        ctx.frame++;
+    }
+};
+
+void setUp() {}
+void tearDown() {}
+
+static void test_descriptor_describes_the_type()
+{
+    TEST_ASSERT_EQUAL_UINT32(sizeof(ScannerEffect::State), SCANNER.stateSize);
+    TEST_ASSERT_EQUAL_UINT32(0, SCANNER.pixelStateSize);
+    TEST_ASSERT_TRUE(SCANNER.init == nullptr);
+    TEST_ASSERT_TRUE(SCANNER.render == ScannerEffect::render);
+    // Registering it must not grow the arena of every other effect
+    TEST_ASSERT_TRUE(SCANNER.stateSize <= EffectRegistry::arenaWords(0) * 4);
+}
+
+static void test_eye_bounces_between_both_ends()
+{
+    ExampleInstance scanner(30, 2.0f);
+    bool reachedEnd = false;
+    bool cameBack = false;
+    for (int i = 0; i < 200; i++) {
+        scanner.frame();
+        uint32_t pixel = scanner.state().position >> 4;
+        TEST_ASSERT_TRUE(pixel < 30);
+        TEST_ASSERT_EQUAL_UINT8(255, scanner.pixels[pixel].r);
+        if (pixel == 29) reachedEnd = true;
+        if (reachedEnd && pixel == 0) cameBack = true;
+    }
+    TEST_ASSERT_TRUE(reachedEnd);
+    TEST_ASSERT_TRUE(cameBack);
+}
+
+// Past 4096 pixels the far end no longer fits 16 bits of 1/16 pixel
+static void test_eye_crosses_long_strips()
+{
+    const uint16_t count = 6000;
+    ExampleInstance scanner(count, 10.0f);
+    uint32_t furthest = 0;
+    for (int i = 0; i < 1300; i++) {
+        scanner.frame();
+        furthest = std::max(furthest, scanner.state().position >> 4);
+    }
+    TEST_ASSERT_EQUAL_UINT32(count - 1, furthest);
+    TEST_ASSERT_EQUAL_INT(-1, scanner.state().direction);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_descriptor_describes_the_type);
+    RUN_TEST(test_eye_bounces_between_both_ends);
+    RUN_TEST(test_eye_crosses_long_strips);
+    return UNITY_END();
+}
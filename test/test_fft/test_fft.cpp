@@ -0,0 +1,225 @@
+// Fixed point FFT accuracy and timing, run on the host: pio test -e native
+//
+// FixedFFT is compared with a direct DFT in double precision over the same
+// input, scaled by 1/n as the Q15 transform is. Tones on and between bins,
+// two tones far apart in level and white noise go through every size from
+// 64 to FFT_MAX_SIZE; the worst bin error is bounded in Q15 units and the
+// strongest bin must be the same. The timing test runs both on the
+// AudioAnalyzer default size and reports the speedup.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <FixedFFT.h>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+// Every stage floors its products and its halved sums, a bias of under one
+// LSB per stage that the next stage halves but adds to again: the worst bin
+// error grows with log2 n, 3.6 at 64 points and 7.3 at 1024
+static const double STAGE_BOUND = 0.75;
+// Hann in Q15 against the exact window, carried into the spectrum
+static const double WINDOW_BOUND = 0.5;
+static const size_t TIMED_SIZE = 512;
+
+static double binBound(size_t n)
+{
+    return 1.0 + STAGE_BOUND * std::log2(static_cast<double>(n));
+}
+
+using Signal = std::function<int16_t(size_t i, size_t n)>;
+
+struct SignalCase {
+    const char* name;
+    Signal signal;
+};
+
+struct Spectrum {
+    std::vector<double> re;
+    std::vector<double> im;
+};
+
+// X[k] / n for the first n/2 bins, twiddles from a table like the FFT's
+static Spectrum referenceDft(const std::vector<double>& x, const std::vector<double>& cosTable,
+                             const std::vector<double>& sinTable)
+{
+    size_t n = x.size();
+    Spectrum out;
+    out.re.assign(n / 2, 0.0);
+    out.im.assign(n / 2, 0.0);
+    for (size_t k = 0; k < n / 2; k++) {
+        double re = 0.0, im = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            size_t phase = (k * i) % n;
+            re += x[i] * cosTable[phase];
+            im -= x[i] * sinTable[phase];
+        }
+        out.re[k] = re / n;
+        out.im[k] = im / n;
+    }
+    return out;
+}
+
+static void twiddles(size_t n, std::vector<double>& cosTable, std::vector<double>& sinTable)
+{
+    cosTable.resize(n);
+    sinTable.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        cosTable[i] = std::cos(2.0 * M_PI * i / n);
+        sinTable[i] = std::sin(2.0 * M_PI * i / n);
+    }
+}
+
+static int16_t tone(double cycles, double amplitude, size_t i, size_t n)
+{
+    return static_cast<int16_t>(std::lround(amplitude * std::sin(2.0 * M_PI * cycles * i / n)));
+}
+
+static const std::vector<SignalCase> CASES = {
+    {"tone on bin 10", [](size_t i, size_t n) { return tone(10.0, 30000.0, i, n); }},
+    {"tone between bins", [](size_t i, size_t n) { return tone(n / 8 + 0.5, 30000.0, i, n); }},
+    {"tone near nyquist", [](size_t i, size_t n) { return tone(n / 2 - 3, 20000.0, i, n); }},
+    {"loud and quiet tones", [](size_t i, size_t n) {
+         return static_cast<int16_t>(tone(5.0, 28000.0, i, n) + tone(n / 4, 300.0, i, n));
+     }},
+    {"white noise", [](size_t i, size_t) {
+         uint32_t x = (i + 1) * 2654435761u;
+         x ^= x >> 15;
+         x *= 0x2c1b3c6du;
+         x ^= x >> 12;
+         return static_cast<int16_t>(static_cast<int32_t>(x & 0xFFFF) - 32768);
+     }},
+};
+
+static size_t strongestBin(const std::vector<double>& power)
+{
+    size_t best = 1;
+    for (size_t k = 1; k < power.size(); k++) {
+        if (power[k] > power[best]) best = k;
+    }
+    return best;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// Transform alone: the reference gets the same Q15 windowed samples
+static void test_transform_matches_dft()
+{
+    for (size_t n = 64; n <= FFT_MAX_SIZE; n *= 2) {
+        FixedFFT fft(n);
+        TEST_ASSERT_EQUAL_UINT32(n, fft.size());
+        std::vector<double> cosTable, sinTable;
+        twiddles(n, cosTable, sinTable);
+
+        for (const SignalCase& c : CASES) {
+            std::vector<int16_t> samples(n), re(n), im(n);
+            for (size_t i = 0; i < n; i++) samples[i] = c.signal(i, n);
+            fft.window(samples.data(), re.data(), im.data());
+            std::vector<double> windowed(re.begin(), re.end());
+            fft.transform(re.data(), im.data());
+            Spectrum expected = referenceDft(windowed, cosTable, sinTable);
+
+            double worst = 0.0;
+            for (size_t k = 0; k < n / 2; k++) {
+                worst = std::max(worst, std::hypot(re[k] - expected.re[k], im[k] - expected.im[k]));
+            }
+            char message[96];
+            snprintf(message, sizeof(message), "n=%u %s: max bin error %.2f, bound %.2f",
+                     static_cast<unsigned>(n), c.name, worst, binBound(n));
+            TEST_ASSERT_TRUE_MESSAGE(worst <= binBound(n), message);
+        }
+    }
+}
+
+// Window, transform and power as AudioAnalyzer runs them, against an exact Hann and DFT
+static void test_power_matches_dft()
+{
+    for (size_t n = 64; n <= FFT_MAX_SIZE; n *= 2) {
+        FixedFFT fft(n);
+        std::vector<double> cosTable, sinTable;
+        twiddles(n, cosTable, sinTable);
+
+        for (const SignalCase& c : CASES) {
+            std::vector<int16_t> samples(n), re(n), im(n);
+            std::vector<double> windowed(n);
+            for (size_t i = 0; i < n; i++) {
+                samples[i] = c.signal(i, n);
+                windowed[i] = samples[i] * (0.5 - 0.5 * cosTable[i]);
+            }
+            fft.window(samples.data(), re.data(), im.data());
+            fft.transform(re.data(), im.data());
+            std::vector<uint32_t> power(n / 2);
+            fft.power(re.data(), im.data(), power.data());
+            Spectrum expected = referenceDft(windowed, cosTable, sinTable);
+
+            std::vector<double> expectedPower(n / 2), actualPower(n / 2);
+            double worst = 0.0;
+            for (size_t k = 0; k < n / 2; k++) {
+                expectedPower[k] = expected.re[k] * expected.re[k] + expected.im[k] * expected.im[k];
+                actualPower[k] = power[k];
+                // Compared as magnitudes, so the bound stays in Q15 units
+                worst = std::max(worst, std::fabs(std::sqrt(actualPower[k]) - std::sqrt(expectedPower[k])));
+            }
+            char message[112];
+            snprintf(message, sizeof(message), "n=%u %s: max magnitude error %.2f, bound %.2f",
+                     static_cast<unsigned>(n), c.name, worst, binBound(n) + WINDOW_BOUND);
+            TEST_ASSERT_TRUE_MESSAGE(worst <= binBound(n) + WINDOW_BOUND, message);
+            if (strcmp(c.name, "white noise") != 0) {
+                TEST_ASSERT_EQUAL_UINT32_MESSAGE(strongestBin(expectedPower), strongestBin(actualPower), message);
+            }
+        }
+    }
+}
+
+template <typename Fn>
+static double microsPerRun(uint32_t runs, Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < runs; r++) fn();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / runs;
+}
+
+// The per block cost of the analyzer against the direct DFT it replaces
+static void test_timing_against_dft()
+{
+    const size_t n = TIMED_SIZE;
+    FixedFFT fft(n);
+    std::vector<double> cosTable, sinTable;
+    twiddles(n, cosTable, sinTable);
+    std::vector<int16_t> samples(n), re(n), im(n);
+    std::vector<uint32_t> power(n / 2);
+    for (size_t i = 0; i < n; i++) samples[i] = CASES[3].signal(i, n);
+
+    volatile uint32_t sink = 0;
+    double fftUs = microsPerRun(2000, [&]() {
+        fft.window(samples.data(), re.data(), im.data());
+        fft.transform(re.data(), im.data());
+        fft.power(re.data(), im.data(), power.data());
+        sink = sink + power[5];
+    });
+    double dftUs = microsPerRun(20, [&]() {
+        std::vector<double> windowed(n);
+        for (size_t i = 0; i < n; i++) windowed[i] = samples[i] * (0.5 - 0.5 * cosTable[i]);
+        Spectrum spectrum = referenceDft(windowed, cosTable, sinTable);
+        sink = sink + static_cast<uint32_t>(spectrum.re[5]);
+    });
+
+    char message[128];
+    snprintf(message, sizeof(message), "n=%u: fixed FFT %.1f us/block, double DFT %.1f us/block (%.0fx)",
+             static_cast<unsigned>(n), fftUs, dftUs, dftUs / fftUs);
+    TEST_MESSAGE(message);
+    // n log2 n against n^2 / 2: anything under 10x means the FFT went quadratic
+    TEST_ASSERT_TRUE_MESSAGE(dftUs > 10.0 * fftUs, message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_transform_matches_dft);
+    RUN_TEST(test_power_matches_dft);
+    RUN_TEST(test_timing_against_dft);
+    return UNITY_END();
+}
@@ -0,0 +1,154 @@
+// Gesture detection tests, run on the host: pio test -e native
+//
+// Raw edge timelines, bounces included, are replayed in real time through a
+// PushBtn the way IOWrapper::checkTaskLoop drives it: edges due by now are
+// handed to onEdge, check() runs, then the loop sleeps until the next edge
+// or msUntilDeadline. Each case lists the gestures the button must report,
+// in order, and how many debounced state changes reach onChange.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <pushBtn.h>
+#include <GestureDetector.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct RawEdge {
+    uint32_t at;             ///< ms from the start of the timeline
+    bool level;              ///< Pin level, HIGH is pressed (not active low)
+};
+
+struct GestureCase {
+    const char* name;
+    std::vector<RawEdge> edges;
+    std::vector<InputGesture> expected;
+};
+
+static const char* gestureName(InputGesture gesture)
+{
+    switch (gesture) {
+    case GESTURE_PRESS: return "press";
+    case GESTURE_RELEASE: return "release";
+    case GESTURE_CLICK: return "click";
+    case GESTURE_DOUBLE_CLICK: return "double";
+    case GESTURE_LONG_PRESS: return "long";
+    default: return "none";
+    }
+}
+
+static std::string describe(const std::vector<InputGesture>& gestures)
+{
+    std::string out;
+    for (InputGesture gesture : gestures) {
+        if (!out.empty()) out += " ";
+        out += gestureName(gesture);
+    }
+    return out;
+}
+
+// Default timing: 30 ms debounce, 250 ms double click window, 600 ms long press
+static const std::vector<GestureCase> CASES = {
+    {"clean click", {{0, HIGH}, {100, LOW}},
+     {GESTURE_PRESS, GESTURE_RELEASE, GESTURE_CLICK}},
+    {"bouncing click", {{0, HIGH}, {2, LOW}, {3, HIGH}, {6, LOW}, {9, HIGH},
+                        {120, LOW}, {121, HIGH}, {124, LOW}, {126, HIGH}, {128, LOW}},
+     {GESTURE_PRESS, GESTURE_RELEASE, GESTURE_CLICK}},
+    {"double click", {{0, HIGH}, {80, LOW}, {160, HIGH}, {240, LOW}},
+     {GESTURE_PRESS, GESTURE_RELEASE, GESTURE_PRESS, GESTURE_RELEASE, GESTURE_DOUBLE_CLICK}},
+    {"bouncing double click", {{0, HIGH}, {1, LOW}, {4, HIGH}, {90, LOW}, {92, HIGH}, {95, LOW},
+                               {180, HIGH}, {183, LOW}, {185, HIGH}, {260, LOW}, {262, HIGH}, {264, LOW}},
+     {GESTURE_PRESS, GESTURE_RELEASE, GESTURE_PRESS, GESTURE_RELEASE, GESTURE_DOUBLE_CLICK}},
+    {"long press", {{0, HIGH}, {3, LOW}, {5, HIGH}, {800, LOW}},
+     {GESTURE_PRESS, GESTURE_LONG_PRESS, GESTURE_RELEASE}},
+    {"click then long press", {{0, HIGH}, {80, LOW}, {160, HIGH}, {900, LOW}},
+     {GESTURE_PRESS, GESTURE_RELEASE, GESTURE_PRESS, GESTURE_CLICK, GESTURE_LONG_PRESS, GESTURE_RELEASE}},
+    {"two clicks too far apart", {{0, HIGH}, {80, LOW}, {450, HIGH}, {530, LOW}},
+     {GESTURE_PRESS, GESTURE_RELEASE, GESTURE_CLICK, GESTURE_PRESS, GESTURE_RELEASE, GESTURE_CLICK}},
+    // The leading edge is taken at once; the level at the end of the window undoes it
+    {"glitch", {{0, HIGH}, {4, LOW}},
+     {GESTURE_PRESS, GESTURE_RELEASE, GESTURE_CLICK}},
+};
+
+static void sleepUntil(uint32_t deadline)
+{
+    int32_t remaining = static_cast<int32_t>(deadline - millis());
+    if (remaining > 0) std::this_thread::sleep_for(std::chrono::milliseconds(remaining));
+}
+
+// Plays the timeline, returns the gestures reported and counts onChange calls
+static std::vector<InputGesture> replay(const GestureCase& gestureCase, uint32_t& changes)
+{
+    PushBtn button(4);
+    std::vector<InputGesture> gestures;
+    changes = 0;
+    button.onGesture([&](DInput*, InputGesture gesture) { gestures.push_back(gesture); });
+    button.onChange([&](DInput*) { changes++; });
+
+    const std::vector<RawEdge>& edges = gestureCase.edges;
+    uint32_t start = millis();
+    size_t next = 0;
+    while (true) {
+        uint32_t now = millis();
+        while (next < edges.size() && static_cast<int32_t>(now - (start + edges[next].at)) >= 0) {
+            button.onEdge(edges[next].level, start + edges[next].at);
+            next++;
+        }
+
+        button.check();
+
+        uint32_t wait = button.msUntilDeadline(millis());
+        if (next < edges.size()) {
+            int32_t untilEdge = static_cast<int32_t>(start + edges[next].at - millis());
+            wait = std::min<uint32_t>(wait, std::max<int32_t>(untilEdge, 0));
+        } else if (wait == GestureDetector::NO_DEADLINE) {
+            break;
+        }
+        sleepUntil(millis() + wait);
+    }
+    return gestures;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_edge_timelines()
+{
+    for (const GestureCase& gestureCase : CASES) {
+        uint32_t changes = 0;
+        std::vector<InputGesture> actual = replay(gestureCase, changes);
+
+        char message[192];
+        snprintf(message, sizeof(message), "%s: expected [%s], got [%s]", gestureCase.name,
+                 describe(gestureCase.expected).c_str(), describe(actual).c_str());
+        TEST_ASSERT_TRUE_MESSAGE(actual == gestureCase.expected, message);
+
+        uint32_t expectedChanges = std::count_if(gestureCase.expected.begin(), gestureCase.expected.end(),
+            [](InputGesture g) { return g == GESTURE_PRESS || g == GESTURE_RELEASE; });
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(expectedChanges, changes, gestureCase.name);
+    }
+}
+
+// Idle buttons must not keep the input task polling
+static void test_idle_button_has_no_deadline()
+{
+    PushBtn button(4);
+    button.check();
+    TEST_ASSERT_EQUAL_UINT32(GestureDetector::NO_DEADLINE, button.msUntilDeadline(millis()));
+
+    uint32_t now = millis();
+    button.onEdge(HIGH, now);
+    TEST_ASSERT_EQUAL_UINT32(0, button.msUntilDeadline(now));
+    button.check();
+    TEST_ASSERT_TRUE(button.msUntilDeadline(millis()) <= 600);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_edge_timelines);
+    RUN_TEST(test_idle_button_has_no_deadline);
+    return UNITY_END();
+}
@@ -0,0 +1,185 @@
+// Golden frames on a virtual clock, run on the host: pio test -e native
+//
+// Each case applies JSON commands to a strip whose clock only moves when the
+// test steps it, renders its duration at the strip frame rate and hashes the
+// driver buffer at four checkpoints. Randomized effects are seeded, so every
+// run shows the same frames. A change to an effect, an easing, or the
+// transition and gradient paths fails here with the new hashes in the
+// message, to paste into the table when the change is intended. The hashes
+// are those of the x86-64 build; float rounding may differ on other hosts.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <LEDStrip.h>
+#include <Clock.h>
+#include <Timeline.h>
+#include <algorithm>
+#include <chrono>
+
+static const uint16_t GOLDEN_PIXELS = 30;
+static const int CHECKPOINTS = 4;
+
+struct GoldenCase {
+    const char* name;
+    const char* setup;      ///< Rendered for 200 ms before the command, nullptr when none
+    const char* command;
+    uint32_t durationMs;
+    uint32_t hashes[CHECKPOINTS];   ///< After 1/4, 1/2, 3/4 and all of the duration
+};
+
+static const GoldenCase CASES[] = {
+    {"fill with transition", R"({"fill": {"color": "red"}})",
+     R"({"fill": {"color": "blue", "transitionDuration": 600, "transitionType": "ease_in_out_cubic"}})",
+     800, {0x0bf56325, 0xd97d7125, 0x83373c1f, 0x83373c1f}},
+    {"rainbow", nullptr,
+     R"({"effect": {"type": "rainbow", "speed": 2}})",
+     1000, {0x60a908a8, 0xb07224a4, 0x653b410a, 0x754b708c}},
+    {"seeded sparkle", nullptr,
+     R"({"effect": {"type": "sparkle", "seed": 42, "colors": ["white"]}})",
+     1000, {0xbd361cdf, 0xb4649900, 0x251665d8, 0x30e75ac6}},
+    {"seeded fire", nullptr,
+     R"({"effect": {"type": "fire", "seed": 7}})",
+     1000, {0x5a89aab8, 0x5f836494, 0x0cae8815, 0x7357c89a}},
+    {"seeded twinkle", nullptr,
+     R"({"effect": {"type": "twinkle", "seed": 11}})",
+     1000, {0x1c670ead, 0xed4dacf1, 0xd0870add, 0x3954a18a}},
+    {"effect crossfade", R"({"effect": {"type": "rainbow"}})",
+     R"j({"effect": {"type": "comets", "seed": 3, "colors": ["orange"], "emitter": {"rate": 8}, "transitionDuration": 500, "transitionType": "cubic-bezier(0.3, 0, 0.2, 1)"}})j",
+     800, {0xb357113a, 0x05205892, 0x6d77d87c, 0x5632939e}},
+    {"rotating gradient", nullptr,
+     R"({"gradient": {"stops": [{"color": "red", "position": 0}, {"color": "green", "position": 0.5},
+        {"color": "blue", "position": 1}], "animate": "rotate", "speed": 12}})",
+     1200, {0x333ca0f5, 0xa6163da5, 0xc6f81f59, 0xfd0366d9}},
+    {"gradient transition", R"({"gradient": {"start": "red", "end": "blue"}})",
+     R"j({"gradient": {"start": "yellow", "end": "purple", "smooth": true, "duration": 400, "easing": "steps(4)"}})j",
+     600, {0x7ff339bd, 0x1002b26d, 0x8e75ca3d, 0x8e75ca3d}},
+    {"looping sequence", nullptr,
+     R"({"fill": {"color": "red", "transitionDuration": 300},
+        "then": [{"fill": {"color": "green", "transitionDuration": 300}},
+                 {"effect": {"type": "chase", "colors": ["white"]}}], "loop": true})",
+     3000, {0xc46f9507, 0x5f38bf23, 0xa643b855, 0x55602fe0}},
+};
+
+// FNV-1a over the bytes the LEDs would receive
+static uint32_t frameHash(LEDStrip& strip)
+{
+    const uint8_t* bytes = strip.neopixel.getPixels();
+    size_t size = static_cast<size_t>(strip.neopixel.numPixels()) * 3;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void apply(LEDStrip& strip, const char* command)
+{
+    JsonDocument doc;
+    TEST_ASSERT_FALSE_MESSAGE(deserializeJson(doc, command), command);
+    JsonObject json = doc.as<JsonObject>();
+    strip.jsonInterpreter(json);
+}
+
+// Frames at the strip frame rate, the last one landing exactly ms later
+static void renderFor(LEDStrip& strip, VirtualClock& clock, uint32_t ms)
+{
+    uint32_t t = 0;
+    while (t < ms) {
+        uint32_t step = std::min(strip.getFrameDelay(), ms - t);
+        clock.advance(step);
+        strip.renderStep();
+        t += step;
+    }
+}
+
+static void renderCase(const GoldenCase& c, uint32_t out[CHECKPOINTS])
+{
+    VirtualClock clock;
+    LEDStrip strip(GOLDEN_PIXELS, 2);
+    strip.setClock(&clock);
+
+    if (c.setup) {
+        apply(strip, c.setup);
+        renderFor(strip, clock, 200);
+    }
+    apply(strip, c.command);
+    for (int i = 0; i < CHECKPOINTS; i++) {
+        renderFor(strip, clock, c.durationMs / CHECKPOINTS);
+        out[i] = frameHash(strip);
+    }
+    strip.timeline->stop();
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_frames_match_golden_hashes()
+{
+    int failures = 0;
+    for (const GoldenCase& c : CASES) {
+        uint32_t hashes[CHECKPOINTS];
+        renderCase(c, hashes);
+        if (memcmp(hashes, c.hashes, sizeof(hashes)) != 0) {
+            char message[160];
+            snprintf(message, sizeof(message), "%s: {0x%08x, 0x%08x, 0x%08x, 0x%08x}", c.name,
+                     hashes[0], hashes[1], hashes[2], hashes[3]);
+            TEST_MESSAGE(message);
+            failures++;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, failures, "frames differ from the golden hashes");
+}
+
+// The same case twice in one process: no state leaks between strips
+static void test_rendering_is_reproducible()
+{
+    uint32_t first[CHECKPOINTS];
+    uint32_t second[CHECKPOINTS];
+    for (const GoldenCase& c : CASES) {
+        renderCase(c, first);
+        renderCase(c, second);
+        TEST_ASSERT_EQUAL_UINT32_ARRAY_MESSAGE(first, second, CHECKPOINTS, c.name);
+    }
+}
+
+// Two hours of a looping sequence, fast-forwarded: every cycle shows the same
+// frames at the same offset, and the run takes seconds
+static void test_fast_forward_keeps_loop_phase()
+{
+    VirtualClock clock;
+    LEDStrip strip(GOLDEN_PIXELS, 2);
+    strip.setClock(&clock);
+    apply(strip, R"({"fill": {"color": "red", "transitionDuration": 400},
+        "then": [{"fill": {"color": "blue", "transitionDuration": 400}},
+                 {"gradient": {"start": "orange", "end": "cyan"}}], "loop": true})");
+
+    // One frame into the second cycle, clear of the first cycle's start-up
+    renderFor(strip, clock, 50);
+    uint32_t cycle = strip.timeline->getCycleLength();
+    TEST_ASSERT_TRUE(cycle > 0);
+    renderFor(strip, clock, cycle);
+    uint32_t start = clock.now();
+    uint32_t phase = frameHash(strip);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    const uint32_t twoHours = 2u * 3600u * 1000u;
+    uint32_t cycles = twoHours / cycle;
+    renderFor(strip, clock, cycles * cycle);
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    TEST_ASSERT_EQUAL_UINT32(start + cycles * cycle, clock.now());
+    TEST_ASSERT_EQUAL_HEX32(phase, frameHash(strip));
+    char message[96];
+    snprintf(message, sizeof(message), "%u cycles of %u ms in %.2f s", cycles, cycle, wallSeconds);
+    TEST_MESSAGE(message);
+    strip.timeline->stop();
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_frames_match_golden_hashes);
+    RUN_TEST(test_rendering_is_reproducible);
+    RUN_TEST(test_fast_forward_keeps_loop_phase);
+    return UNITY_END();
+}
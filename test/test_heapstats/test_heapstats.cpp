@@ -0,0 +1,213 @@
+// Allocation counters and the allocation-free render loop, run on the host:
+// pio test -e native
+//
+// The native environment links the malloc hooks, so every allocation of a
+// thread tagged ALLOC_RENDER is counted. Each scene is applied, warmed up so
+// buffers reach their steady size, then rendered for a few hundred frames
+// with the test thread tagged as a render task: any allocation there fails
+// the test with the scene and the bytes it took. Sequences are left out,
+// their keyframes apply commands from the timeline.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <HeapStats.h>
+#include <LEDStrip.h>
+#include <Clock.h>
+#include <EffectRegistry.h>
+#include <EffectsManager.h>
+#include <TranstionsManager.h>
+#include <Timeline.h>
+#include <algorithm>
+#include <vector>
+
+static const uint16_t TEST_PIXELS = 60;
+static const uint32_t WARMUP_MS = 2000;
+static const uint32_t MEASURE_MS = 6000;
+
+static void apply(LEDStrip& strip, const char* command)
+{
+    JsonDocument doc;
+    TEST_ASSERT_FALSE_MESSAGE(deserializeJson(doc, command), command);
+    JsonObject json = doc.as<JsonObject>();
+    strip.jsonInterpreter(json);
+}
+
+static void renderFor(LEDStrip& strip, VirtualClock& clock, uint32_t ms)
+{
+    uint32_t t = 0;
+    while (t < ms) {
+        uint32_t step = std::min(strip.getFrameDelay(), ms - t);
+        clock.advance(step);
+        strip.renderStep();
+        t += step;
+    }
+}
+
+// Allocations the render loop made while rendering ms of the scene
+static AllocCounters renderAllocations(LEDStrip& strip, VirtualClock& clock, uint32_t ms)
+{
+    AllocCounters before = HeapStats::counters(ALLOC_RENDER);
+    HeapStats::tagTask(ALLOC_RENDER);
+    renderFor(strip, clock, ms);
+    HeapStats::untagTask();
+    AllocCounters after = HeapStats::counters(ALLOC_RENDER);
+    AllocCounters out = {};
+    out.count = after.count - before.count;
+    out.bytes = after.bytes - before.bytes;
+    return out;
+}
+
+// Applies setup then command, warms up and counts what the steady frames allocate
+static void checkScene(const char* name, const char* setup, const char* command, uint32_t warmupMs)
+{
+    VirtualClock clock;
+    LEDStrip strip(TEST_PIXELS, 2);
+    strip.setClock(&clock);
+    if (setup) {
+        apply(strip, setup);
+        renderFor(strip, clock, 200);
+    }
+    apply(strip, command);
+    renderFor(strip, clock, warmupMs);
+
+    AllocCounters c = renderAllocations(strip, clock, MEASURE_MS);
+    if (c.count != 0) {
+        char message[128];
+        snprintf(message, sizeof(message), "%s: %u allocations, %u bytes after warmup", name,
+                 static_cast<unsigned>(c.count), static_cast<unsigned>(c.bytes));
+        TEST_FAIL_MESSAGE(message);
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_counters_follow_the_tagged_task()
+{
+    HeapStats::tagTask(ALLOC_JOURNAL);
+    TEST_ASSERT_EQUAL(ALLOC_JOURNAL, HeapStats::currentSubsystem());
+    AllocCounters before = HeapStats::counters(ALLOC_JOURNAL);
+
+    std::vector<uint8_t>* buffer = new std::vector<uint8_t>(4096);
+    AllocCounters during = HeapStats::counters(ALLOC_JOURNAL);
+    TEST_ASSERT_EQUAL_UINT32(before.count + 2, during.count);
+    TEST_ASSERT_TRUE(during.bytes - before.bytes >= 4096 + sizeof(*buffer));
+    TEST_ASSERT_TRUE(during.live - before.live >= 4096);
+    TEST_ASSERT_TRUE(during.peak >= during.live);
+
+    delete buffer;
+    AllocCounters after = HeapStats::counters(ALLOC_JOURNAL);
+    HeapStats::untagTask();
+    TEST_ASSERT_EQUAL_INT32(before.live, after.live);
+    TEST_ASSERT_EQUAL_INT32(during.peak, after.peak);
+    TEST_ASSERT_EQUAL(ALLOC_OTHER, HeapStats::currentSubsystem());
+
+    // Untagged, nothing more lands in the journal counters
+    void* block = malloc(64);
+    free(block);
+    TEST_ASSERT_EQUAL_UINT32(after.count, HeapStats::counters(ALLOC_JOURNAL).count);
+}
+
+static void test_every_effect_renders_without_allocating()
+{
+    char command[128];
+    for (size_t id = 1; id < EffectRegistry::count(); id++) {
+        const char* name = EffectRegistry::get(static_cast<EffectType>(id)).name;
+        snprintf(command, sizeof(command), R"({"effect": {"type": "%s", "seed": 5}})", name);
+        checkScene(name, nullptr, command, WARMUP_MS);
+    }
+}
+
+static void test_gradients_and_transitions_render_without_allocating()
+{
+    checkScene("rotating gradient", nullptr,
+               R"({"gradient": {"stops": [{"color": "red", "position": 0}, {"color": "yellow", "position": 0.2},
+                  {"color": "green", "position": 0.4}, {"color": "cyan", "position": 0.6},
+                  {"color": "blue", "position": 0.8}, {"color": "purple", "position": 1}],
+                  "animate": "rotate", "speed": 12}})",
+               WARMUP_MS);
+    // Counted while the crossfade runs, warmed up on a first crossfade
+    checkScene("effect crossfade", R"({"effect": {"type": "rainbow"}})",
+               R"({"effect": {"type": "fire", "seed": 7, "transitionDuration": 20000}})", 500);
+    checkScene("fill transition", R"({"fill": {"color": "red"}})",
+               R"({"fill": {"color": "blue", "transitionDuration": 20000, "transitionType": "ease_in_out_cubic"}})", 500);
+    checkScene("gradient transition", R"({"gradient": {"start": "red", "end": "blue"}})",
+               R"({"gradient": {"start": "yellow", "end": "purple", "smooth": true, "duration": 20000}})", 500);
+}
+
+// Gradient transitions lerp two buffers rasterized into reserved scratch:
+// counted from their first frame, whatever the stop counts and direction
+static void test_gradient_transitions_allocate_nothing_per_frame()
+{
+    checkScene("2 stops to 8", R"({"gradient": {"start": "red", "end": "blue"}})",
+               R"({"gradient": {"stops": [{"color": "red", "position": 0}, {"color": "orange", "position": 0.14},
+                  {"color": "yellow", "position": 0.28}, {"color": "green", "position": 0.42},
+                  {"color": "cyan", "position": 0.57}, {"color": "blue", "position": 0.71},
+                  {"color": "purple", "position": 0.85}, {"color": "white", "position": 1}],
+                  "smooth": true, "duration": 4000}})", 0);
+    checkScene("8 stops to 2", R"({"gradient": {"stops": [{"color": "red", "position": 0},
+                  {"color": "orange", "position": 0.14}, {"color": "yellow", "position": 0.28},
+                  {"color": "green", "position": 0.42}, {"color": "cyan", "position": 0.57},
+                  {"color": "blue", "position": 0.71}, {"color": "purple", "position": 0.85},
+                  {"color": "white", "position": 1}]}})",
+               R"({"gradient": {"start": "black", "end": "white", "smooth": true, "duration": 4000}})", 0);
+    checkScene("3 stops reversed", R"({"gradient": {"stops": [{"color": "red", "position": 0},
+                  {"color": "green", "position": 0.5}, {"color": "blue", "position": 1}]}})",
+               R"({"gradient": {"stops": [{"color": "blue", "position": 0}, {"color": "green", "position": 0.3},
+                  {"color": "red", "position": 1}], "reverse": true, "smooth": true, "duration": 4000,
+                  "easing": "ease_in_out_cubic"}})", 0);
+    checkScene("reversed back, stepped", R"({"gradient": {"start": "cyan", "end": "purple", "reverse": true}})",
+               R"j({"gradient": {"start": "purple", "end": "cyan", "reverse": false, "smooth": true,
+                  "duration": 4000, "easing": "steps(5)"}})j", 0);
+}
+
+// With no room for its scratch, a transition becomes a cut to the target
+static void test_low_heap_turns_a_transition_into_a_cut()
+{
+    VirtualClock clock;
+    LEDStrip strip(TEST_PIXELS, 2);
+    strip.setClock(&clock);
+    apply(strip, R"({"effect": {"type": "rainbow"}})");
+    renderFor(strip, clock, 200);
+
+    // As if the boot-time reservation had failed
+    TransitionState& transition = strip.transitionsManager->transition;
+    std::vector<WColor>().swap(transition.sourcePixels);
+    ESP.hostLargestBlock = 64;
+    apply(strip, R"({"effect": {"type": "fire", "seed": 7, "transitionDuration": 1000}})");
+    renderFor(strip, clock, strip.getFrameDelay());
+    ESP.hostLargestBlock = 114688;
+
+    TEST_ASSERT_TRUE(transition.memoryError);
+    TEST_ASSERT_FALSE(transition.active);
+    TEST_ASSERT_EQUAL_INT(EffectRegistry::find("fire"), static_cast<int>(strip.effectsManager->state.type));
+    TEST_ASSERT_TRUE(transition.sourcePixels.capacity() < TEST_PIXELS);
+}
+
+static void test_stats_report_heap_and_subsystems()
+{
+    JsonDocument doc;
+    JsonObject out = doc.to<JsonObject>();
+    HeapStats::getStats(out);
+    TEST_ASSERT_EQUAL_UINT32(ESP.getFreeHeap(), out["free"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(ESP.getMaxAllocHeap(), out["largestBlock"].as<uint32_t>());
+    TEST_ASSERT_TRUE(out["minFree"].is<uint32_t>());
+    TEST_ASSERT_TRUE(out["fragmentation"].as<uint32_t>() <= 100);
+    TEST_ASSERT_TRUE(out["hooks"].as<bool>());
+    for (uint8_t i = 0; i < ALLOC_SUBSYSTEM_COUNT; i++) {
+        const char* name = HeapStats::subsystemName(static_cast<AllocSubsystem>(i));
+        TEST_ASSERT_TRUE_MESSAGE(out["subsystems"][name]["count"].is<uint32_t>(), name);
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_counters_follow_the_tagged_task);
+    RUN_TEST(test_every_effect_renders_without_allocating);
+    RUN_TEST(test_gradients_and_transitions_render_without_allocating);
+    RUN_TEST(test_gradient_transitions_allocate_nothing_per_frame);
+    RUN_TEST(test_low_heap_turns_a_transition_into_a_cut);
+    RUN_TEST(test_stats_report_heap_and_subsystems);
+    return UNITY_END();
+}
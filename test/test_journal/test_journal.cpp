@@ -0,0 +1,273 @@
+// Scene journal torn writes, run on the host: pio test -e native
+//
+// SPIFFS is a scratch directory of the host. Each case journals a run of
+// scenes, wrapping around the slots, then damages the newest slot file the
+// way a power cut or a bad flash page would: cut short in the middle of the
+// payload, or with a payload byte flipped. A fresh strip and journal, as
+// after a reboot, must restore the scene before it, count the bad slot, and
+// write the next scene over the damaged slot, never over the one restored.
+// A looping sequence keeps a transition running on every frame, and is
+// journaled all the same, as its keyframes.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <SPIFFS.h>
+#include <LEDStrip.h>
+#include <Clock.h>
+#include <SceneJournal.h>
+#include <ConfigStore.h>
+#include <EffectRegistry.h>
+#include <EffectsManager.h>
+#include <TranstionsManager.h>
+#include <Timeline.h>
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+static const uint16_t TEST_PIXELS = 30;
+static const char* const UID = "journaltest";
+// magic u32, version u8, reserved u8[3], sequence u32, length u32, crc32 u32
+static const size_t SLOT_HEADER_BYTES = 20;
+
+// Six writes over four slots: slots 0-3, then 0 and 1 again
+static const char* const SCENES[] = {"rainbow", "fire", "chase", "wave", "sparkle", "plasma"};
+static const size_t SCENE_COUNT = sizeof(SCENES) / sizeof(SCENES[0]);
+
+static String slotPath(int slot)
+{
+    return "/scene_" + String(UID) + "." + String(slot);
+}
+
+static std::vector<uint8_t> readFile(const String& path)
+{
+    std::vector<uint8_t> bytes;
+    File file = SPIFFS.open(path, FILE_READ);
+    if (file) {
+        bytes.resize(file.size());
+        bytes.resize(file.read(bytes.data(), bytes.size()));
+        file.close();
+    }
+    return bytes;
+}
+
+static void writeFile(const String& path, const std::vector<uint8_t>& bytes)
+{
+    File file = SPIFFS.open(path, FILE_WRITE);
+    TEST_ASSERT_TRUE(file);
+    file.write(bytes.data(), bytes.size());
+    file.close();
+}
+
+static void applyEffect(LEDStrip& strip, const char* type)
+{
+    JsonDocument doc;
+    doc["effect"]["type"] = type;
+    JsonObject json = doc.as<JsonObject>();
+    strip.jsonInterpreter(json);
+}
+
+static void applyCommand(LEDStrip& strip, const char* command)
+{
+    JsonDocument doc;
+    TEST_ASSERT_FALSE_MESSAGE(deserializeJson(doc, command), command);
+    JsonObject json = doc.as<JsonObject>();
+    strip.jsonInterpreter(json);
+}
+
+static JsonObject statsOf(SceneJournal& journal, JsonDocument& doc)
+{
+    JsonObject out = doc.to<JsonObject>();
+    journal.getStats(out);
+    return out;
+}
+
+// A strip on a stepped clock, so no render task runs, journaled as on the device
+struct JournaledStrip {
+    VirtualClock clock;
+    LEDStrip strip;
+    SceneJournal journal;
+
+    JournaledStrip() : strip(TEST_PIXELS, 2), journal(&strip, UID)
+    {
+        strip.setClock(&clock);
+        strip.journal = &journal;
+    }
+    ~JournaledStrip() { strip.journal = nullptr; }
+
+    EffectType effect() const { return strip.effectsManager->state.type; }
+};
+
+static EffectType effectNamed(const char* name)
+{
+    return static_cast<EffectType>(EffectRegistry::find(name));
+}
+
+// Journals every scene and returns the slot holding the last one
+static int journalScenes()
+{
+    JournaledStrip node;
+    for (const char* scene : SCENES) {
+        applyEffect(node.strip, scene);
+        TEST_ASSERT_TRUE(node.journal.flush());
+    }
+    JsonDocument doc;
+    JsonObject stats = statsOf(node.journal, doc);
+    TEST_ASSERT_EQUAL_UINT32(SCENE_COUNT, stats["sequence"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(SCENE_COUNT, stats["writes"].as<uint32_t>());
+    return stats["slot"].as<int>();
+}
+
+// Damages the newest slot, then reboots onto the journal
+static void checkRestoreAfterDamage(void (*damage)(std::vector<uint8_t>& bytes))
+{
+    int newest = journalScenes();
+    TEST_ASSERT_EQUAL_INT((SCENE_COUNT - 1) % SCENE_JOURNAL_SLOTS, newest);
+    int previous = (newest + SCENE_JOURNAL_SLOTS - 1) % SCENE_JOURNAL_SLOTS;
+
+    std::vector<uint8_t> bytes = readFile(slotPath(newest));
+    TEST_ASSERT_TRUE(bytes.size() > SLOT_HEADER_BYTES + 8);
+    damage(bytes);
+    writeFile(slotPath(newest), bytes);
+    std::vector<uint8_t> previousBytes = readFile(slotPath(previous));
+
+    JournaledStrip node;
+    TEST_ASSERT_TRUE(node.journal.restore());
+    TEST_ASSERT_EQUAL_INT(effectNamed(SCENES[SCENE_COUNT - 2]), node.effect());
+
+    JsonDocument doc;
+    JsonObject stats = statsOf(node.journal, doc);
+    TEST_ASSERT_EQUAL_UINT32(SCENE_COUNT - 1, stats["sequence"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_INT(previous, stats["slot"].as<int>());
+    TEST_ASSERT_EQUAL_UINT32(1, stats["invalidSlots"].as<uint32_t>());
+
+    // The next scene goes over the damaged slot, the restored one is kept
+    applyEffect(node.strip, "breathing");
+    TEST_ASSERT_TRUE(node.journal.flush());
+    stats = statsOf(node.journal, doc);
+    TEST_ASSERT_EQUAL_INT((previous + 1) % SCENE_JOURNAL_SLOTS, stats["slot"].as<int>());
+    TEST_ASSERT_EQUAL_UINT32(SCENE_COUNT, stats["sequence"].as<uint32_t>());
+    std::vector<uint8_t> kept = readFile(slotPath(previous));
+    TEST_ASSERT_TRUE_MESSAGE(kept == previousBytes, "the restored slot was overwritten");
+
+    JournaledStrip rebooted;
+    TEST_ASSERT_TRUE(rebooted.journal.restore());
+    TEST_ASSERT_EQUAL_INT(effectNamed("breathing"), rebooted.effect());
+    stats = statsOf(rebooted.journal, doc);
+    TEST_ASSERT_EQUAL_UINT32(0, stats["invalidSlots"].as<uint32_t>());
+}
+
+static void truncatePayload(std::vector<uint8_t>& bytes)
+{
+    bytes.resize(SLOT_HEADER_BYTES + (bytes.size() - SLOT_HEADER_BYTES) / 2);
+}
+
+static void flipPayloadByte(std::vector<uint8_t>& bytes)
+{
+    bytes[SLOT_HEADER_BYTES + (bytes.size() - SLOT_HEADER_BYTES) / 2] ^= 0x10;
+}
+
+void setUp()
+{
+    for (int slot = 0; slot < SCENE_JOURNAL_SLOTS; slot++) {
+        SPIFFS.remove(slotPath(slot));
+    }
+}
+
+void tearDown() {}
+
+static void test_restores_newest_scene()
+{
+    journalScenes();
+    JournaledStrip node;
+    TEST_ASSERT_TRUE(node.journal.restore());
+    TEST_ASSERT_EQUAL_INT(effectNamed(SCENES[SCENE_COUNT - 1]), node.effect());
+}
+
+static void test_truncated_slot_restores_previous_scene()
+{
+    checkRestoreAfterDamage(truncatePayload);
+}
+
+static void test_corrupt_slot_restores_previous_scene()
+{
+    checkRestoreAfterDamage(flipPayloadByte);
+}
+
+// Each keyframe's transition starts as the previous one lands, so there is
+// never a frame without one: the journal must not wait for it
+static void test_looping_sequence_is_journaled()
+{
+    uint32_t keyframes = 0;
+    {
+        JournaledStrip node;
+        applyCommand(node.strip, R"({"fill": {"color": "red", "transitionDuration": 300},
+            "then": [{"fill": {"color": "green", "transitionDuration": 300}},
+                     {"fill": {"color": "blue", "transitionDuration": 300}}], "loop": {"count": 0}})");
+        keyframes = node.strip.timeline->getKeyframeCount();
+        TEST_ASSERT_TRUE(keyframes > 0);
+
+        uint32_t elapsed = 0;
+        while (elapsed < 1000) {
+            uint32_t step = std::min<uint32_t>(node.strip.getFrameDelay(), 1000 - elapsed);
+            node.clock.advance(step);
+            node.strip.renderStep();
+            elapsed += step;
+        }
+        TEST_ASSERT_TRUE(node.strip.timeline->isActive());
+        TEST_ASSERT_TRUE(node.strip.transitionsManager->transition.active);
+        TEST_ASSERT_TRUE(node.journal.flush());
+        JsonDocument doc;
+        JsonObject stats = statsOf(node.journal, doc);
+        TEST_ASSERT_EQUAL_UINT32(1, stats["writes"].as<uint32_t>());
+        TEST_ASSERT_FALSE(stats["pending"].as<bool>());
+    }
+
+    JournaledStrip rebooted;
+    TEST_ASSERT_TRUE(rebooted.journal.restore());
+    TEST_ASSERT_TRUE(rebooted.strip.timeline->isActive());
+    TEST_ASSERT_TRUE(rebooted.strip.timeline->isLoopingProgram());
+    TEST_ASSERT_EQUAL_UINT32(keyframes, rebooted.strip.timeline->getKeyframeCount());
+}
+
+// A plain transition is still waited for, then written once it lands
+static void test_transition_is_journaled_once_landed()
+{
+    JournaledStrip node;
+    applyCommand(node.strip, R"({"fill": {"color": "blue", "transitionDuration": 500}})");
+    node.clock.advance(node.strip.getFrameDelay());
+    node.strip.renderStep();
+    TEST_ASSERT_TRUE(node.strip.transitionsManager->transition.active);
+    TEST_ASSERT_FALSE(node.journal.flush());
+
+    node.clock.advance(600);
+    node.strip.renderStep();
+    TEST_ASSERT_FALSE(node.strip.transitionsManager->transition.active);
+    TEST_ASSERT_TRUE(node.journal.flush());
+}
+
+static void test_empty_journal_restores_nothing()
+{
+    JournaledStrip node;
+    TEST_ASSERT_FALSE(node.journal.restore());
+    JsonDocument doc;
+    JsonObject stats = statsOf(node.journal, doc);
+    TEST_ASSERT_EQUAL_INT(-1, stats["slot"].as<int>());
+    TEST_ASSERT_EQUAL_UINT32(0, stats["invalidSlots"].as<uint32_t>());
+}
+
+int main()
+{
+    std::filesystem::path root = std::filesystem::temp_directory_path() / "test_journal";
+    std::filesystem::create_directories(root);
+    SPIFFS.setRoot(root.string());
+    ConfigStore::getInstance().mount();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_restores_newest_scene);
+    RUN_TEST(test_truncated_slot_restores_previous_scene);
+    RUN_TEST(test_corrupt_slot_restores_previous_scene);
+    RUN_TEST(test_looping_sequence_is_journaled);
+    RUN_TEST(test_transition_is_journaled_once_landed);
+    RUN_TEST(test_empty_journal_restores_nothing);
+    return UNITY_END();
+}
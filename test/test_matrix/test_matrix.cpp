@@ -0,0 +1,196 @@
+// Matrix layouts and 2D effect timing, run on the host: pio test -e native
+//
+// The layout tests check known corners of small panels for each wiring
+// option, and that every compiled table is a permutation of the LEDs it
+// covers. The benchmark renders each 2D effect through the registry, the
+// way EffectsManager does, on 16x16, 32x32 and 64x8 serpentine panels and
+// reports the cost per frame and per pixel.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <PixelLayout.h>
+#include <EffectRegistry.h>
+#include <chrono>
+#include <vector>
+
+static MatrixConfig panel(uint16_t width, uint16_t height)
+{
+    MatrixConfig config;
+    config.width = width;
+    config.height = height;
+    return config;
+}
+
+static void assertPermutation(const MatrixLayout& layout, uint16_t ledCount)
+{
+    std::vector<bool> seen(ledCount, false);
+    for (uint16_t y = 0; y < layout.height(); y++) {
+        for (uint16_t x = 0; x < layout.width(); x++) {
+            uint16_t index = layout.index(x, y);
+            TEST_ASSERT_TRUE(index < ledCount);
+            TEST_ASSERT_FALSE(seen[index]);
+            seen[index] = true;
+        }
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_linear_is_one_row()
+{
+    MatrixLayout layout;
+    layout.linear(10);
+    TEST_ASSERT_FALSE(layout.isMatrix());
+    TEST_ASSERT_EQUAL_UINT16(10, layout.width());
+    TEST_ASSERT_EQUAL_UINT16(1, layout.height());
+    TEST_ASSERT_EQUAL_UINT16(7, layout.row(0)[7]);
+}
+
+static void test_serpentine_rows_alternate()
+{
+    MatrixConfig config = panel(4, 3);
+    config.serpentine = true;
+    MatrixLayout layout;
+    TEST_ASSERT_TRUE(layout.compile(config, 12));
+    TEST_ASSERT_EQUAL_UINT16(3, layout.index(3, 0));
+    TEST_ASSERT_EQUAL_UINT16(4, layout.index(3, 1));
+    TEST_ASSERT_EQUAL_UINT16(7, layout.index(0, 1));
+    TEST_ASSERT_EQUAL_UINT16(8, layout.index(0, 2));
+    assertPermutation(layout, 12);
+}
+
+static void test_origin_moves_the_first_led()
+{
+    const MatrixOrigin origins[] = {MATRIX_TOP_RIGHT, MATRIX_BOTTOM_LEFT, MATRIX_BOTTOM_RIGHT};
+    const uint16_t x[] = {3, 0, 3};
+    const uint16_t y[] = {0, 2, 2};
+    for (uint8_t i = 0; i < 3; i++) {
+        MatrixConfig config = panel(4, 3);
+        config.origin = origins[i];
+        MatrixLayout layout;
+        TEST_ASSERT_TRUE(layout.compile(config, 12));
+        TEST_ASSERT_EQUAL_UINT16(0, layout.index(x[i], y[i]));
+        assertPermutation(layout, 12);
+    }
+}
+
+// A 4x2 panel turned clockwise is 2 wide and 4 high, its first LED top right
+static void test_rotation_swaps_the_canvas()
+{
+    MatrixConfig config = panel(4, 2);
+    config.rotation = 90;
+    MatrixLayout layout;
+    TEST_ASSERT_TRUE(layout.compile(config, 8));
+    TEST_ASSERT_EQUAL_UINT16(2, layout.width());
+    TEST_ASSERT_EQUAL_UINT16(4, layout.height());
+    TEST_ASSERT_EQUAL_UINT16(0, layout.index(1, 0));
+    TEST_ASSERT_EQUAL_UINT16(3, layout.index(1, 3));
+    TEST_ASSERT_EQUAL_UINT16(4, layout.index(0, 0));
+    assertPermutation(layout, 8);
+
+    config.rotation = 180;
+    TEST_ASSERT_TRUE(layout.compile(config, 8));
+    TEST_ASSERT_EQUAL_UINT16(0, layout.index(3, 1));
+
+    config.rotation = 270;
+    TEST_ASSERT_TRUE(layout.compile(config, 8));
+    TEST_ASSERT_EQUAL_UINT16(0, layout.index(0, 3));
+    assertPermutation(layout, 8);
+}
+
+static void test_tiled_panels()
+{
+    MatrixConfig config = panel(2, 2);
+    config.panelsX = 2;
+    config.panelsY = 2;
+    config.panelSerpentine = true;
+    MatrixLayout layout;
+    TEST_ASSERT_TRUE(layout.compile(config, 16));
+    TEST_ASSERT_EQUAL_UINT16(4, layout.width());
+    TEST_ASSERT_EQUAL_UINT16(4, layout.height());
+    TEST_ASSERT_EQUAL_UINT16(4, layout.index(2, 0));    // Second panel, top right
+    TEST_ASSERT_EQUAL_UINT16(8, layout.index(2, 2));    // Third panel runs back, bottom right
+    TEST_ASSERT_EQUAL_UINT16(12, layout.index(0, 2));   // Fourth, bottom left
+    assertPermutation(layout, 16);
+}
+
+static void test_rejects_what_does_not_fit()
+{
+    MatrixLayout layout;
+    layout.linear(10);
+    TEST_ASSERT_FALSE(layout.compile(panel(4, 4), 10));
+    TEST_ASSERT_FALSE(layout.isMatrix());
+    TEST_ASSERT_EQUAL_UINT16(10, layout.width());
+
+    // Spare LEDs past the matrix are allowed
+    TEST_ASSERT_TRUE(layout.compile(panel(3, 3), 10));
+    assertPermutation(layout, 10);
+}
+
+struct MatrixSize {
+    uint16_t width;
+    uint16_t height;
+};
+
+static const MatrixSize SIZES[] = {{16, 16}, {32, 32}, {64, 8}};
+static const char* const EFFECTS_2D[] = {"plasma", "fire2d", "scroll", "noise"};
+
+static void test_benchmark_2d_effects()
+{
+    for (const MatrixSize& size : SIZES) {
+        MatrixConfig config = panel(size.width, size.height);
+        config.serpentine = true;
+        uint16_t count = size.width * size.height;
+        MatrixLayout layout;
+        TEST_ASSERT_TRUE(layout.compile(config, count));
+
+        for (const char* name : EFFECTS_2D) {
+            int type = EffectRegistry::find(name);
+            TEST_ASSERT_TRUE(type >= 0);
+
+            EffectState s;
+            s.type = static_cast<EffectType>(type);
+            s.seed = 42;
+            s.color1 = WColor(255, 0, 0);
+            s.color2 = WColor(0, 0, 255);
+            s.pixels.assign(count, WColor::BLACK);
+            s.matrix = &layout;
+            EffectRegistry::start(s);
+
+            const uint32_t frames = 200;
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t f = 0; f < frames; f++) {
+                EffectRegistry::render(s);
+                s.counter++;
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            double frameUs = std::chrono::duration<double, std::micro>(elapsed).count() / frames;
+
+            char message[128];
+            snprintf(message, sizeof(message), "%ux%u %s: %.1f us/frame, %.1f ns/pixel",
+                     size.width, size.height, name, frameUs, frameUs * 1000.0 / count);
+            TEST_MESSAGE(message);
+
+            // Fire is dark where it cooled, the others cover the whole canvas
+            if (strcmp(name, "fire2d") != 0) {
+                for (uint16_t i = 0; i < count; i++) {
+                    TEST_ASSERT_TRUE_MESSAGE(s.pixels[i] != WColor::BLACK, message);
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_linear_is_one_row);
+    RUN_TEST(test_serpentine_rows_alternate);
+    RUN_TEST(test_origin_moves_the_first_led);
+    RUN_TEST(test_rotation_swaps_the_canvas);
+    RUN_TEST(test_tiled_panels);
+    RUN_TEST(test_rejects_what_does_not_fit);
+    RUN_TEST(test_benchmark_2d_effects);
+    return UNITY_END();
+}
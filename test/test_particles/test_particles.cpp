@@ -0,0 +1,130 @@
+// Particle pool behaviour, run on the host: pio test -e native
+//
+// The pool keeps live particles packed at the front of its attribute
+// arrays. These cases pin down what the effects rely on: spawn fills the
+// next free index, a dead particle is replaced by the last one, a full pool
+// turns spawns away, and a splat spreads a particle over the pixels it
+// overlaps.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <ParticlePool.h>
+
+typedef ParticlePool<8> SmallPool;
+
+static void spawnAt(SmallPool& pool, float position)
+{
+    // Colour channels carry the position, to follow a particle as it moves index
+    uint8_t tag = static_cast<uint8_t>(position);
+    TEST_ASSERT_TRUE(pool.spawn(position, 0.0f, WColor(tag, tag, tag), 1.0f) >= 0);
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_spawn_fills_the_next_index()
+{
+    SmallPool pool;
+    pool.clear();
+    TEST_ASSERT_EQUAL_INT(0, pool.spawn(3.5f, -2.0f, WColor(10, 20, 30), 0.5f));
+    TEST_ASSERT_EQUAL_INT(1, pool.spawn(7.0f, 1.0f, WColor(1, 2, 3), 0.0f));
+    TEST_ASSERT_EQUAL_UINT32(2, pool.count);
+
+    TEST_ASSERT_TRUE(pool.position[0] == 3.5f);
+    TEST_ASSERT_TRUE(pool.velocity[0] == -2.0f);
+    TEST_ASSERT_TRUE(pool.life[0] == 1.0f);
+    TEST_ASSERT_TRUE(pool.decay[0] == 2.0f);
+    TEST_ASSERT_EQUAL_UINT32(10, pool.red[0]);
+    TEST_ASSERT_EQUAL_UINT32(20, pool.green[0]);
+    TEST_ASSERT_EQUAL_UINT32(30, pool.blue[0]);
+    // No lifetime, no decay: the particle lives until it leaves the bounds
+    TEST_ASSERT_TRUE(pool.decay[1] == 0.0f);
+}
+
+static void test_kill_swaps_in_the_last_particle()
+{
+    SmallPool pool;
+    pool.clear();
+    for (int i = 0; i < 5; i++) spawnAt(pool, 10.0f * i);
+
+    pool.kill(1);
+    TEST_ASSERT_EQUAL_UINT32(4, pool.count);
+    TEST_ASSERT_TRUE(pool.position[1] == 40.0f);
+    TEST_ASSERT_EQUAL_UINT32(40, pool.red[1]);
+    TEST_ASSERT_TRUE(pool.position[0] == 0.0f);
+    TEST_ASSERT_TRUE(pool.position[2] == 20.0f);
+    TEST_ASSERT_TRUE(pool.position[3] == 30.0f);
+
+    // The last one goes without moving anything
+    pool.kill(3);
+    TEST_ASSERT_EQUAL_UINT32(3, pool.count);
+    TEST_ASSERT_TRUE(pool.position[2] == 20.0f);
+}
+
+// update() removes in place: a particle swapped in is tested in the same pass
+static void test_update_drops_dead_and_escaped_particles()
+{
+    SmallPool pool;
+    pool.clear();
+    pool.spawn(5.0f, 0.0f, WColor(1, 1, 1), 0.0f);     // stays
+    pool.spawn(5.0f, 0.0f, WColor(2, 2, 2), 0.05f);    // dies of age
+    pool.spawn(5.0f, -100.0f, WColor(3, 3, 3), 0.0f);  // leaves below
+    pool.spawn(5.0f, 100.0f, WColor(4, 4, 4), 0.0f);   // leaves above
+    pool.spawn(5.0f, 10.0f, WColor(5, 5, 5), 0.0f);    // stays
+
+    pool.update(0.1f, 0.0f, 0.0f, 9.0f);
+    TEST_ASSERT_EQUAL_UINT32(2, pool.count);
+    TEST_ASSERT_EQUAL_UINT32(1, pool.red[0]);
+    TEST_ASSERT_EQUAL_UINT32(5, pool.red[1]);
+    TEST_ASSERT_TRUE(fabsf(pool.position[1] - 6.0f) < 1e-5f);
+}
+
+static void test_full_pool_turns_spawns_away()
+{
+    SmallPool pool;
+    pool.clear();
+    for (uint16_t i = 0; i < SmallPool::capacity(); i++) spawnAt(pool, i);
+    TEST_ASSERT_EQUAL_INT(-1, pool.spawn(99.0f, 0.0f, WColor(99, 99, 99), 1.0f));
+    TEST_ASSERT_EQUAL_UINT32(SmallPool::capacity(), pool.count);
+    for (uint16_t i = 0; i < SmallPool::capacity(); i++) {
+        TEST_ASSERT_TRUE(pool.position[i] == i);
+    }
+
+    // A freed index is taken again
+    pool.kill(0);
+    TEST_ASSERT_EQUAL_INT(SmallPool::capacity() - 1, pool.spawn(99.0f, 0.0f, WColor(99, 99, 99), 1.0f));
+}
+
+static void test_splat_spreads_over_covered_pixels()
+{
+    WColor pixels[4];
+    // One pixel wide, centered on the boundary between pixels 1 and 2
+    splatOne(pixels, 4, 2.0f, 1.0f, WColor(200, 100, 0), 1.0f);
+    TEST_ASSERT_EQUAL_UINT32(0, pixels[0].r);
+    TEST_ASSERT_EQUAL_UINT32(100, pixels[1].r);
+    TEST_ASSERT_EQUAL_UINT32(100, pixels[2].r);
+    TEST_ASSERT_EQUAL_UINT32(50, pixels[2].g);
+    TEST_ASSERT_EQUAL_UINT32(0, pixels[3].r);
+
+    // Additive, saturating at 255
+    splatOne(pixels, 4, 2.0f, 1.0f, WColor(255, 255, 255), 2.0f);
+    TEST_ASSERT_EQUAL_UINT32(255, pixels[1].r);
+    TEST_ASSERT_EQUAL_UINT32(255, pixels[2].g);
+
+    // Clipped at both ends of the strip
+    splatOne(pixels, 4, -0.25f, 1.0f, WColor(0, 0, 40), 1.0f);
+    splatOne(pixels, 4, 4.25f, 1.0f, WColor(0, 0, 40), 1.0f);
+    TEST_ASSERT_EQUAL_UINT32(10, pixels[0].b);
+    TEST_ASSERT_EQUAL_UINT32(10, pixels[3].b);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_spawn_fills_the_next_index);
+    RUN_TEST(test_kill_swaps_in_the_last_particle);
+    RUN_TEST(test_update_drops_dead_and_escaped_particles);
+    RUN_TEST(test_full_pool_turns_spawns_away);
+    RUN_TEST(test_splat_spreads_over_covered_pixels);
+    return UNITY_END();
+}
@@ -0,0 +1,204 @@
+// Logical to physical pixel maps and their cost in the pack, run on the host: pio test -e native
+//
+// PixelMap is checked for the form each config compiles to and the LED every
+// logical pixel lands on. The benchmark packs 1000 logical pixels into a
+// driver buffer the way Adafruit_NeoPixel::setPixelColor does (brightness
+// scaled, GRB order) straight, then through run-length and table maps, and
+// bounds what the runs add to the pack time.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <PixelLayout.h>
+#include <wcolor.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+static const uint16_t BENCH_PIXELS = 1000;
+static const double RUN_OVERHEAD_BOUND = 0.10;
+
+// Stand-in for the NeoPixel buffer, written by setPixelColor(n, r, g, b).
+// Out of line and bounds checked like the library call it models.
+struct DriverBuffer {
+    std::vector<uint8_t> bytes;
+    uint8_t brightness = 200;
+
+    explicit DriverBuffer(uint16_t leds) : bytes(leds * 3u, 0) {}
+
+    __attribute__((noinline)) void set(uint16_t n, const WColor& c)
+    {
+        if (n * 3u >= bytes.size()) return;
+        uint8_t* p = &bytes[n * 3u];
+        p[0] = (c.g * brightness) >> 8;
+        p[1] = (c.r * brightness) >> 8;
+        p[2] = (c.b * brightness) >> 8;
+    }
+};
+
+// LED of every logical pixel, packing a frame where pixel i has red i
+static std::vector<int> landing(const PixelMap& map, uint16_t leds)
+{
+    std::vector<WColor> logical(map.size());
+    for (uint16_t i = 0; i < map.size(); i++) logical[i] = WColor(i, 0, 0);
+    std::vector<int> ledOf(map.size(), -1);
+    std::vector<bool> written(leds, false);
+    map.pack(logical.data(), [&](uint16_t led, const WColor& c) {
+        TEST_ASSERT_TRUE(led < leds);
+        TEST_ASSERT_FALSE(written[led]);
+        written[led] = true;
+        ledOf[c.r] = led;
+    });
+    return ledOf;
+}
+
+static bool parseMap(PixelMap& map, const char* json, uint16_t leds)
+{
+    JsonDocument doc;
+    deserializeJson(doc, json);
+    return map.parse(doc.as<JsonVariantConst>(), leds);
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_identity_is_one_run()
+{
+    PixelMap map;
+    map.identity(10);
+    TEST_ASSERT_EQUAL_UINT16(10, map.size());
+    TEST_ASSERT_EQUAL_UINT32(1, map.runCount());
+    TEST_ASSERT_EQUAL_INT(7, landing(map, 10)[7]);
+}
+
+static void test_offset_gaps_and_reverse()
+{
+    PixelMap map;
+    TEST_ASSERT_TRUE(parseMap(map, R"({"offset": 2, "skip": [[10, 2]], "reverse": true})", 20));
+    // LEDs 2-9 and 12-19, the far end first
+    TEST_ASSERT_EQUAL_UINT16(16, map.size());
+    TEST_ASSERT_FALSE(map.usesTable());
+    TEST_ASSERT_EQUAL_UINT32(2, map.runCount());
+    const int expected[] = {19, 18, 17, 16, 15, 14, 13, 12, 9, 8, 7, 6, 5, 4, 3, 2};
+    TEST_ASSERT_EQUAL_INT_ARRAY(expected, landing(map, 20).data(), 16);
+}
+
+static void test_spliced_segments()
+{
+    PixelMap map;
+    TEST_ASSERT_TRUE(parseMap(map,
+        R"({"segments": [{"start": 4, "count": 4, "reverse": true}, {"start": 0, "count": 4}]})", 8));
+    TEST_ASSERT_EQUAL_UINT32(2, map.runCount());
+    const int expected[] = {7, 6, 5, 4, 0, 1, 2, 3};
+    TEST_ASSERT_EQUAL_INT_ARRAY(expected, landing(map, 8).data(), 8);
+}
+
+// Runs of one or two LEDs pack faster and smaller as a table
+static void test_scattered_order_falls_back_to_a_table()
+{
+    PixelMap map;
+    TEST_ASSERT_TRUE(parseMap(map, R"({"table": [3, 0, 6, 1, 4, 7, 2, 5]})", 8));
+    TEST_ASSERT_TRUE(map.usesTable());
+    const int expected[] = {3, 0, 6, 1, 4, 7, 2, 5};
+    TEST_ASSERT_EQUAL_INT_ARRAY(expected, landing(map, 8).data(), 8);
+
+    // A table that is really two runs compiles to runs
+    TEST_ASSERT_TRUE(parseMap(map, R"({"table": [3, 2, 1, 0, 4, 5, 6, 7]})", 8));
+    TEST_ASSERT_FALSE(map.usesTable());
+    TEST_ASSERT_EQUAL_UINT32(2, map.runCount());
+}
+
+static void test_rejects_invalid_maps()
+{
+    PixelMap map;
+    TEST_ASSERT_FALSE(parseMap(map, R"({"table": [0, 1, 1]})", 8));
+    TEST_ASSERT_FALSE(parseMap(map, R"({"table": [0, 8]})", 8));
+    TEST_ASSERT_FALSE(parseMap(map, R"({"segments": [{"start": 6, "count": 4}]})", 8));
+    TEST_ASSERT_FALSE(parseMap(map, R"({"segments": [{"start": 0, "count": 4}, {"start": 2, "count": 4}]})", 8));
+    TEST_ASSERT_FALSE(parseMap(map, R"({"offset": 8})", 8));
+}
+
+// Best of several trials, the variants taking turns within each trial so a
+// slow stretch of the machine hits all of them, to keep scheduler noise out
+// of a 10% comparison
+template <typename Fn>
+static double timeMicros(Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < 200; r++) fn();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / 200;
+}
+
+template <typename A, typename B, typename C>
+static void bestMicros(A a, B b, C c, double best[3])
+{
+    best[0] = best[1] = best[2] = 1e30;
+    for (int trial = 0; trial < 100; trial++) {
+        best[0] = std::min(best[0], timeMicros(a));
+        best[1] = std::min(best[1], timeMicros(b));
+        best[2] = std::min(best[2], timeMicros(c));
+    }
+}
+
+static void test_benchmark_pack()
+{
+    const uint16_t leds = BENCH_PIXELS + 40;
+    std::vector<WColor> logical(BENCH_PIXELS);
+    for (uint16_t i = 0; i < BENCH_PIXELS; i++) logical[i] = WColor(i * 7, i * 13, i * 29);
+    DriverBuffer driver(leds);
+    volatile uint8_t sink = 0;
+
+    // Five reversed and forward runs with gaps between them
+    PixelMap runs;
+    TEST_ASSERT_TRUE(parseMap(runs, R"({"segments": [
+        {"start": 0, "count": 200}, {"start": 208, "count": 200, "reverse": true},
+        {"start": 416, "count": 200}, {"start": 624, "count": 200, "reverse": true},
+        {"start": 832, "count": 200}]})", leds));
+    TEST_ASSERT_FALSE(runs.usesTable());
+
+    // Every other pixel swapped with its neighbour, too fragmented for runs
+    std::vector<uint16_t> order(BENCH_PIXELS);
+    for (uint16_t i = 0; i < BENCH_PIXELS; i++) order[i] = i ^ 1;
+    PixelMap table;
+    TEST_ASSERT_TRUE(table.compile(order, leds));
+    TEST_ASSERT_TRUE(table.usesTable());
+
+    double best[3];
+    bestMicros(
+        // What show() did before maps: logical pixel i on LED i
+        [&]() {
+            for (uint16_t i = 0; i < BENCH_PIXELS; i++) driver.set(i, logical[i]);
+            sink = sink + driver.bytes[7];
+        },
+        [&]() {
+            runs.pack(logical.data(), [&](uint16_t led, const WColor& c) { driver.set(led, c); });
+            sink = sink + driver.bytes[7];
+        },
+        [&]() {
+            table.pack(logical.data(), [&](uint16_t led, const WColor& c) { driver.set(led, c); });
+            sink = sink + driver.bytes[7];
+        },
+        best);
+    double straightUs = best[0];
+    double runsUs = best[1];
+    double tableUs = best[2];
+
+    char message[160];
+    snprintf(message, sizeof(message), "%u pixels: straight %.2f us, runs %.2f us (%+.1f%%), table %.2f us (%+.1f%%)",
+             BENCH_PIXELS, straightUs, runsUs, (runsUs / straightUs - 1.0) * 100.0,
+             tableUs, (tableUs / straightUs - 1.0) * 100.0);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE_MESSAGE(runsUs < straightUs * (1.0 + RUN_OVERHEAD_BOUND), message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_identity_is_one_run);
+    RUN_TEST(test_offset_gaps_and_reverse);
+    RUN_TEST(test_spliced_segments);
+    RUN_TEST(test_scattered_order_falls_back_to_a_table);
+    RUN_TEST(test_rejects_invalid_maps);
+    RUN_TEST(test_benchmark_pack);
+    return UNITY_END();
+}
@@ -0,0 +1,330 @@
+// Command scheduler tests, run on the host: pio test -e native
+//
+// The loopback load test puts a real CommandScheduler and worker task in
+// front of a stub output that spends a fixed time per command, floods it with
+// low priority tweaks faster than it can drain them, and checks that high
+// priority commands sent meanwhile are never rejected and keep a bounded
+// queue latency. The input latency probe must complete only on the command
+// it was armed with. The text buffer and the router cooldown in front of the
+// queue are checked without a worker.
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <unity.h>
+#include <CommandScheduler.h>
+#include <omniSourceRouter.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const uint32_t WORK_US = 500;              ///< Stub output time per command
+static const uint32_t FLOOD_INTERVAL_US = 200;    ///< 5000 low commands/s, twice the drain rate
+static const uint32_t FLOOD_MS = 1500;
+static const uint32_t HIGH_INTERVAL_MS = 20;
+// p99 bound: one frame budget spent on lows, one yielded frame, and host scheduling slack
+static const uint32_t MAX_HIGH_LATENCY_US = 40000;
+
+// Records when tagged commands reach the output
+class LoopbackOutput : public Output {
+public:
+    bool begin() override { return true; }
+    void end() override {}
+
+    void jsonInterpreter(JsonObject& json) override
+    {
+        uint32_t start = micros();
+        if (json["high"].as<bool>()) {
+            std::lock_guard<std::mutex> lock(latencyMutex);
+            highLatencyUs.push_back(start - json["sentUs"].as<uint32_t>());
+        } else {
+            lowApplied++;
+        }
+        while (micros() - start < WORK_US) {
+        }
+    }
+
+    std::mutex latencyMutex;
+    std::vector<uint32_t> highLatencyUs;
+    std::atomic<uint32_t> lowApplied{0};
+};
+
+// Records whether the latency probe was complete as each command arrives
+class ProbeOutput : public Output {
+public:
+    bool begin() override { return true; }
+    void end() override {}
+
+    void jsonInterpreter(JsonObject& json) override
+    {
+        std::lock_guard<std::mutex> lock(seenMutex);
+        seen.push_back({json["name"].as<std::string>(), probeApplied});
+    }
+
+    std::mutex seenMutex;
+    std::vector<std::pair<std::string, bool>> seen;
+};
+
+static CommandPriority classifyJson(const char* text)
+{
+    JsonDocument doc;
+    deserializeJson(doc, text);
+    JsonObject command = doc.as<JsonObject>();
+    return CommandScheduler::classify(command);
+}
+
+static bool enqueueJson(CommandScheduler& scheduler, const char* text)
+{
+    JsonDocument doc;
+    deserializeJson(doc, text);
+    JsonObject command = doc.as<JsonObject>();
+    return scheduler.enqueue(command);
+}
+
+static JsonObject statsOf(CommandScheduler& scheduler, JsonDocument& doc)
+{
+    JsonObject out = doc.to<JsonObject>();
+    scheduler.getStats(out);
+    return out;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_classify()
+{
+    TEST_ASSERT_EQUAL(PRIORITY_SAFETY, classifyJson(R"({"blackout":true})"));
+    TEST_ASSERT_EQUAL(PRIORITY_NORMAL, classifyJson(R"({"blackout":false})"));
+    TEST_ASSERT_EQUAL(PRIORITY_NORMAL, classifyJson(R"({"safety":true,"fill":{"color":"#ff0000"}})"));
+    TEST_ASSERT_EQUAL(PRIORITY_SAFETY, classifyJson(R"({"priority":"safety","fill":{"color":"#000000"}})"));
+    TEST_ASSERT_EQUAL(PRIORITY_HIGH, classifyJson(R"({"animation":{"type":"pulse"}})"));
+    TEST_ASSERT_EQUAL(PRIORITY_LOW, classifyJson(R"({"effect":{"speed":2}})"));
+    TEST_ASSERT_EQUAL(PRIORITY_NORMAL, classifyJson(R"({"effect":{"type":"fire"}})"));
+}
+
+// Without a worker the queue only fills, so flushing is observable
+static void test_only_a_real_blackout_flushes()
+{
+    LoopbackOutput output;
+    CommandScheduler scheduler(&output, "loopback");
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(enqueueJson(scheduler, R"({"fill":{"color":"#ff0000"}})"));
+    }
+    TEST_ASSERT_TRUE(enqueueJson(scheduler, R"({"blackout":false})"));
+    TEST_ASSERT_EQUAL_UINT32(4, scheduler.pendingCount());
+
+    TEST_ASSERT_TRUE(enqueueJson(scheduler, R"({"blackout":true})"));
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.pendingCount());
+
+    JsonDocument doc;
+    JsonObject stats = statsOf(scheduler, doc);
+    TEST_ASSERT_EQUAL_UINT32(4, stats["normal"]["preempted"].as<uint32_t>());
+}
+
+// Text space comes back on flush, and a command over the limit evicts nothing
+static void test_text_buffer_is_reused()
+{
+    LoopbackOutput output;
+    CommandScheduler scheduler(&output, "loopback");
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < MAX_QUEUE_SIZE; i++) {
+            TEST_ASSERT_TRUE(enqueueJson(scheduler, R"({"fill":{"color":"#ff0000"}})"));
+        }
+        TEST_ASSERT_FALSE(enqueueJson(scheduler, R"({"fill":{"color":"#00ff00"}})"));
+        TEST_ASSERT_TRUE(enqueueJson(scheduler, R"({"blackout":true})"));
+        TEST_ASSERT_EQUAL_UINT32(1, scheduler.pendingCount());
+        TEST_ASSERT_TRUE(enqueueJson(scheduler, R"({"blackout":true})"));
+        TEST_ASSERT_EQUAL_UINT32(2, scheduler.pendingCount());
+        scheduler.end();
+    }
+
+    JsonDocument doc;
+    JsonArray pixels = doc["pixels"].to<JsonArray>();
+    while (measureJson(doc) < MAX_JSON_SIZE) pixels.add("#ffffff");
+    JsonObject oversized = doc.as<JsonObject>();
+    TEST_ASSERT_TRUE(enqueueJson(scheduler, R"({"fill":{"color":"#ff0000"}})"));
+    TEST_ASSERT_FALSE(scheduler.enqueue(oversized, PRIORITY_SAFETY));
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.pendingCount());
+}
+
+// Large commands fill the text buffer before the queue is full: a higher
+// priority command evicts lower ones until it fits, an equal one is refused
+static void test_text_buffer_evicts_by_priority()
+{
+    LoopbackOutput output;
+    CommandScheduler scheduler(&output, "loopback");
+
+    JsonDocument doc;
+    JsonArray pixels = doc["pixels"].to<JsonArray>();
+    while (measureJson(doc) < 1000) pixels.add("#ffffff");
+    JsonObject large = doc.as<JsonObject>();
+    size_t fitting = MAX_QUEUED_JSON_BYTES / measureJson(doc);
+
+    size_t lows = 0;
+    while (lows <= MAX_QUEUE_SIZE && scheduler.enqueue(large, PRIORITY_LOW)) lows++;
+    TEST_ASSERT_EQUAL_UINT32(fitting, lows);
+
+    for (size_t i = 0; i < fitting; i++) {
+        TEST_ASSERT_TRUE(scheduler.enqueue(large, PRIORITY_NORMAL));
+        TEST_ASSERT_EQUAL_UINT32(fitting, scheduler.pendingCount());
+    }
+    TEST_ASSERT_FALSE(scheduler.enqueue(large, PRIORITY_NORMAL));
+    TEST_ASSERT_TRUE(enqueueJson(scheduler, R"({"blackout":true})"));
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.pendingCount());
+
+    JsonDocument statsDoc;
+    JsonObject stats = statsOf(scheduler, statsDoc);
+    TEST_ASSERT_EQUAL_UINT32(fitting, stats["low"]["preempted"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(1, stats["low"]["rejected"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(1, stats["normal"]["rejected"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(fitting, stats["normal"]["preempted"].as<uint32_t>());
+}
+
+// The router parks calls made inside a cooldown and keeps only the latest, so
+// with the 60 ms it used to have, a tweak right after a blackout replaced it
+static void test_router_cooldown_keeps_blackout()
+{
+    const unsigned long cooldowns[] = {60, CommandScheduler::ROUTER_COOLDOWN_MS};
+    const uint32_t safetyQueued[] = {0, 1};
+    // The cooldown reads a call at millis() 0 as no call yet, and the host
+    // clock starts with the process
+    while (millis() == 0) delay(1);
+    for (int c = 0; c < 2; c++) {
+        LoopbackOutput output;
+        CommandScheduler scheduler(&output, "loopback");
+        OmniSourceRouterCallback callback("loopback", [&scheduler](JsonObject& data) { scheduler.enqueue(data); },
+                                          cooldowns[c]);
+        CooldownManager cooldown;
+
+        const char* burst[] = {R"({"effect":{"speed":2}})", R"({"blackout":true})", R"({"effect":{"speed":3}})"};
+        for (const char* text : burst) {
+            JsonDocument doc;
+            deserializeJson(doc, text);
+            JsonObject data = doc.as<JsonObject>();
+            cooldown.executeWithCooldown(callback, data);
+        }
+
+        JsonDocument doc;
+        JsonObject stats = statsOf(scheduler, doc);
+        TEST_ASSERT_EQUAL_UINT32(safetyQueued[c], stats["safety"]["enqueued"].as<uint32_t>());
+    }
+}
+
+// The probe belongs to the command it was armed with, not to whatever runs first
+static void test_probe_completes_on_its_own_command()
+{
+    ProbeOutput output;
+    CommandScheduler scheduler(&output, "probe");
+
+    JsonDocument doc;
+    doc["name"] = "other";
+    JsonObject other = doc.as<JsonObject>();
+    TEST_ASSERT_TRUE(scheduler.enqueue(other, PRIORITY_HIGH));
+
+    output.probeStartUs = micros();
+    doc["name"] = "probed";
+    JsonObject probed = doc.as<JsonObject>();
+    TEST_ASSERT_TRUE(scheduler.enqueue(probed, PRIORITY_NORMAL, true));
+
+    doc["name"] = "after";
+    JsonObject after = doc.as<JsonObject>();
+    TEST_ASSERT_TRUE(scheduler.enqueue(after, PRIORITY_LOW));
+
+    TEST_ASSERT_TRUE(scheduler.begin());
+    for (int i = 0; i < 200 && scheduler.pendingCount() > 0; i++) delay(5);
+    delay(10);
+    scheduler.end();
+
+    std::lock_guard<std::mutex> lock(output.seenMutex);
+    TEST_ASSERT_EQUAL_UINT32(3, output.seen.size());
+    TEST_ASSERT_TRUE(output.seen[0].first == "other" && !output.seen[0].second);
+    TEST_ASSERT_TRUE(output.seen[1].first == "probed" && !output.seen[1].second);
+    TEST_ASSERT_TRUE(output.seen[2].first == "after" && output.seen[2].second);
+}
+
+static void test_high_latency_under_low_flood()
+{
+    LoopbackOutput output;
+    CommandScheduler scheduler(&output, "loopback");
+    TEST_ASSERT_TRUE(scheduler.begin());
+
+    std::atomic<bool> flooding{true};
+    std::thread flooder([&]() {
+        uint32_t n = 0;
+        while (flooding) {
+            char text[64];
+            snprintf(text, sizeof(text), R"({"effect":{"speed":%u}})", 1 + (n++ % 9));
+            enqueueJson(scheduler, text);
+            std::this_thread::sleep_for(std::chrono::microseconds(FLOOD_INTERVAL_US));
+        }
+    });
+
+    uint32_t highSent = 0;
+    uint32_t highAccepted = 0;
+    uint32_t start = millis();
+    while (millis() - start < FLOOD_MS) {
+        JsonDocument doc;
+        doc["high"] = true;
+        doc["sentUs"] = micros();
+        JsonObject command = doc.as<JsonObject>();
+        highSent++;
+        if (scheduler.enqueue(command, PRIORITY_HIGH)) highAccepted++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(HIGH_INTERVAL_MS));
+    }
+    flooding = false;
+    flooder.join();
+
+    // Let the queue drain before reading the results
+    for (int i = 0; i < 200 && scheduler.pendingCount() > 0; i++) delay(5);
+    delay(WORK_US / 1000 + 5);
+    scheduler.end();
+
+    JsonDocument doc;
+    JsonObject stats = statsOf(scheduler, doc);
+    JsonObject low = stats["low"];
+    uint32_t lowEnqueued = low["enqueued"];
+    uint32_t lowShed = low["droppedStale"].as<uint32_t>() + low["preempted"].as<uint32_t>() +
+                       low["rejected"].as<uint32_t>();
+
+    std::vector<uint32_t> latencies;
+    {
+        std::lock_guard<std::mutex> lock(output.latencyMutex);
+        latencies = output.highLatencyUs;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    uint32_t p50 = latencies.empty() ? 0 : latencies[latencies.size() / 2];
+    uint32_t p99 = latencies.empty() ? 0 : latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+    uint32_t worst = latencies.empty() ? 0 : latencies.back();
+
+    char message[192];
+    snprintf(message, sizeof(message),
+             "high: %u sent, p50 %.2f ms, p99 %.2f ms, max %.2f ms; low: %u enqueued, %u applied, %u shed",
+             static_cast<unsigned>(highSent), p50 / 1000.0, p99 / 1000.0, worst / 1000.0,
+             static_cast<unsigned>(lowEnqueued), static_cast<unsigned>(output.lowApplied.load()),
+             static_cast<unsigned>(lowShed));
+    TEST_MESSAGE(message);
+
+    // The flood has to exceed the drain rate for the test to mean anything
+    TEST_ASSERT_TRUE_MESSAGE(lowShed > 0, "low flood did not overload the scheduler");
+    TEST_ASSERT_EQUAL_UINT32(highSent, highAccepted);
+    TEST_ASSERT_EQUAL_UINT32(highSent, latencies.size());
+    TEST_ASSERT_TRUE_MESSAGE(p99 <= MAX_HIGH_LATENCY_US, message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_classify);
+    RUN_TEST(test_only_a_real_blackout_flushes);
+    RUN_TEST(test_text_buffer_is_reused);
+    RUN_TEST(test_text_buffer_evicts_by_priority);
+    RUN_TEST(test_router_cooldown_keeps_blackout);
+    RUN_TEST(test_probe_completes_on_its_own_command);
+    RUN_TEST(test_high_latency_under_low_flood);
+    return UNITY_END();
+}
@@ -0,0 +1,211 @@
+// Pixel coordinates and spatial effect timing, run on the host: pio test -e native
+//
+// PixelCoords is checked for its normalization, the positions it derives from
+// a layout and its flash form. The benchmark renders the spatial effects
+// through the registry on 1000 pixels running along the walls and ceiling of
+// a room, and reports the cost per frame. An ESP32 core at 240 MHz runs these
+// loops about 20 times slower than a desktop core; scaled by that, the sweep
+// must fit in a quarter of a 60 fps frame, leaving the rest for the pack into
+// the driver buffer and show().
+
+#include <Arduino.h>
+#include <unity.h>
+#include <PixelLayout.h>
+#include <EffectRegistry.h>
+#include <chrono>
+#include <vector>
+
+static const uint16_t ROOM_PIXELS = 1000;
+static const double DEVICE_SLOWDOWN = 20.0;
+static const double FRAME_BUDGET_US = 1e6 / 60.0 / 4.0;
+
+// Builds a {"x": [...], "y": [...], "z": [...]} document
+static void coordsJson(JsonDocument& doc, const std::vector<float>& x,
+                       const std::vector<float>& y, const std::vector<float>& z)
+{
+    JsonArray xs = doc["x"].to<JsonArray>();
+    JsonArray ys = doc["y"].to<JsonArray>();
+    JsonArray zs = doc["z"].to<JsonArray>();
+    for (size_t i = 0; i < x.size(); i++) {
+        xs.add(x[i]);
+        ys.add(y[i]);
+        zs.add(z[i]);
+    }
+}
+
+// Up one wall, across the ceiling, down the opposite wall; meters
+static void roomJson(JsonDocument& doc)
+{
+    std::vector<float> x, y, z;
+    for (uint16_t i = 0; i < ROOM_PIXELS; i++) {
+        float t = i / static_cast<float>(ROOM_PIXELS - 1) * 11.0f;
+        if (t < 2.5f) {
+            x.push_back(0.0f); y.push_back(t); z.push_back(1.0f);
+        } else if (t < 8.5f) {
+            x.push_back(t - 2.5f); y.push_back(2.5f); z.push_back(1.0f);
+        } else {
+            x.push_back(6.0f); y.push_back(11.0f - t); z.push_back(1.0f);
+        }
+    }
+    coordsJson(doc, x, y, z);
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_longest_axis_spans_the_unit()
+{
+    JsonDocument doc;
+    coordsJson(doc, {0.0f, 10.0f, 20.0f}, {0.0f, 5.0f, 0.0f}, {3.0f, 3.0f, 3.0f});
+    PixelCoords coords;
+    TEST_ASSERT_TRUE(coords.parse(doc.as<JsonVariantConst>(), 3));
+    TEST_ASSERT_TRUE(coords.isCustom());
+    TEST_ASSERT_EQUAL_INT16(-PixelCoords::UNIT, coords.x()[0]);
+    TEST_ASSERT_EQUAL_INT16(0, coords.x()[1]);
+    TEST_ASSERT_EQUAL_INT16(PixelCoords::UNIT, coords.x()[2]);
+    // Same scale on every axis: y is 2.5 above its center, a quarter of x's 10
+    TEST_ASSERT_INT16_WITHIN(1, PixelCoords::UNIT / 4, coords.y()[1]);
+    TEST_ASSERT_EQUAL_INT16(0, coords.z()[0]);
+}
+
+static void test_rejects_a_table_of_the_wrong_length()
+{
+    JsonDocument doc;
+    coordsJson(doc, {0.0f, 1.0f}, {0.0f, 1.0f}, {0.0f, 1.0f});
+    PixelCoords coords;
+    TEST_ASSERT_FALSE(coords.parse(doc.as<JsonVariantConst>(), 3));
+
+    JsonDocument noX;
+    noX["y"].to<JsonArray>().add(1.0f);
+    TEST_ASSERT_FALSE(coords.parse(noX.as<JsonVariantConst>(), 1));
+}
+
+static void test_positions_follow_the_layout()
+{
+    MatrixConfig config;
+    config.width = 4;
+    config.height = 2;
+    config.serpentine = true;
+    MatrixLayout layout;
+    TEST_ASSERT_TRUE(layout.compile(config, 8));
+
+    PixelCoords coords;
+    coords.fromLayout(layout, 8);
+    TEST_ASSERT_FALSE(coords.isCustom());
+    // LED 0 top left, LED 4 starts the second row on the right
+    TEST_ASSERT_EQUAL_INT16(-PixelCoords::UNIT, coords.x()[0]);
+    TEST_ASSERT_EQUAL_INT16(PixelCoords::UNIT / 3, coords.y()[0]);
+    TEST_ASSERT_EQUAL_INT16(PixelCoords::UNIT, coords.x()[4]);
+    TEST_ASSERT_EQUAL_INT16(-PixelCoords::UNIT / 3, coords.y()[4]);
+
+    layout.linear(5);
+    coords.fromLayout(layout, 5);
+    TEST_ASSERT_EQUAL_INT16(-PixelCoords::UNIT, coords.x()[0]);
+    TEST_ASSERT_EQUAL_INT16(0, coords.x()[2]);
+    TEST_ASSERT_EQUAL_INT16(0, coords.y()[2]);
+}
+
+static void test_flash_form_round_trips()
+{
+    JsonDocument doc;
+    roomJson(doc);
+    PixelCoords coords;
+    TEST_ASSERT_TRUE(coords.parse(doc.as<JsonVariantConst>(), ROOM_PIXELS));
+
+    std::vector<uint8_t> data;
+    coords.encode(data);
+    PixelCoords loaded;
+    TEST_ASSERT_TRUE(loaded.decode(data.data(), data.size(), ROOM_PIXELS));
+    TEST_ASSERT_EQUAL_INT16_ARRAY(coords.x(), loaded.x(), ROOM_PIXELS);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(coords.y(), loaded.y(), ROOM_PIXELS);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(coords.z(), loaded.z(), ROOM_PIXELS);
+
+    // Strip resized since the table was saved
+    TEST_ASSERT_FALSE(loaded.decode(data.data(), data.size(), ROOM_PIXELS - 1));
+    TEST_ASSERT_FALSE(loaded.decode(data.data(), data.size() - 1, ROOM_PIXELS));
+}
+
+static EffectState spatialInstance(const char* name, const PixelCoords& coords)
+{
+    EffectState s;
+    s.type = static_cast<EffectType>(EffectRegistry::find(name));
+    s.seed = 42;
+    s.color1 = WColor(255, 255, 255);
+    s.pixels.assign(coords.size(), WColor::BLACK);
+    s.coords = &coords;
+    EffectRegistry::start(s);
+    return s;
+}
+
+// Along +x the front reaches the left wall before the right one
+static void test_sweep_travels_along_its_direction()
+{
+    JsonDocument doc;
+    roomJson(doc);
+    PixelCoords coords;
+    TEST_ASSERT_TRUE(coords.parse(doc.as<JsonVariantConst>(), ROOM_PIXELS));
+
+    EffectState s = spatialInstance("sweep", coords);
+    int firstLeft = -1, firstRight = -1;
+    for (int frame = 0; frame < 200 && (firstLeft < 0 || firstRight < 0); frame++) {
+        EffectRegistry::render(s);
+        if (firstLeft < 0 && s.pixels[0] != WColor::BLACK) firstLeft = frame;
+        if (firstRight < 0 && s.pixels[ROOM_PIXELS - 1] != WColor::BLACK) firstRight = frame;
+    }
+    TEST_ASSERT_TRUE(firstLeft >= 0);
+    TEST_ASSERT_TRUE(firstRight > firstLeft);
+
+    // Turned toward -x the order flips, without restarting the effect
+    s.spatial.direction[0] = -1.0f;
+    for (int frame = 0; frame < 200; frame++) {
+        EffectRegistry::render(s);
+        if (s.pixels[ROOM_PIXELS - 1] != WColor::BLACK) {
+            TEST_ASSERT_TRUE(s.pixels[0] == WColor::BLACK);
+            return;
+        }
+    }
+    TEST_FAIL_MESSAGE("Sweep toward -x never reached the right wall");
+}
+
+static const char* const SPATIAL_EFFECTS[] = {"sweep", "pulse", "noise3d"};
+
+static void test_benchmark_spatial_effects()
+{
+    JsonDocument doc;
+    roomJson(doc);
+    PixelCoords coords;
+    TEST_ASSERT_TRUE(coords.parse(doc.as<JsonVariantConst>(), ROOM_PIXELS));
+
+    for (const char* name : SPATIAL_EFFECTS) {
+        EffectState s = spatialInstance(name, coords);
+        EffectRegistry::render(s);   // Cached terms, once per geometry
+
+        const uint32_t frames = 1000;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t f = 0; f < frames; f++) {
+            EffectRegistry::render(s);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        double frameUs = std::chrono::duration<double, std::micro>(elapsed).count() / frames;
+
+        char message[128];
+        snprintf(message, sizeof(message), "%u pixels %s: %.1f us/frame, %.1f ns/pixel",
+                 ROOM_PIXELS, name, frameUs, frameUs * 1000.0 / ROOM_PIXELS);
+        TEST_MESSAGE(message);
+        if (strcmp(name, "sweep") == 0) {
+            TEST_ASSERT_TRUE_MESSAGE(frameUs * DEVICE_SLOWDOWN < FRAME_BUDGET_US, message);
+        }
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_longest_axis_spans_the_unit);
+    RUN_TEST(test_rejects_a_table_of_the_wrong_length);
+    RUN_TEST(test_positions_follow_the_layout);
+    RUN_TEST(test_flash_form_round_trips);
+    RUN_TEST(test_sweep_travels_along_its_direction);
+    RUN_TEST(test_benchmark_spatial_effects);
+    return UNITY_END();
+}
@@ -0,0 +1,274 @@
+// Telemetry uplink tests, run on the host: pio test -e native
+//
+// Frames handed to the send callback are parsed back against the wire
+// layout in Telemetry.h: header, fixed size events and the source names
+// trailing their TELEMETRY_SOURCE events. The size test replays a button
+// session and compares the bytes sent with the text messages the buttons
+// used to send, one WebSocket message per edge. The legacy text messages
+// go through the NetworkManager outbox, which only the network loop sends.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <Telemetry.h>
+#include <GestureDetector.h>
+#include <networkManager.h>
+#include <string>
+#include <vector>
+
+struct ParsedEvent {
+    TelemetryEvent event;
+    std::string name;        ///< Trailing bytes of a TELEMETRY_SOURCE event
+};
+
+struct ParsedFrame {
+    TelemetryFrameHeader header;
+    std::vector<ParsedEvent> events;
+    size_t length;
+};
+
+static const size_t EVENTS_PER_FRAME =
+    (TELEMETRY_FRAME_SIZE - sizeof(TelemetryFrameHeader)) / sizeof(TelemetryEvent);
+
+static std::vector<ParsedFrame> sent;
+static bool failSends = false;
+
+static ParsedFrame parseFrame(const uint8_t* data, size_t length)
+{
+    ParsedFrame frame;
+    frame.length = length;
+    TEST_ASSERT_TRUE(length >= sizeof(TelemetryFrameHeader));
+    memcpy(&frame.header, data, sizeof(frame.header));
+
+    size_t offset = sizeof(TelemetryFrameHeader);
+    for (uint16_t i = 0; i < frame.header.count; i++) {
+        TEST_ASSERT_TRUE(offset + sizeof(TelemetryEvent) <= length);
+        ParsedEvent parsed;
+        memcpy(&parsed.event, data + offset, sizeof(TelemetryEvent));
+        offset += sizeof(TelemetryEvent);
+        if (parsed.event.type == TELEMETRY_SOURCE) {
+            TEST_ASSERT_TRUE(offset + parsed.event.code <= length);
+            parsed.name.assign(reinterpret_cast<const char*>(data + offset), parsed.event.code);
+            offset += parsed.event.code;
+        }
+        frame.events.push_back(parsed);
+    }
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(length, offset, "bytes after the last event");
+    return frame;
+}
+
+static bool capture(const uint8_t* data, size_t length)
+{
+    if (failSends) return false;
+    sent.push_back(parseFrame(data, length));
+    return true;
+}
+
+// Polls as if the flush interval had passed until nothing is left to send
+static void drain()
+{
+    Telemetry& telemetry = Telemetry::getInstance();
+    for (int i = 0; i < 4; i++) telemetry.poll(millis() + telemetry.flushIntervalMs, capture);
+}
+
+void setUp()
+{
+    Telemetry& telemetry = Telemetry::getInstance();
+    telemetry.statsIntervalMs = 0xFFFFFFFFu;    // no heap samples in the middle of a test
+    failSends = false;
+    drain();
+    sent.clear();
+}
+
+void tearDown() {}
+
+static void test_frame_layout()
+{
+    Telemetry& telemetry = Telemetry::getInstance();
+    uint8_t source = telemetry.registerSource("layout-btn");
+    uint32_t before = millis();
+    telemetry.record(TELEMETRY_INPUT_CHANGE, source, 0, 1);
+    telemetry.record(TELEMETRY_GESTURE, source, GESTURE_DOUBLE_CLICK, 0);
+    telemetry.record(TELEMETRY_ERROR, TELEMETRY_NO_SOURCE, TELEMETRY_ERR_PARSE, -7);
+
+    // Nothing goes out before the flush interval
+    telemetry.poll(millis(), capture);
+    TEST_ASSERT_EQUAL_UINT32(0, sent.size());
+
+    drain();
+    TEST_ASSERT_EQUAL_UINT32(1, sent.size());
+    const ParsedFrame& frame = sent[0];
+    TEST_ASSERT_EQUAL_UINT8('W', frame.header.magic[0]);
+    TEST_ASSERT_EQUAL_UINT8('T', frame.header.magic[1]);
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_VERSION, frame.header.version);
+    TEST_ASSERT_EQUAL_UINT32(0, frame.header.dropped);
+    TEST_ASSERT_TRUE(frame.header.baseMs - before <= 5);
+    TEST_ASSERT_EQUAL_UINT32(4, frame.header.count);
+
+    const std::vector<ParsedEvent>& events = frame.events;
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_SOURCE, events[0].event.type);
+    TEST_ASSERT_EQUAL_UINT8(source, events[0].event.source);
+    TEST_ASSERT_TRUE(events[0].name == "layout-btn");
+
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_INPUT_CHANGE, events[1].event.type);
+    TEST_ASSERT_EQUAL_INT32(1, events[1].event.value);
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_GESTURE, events[2].event.type);
+    TEST_ASSERT_EQUAL_UINT32(GESTURE_DOUBLE_CLICK, events[2].event.code);
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_ERROR, events[3].event.type);
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_NO_SOURCE, events[3].event.source);
+    TEST_ASSERT_EQUAL_INT32(-7, events[3].event.value);
+    for (const ParsedEvent& parsed : events) TEST_ASSERT_TRUE(parsed.event.dtMs <= 5);
+
+    // Already registered: same id, no second announcement
+    TEST_ASSERT_EQUAL_UINT8(source, telemetry.registerSource("layout-btn"));
+    drain();
+    TEST_ASSERT_EQUAL_UINT32(1, sent.size());
+}
+
+// +1 per frame sent; a failed send is retried with the same sequence
+static void test_sequence_numbers()
+{
+    Telemetry& telemetry = Telemetry::getInstance();
+    telemetry.record(TELEMETRY_INPUT_CHANGE, 0, 0, 1);
+    drain();
+    telemetry.record(TELEMETRY_INPUT_CHANGE, 0, 0, 0);
+    failSends = true;
+    drain();
+    failSends = false;
+    drain();
+    telemetry.record(TELEMETRY_INPUT_CHANGE, 0, 0, 1);
+    drain();
+
+    TEST_ASSERT_EQUAL_UINT32(3, sent.size());
+    TEST_ASSERT_EQUAL_UINT32(sent[0].header.sequence + 1, sent[1].header.sequence);
+    TEST_ASSERT_EQUAL_UINT32(sent[1].header.sequence + 1, sent[2].header.sequence);
+    TEST_ASSERT_EQUAL_INT32(0, sent[1].events[0].event.value);
+}
+
+// A full frame is sealed at once; with both buffers waiting, losses go in the next header sent
+static void test_full_frames_and_losses()
+{
+    Telemetry& telemetry = Telemetry::getInstance();
+    const size_t lost = 5;
+    const size_t total = 2 * EVENTS_PER_FRAME + lost;
+    for (size_t i = 0; i < total; i++) {
+        telemetry.record(TELEMETRY_STAT, TELEMETRY_NO_SOURCE, TELEMETRY_STAT_UPTIME_S, static_cast<int32_t>(i));
+    }
+
+    // Sent without waiting for the interval, the frame is full
+    telemetry.poll(millis(), capture);
+    TEST_ASSERT_EQUAL_UINT32(1, sent.size());
+    TEST_ASSERT_EQUAL_UINT32(EVENTS_PER_FRAME, sent[0].header.count);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(TelemetryFrameHeader) + EVENTS_PER_FRAME * sizeof(TelemetryEvent),
+                             sent[0].length);
+    TEST_ASSERT_EQUAL_UINT32(lost, sent[0].header.dropped);
+
+    drain();
+    TEST_ASSERT_EQUAL_UINT32(2, sent.size());
+    TEST_ASSERT_EQUAL_UINT32(EVENTS_PER_FRAME, sent[1].header.count);
+    TEST_ASSERT_EQUAL_UINT32(0, sent[1].header.dropped);
+
+    // Values arrive in order, the lost ones are the newest
+    int32_t expected = 0;
+    for (const ParsedFrame& frame : sent) {
+        for (const ParsedEvent& parsed : frame.events) TEST_ASSERT_EQUAL_INT32(expected++, parsed.event.value);
+    }
+}
+
+// Bytes on the wire for a button session, against the text messages it replaced
+static void test_bytes_per_event()
+{
+    Telemetry& telemetry = Telemetry::getInstance();
+    const String uid = "btn-hall-01";
+    uint8_t source = telemetry.registerSource(uid);
+    drain();
+    sent.clear();
+
+    // Ten clicks and a double click: press, release and a gesture each
+    const InputGesture gestures[] = {GESTURE_CLICK, GESTURE_CLICK, GESTURE_CLICK, GESTURE_CLICK, GESTURE_CLICK,
+                                     GESTURE_CLICK, GESTURE_CLICK, GESTURE_CLICK, GESTURE_CLICK, GESTURE_CLICK,
+                                     GESTURE_DOUBLE_CLICK};
+    size_t events = 0;
+    size_t textBytes = 0;
+    for (InputGesture gesture : gestures) {
+        for (int state = 1; state >= 0; state--) {
+            telemetry.record(TELEMETRY_INPUT_CHANGE, source, 0, state);
+            String text = "btn changed from setup, UID : " + uid + ", state : " + String(state);
+            textBytes += text.length();
+            events++;
+        }
+        telemetry.record(TELEMETRY_GESTURE, source, gesture, 0);
+        String text = "btn gesture, UID : " + uid + ", gesture : " + String(gesture == GESTURE_CLICK ? "click" : "double_click");
+        textBytes += text.length();
+        events++;
+    }
+    drain();
+
+    size_t binaryBytes = 0;
+    size_t framed = 0;
+    for (const ParsedFrame& frame : sent) {
+        binaryBytes += frame.length;
+        framed += frame.header.count;
+    }
+    TEST_ASSERT_EQUAL_UINT32(events, framed);
+
+    double binaryPerEvent = static_cast<double>(binaryBytes) / events;
+    double textPerEvent = static_cast<double>(textBytes) / events;
+    char message[160];
+    snprintf(message, sizeof(message),
+             "%u events: %.1f bytes/event in %u binary frame(s), %.1f bytes/event as text messages (%.1fx)",
+             static_cast<unsigned>(events), binaryPerEvent, static_cast<unsigned>(sent.size()), textPerEvent,
+             textPerEvent / binaryPerEvent);
+    TEST_MESSAGE(message);
+
+    // Header amortised over the batch: close to the 10 byte event
+    TEST_ASSERT_TRUE_MESSAGE(binaryPerEvent < sizeof(TelemetryEvent) + 1.0, message);
+    TEST_ASSERT_TRUE_MESSAGE(textPerEvent > 4.0 * binaryPerEvent, message);
+    // And one message instead of one per edge
+    TEST_ASSERT_EQUAL_UINT32(1, sent.size());
+}
+
+// Text queued by the input task waits for a connected client, in order
+static void test_text_outbox_waits_for_the_network_loop()
+{
+    NetworkManager nm;
+    std::vector<std::string> texts;
+    bool connected = false;
+    auto send = [&](const char* text) {
+        if (!connected) return false;
+        texts.push_back(text);
+        return true;
+    };
+
+    TEST_ASSERT_TRUE(nm.queueMessage("btn changed from setup, UID : a, state : true"));
+    TEST_ASSERT_TRUE(nm.queueMessage("btn changed from setup, UID : a, state : false"));
+    nm.flushOutbox(send);
+    TEST_ASSERT_EQUAL_UINT32(0, texts.size());
+
+    connected = true;
+    nm.flushOutbox(send);
+    TEST_ASSERT_EQUAL_UINT32(2, texts.size());
+    TEST_ASSERT_TRUE(texts[0] == "btn changed from setup, UID : a, state : true");
+    TEST_ASSERT_TRUE(texts[1] == "btn changed from setup, UID : a, state : false");
+
+    // A full outbox turns new messages away and counts them
+    connected = false;
+    texts.clear();
+    for (int i = 0; i < OUTBOX_DEPTH + 3; i++) nm.queueMessage(String(i));
+    TEST_ASSERT_EQUAL_UINT32(3, nm.getOutboxDropped());
+    connected = true;
+    nm.flushOutbox(send);
+    TEST_ASSERT_EQUAL_UINT32(OUTBOX_DEPTH, texts.size());
+    TEST_ASSERT_TRUE(texts.front() == "0");
+    TEST_ASSERT_TRUE(texts.back() == std::to_string(OUTBOX_DEPTH - 1));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_frame_layout);
+    RUN_TEST(test_sequence_numbers);
+    RUN_TEST(test_full_frames_and_losses);
+    RUN_TEST(test_bytes_per_event);
+    RUN_TEST(test_text_outbox_waits_for_the_network_loop);
+    return UNITY_END();
+}